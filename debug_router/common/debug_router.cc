@@ -118,6 +118,62 @@ void DebugRouter::SendDataAsync(const std::string &data,
                                                      is_object);
 }
 
+void DebugRouter::SendDataAsync(const std::string &data,
+                                const std::string &type, int32_t session,
+                                bool is_object, MessagePriority priority) {
+  core::MessagePriority core_priority = core::MessagePriority::kInteractive;
+  switch (priority) {
+    case MessagePriority::kInteractive:
+      core_priority = core::MessagePriority::kInteractive;
+      break;
+    case MessagePriority::kBulk:
+      core_priority = core::MessagePriority::kBulk;
+      break;
+    case MessagePriority::kScreencast:
+      core_priority = core::MessagePriority::kScreencast;
+      break;
+  }
+  core::DebugRouterCore::GetInstance().SendDataAsync(data, type, session, -1,
+                                                     is_object, core_priority);
+}
+
+void DebugRouter::SendScreenCastDataAsync(
+    std::string data, std::unordered_map<std::string, float> metadata,
+    int32_t session) {
+  core::DebugRouterCore::GetInstance().SendScreenCastDataAsync(
+      session, std::move(data), std::move(metadata));
+}
+
+void DebugRouter::SendScreenCastAsync(
+    std::string image, std::unordered_map<std::string, float> metadata,
+    int32_t session) {
+  core::DebugRouterCore::GetInstance().SendScreenCastAsync(
+      session, std::move(image), std::move(metadata));
+}
+
+void DebugRouter::AddCdpMethodHandler(const std::string &method,
+                                      CdpMethodHandler handler) {
+  core::DebugRouterCore::GetInstance().AddCdpMethodHandler(
+      method, [handler = std::move(handler)](int session_id,
+                                             const std::string &message) {
+        return handler(session_id, message);
+      });
+}
+
+bool DebugRouter::RemoveCdpMethodHandler(const std::string &method) {
+  return core::DebugRouterCore::GetInstance().RemoveCdpMethodHandler(method);
+}
+
+CdpRouteStats DebugRouter::GetCdpRouteStats() {
+  processor::CdpRouteStats core_stats =
+      core::DebugRouterCore::GetInstance().GetCdpRouteStats();
+  CdpRouteStats stats;
+  stats.messages = core_stats.messages;
+  stats.hits = core_stats.hits;
+  stats.handled = core_stats.handled;
+  return stats;
+}
+
 int32_t DebugRouter::Plug(const std::shared_ptr<DebugRouterSlot> &slot) {
   std::shared_ptr<core::NativeSlot> native_slot =
       std::make_shared<NativeSlotDelegate>(slot);
@@ -129,10 +185,16 @@ void DebugRouter::Pull(int32_t session_id_) {
 }
 
 void DebugRouter::AddGlobalHandler(DebugRouterGlobalHandler *handler) {
+  AddGlobalHandler(handler, {});
+}
+
+void DebugRouter::AddGlobalHandler(
+    DebugRouterGlobalHandler *handler,
+    const std::unordered_set<std::string> &types) {
   DebugRouterGlobalHandlerDelegate *common_global_handler =
       new DebugRouterGlobalHandlerDelegate(handler);
   int handler_id = core::DebugRouterCore::GetInstance().AddGlobalHandler(
-      common_global_handler);
+      common_global_handler, types);
   global_handlers_map_[handler] = handler_id;
 }
 
@@ -145,10 +207,20 @@ bool DebugRouter::RemoveGlobalHandler(DebugRouterGlobalHandler *handler) {
 }
 
 void DebugRouter::AddSessionHandler(DebugRouterSessionHandler *handler) {
+  AddSessionHandler(handler, {}, {});
+}
+
+void DebugRouter::AddSessionHandler(
+    DebugRouterSessionHandler *handler,
+    const std::unordered_set<int32_t> &session_ids,
+    const std::unordered_set<std::string> &types) {
   DebugRouterSessionHandlerDelegate *common_session_handler =
       new DebugRouterSessionHandlerDelegate(handler);
+  core::HandlerSubscription subscription;
+  subscription.session_ids = session_ids;
+  subscription.types = types;
   int handler_id = core::DebugRouterCore::GetInstance().AddSessionHandler(
-      common_session_handler);
+      common_session_handler, subscription);
   session_handlers_map_[handler] = handler_id;
 }
 
@@ -5,6 +5,8 @@
 #ifndef DEBUGROUTER_COMMON_DEBUG_ROUTER_H_
 #define DEBUGROUTER_COMMON_DEBUG_ROUTER_H_
 
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -35,6 +37,31 @@ class DebugRouterStateListener {
 
 typedef enum { DISCONNECTED = 0, CONNECTING, CONNECTED } ConnectionState;
 
+// messages waiting for the connection are sent by priority, from the most
+// urgent. Only screencast messages are dropped when they fall behind.
+enum class MessagePriority {
+  // e.g. Debugger.paused and the responses a debugger waits for
+  kInteractive,
+  // large payloads, e.g. heap snapshots
+  kBulk,
+  // screencast frames and screenshots
+  kScreencast,
+};
+
+// handles a CDP message of session_id natively, returns true if it has been
+// answered and must not be forwarded to the slot of the session
+using CdpMethodHandler =
+    std::function<bool(int32_t session_id, const std::string &message)>;
+
+struct CdpRouteStats {
+  // CDP messages whose method was looked up
+  uint64_t messages = 0;
+  // messages with a native handler
+  uint64_t hits = 0;
+  // messages the native handler answered, they were not forwarded
+  uint64_t handled = 0;
+};
+
 class DebugRouterSlot;
 class DebugRouterGlobalHandlerDelegate;
 class DebugRouterSessionHandlerDelegate;
@@ -56,16 +83,48 @@ class DEBUG_ROUTER_EXPORT DebugRouter {
   void SendDataAsync(const std::string &data, const std::string &type,
                      int32_t session, bool is_object);
 
+  // the other overloads derive the priority from type and data
+  void SendDataAsync(const std::string &data, const std::string &type,
+                     int32_t session, bool is_object,
+                     MessagePriority priority);
+
+  // data is base64, see DebugRouterSlot::SendScreenCast
+  void SendScreenCastDataAsync(std::string data,
+                               std::unordered_map<std::string, float> metadata,
+                               int32_t session);
+
+  // image is an encoded JPEG or PNG, see DebugRouterSlot::SendScreenCastImage
+  void SendScreenCastAsync(std::string image,
+                           std::unordered_map<std::string, float> metadata,
+                           int32_t session);
+
+  // handler answers the CDP messages of method before they reach slots, on
+  // the thread that received them. It replaces the handler of method.
+  void AddCdpMethodHandler(const std::string &method,
+                           CdpMethodHandler handler);
+  bool RemoveCdpMethodHandler(const std::string &method);
+  CdpRouteStats GetCdpRouteStats();
+
   int32_t Plug(const std::shared_ptr<DebugRouterSlot> &slot);
 
   void Pull(int32_t session_id);
 
   void AddGlobalHandler(DebugRouterGlobalHandler *handler);
 
+  // handler only receives global messages of types
+  void AddGlobalHandler(DebugRouterGlobalHandler *handler,
+                        const std::unordered_set<std::string> &types);
+
   bool RemoveGlobalHandler(DebugRouterGlobalHandler *handler);
 
   void AddSessionHandler(DebugRouterSessionHandler *handler);
 
+  // handler only receives messages of types to session_ids, an empty set
+  // matches every session or type
+  void AddSessionHandler(DebugRouterSessionHandler *handler,
+                         const std::unordered_set<int32_t> &session_ids,
+                         const std::unordered_set<std::string> &types);
+
   bool RemoveSessionHandler(DebugRouterSessionHandler *handler);
 
   bool IsValidSchema(const std::string &schema);
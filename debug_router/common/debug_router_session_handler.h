@@ -14,6 +14,10 @@ class DebugRouterSessionHandler {
  public:
   virtual void OnSessionCreate(int session_id, const std::string &url) = 0;
   virtual void OnSessionDestroy(int session_id) = 0;
+  // called on one of a few dispatch threads, the messages of a session one
+  // at a time and in order, not necessarily on the same thread. Messages of
+  // different sessions may arrive at the same time, a handler of several
+  // sessions has to be thread safe.
   virtual void OnMessage(const std::string &message, const std::string &type,
                          int session_id) = 0;
 };
@@ -76,10 +76,16 @@ void DebugRouterSlot::DispatchScreencastVisibilityChanged(bool status) {
 void DebugRouterSlot::SendScreenCast(
     const std::string &data,
     const std::unordered_map<std::string, float> &metadata) {
-  auto cdp_data =
-      debugrouter::processor::MessageAssembler::AssembleScreenCastFrame(
-          session_id_, data, metadata);
-  SendDataAsync(cdp_data, "CDP");
+  // assembled once the router sends it, repeated frames are skipped
+  DebugRouter::GetInstance().SendScreenCastDataAsync(data, metadata,
+                                                     session_id_);
+}
+
+void DebugRouterSlot::SendScreenCastImage(
+    std::string image,
+    const std::unordered_map<std::string, float> &metadata) {
+  DebugRouter::GetInstance().SendScreenCastAsync(std::move(image), metadata,
+                                                 session_id_);
 }
 
 void DebugRouterSlot::SetDelegate(
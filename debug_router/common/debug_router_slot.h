@@ -27,6 +27,8 @@ class DebugRouterSlot : public std::enable_shared_from_this<DebugRouterSlot> {
 
   // delegate methods
   std::string GetTemplateUrl() const;
+  // called on a dispatch thread of the session, in order, see
+  // DebugRouterSessionHandler::OnMessage
   void OnMessage(const std::string &message, const std::string &type);
 
   // dispatch specific messages
@@ -36,6 +38,12 @@ class DebugRouterSlot : public std::enable_shared_from_this<DebugRouterSlot> {
   [[deprecated]] void ClearScreenCastCache();
   void SendScreenCast(const std::string &data,
                       const std::unordered_map<std::string, float> &metadata);
+  // sends the encoded JPEG or PNG bytes of a frame. Debuggers that enabled
+  // binary messages get them as is, others get the base64
+  // Page.screencastFrame that SendScreenCast sends.
+  void SendScreenCastImage(
+      std::string image,
+      const std::unordered_map<std::string, float> &metadata);
 
   void SetDelegate(const std::shared_ptr<DebugRouterSlotDelegate> &delegate);
   const std::string &GetType();
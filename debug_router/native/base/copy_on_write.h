@@ -0,0 +1,55 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_BASE_COPY_ON_WRITE_H_
+#define DEBUGROUTER_NATIVE_BASE_COPY_ON_WRITE_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace debugrouter {
+namespace base {
+
+/**
+ * A value that is read far more often than it is written, e.g. a list of
+ * handlers. Readers load an immutable snapshot with one atomic load and no
+ * allocation, and keep it alive while they use it. Writers are serialized,
+ * they update a copy and publish it.
+ */
+template <typename T>
+class CopyOnWrite {
+ public:
+  CopyOnWrite() : snapshot_(std::make_shared<const T>()) {}
+
+  CopyOnWrite(const CopyOnWrite &) = delete;
+  CopyOnWrite &operator=(const CopyOnWrite &) = delete;
+
+  std::shared_ptr<const T> Load() const {
+    return std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+  }
+
+  // calls update with a copy of the value, the copy is published if update
+  // returns true.
+  template <typename Function>
+  void Update(Function update) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    auto copy = std::make_shared<T>(*snapshot_);
+    if (update(*copy)) {
+      std::atomic_store_explicit(&snapshot_,
+                                 std::shared_ptr<const T>(std::move(copy)),
+                                 std::memory_order_release);
+    }
+  }
+
+ private:
+  std::shared_ptr<const T> snapshot_;
+  // only writers take it, they read snapshot_ under it
+  std::mutex write_mutex_;
+};
+
+}  // namespace base
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_BASE_COPY_ON_WRITE_H_
@@ -0,0 +1,693 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/base/string_kernels.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define DEBUGROUTER_KERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2 is compiled with target attributes and used if the CPU has it
+#if defined(DEBUGROUTER_KERNELS_SSE2) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define DEBUGROUTER_KERNELS_AVX2 1
+#include <immintrin.h>
+#define DEBUGROUTER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// the kernels use instructions of AArch64 NEON, e.g. vqtbl4q_u8
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define DEBUGROUTER_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace debugrouter {
+namespace base {
+
+namespace {
+
+// bytes written for each input byte, 1 if it is not escaped
+constexpr std::array<uint8_t, 256> MakeEscapeSizes() {
+  std::array<uint8_t, 256> sizes = {};
+  for (int c = 0; c < 256; ++c) {
+    sizes[c] = c < 0x20 ? 6 : 1;
+  }
+  for (char c : {'"', '\\', '\b', '\f', '\n', '\r', '\t'}) {
+    sizes[static_cast<uint8_t>(c)] = 2;
+  }
+  return sizes;
+}
+
+constexpr std::array<uint8_t, 256> kEscapeSizes = MakeEscapeSizes();
+
+constexpr char kBase64Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// the value of each base64 character, 0xff if it is none
+constexpr std::array<uint8_t, 256> MakeBase64Values() {
+  std::array<uint8_t, 256> values = {};
+  for (int c = 0; c < 256; ++c) {
+    values[c] = 0xff;
+  }
+  for (int i = 0; i < 64; ++i) {
+    values[static_cast<uint8_t>(kBase64Alphabet[i])] = i;
+  }
+  return values;
+}
+
+constexpr std::array<uint8_t, 256> kBase64Values = MakeBase64Values();
+
+// mask is not 0
+inline int CountTrailingZeros(uint64_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;
+  _BitScanForward64(&index, mask);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(mask);
+#endif
+}
+
+KernelLevel DetectKernelLevel() {
+#if defined(DEBUGROUTER_KERNELS_AVX2)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return KernelLevel::kAvx2;
+  }
+#endif
+#if defined(DEBUGROUTER_KERNELS_SSE2) || defined(DEBUGROUTER_KERNELS_NEON)
+  return KernelLevel::kSimd;
+#else
+  return KernelLevel::kScalar;
+#endif
+}
+
+KernelLevel BestKernelLevel() {
+  static const KernelLevel level = DetectKernelLevel();
+  return level;
+}
+
+std::atomic<KernelLevel> &CurrentKernelLevel() {
+  static std::atomic<KernelLevel> level(BestKernelLevel());
+  return level;
+}
+
+// scalar code, also for the tails of the vector loops
+
+// the escape of each byte, padded to 8 bytes so that it is copied at once
+struct EscapeText {
+  char text[8];
+};
+
+constexpr std::array<EscapeText, 256> MakeEscapeTexts() {
+  std::array<EscapeText, 256> texts = {};
+  const char kHex[] = "0123456789ABCDEF";
+  for (int c = 0; c < 0x20; ++c) {
+    texts[c] = {{'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xf]}};
+  }
+  const char pairs[][2] = {{'"', '"'},  {'\\', '\\'}, {'\b', 'b'},
+                           {'\f', 'f'}, {'\n', 'n'},  {'\r', 'r'},
+                           {'\t', 't'}};
+  for (const auto &pair : pairs) {
+    texts[static_cast<uint8_t>(pair[0])] = {{'\\', pair[1]}};
+  }
+  return texts;
+}
+
+constexpr std::array<EscapeText, 256> kEscapeTexts = MakeEscapeTexts();
+
+size_t ScalarJsonEscapedSize(const uint8_t *data, size_t size) {
+  size_t escaped_size = 0;
+  for (size_t i = 0; i < size; ++i) {
+    escaped_size += kEscapeSizes[data[i]];
+  }
+  return escaped_size;
+}
+
+char *ScalarJsonEscape(const uint8_t *data, size_t size, char *out) {
+  for (size_t i = 0; i < size; ++i) {
+    uint8_t c = data[i];
+    if (kEscapeSizes[c] == 1) {
+      *out++ = static_cast<char>(c);
+    } else {
+      memcpy(out, kEscapeTexts[c].text, kEscapeSizes[c]);
+      out += kEscapeSizes[c];
+    }
+  }
+  return out;
+}
+
+// writes the padded base64 of all of data
+char *ScalarBase64Encode(const uint8_t *data, size_t size, char *out) {
+  size_t i = 0;
+  for (; i + 3 <= size; i += 3) {
+    uint32_t triple = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+    *out++ = kBase64Alphabet[(triple >> 18) & 0x3f];
+    *out++ = kBase64Alphabet[(triple >> 12) & 0x3f];
+    *out++ = kBase64Alphabet[(triple >> 6) & 0x3f];
+    *out++ = kBase64Alphabet[triple & 0x3f];
+  }
+  size_t rest = size - i;
+  if (rest > 0) {
+    uint32_t triple = data[i] << 16;
+    if (rest == 2) {
+      triple |= data[i + 1] << 8;
+    }
+    *out++ = kBase64Alphabet[(triple >> 18) & 0x3f];
+    *out++ = kBase64Alphabet[(triple >> 12) & 0x3f];
+    *out++ = rest == 2 ? kBase64Alphabet[(triple >> 6) & 0x3f] : '=';
+    *out++ = '=';
+  }
+  return out;
+}
+
+// decodes groups of 4 characters without padding, size is a multiple of 4
+bool ScalarBase64Decode(const uint8_t *data, size_t size, char *out) {
+  for (size_t i = 0; i < size; i += 4) {
+    uint32_t a = kBase64Values[data[i]];
+    uint32_t b = kBase64Values[data[i + 1]];
+    uint32_t c = kBase64Values[data[i + 2]];
+    uint32_t d = kBase64Values[data[i + 3]];
+    if ((a | b | c | d) & 0x80) {
+      return false;
+    }
+    uint32_t triple = (a << 18) | (b << 12) | (c << 6) | d;
+    *out++ = static_cast<char>(triple >> 16);
+    *out++ = static_cast<char>(triple >> 8);
+    *out++ = static_cast<char>(triple);
+  }
+  return true;
+}
+
+#if defined(DEBUGROUTER_KERNELS_SSE2) || defined(DEBUGROUTER_KERNELS_NEON)
+
+// writes the block [begin, end) of data, whose escaped bytes have a bit in
+// mask: bit k << shift for byte begin + k. The output has room for at least
+// the input left, so plain bytes are copied 32 and escapes 8 at a time while
+// the input has that many bytes left.
+char *EscapeBlock(const uint8_t *data, size_t size, size_t begin, size_t end,
+                  uint64_t mask, int shift, char *out) {
+  size_t pos = begin;
+  while (true) {
+    size_t next =
+        mask != 0 ? begin + (CountTrailingZeros(mask) >> shift) : end;
+    if (pos + 32 <= size) {
+      memcpy(out, data + pos, 32);
+    } else {
+      memcpy(out, data + pos, next - pos);
+    }
+    out += next - pos;
+    if (mask == 0) {
+      return out;
+    }
+    uint8_t c = data[next];
+    if (next + sizeof(EscapeText) <= size) {
+      memcpy(out, kEscapeTexts[c].text, sizeof(EscapeText));
+    } else {
+      memcpy(out, kEscapeTexts[c].text, kEscapeSizes[c]);
+    }
+    out += kEscapeSizes[c];
+    pos = next + 1;
+    mask &= mask - 1;
+  }
+}
+
+// the vector loops return the input bytes they consumed or, for escaping,
+// the end of the output. The caller finishes the rest with the scalar code.
+// The escaped sizes are counted in bytes, each block adds at most 5 to one.
+constexpr int kBlocksPerCount = 51;
+
+#endif
+
+#if defined(DEBUGROUTER_KERNELS_SSE2)
+
+// the bytes of x below 0x20
+inline __m128i Sse2Control(__m128i x) {
+  return _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(0x1f)), x);
+}
+
+inline __m128i Sse2Escaped(__m128i x, __m128i control) {
+  return _mm_or_si128(control,
+                      _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('"')),
+                                   _mm_cmpeq_epi8(x, _mm_set1_epi8('\\'))));
+}
+
+// the control bytes written as \u00XX, \b \t \n \f \r are 8 to 13 but 11
+inline __m128i Sse2Unicode(__m128i x, __m128i control) {
+  __m128i offset = _mm_sub_epi8(x, _mm_set1_epi8('\b'));
+  __m128i named = _mm_andnot_si128(
+      _mm_cmpeq_epi8(x, _mm_set1_epi8(11)),
+      _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(5)), offset));
+  return _mm_andnot_si128(named, control);
+}
+
+size_t Sse2JsonEscapedSize(const uint8_t *data, size_t size, size_t &i) {
+  size_t escaped_size = 0;
+  while (i + 16 <= size) {
+    __m128i extra = _mm_setzero_si128();
+    for (int k = 0; k < kBlocksPerCount && i + 16 <= size; ++k, i += 16) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+      __m128i control = Sse2Control(x);
+      extra = _mm_sub_epi8(extra, Sse2Escaped(x, control));
+      extra = _mm_add_epi8(extra, _mm_and_si128(Sse2Unicode(x, control),
+                                                _mm_set1_epi8(4)));
+      escaped_size += 16;
+    }
+    __m128i sums = _mm_sad_epu8(extra, _mm_setzero_si128());
+    escaped_size += _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+  }
+  return escaped_size;
+}
+
+char *Sse2JsonEscape(const uint8_t *data, size_t size, size_t &i, char *out) {
+  for (; i + 16 <= size; i += 16) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    uint32_t escaped = _mm_movemask_epi8(Sse2Escaped(x, Sse2Control(x)));
+    if (escaped == 0) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out), x);
+      out += 16;
+    } else {
+      out = EscapeBlock(data, size, i, i + 16, escaped, 0, out);
+    }
+  }
+  return out;
+}
+
+#endif  // DEBUGROUTER_KERNELS_SSE2
+
+#if defined(DEBUGROUTER_KERNELS_AVX2)
+
+DEBUGROUTER_TARGET_AVX2 inline __m256i Avx2Control(__m256i x) {
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(0x1f)), x);
+}
+
+DEBUGROUTER_TARGET_AVX2 inline __m256i Avx2Escaped(__m256i x,
+                                                   __m256i control) {
+  return _mm256_or_si256(
+      control, _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('"')),
+                               _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\\'))));
+}
+
+DEBUGROUTER_TARGET_AVX2 inline __m256i Avx2Unicode(__m256i x,
+                                                   __m256i control) {
+  __m256i offset = _mm256_sub_epi8(x, _mm256_set1_epi8('\b'));
+  __m256i named = _mm256_andnot_si256(
+      _mm256_cmpeq_epi8(x, _mm256_set1_epi8(11)),
+      _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(5)), offset));
+  return _mm256_andnot_si256(named, control);
+}
+
+DEBUGROUTER_TARGET_AVX2 size_t Avx2JsonEscapedSize(const uint8_t *data,
+                                                   size_t size, size_t &i) {
+  size_t escaped_size = 0;
+  while (i + 32 <= size) {
+    __m256i extra = _mm256_setzero_si256();
+    for (int k = 0; k < kBlocksPerCount && i + 32 <= size; ++k, i += 32) {
+      __m256i x =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+      __m256i control = Avx2Control(x);
+      extra = _mm256_sub_epi8(extra, Avx2Escaped(x, control));
+      extra = _mm256_add_epi8(extra, _mm256_and_si256(Avx2Unicode(x, control),
+                                                      _mm256_set1_epi8(4)));
+      escaped_size += 32;
+    }
+    __m256i sums = _mm256_sad_epu8(extra, _mm256_setzero_si256());
+    __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums),
+                                 _mm256_extracti128_si256(sums, 1));
+    escaped_size += _mm_cvtsi128_si32(half) + _mm_extract_epi16(half, 4);
+  }
+  return escaped_size;
+}
+
+DEBUGROUTER_TARGET_AVX2 char *Avx2JsonEscape(const uint8_t *data, size_t size,
+                                             size_t &i, char *out) {
+  for (; i + 32 <= size; i += 32) {
+    __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    uint32_t escaped =
+        _mm256_movemask_epi8(Avx2Escaped(x, Avx2Control(x)));
+    if (escaped == 0) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), x);
+      out += 32;
+    } else {
+      out = EscapeBlock(data, size, i, i + 32, escaped, 0, out);
+    }
+  }
+  return out;
+}
+
+// the encoding of W. Mula and D. Lemire, "Faster Base64 Encoding and
+// Decoding using AVX2 Instructions": 24 bytes to 32 characters per step
+DEBUGROUTER_TARGET_AVX2 size_t Avx2Base64Encode(const uint8_t *data,
+                                                size_t size, char *out) {
+  // each 32-bit lane gets the bytes b a c b of a group of three
+  const __m256i shuffle = _mm256_setr_epi8(
+      1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5,
+      4, 7, 6, 8, 7, 10, 9, 11, 10);
+  // the offset to the character for 0-25, 26-51, 52-61, 62 and 63
+  const __m256i offsets = _mm256_setr_epi8(
+      65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0, 65, 71,
+      -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+  size_t i = 0;
+  // reads 28 bytes, the halves hold bytes [0, 12) and [12, 24)
+  for (; i + 28 <= size; i += 24) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    __m128i high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 12));
+    __m256i x = _mm256_shuffle_epi8(
+        _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1),
+        shuffle);
+    // the four 6-bit values of each lane
+    __m256i t0 = _mm256_mulhi_epu16(
+        _mm256_and_si256(x, _mm256_set1_epi32(0x0fc0fc00)),
+        _mm256_set1_epi32(0x04000040));
+    __m256i t1 = _mm256_mullo_epi16(
+        _mm256_and_si256(x, _mm256_set1_epi32(0x003f03f0)),
+        _mm256_set1_epi32(0x01000010));
+    __m256i values = _mm256_or_si256(t0, t1);
+    __m256i index = _mm256_subs_epu8(values, _mm256_set1_epi8(51));
+    index = _mm256_sub_epi8(
+        index, _mm256_cmpgt_epi8(values, _mm256_set1_epi8(25)));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(out),
+        _mm256_add_epi8(values, _mm256_shuffle_epi8(offsets, index)));
+    out += 32;
+  }
+  return i;
+}
+
+// 32 characters to 24 bytes per step. Stops before a step with characters
+// that are not base64, the scalar code then reports them.
+DEBUGROUTER_TARGET_AVX2 size_t Avx2Base64Decode(const uint8_t *data,
+                                                size_t size, char *out) {
+  // a character is valid if the bits of its low and high nibble do not meet
+  const __m256i low_bits = _mm256_setr_epi8(
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a,
+      0x1b, 0x1b, 0x1b, 0x1a, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+      0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  const __m256i high_bits = _mm256_setr_epi8(
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  // the offset to the value by high nibble, index 1 is for '/'
+  const __m256i offsets = _mm256_setr_epi8(
+      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4,
+      -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i slash = _mm256_set1_epi8(0x2f);
+  const __m256i pack = _mm256_setr_epi8(
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4,
+      10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    __m256i high_nibbles =
+        _mm256_and_si256(_mm256_srli_epi32(x, 4), slash);
+    __m256i low = _mm256_shuffle_epi8(low_bits, _mm256_and_si256(x, slash));
+    __m256i high = _mm256_shuffle_epi8(high_bits, high_nibbles);
+    if (!_mm256_testz_si256(low, high)) {
+      break;
+    }
+    __m256i values = _mm256_add_epi8(
+        x, _mm256_shuffle_epi8(
+               offsets, _mm256_add_epi8(_mm256_cmpeq_epi8(x, slash),
+                                        high_nibbles)));
+    // merge to 12 bits per 16 and 24 bits per 32, then pack 12 bytes a half
+    __m256i merged =
+        _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+    merged = _mm256_permutevar8x32_epi32(
+        _mm256_shuffle_epi8(merged, pack),
+        _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                     _mm256_castsi256_si128(merged));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out + 16),
+                     _mm256_extracti128_si256(merged, 1));
+    out += 24;
+  }
+  return i;
+}
+
+#endif  // DEBUGROUTER_KERNELS_AVX2
+
+#if defined(DEBUGROUTER_KERNELS_NEON)
+
+// 4 bits for each byte of a compare result
+inline uint64_t NeonMask(uint8x16_t bytes) {
+  return vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(bytes), 4)), 0);
+}
+
+inline uint8x16_t NeonControl(uint8x16_t x) {
+  return vcleq_u8(x, vdupq_n_u8(0x1f));
+}
+
+inline uint8x16_t NeonEscaped(uint8x16_t x, uint8x16_t control) {
+  return vorrq_u8(control, vorrq_u8(vceqq_u8(x, vdupq_n_u8('"')),
+                                    vceqq_u8(x, vdupq_n_u8('\\'))));
+}
+
+inline uint8x16_t NeonUnicode(uint8x16_t x, uint8x16_t control) {
+  uint8x16_t named =
+      vbicq_u8(vcleq_u8(vsubq_u8(x, vdupq_n_u8('\b')), vdupq_n_u8(5)),
+               vceqq_u8(x, vdupq_n_u8(11)));
+  return vbicq_u8(control, named);
+}
+
+size_t NeonJsonEscapedSize(const uint8_t *data, size_t size, size_t &i) {
+  size_t escaped_size = 0;
+  while (i + 16 <= size) {
+    uint8x16_t extra = vdupq_n_u8(0);
+    for (int k = 0; k < kBlocksPerCount && i + 16 <= size; ++k, i += 16) {
+      uint8x16_t x = vld1q_u8(data + i);
+      uint8x16_t control = NeonControl(x);
+      extra = vsubq_u8(extra, NeonEscaped(x, control));
+      extra = vaddq_u8(extra,
+                       vandq_u8(NeonUnicode(x, control), vdupq_n_u8(4)));
+      escaped_size += 16;
+    }
+    escaped_size += vaddlvq_u8(extra);
+  }
+  return escaped_size;
+}
+
+char *NeonJsonEscape(const uint8_t *data, size_t size, size_t &i, char *out) {
+  for (; i + 16 <= size; i += 16) {
+    uint8x16_t x = vld1q_u8(data + i);
+    uint64_t escaped = NeonMask(NeonEscaped(x, NeonControl(x)));
+    if (escaped == 0) {
+      vst1q_u8(reinterpret_cast<uint8_t *>(out), x);
+      out += 16;
+    } else {
+      // one bit of the 4 of each byte
+      out = EscapeBlock(data, size, i, i + 16,
+                        escaped & 0x1111111111111111ULL, 2, out);
+    }
+  }
+  return out;
+}
+
+// 48 bytes to 64 characters per step
+size_t NeonBase64Encode(const uint8_t *data, size_t size, char *out) {
+  const uint8_t *alphabet = reinterpret_cast<const uint8_t *>(kBase64Alphabet);
+  const uint8x16x4_t table = {{vld1q_u8(alphabet), vld1q_u8(alphabet + 16),
+                               vld1q_u8(alphabet + 32),
+                               vld1q_u8(alphabet + 48)}};
+  const uint8x16_t mask = vdupq_n_u8(0x3f);
+  size_t i = 0;
+  for (; i + 48 <= size; i += 48) {
+    uint8x16x3_t in = vld3q_u8(data + i);
+    uint8x16x4_t values;
+    values.val[0] = vshrq_n_u8(in.val[0], 2);
+    values.val[1] = vorrq_u8(vshrq_n_u8(in.val[1], 4),
+                             vandq_u8(vshlq_n_u8(in.val[0], 4), mask));
+    values.val[2] = vorrq_u8(vshrq_n_u8(in.val[2], 6),
+                             vandq_u8(vshlq_n_u8(in.val[1], 2), mask));
+    values.val[3] = vandq_u8(in.val[2], mask);
+    for (int k = 0; k < 4; ++k) {
+      values.val[k] = vqtbl4q_u8(table, values.val[k]);
+    }
+    vst4q_u8(reinterpret_cast<uint8_t *>(out), values);
+    out += 64;
+  }
+  return i;
+}
+
+// 64 characters to 48 bytes per step
+size_t NeonBase64Decode(const uint8_t *data, size_t size, char *out) {
+  const uint8_t *values = kBase64Values.data();
+  const uint8x16x4_t low_table = {{vld1q_u8(values), vld1q_u8(values + 16),
+                                   vld1q_u8(values + 32),
+                                   vld1q_u8(values + 48)}};
+  const uint8x16x4_t high_table = {{vld1q_u8(values + 64),
+                                    vld1q_u8(values + 80),
+                                    vld1q_u8(values + 96),
+                                    vld1q_u8(values + 112)}};
+  size_t i = 0;
+  for (; i + 64 <= size; i += 64) {
+    uint8x16x4_t in = vld4q_u8(data + i);
+    uint8x16_t invalid = vdupq_n_u8(0);
+    for (int k = 0; k < 4; ++k) {
+      // out of range indices look up 0, characters from 128 are caught by
+      // their high bit
+      uint8x16_t c = in.val[k];
+      in.val[k] =
+          vorrq_u8(vqtbl4q_u8(low_table, c),
+                   vqtbl4q_u8(high_table, vsubq_u8(c, vdupq_n_u8(64))));
+      invalid = vorrq_u8(invalid, vorrq_u8(c, in.val[k]));
+    }
+    if (vmaxvq_u8(invalid) & 0x80) {
+      break;
+    }
+    uint8x16x3_t bytes;
+    bytes.val[0] =
+        vorrq_u8(vshlq_n_u8(in.val[0], 2), vshrq_n_u8(in.val[1], 4));
+    bytes.val[1] =
+        vorrq_u8(vshlq_n_u8(in.val[1], 4), vshrq_n_u8(in.val[2], 2));
+    bytes.val[2] = vorrq_u8(vshlq_n_u8(in.val[2], 6), in.val[3]);
+    vst3q_u8(reinterpret_cast<uint8_t *>(out), bytes);
+    out += 48;
+  }
+  return i;
+}
+
+#endif  // DEBUGROUTER_KERNELS_NEON
+
+}  // namespace
+
+KernelLevel GetKernelLevel() {
+  return CurrentKernelLevel().load(std::memory_order_relaxed);
+}
+
+KernelLevel SetKernelLevel(KernelLevel level) {
+  if (level > BestKernelLevel()) {
+    level = BestKernelLevel();
+  }
+  return CurrentKernelLevel().exchange(level);
+}
+
+size_t JsonEscapedSize(std::string_view value) {
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(value.data());
+  size_t i = 0;
+  size_t escaped_size = 0;
+  [[maybe_unused]] KernelLevel level = GetKernelLevel();
+#if defined(DEBUGROUTER_KERNELS_AVX2)
+  if (level == KernelLevel::kAvx2) {
+    escaped_size += Avx2JsonEscapedSize(data, value.size(), i);
+  }
+#endif
+#if defined(DEBUGROUTER_KERNELS_SSE2)
+  if (level != KernelLevel::kScalar) {
+    escaped_size += Sse2JsonEscapedSize(data, value.size(), i);
+  }
+#elif defined(DEBUGROUTER_KERNELS_NEON)
+  if (level != KernelLevel::kScalar) {
+    escaped_size += NeonJsonEscapedSize(data, value.size(), i);
+  }
+#endif
+  return escaped_size + ScalarJsonEscapedSize(data + i, value.size() - i);
+}
+
+char *JsonEscape(std::string_view value, char *out) {
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(value.data());
+  size_t i = 0;
+  [[maybe_unused]] KernelLevel level = GetKernelLevel();
+#if defined(DEBUGROUTER_KERNELS_AVX2)
+  if (level == KernelLevel::kAvx2) {
+    out = Avx2JsonEscape(data, value.size(), i, out);
+  }
+#endif
+#if defined(DEBUGROUTER_KERNELS_SSE2)
+  if (level != KernelLevel::kScalar) {
+    out = Sse2JsonEscape(data, value.size(), i, out);
+  }
+#elif defined(DEBUGROUTER_KERNELS_NEON)
+  if (level != KernelLevel::kScalar) {
+    out = NeonJsonEscape(data, value.size(), i, out);
+  }
+#endif
+  return ScalarJsonEscape(data + i, value.size() - i, out);
+}
+
+size_t Base64EncodedSize(size_t size) { return (size + 2) / 3 * 4; }
+
+void Base64Encode(std::string_view data, std::string &out) {
+  size_t begin = out.size();
+  out.resize(begin + Base64EncodedSize(data.size()));
+  const uint8_t *src = reinterpret_cast<const uint8_t *>(data.data());
+  char *dst = &out[begin];
+  size_t i = 0;
+  [[maybe_unused]] KernelLevel level = GetKernelLevel();
+  // SSE2 has no byte shuffle, x86 without AVX2 uses the scalar code
+#if defined(DEBUGROUTER_KERNELS_AVX2)
+  if (level == KernelLevel::kAvx2) {
+    i = Avx2Base64Encode(src, data.size(), dst);
+  }
+#elif defined(DEBUGROUTER_KERNELS_NEON)
+  if (level != KernelLevel::kScalar) {
+    i = NeonBase64Encode(src, data.size(), dst);
+  }
+#endif
+  ScalarBase64Encode(src + i, data.size() - i, dst + i / 3 * 4);
+}
+
+bool Base64Decode(std::string_view data, std::string &out) {
+  if (data.size() % 4 != 0) {
+    return false;
+  }
+  if (data.empty()) {
+    return true;
+  }
+  const uint8_t *src = reinterpret_cast<const uint8_t *>(data.data());
+  size_t size = data.size();
+  size_t padding = 0;
+  if (src[size - 1] == '=') {
+    padding = src[size - 2] == '=' ? 2 : 1;
+  }
+  size_t begin = out.size();
+  out.resize(begin + size / 4 * 3 - padding);
+  char *dst = &out[begin];
+  // the last group may be padded
+  size_t body = size - 4;
+  size_t i = 0;
+  [[maybe_unused]] KernelLevel level = GetKernelLevel();
+#if defined(DEBUGROUTER_KERNELS_AVX2)
+  if (level == KernelLevel::kAvx2) {
+    i = Avx2Base64Decode(src, body, dst);
+  }
+#elif defined(DEBUGROUTER_KERNELS_NEON)
+  if (level != KernelLevel::kScalar) {
+    i = NeonBase64Decode(src, body, dst);
+  }
+#endif
+  bool valid = ScalarBase64Decode(src + i, body - i, dst + i / 4 * 3);
+  if (valid) {
+    uint8_t last[4] = {src[body], src[body + 1], 'A', 'A'};
+    for (size_t k = 2; k < 4 - padding; ++k) {
+      last[k] = src[body + k];
+    }
+    char bytes[3];
+    valid = ScalarBase64Decode(last, 4, bytes);
+    for (size_t k = 0; k < 3 - padding; ++k) {
+      dst[body / 4 * 3 + k] = bytes[k];
+    }
+  }
+  if (!valid) {
+    out.resize(begin);
+  }
+  return valid;
+}
+
+}  // namespace base
+}  // namespace debugrouter
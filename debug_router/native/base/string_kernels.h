@@ -0,0 +1,50 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_BASE_STRING_KERNELS_H_
+#define DEBUGROUTER_NATIVE_BASE_STRING_KERNELS_H_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace debugrouter {
+namespace base {
+
+/**
+ * Kernels for the large payloads of the send path: JSON string escaping and
+ * base64. They use SSE2 or AVX2 on x86, where AVX2 is detected at runtime,
+ * and NEON on arm64. Other targets use the scalar code.
+ */
+enum class KernelLevel {
+  kScalar,
+  // SSE2 on x86, NEON on arm64
+  kSimd,
+  kAvx2,
+};
+
+// the best level of this CPU, or the level set by SetKernelLevel
+KernelLevel GetKernelLevel();
+// uses at most level, e.g. to compare a path with the scalar one. Returns
+// the previous level.
+KernelLevel SetKernelLevel(KernelLevel level);
+
+// size of data escaped as the content of a JSON string, without quotes.
+// '"', '\\' and control characters are escaped like Json::Value does.
+size_t JsonEscapedSize(std::string_view data);
+// writes the escaped data to out, which holds JsonEscapedSize(data) bytes.
+// Returns the end of the written bytes.
+char *JsonEscape(std::string_view data, char *out);
+
+size_t Base64EncodedSize(size_t size);
+// appends the padded base64 of data to out
+void Base64Encode(std::string_view data, std::string &out);
+// appends the bytes of padded base64 data to out. False if data is not
+// base64, out is unchanged then.
+bool Base64Decode(std::string_view data, std::string &out);
+
+}  // namespace base
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_BASE_STRING_KERNELS_H_
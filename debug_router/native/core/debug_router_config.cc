@@ -4,6 +4,8 @@
 
 #include "debug_router/native/core/debug_router_config.h"
 
+#include <cstdlib>
+
 namespace debugrouter {
 namespace core {
 
@@ -25,6 +27,20 @@ std::string DebugRouterConfigs::GetConfig(const std::string& key,
   return value;
 }
 
+int64_t DebugRouterConfigs::GetIntConfig(const std::string& key,
+                                         int64_t default_value) {
+  std::string value = GetConfig(key);
+  if (value.empty()) {
+    return default_value;
+  }
+  char* end = nullptr;
+  long long result = std::strtoll(value.c_str(), &end, 10);
+  if (end == value.c_str() || *end != '\0' || result < 0) {
+    return default_value;
+  }
+  return static_cast<int64_t>(result);
+}
+
 void DebugRouterConfigs::SetConfig(const std::string& key,
                                    const std::string& value) {
   std::lock_guard<std::mutex> lock(mutex_);
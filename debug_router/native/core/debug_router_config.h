@@ -5,6 +5,7 @@
 #ifndef DEBUGROUTER_NATIVE_CORE_DEBUG_ROUTER_CONFIG_H_
 #define DEBUGROUTER_NATIVE_CORE_DEBUG_ROUTER_CONFIG_H_
 
+#include <cstdint>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -23,6 +24,9 @@ class DebugRouterConfigs {
   DebugRouterConfigs(const DebugRouterConfigs&) = delete;
   DebugRouterConfigs& operator=(const DebugRouterConfigs&) = delete;
   std::string GetConfig(const std::string& key, std::string default_value = "");
+  // returns default_value when the config is unset or not a non-negative
+  // decimal integer.
+  int64_t GetIntConfig(const std::string& key, int64_t default_value);
   void SetConfig(const std::string& key, const std::string& value);
 
  private:
@@ -4,6 +4,7 @@
 
 #include "debug_router/native/core/debug_router_core.h"
 
+#include <chrono>
 #include <mutex>
 
 #include "debug_router/native/base/no_destructor.h"
@@ -15,8 +16,10 @@
 #include "debug_router/native/log/logging.h"
 #include "debug_router/native/net/socket_server_client.h"
 #include "debug_router/native/net/websocket_client.h"
+#include "debug_router/native/processor/message_assembler.h"
 #include "debug_router/native/processor/message_handler.h"
 #include "debug_router/native/processor/processor.h"
+#include "debug_router/native/protocol/message_writer.h"
 #include "debug_router/native/thread/debug_router_executor.h"
 #include "debug_router_state_listener.h"
 #include "json/value.h"
@@ -24,6 +27,32 @@
 namespace debugrouter {
 
 namespace core {
+
+namespace {
+
+constexpr size_t kSessionDispatchThreads = 4;
+
+const char *kScreencastFrameMethod = "Page.screencastFrame";
+const char *kScreencastFrameAckMethod = "Page.screencastFrameAck";
+const char *kStartScreencastMethod = "Page.startScreencast";
+const char *kStopScreencastMethod = "Page.stopScreencast";
+// answered by the router itself, a debugger measures the round trip to the
+// device with it without waiting for a slot
+const char *kPingMethod = "DebugRouter.ping";
+
+size_t GetScreencastMaxFramesInFlight() {
+  return static_cast<size_t>(DebugRouterConfigs::GetInstance().GetIntConfig(
+      kScreencastMaxFramesInFlight, kDefaultScreencastMaxFramesInFlight));
+}
+
+std::chrono::milliseconds GetScreencastAckTimeout() {
+  return std::chrono::milliseconds(
+      DebugRouterConfigs::GetInstance().GetIntConfig(
+          kScreencastAckTimeoutMs, kDefaultScreencastAckTimeout.count()));
+}
+
+}  // namespace
+
 class MessageHandlerCore : public processor::MessageHandler {
  public:
   MessageHandlerCore() {}
@@ -42,10 +71,9 @@ class MessageHandlerCore : public processor::MessageHandler {
     const auto &slots = DebugRouterCore::GetInstance().slots_;
     if (!slots.empty()) {
       for (auto it = slots.begin(); it != slots.end(); ++it) {
-        Json::Value session_info;
-        session_info["type"] = it->second->GetType();
-        session_info["url"] = it->second->GetUrl();
-        session_list[it->first] = session_info.toStyledString();
+        session_list[it->first] = protocol::json::Write(protocol::json::Object(
+            protocol::json::Member(protocol::kKeyType, it->second->GetType()),
+            protocol::json::Member(protocol::kKeyUrl, it->second->GetUrl())));
       }
     }
     return session_list;
@@ -67,38 +95,28 @@ class MessageHandlerCore : public processor::MessageHandler {
   void OnMessage(const std::string &type, int session_id,
                  const std::string &message) override {
     if (session_id < 0) {
-      std::vector<DebugRouterGlobalHandler *> handlers;
-      {
-        std::shared_lock lock(
-            DebugRouterCore::GetInstance().global_handler_mutex_);
-        const auto &global_handler_map =
-            DebugRouterCore::GetInstance().global_handler_map_;
-        handlers.reserve(global_handler_map.size());
-        for (auto it : global_handler_map) {
-          handlers.push_back(it.second);
-        }
-      }
-      for (auto *handler : handlers) {
-        handler->OnMessage(message, type);
-      }
+      auto handlers = DebugRouterCore::GetInstance().global_handlers_.Load();
+      handlers->ForEachSubscriber(
+          session_id, type, [&](DebugRouterGlobalHandler *handler) {
+            handler->OnMessage(message, type);
+          });
       return;
     }
+    // sessions are dispatched in parallel, the messages of each in order
+    DebugRouterCore::GetInstance().session_strands_.Post(
+        session_id, [this, type, session_id, message]() {
+          DispatchSessionMessage(type, session_id, message);
+        });
+  }
 
+  void DispatchSessionMessage(const std::string &type, int session_id,
+                              const std::string &message) {
     {
-      std::vector<DebugRouterSessionHandler *> handlers;
-      {
-        std::shared_lock lock(
-            DebugRouterCore::GetInstance().session_handler_mutex_);
-        const auto &session_handler_map =
-            DebugRouterCore::GetInstance().session_handler_map_;
-        handlers.reserve(session_handler_map.size());
-        for (auto it : session_handler_map) {
-          handlers.push_back(it.second);
-        }
-      }
-      for (auto *handler : handlers) {
-        handler->OnMessage(message, type, session_id);
-      }
+      auto handlers = DebugRouterCore::GetInstance().session_handlers_.Load();
+      handlers->ForEachSubscriber(
+          session_id, type, [&](DebugRouterSessionHandler *handler) {
+            handler->OnMessage(message, type, session_id);
+          });
     }
 
     // Never hold slots_mutex_ while invoking app callbacks.
@@ -119,24 +137,16 @@ class MessageHandlerCore : public processor::MessageHandler {
   }
 
   void SendMessage(const std::string &message) override {
-    DebugRouterCore::GetInstance().Send(message);
+    // session lists and other messages of the router itself
+    OutboundMessage outbound(message);
+    outbound.priority = MessagePriority::kControl;
+    DebugRouterCore::GetInstance().Send(outbound);
   }
 
   void OpenCard(const std::string &url) override {
-    std::vector<DebugRouterGlobalHandler *> handlers;
-    {
-      std::shared_lock lock(
-          DebugRouterCore::GetInstance().global_handler_mutex_);
-      const auto &global_handler_map_ =
-          DebugRouterCore::GetInstance().global_handler_map_;
-      handlers.reserve(global_handler_map_.size());
-      for (auto it : global_handler_map_) {
-        handlers.push_back(it.second);
-      }
-    }
-    for (auto *handler : handlers) {
-      handler->OpenCard(url);
-    }
+    auto handlers = DebugRouterCore::GetInstance().global_handlers_.Load();
+    handlers->ForEach(
+        [&](DebugRouterGlobalHandler *handler) { handler->OpenCard(url); });
   }
 
   void ChangeRoomServer(const std::string &url,
@@ -145,6 +155,10 @@ class MessageHandlerCore : public processor::MessageHandler {
   }
 
   void ReportError(const std::string &error) override {}
+
+  bool EnableBinaryScreencast(bool enable) override {
+    return DebugRouterCore::GetInstance().EnableBinaryScreencast(enable);
+  }
 };
 
 DebugRouterCore &DebugRouterCore::GetInstance() {
@@ -158,9 +172,12 @@ DebugRouterCore::DebugRouterCore()
       max_session_id_(0),
       report_(nullptr),
       processor_(nullptr),
-      retry_times_(0),
+      reconnect_policy_(ExponentialBackoffReconnectPolicy::CreateFromConfigs()),
+      custom_reconnect_policy_(false),
       handler_count_(1),
-      is_first_connect_(UNINIT) {
+      is_first_connect_(UNINIT),
+      screencast_flow_control_(kDefaultScreencastMaxFramesInFlight),
+      session_strands_(kSessionDispatchThreads) {
 #if ENABLE_MESSAGE_IMPL
   size_t transceiver_count = 0;
   message_transceivers_[transceiver_count++] =
@@ -175,6 +192,37 @@ DebugRouterCore::DebugRouterCore()
   std::unique_ptr<processor::MessageHandler> handler =
       std::make_unique<MessageHandlerCore>();
   processor_ = std::make_unique<processor::Processor>(std::move(handler));
+  processor_->AddCdpMethodHandler(
+      kScreencastFrameAckMethod,
+      [this](int session_id, const std::string &message) {
+        if (session_id >= 0) {
+          OnScreencastFrameAck(session_id);
+        }
+        // still forwarded, slots may count acks themselves
+        return false;
+      });
+  // frames of a previous screencast are never acked
+  for (const char *method : {kStartScreencastMethod, kStopScreencastMethod}) {
+    processor_->AddCdpMethodHandler(
+        method, [this](int session_id, const std::string &message) {
+          screencast_flow_control_.RemoveSession(session_id);
+          return false;
+        });
+  }
+  processor_->AddCdpMethodHandler(
+      kPingMethod, [this](int session_id, const std::string &message) {
+        int64_t id = FindCdpId(message);
+        if (id < 0) {
+          return false;
+        }
+        SendData(protocol::json::Write(protocol::json::Object(
+                     protocol::json::Member("id", id),
+                     protocol::json::Member("result",
+                                            protocol::json::Object()))),
+                 protocol::kRemoteDebugProtocolBodyData4CDP, session_id, -1,
+                 true);
+        return true;
+      });
   thread::DebugRouterExecutor::GetInstance().Start();
 }
 
@@ -192,6 +240,7 @@ ConnectionState DebugRouterCore::GetConnectionState() {
 }
 
 void DebugRouterCore::Disconnect() {
+  CancelPendingReconnect();
   if (connection_state_.load(std::memory_order_relaxed) != DISCONNECTED) {
     LOGI("Disconnect");
     if (current_transceiver_) {
@@ -249,12 +298,10 @@ void DebugRouterCore::Connect(const std::string &url, const std::string &room,
   } else {
     LOGI("is_first_connect");
     is_first_connect_.store(FIRST_CONNECT);
-    retry_times_.store(0, std::memory_order_relaxed);
+    ResetReconnectPolicy();
     Report("Connect", catagary, "", "");
   }
 
-  LOGI(
-      "connect. retry times: " << retry_times_.load(std::memory_order_relaxed));
   Disconnect();
   connection_state_.store(CONNECTING, std::memory_order_relaxed);
   for (size_t i = 0; i < kTransceiverCount; ++i) {
@@ -269,7 +316,15 @@ void DebugRouterCore::Connect(const std::string &url, const std::string &room,
 
 void DebugRouterCore::Send(const std::string &message) {
   if (connection_state_.load(std::memory_order_relaxed) == CONNECTED) {
-    current_transceiver_->Send(message);
+    current_transceiver_->SendMessage(OutboundMessage(message));
+  }
+}
+
+void DebugRouterCore::Send(const OutboundMessage &message) {
+  if (connection_state_.load(std::memory_order_relaxed) == CONNECTED) {
+    current_transceiver_->SendMessage(message);
+  } else {
+    NotifyDropped(message);
   }
 }
 
@@ -282,9 +337,24 @@ void DebugRouterCore::SendAsync(const std::string &message) {
 
 void DebugRouterCore::SendData(const std::string &data, const std::string &type,
                                int32_t session, int32_t mark, bool is_object) {
+  SendDataInternal(data, type, session, mark, is_object, std::nullopt);
+}
+
+void DebugRouterCore::SendData(const std::string &data, const std::string &type,
+                               int32_t session, int32_t mark, bool is_object,
+                               MessagePriority priority) {
+  SendDataInternal(data, type, session, mark, is_object, priority);
+}
+
+void DebugRouterCore::SendDataInternal(
+    const std::string &data, const std::string &type, int32_t session,
+    int32_t mark, bool is_object, std::optional<MessagePriority> priority) {
   if (connection_state_.load(std::memory_order_relaxed) == CONNECTED) {
-    std::string message =
-        processor_->WrapCustomizedMessage(type, session, data, mark, is_object);
+    OutboundMessage message =
+        processor_->WrapOutboundMessage(type, session, data, mark, is_object);
+    if (priority) {
+      message.priority = *priority;
+    }
     Send(message);
   }
 }
@@ -292,11 +362,141 @@ void DebugRouterCore::SendData(const std::string &data, const std::string &type,
 void DebugRouterCore::SendDataAsync(const std::string &data,
                                     const std::string &type, int32_t session,
                                     int32_t mark, bool is_object) {
+  SendDataAsyncInternal(data, type, session, mark, is_object, std::nullopt);
+}
+
+void DebugRouterCore::SendDataAsync(const std::string &data,
+                                    const std::string &type, int32_t session,
+                                    int32_t mark, bool is_object,
+                                    MessagePriority priority) {
+  SendDataAsyncInternal(data, type, session, mark, is_object, priority);
+}
+
+void DebugRouterCore::SendDataAsyncInternal(
+    const std::string &data, const std::string &type, int32_t session,
+    int32_t mark, bool is_object, std::optional<MessagePriority> priority) {
   if (connection_state_.load(std::memory_order_relaxed) != CONNECTED) {
     return;
   }
-  thread::DebugRouterExecutor::GetInstance().Post(
-      [=]() { SendData(data, type, session, mark, is_object); });
+  if (type == protocol::kRemoteDebugProtocolBodyData4CDP && mark < 0 &&
+      !is_object && FindCdpMethod(data) == kScreencastFrameMethod) {
+    // frames assembled by the platforms
+    ScreencastFrame frame;
+    frame.data = data;
+    SubmitScreencastFrame(session, std::move(frame));
+    return;
+  }
+  thread::DebugRouterExecutor::GetInstance().Post([=]() {
+    SendDataInternal(data, type, session, mark, is_object, priority);
+  });
+}
+
+void DebugRouterCore::SendScreenCast(
+    int32_t session, const std::string &image,
+    const std::unordered_map<std::string, float> &metadata) {
+  if (connection_state_.load(std::memory_order_relaxed) == CONNECTED) {
+    Send(processor_->WrapScreencastFrame(
+        session, image, metadata,
+        binary_screencast_enabled_.load(std::memory_order_relaxed)));
+  }
+}
+
+void DebugRouterCore::SendScreenCastAsync(
+    int32_t session, std::string image,
+    std::unordered_map<std::string, float> metadata) {
+  if (connection_state_.load(std::memory_order_relaxed) != CONNECTED) {
+    return;
+  }
+  // the image is moved, not copied, to the executor
+  ScreencastFrame frame;
+  frame.kind = ScreencastFrame::Kind::kImage;
+  frame.data = std::move(image);
+  frame.metadata = std::move(metadata);
+  SubmitScreencastFrame(session, std::move(frame));
+}
+
+void DebugRouterCore::SendScreenCastDataAsync(
+    int32_t session, std::string data,
+    std::unordered_map<std::string, float> metadata) {
+  if (connection_state_.load(std::memory_order_relaxed) != CONNECTED) {
+    return;
+  }
+  ScreencastFrame frame;
+  frame.kind = ScreencastFrame::Kind::kData;
+  frame.data = std::move(data);
+  frame.metadata = std::move(metadata);
+  SubmitScreencastFrame(session, std::move(frame));
+}
+
+void DebugRouterCore::SubmitScreencastFrame(int32_t session,
+                                            ScreencastFrame frame) {
+  if (screencast_flow_control_.Submit(session, std::move(frame))) {
+    thread::DebugRouterExecutor::GetInstance().Post(
+        [this, session]() { SendScreencastFrame(session); });
+  }
+}
+
+void DebugRouterCore::SendScreencastFrame(int32_t session) {
+  ScreencastFrame frame;
+  if (!screencast_flow_control_.TakeFrame(session, frame)) {
+    return;
+  }
+  OutboundMessage message;
+  if (frame.kind == ScreencastFrame::Kind::kImage) {
+    message = processor_->WrapScreencastFrame(
+        session, frame.data, frame.metadata,
+        binary_screencast_enabled_.load(std::memory_order_relaxed));
+  } else if (frame.kind == ScreencastFrame::Kind::kData) {
+    message = processor_->WrapOutboundMessage(
+        protocol::kRemoteDebugProtocolBodyData4CDP, session,
+        processor::MessageAssembler::AssembleScreenCastFrame(
+            session, frame.data, frame.metadata),
+        -1, false);
+  } else {
+    message = processor_->WrapOutboundMessage(
+        protocol::kRemoteDebugProtocolBodyData4CDP, session, frame.data, -1,
+        false);
+  }
+  // a frame the transport drops is never acked, its slot is released
+  message.on_dropped = [this, session]() {
+    if (screencast_flow_control_.OnDropped(session)) {
+      thread::DebugRouterExecutor::GetInstance().Post(
+          [this, session]() { SendScreencastFrame(session); });
+    }
+  };
+  Send(message);
+}
+
+void DebugRouterCore::OnScreencastFrameAck(int32_t session) {
+  if (screencast_flow_control_.OnAck(session)) {
+    thread::DebugRouterExecutor::GetInstance().Post(
+        [this, session]() { SendScreencastFrame(session); });
+  }
+}
+
+void DebugRouterCore::AddCdpMethodHandler(
+    const std::string &method, processor::CdpMethodHandler handler) {
+  processor_->AddCdpMethodHandler(method, std::move(handler));
+}
+
+bool DebugRouterCore::RemoveCdpMethodHandler(const std::string &method) {
+  return processor_->RemoveCdpMethodHandler(method);
+}
+
+processor::CdpRouteStats DebugRouterCore::GetCdpRouteStats() {
+  return processor_->GetCdpRouteStats();
+}
+
+ScreencastStats DebugRouterCore::GetScreencastStats() {
+  return screencast_flow_control_.GetStats();
+}
+
+bool DebugRouterCore::EnableBinaryScreencast(bool enable) {
+  std::shared_ptr<MessageTransceiver> transceiver = current_transceiver_;
+  bool enabled =
+      enable && transceiver && transceiver->SupportsBinaryMessages();
+  binary_screencast_enabled_.store(enabled, std::memory_order_relaxed);
+  return enabled;
 }
 
 int32_t DebugRouterCore::Plug(const std::shared_ptr<core::NativeSlot> &slot) {
@@ -311,17 +511,10 @@ int32_t DebugRouterCore::Plug(const std::shared_ptr<core::NativeSlot> &slot) {
   }
   NotifyConnectStateByMessage(GetConnectionState());
   {
-    std::vector<DebugRouterSessionHandler *> handlers;
-    {
-      std::shared_lock lock(session_handler_mutex_);
-      handlers.reserve(session_handler_map_.size());
-      for (auto it : session_handler_map_) {
-        handlers.push_back(it.second);
-      }
-    }
-    for (auto *handler : handlers) {
+    auto handlers = session_handlers_.Load();
+    handlers->ForEach([&](DebugRouterSessionHandler *handler) {
       handler->OnSessionCreate(max_session_id_, slot->GetUrl());
-    }
+    });
   }
   return max_session_id_;
 }
@@ -332,6 +525,7 @@ int32_t DebugRouterCore::GetUSBPort() {
 
 void DebugRouterCore::Pull(int32_t session_id_) {
   LOGI("pull session: " << session_id_);
+  screencast_flow_control_.RemoveSession(session_id_);
   bool stop_server = false;
   if (!enable_all_sessions_.load(std::memory_order_relaxed)) {
     {
@@ -366,17 +560,10 @@ void DebugRouterCore::Pull(int32_t session_id_) {
     processor_->FlushSessionList();
   }
   {
-    std::vector<DebugRouterSessionHandler *> handlers;
-    {
-      std::shared_lock lock(session_handler_mutex_);
-      handlers.reserve(session_handler_map_.size());
-      for (auto it : session_handler_map_) {
-        handlers.push_back(it.second);
-      }
-    }
-    for (auto *handler : handlers) {
+    auto handlers = session_handlers_.Load();
+    handlers->ForEach([&](DebugRouterSessionHandler *handler) {
       handler->OnSessionDestroy(session_id_);
-    }
+    });
   }
 }
 
@@ -415,9 +602,32 @@ void DebugRouterCore::OnOpen(
   }
   LOGI("DebugRouterCore: onOpen.");
   current_transceiver_ = transceiver;
+  // a new debugger has to enable binary messages again
+  binary_screencast_enabled_.store(false, std::memory_order_relaxed);
+  screencast_flow_control_.Reset(GetScreencastMaxFramesInFlight(),
+                                  GetScreencastAckTimeout());
+  screencast_flow_control_.SetSkipDuplicates(
+      DebugRouterConfigs::GetInstance().GetConfig(kScreencastSkipDuplicates,
+                                                  "true") != "false",
+      std::chrono::milliseconds(DebugRouterConfigs::GetInstance().GetIntConfig(
+          kScreencastKeepAliveMs, 0)));
   connection_state_.store(CONNECTED, std::memory_order_relaxed);
   NotifyConnectStateByMessage(CONNECTED);
   ConnectionType connect_type = current_transceiver_->GetType();
+  {
+    ReconnectDecision decision;
+    std::chrono::milliseconds elapsed(0);
+    {
+      std::lock_guard<std::mutex> lock(reconnect_mutex_);
+      reconnect_task_.Cancel();
+      decision.attempt = reconnect_policy_->GetAttempts();
+      elapsed = reconnect_policy_->GetElapsed(ReconnectClock::now());
+      reconnect_policy_->OnConnected();
+    }
+    if (decision.attempt > 0) {
+      ReportReconnect("ReconnectSuccess", decision, elapsed);
+    }
+  }
   if (connect_type == ConnectionType::kUsb) {
     host_url_ = "";
     server_url_ = "";
@@ -441,13 +651,8 @@ void DebugRouterCore::OnOpen(
     Report("OnOpen", catagary, "", "");
   }
 
-  std::vector<std::shared_ptr<DebugRouterStateListener>> listeners;
-  {
-    std::shared_lock lock(state_listeners_mutex_);
-    listeners = state_listeners_;
-  }
-
-  for (const auto &listener : listeners) {
+  std::shared_ptr<const StateListeners> listeners = state_listeners_.Load();
+  for (const auto &listener : *listeners) {
     LOGI("do state_listeners_ onopen.");
     listener->OnOpen(connect_type);
   }
@@ -463,21 +668,11 @@ void DebugRouterCore::OnClosed(
   connection_state_.store(DISCONNECTED, std::memory_order_relaxed);
   current_transceiver_ = nullptr;
   NotifyConnectStateByMessage(DISCONNECTED);
-  if (transceiver->GetType() == ConnectionType::kUsb ||
-      (transceiver->GetType() == ConnectionType::kWebSocket &&
-       retry_times_.load(std::memory_order_relaxed) >= 3)) {
-    std::vector<std::shared_ptr<DebugRouterStateListener>> listeners;
-    {
-      std::shared_lock lock(state_listeners_mutex_);
-      listeners = state_listeners_;
-    }
-
-    for (const auto &listener : listeners) {
-      LOGI("do state_listeners_ onclose.");
-      listener->OnClose(-1, "unknown reason");
-    }
-  }
+  // frames waiting for this connection are not sent to the next one
+  screencast_flow_control_.Reset(GetScreencastMaxFramesInFlight(),
+                                  GetScreencastAckTimeout());
 
+  bool reconnecting = false;
   if (transceiver->GetType() == ConnectionType::kWebSocket) {
     if (current_transceiver_ == nullptr ||
         current_transceiver_->GetType() == ConnectionType::kWebSocket) {
@@ -485,10 +680,18 @@ void DebugRouterCore::OnClosed(
           kForbidReconnectWhenClose, "false");
       if (result == "true") {
         LOGI("onClosed: forbid reconnect");
-        return;
+      } else {
+        LOGI("onClosed: try to reconnect");
+        reconnecting = TryToReconnect();
       }
-      LOGI("onClosed: try to reconnect");
-      TryToReconnect();
+    }
+  }
+
+  if (!reconnecting) {
+    std::shared_ptr<const StateListeners> listeners = state_listeners_.Load();
+    for (const auto &listener : *listeners) {
+      LOGI("do state_listeners_ onclose.");
+      listener->OnClose(-1, "unknown reason");
     }
   }
 }
@@ -535,29 +738,23 @@ void DebugRouterCore::OnFailure(
   current_transceiver_ = nullptr;
   NotifyConnectStateByMessage(DISCONNECTED);
 
-  if (transceiver->GetType() == ConnectionType::kUsb ||
-      (transceiver->GetType() == ConnectionType::kWebSocket &&
-       retry_times_.load(std::memory_order_relaxed) >= 3)) {
-    std::vector<std::shared_ptr<DebugRouterStateListener>> listeners;
-    {
-      std::shared_lock lock(state_listeners_mutex_);
-      listeners = state_listeners_;
+  bool reconnecting = false;
+  if (transceiver->GetType() == ConnectionType::kWebSocket) {
+    if (current_transceiver_ == nullptr ||
+        current_transceiver_->GetType() == ConnectionType::kWebSocket) {
+      LOGI("onFailure: try to reconnect");
+      reconnecting = TryToReconnect();
     }
+  }
 
-    for (const auto &listener : listeners) {
+  if (!reconnecting) {
+    std::shared_ptr<const StateListeners> listeners = state_listeners_.Load();
+    for (const auto &listener : *listeners) {
       // TODO(zhoumingsong.smile): add more details
       LOGI("do state_listeners_ onfailure.");
       listener->OnError(error_message);
     }
   }
-
-  if (transceiver->GetType() == ConnectionType::kWebSocket) {
-    if (current_transceiver_ == nullptr ||
-        current_transceiver_->GetType() == ConnectionType::kWebSocket) {
-      LOGI("onFailure: try to reconnect");
-      TryToReconnect();
-    }
-  }
 }
 
 void DebugRouterCore::OnMessage(
@@ -568,14 +765,24 @@ void DebugRouterCore::OnMessage(
   }
   LOGI("DebugRouter OnMessage.");
   processor_->Process(message);
+  NotifyMessage(message);
+}
 
-  std::vector<std::shared_ptr<DebugRouterStateListener>> listeners;
-  {
-    std::shared_lock lock(state_listeners_mutex_);
-    listeners = state_listeners_;
+void DebugRouterCore::OnParsedMessage(
+    const std::string &message, const protocol::MessageEnvelope &envelope,
+    const std::string &payload,
+    const std::shared_ptr<MessageTransceiver> &transceiver) {
+  if (transceiver != current_transceiver_) {
+    return;
   }
+  LOGI("DebugRouter OnMessage.");
+  processor_->Process(message, envelope, payload);
+  NotifyMessage(message);
+}
 
-  for (const auto &listener : listeners) {
+void DebugRouterCore::NotifyMessage(const std::string &message) {
+  std::shared_ptr<const StateListeners> listeners = state_listeners_.Load();
+  for (const auto &listener : *listeners) {
     listener->OnMessage(message);
   }
 }
@@ -585,26 +792,55 @@ DebugRouterCore::~DebugRouterCore() {
   // It's not a good way to do this
 }
 
-int DebugRouterCore::AddGlobalHandler(DebugRouterGlobalHandler *handler) {
-  std::unique_lock lock(global_handler_mutex_);
-  for (auto key : global_handler_map_) {
-    if (key.second == handler) {
-      return key.first;
+namespace {
+
+// returns the id of handler, added with a new id if needed
+template <typename Handler>
+int AddHandler(base::CopyOnWrite<HandlerIndex<Handler>> &handlers,
+               Handler *handler, HandlerSubscription subscription,
+               std::atomic<int> &handler_count) {
+  int handler_id = 0;
+  handlers.Update([&](HandlerIndex<Handler> &index) {
+    handler_id = index.Find(handler);
+    if (handler_id != 0) {
+      return false;
     }
-  }
-  int handler_id = handler_count_.fetch_add(1, std::memory_order_relaxed);
-  global_handler_map_[handler_id] = handler;
+    handler_id = handler_count.fetch_add(1, std::memory_order_relaxed);
+    index.Add(handler_id, handler, std::move(subscription));
+    return true;
+  });
   return handler_id;
 }
 
+template <typename Handler>
+bool RemoveHandler(base::CopyOnWrite<HandlerIndex<Handler>> &handlers,
+                   int handler_id) {
+  bool removed = false;
+  handlers.Update([&](HandlerIndex<Handler> &index) {
+    removed = index.Remove(handler_id);
+    return removed;
+  });
+  return removed;
+}
+
+}  // namespace
+
+int DebugRouterCore::AddGlobalHandler(DebugRouterGlobalHandler *handler) {
+  return AddHandler(global_handlers_, handler, HandlerSubscription(),
+                    handler_count_);
+}
+
+int DebugRouterCore::AddGlobalHandler(
+    DebugRouterGlobalHandler *handler,
+    const std::unordered_set<std::string> &types) {
+  HandlerSubscription subscription;
+  subscription.types = types;
+  return AddHandler(global_handlers_, handler, std::move(subscription),
+                    handler_count_);
+}
+
 bool DebugRouterCore::RemoveGlobalHandler(int handler_id) {
-  std::unique_lock lock(global_handler_mutex_);
-  auto it = global_handler_map_.find(handler_id);
-  if (it != global_handler_map_.end()) {
-    global_handler_map_.erase(it);
-    return true;
-  }
-  return false;
+  return RemoveHandler(global_handlers_, handler_id);
 }
 
 void DebugRouterCore::AddMessageHandler(DebugRouterMessageHandler *handler) {
@@ -626,25 +862,18 @@ bool DebugRouterCore::RemoveMessageHandler(const std::string &handler_name) {
 }
 
 int DebugRouterCore::AddSessionHandler(DebugRouterSessionHandler *handler) {
-  std::unique_lock lock(session_handler_mutex_);
-  for (auto key : session_handler_map_) {
-    if (key.second == handler) {
-      return key.first;
-    }
-  }
-  int handler_id = handler_count_.fetch_add(1, std::memory_order_relaxed);
-  session_handler_map_[handler_id] = handler;
-  return handler_id;
+  return AddHandler(session_handlers_, handler, HandlerSubscription(),
+                    handler_count_);
+}
+
+int DebugRouterCore::AddSessionHandler(
+    DebugRouterSessionHandler *handler,
+    const HandlerSubscription &subscription) {
+  return AddHandler(session_handlers_, handler, subscription, handler_count_);
 }
 
 bool DebugRouterCore::RemoveSessionHandler(int handler_id) {
-  std::unique_lock lock(session_handler_mutex_);
-  auto it = session_handler_map_.find(handler_id);
-  if (it != session_handler_map_.end()) {
-    session_handler_map_.erase(it);
-    return true;
-  }
-  return false;
+  return RemoveHandler(session_handlers_, handler_id);
 }
 
 bool DebugRouterCore::IsValidSchema(const std::string &schema) {
@@ -741,20 +970,107 @@ void DebugRouterCore::AddStateListener(
   if (listener == nullptr) {
     return;
   }
-  std::unique_lock lock(state_listeners_mutex_);
-  state_listeners_.push_back(listener);
+  state_listeners_.Update([&](StateListeners &listeners) {
+    listeners.push_back(listener);
+    return true;
+  });
+}
+
+bool DebugRouterCore::TryToReconnect() {
+  auto now = ReconnectClock::now();
+  ReconnectDecision decision;
+  std::chrono::milliseconds elapsed(0);
+  bool fallback = false;
+  {
+    std::lock_guard<std::mutex> lock(reconnect_mutex_);
+    reconnect_task_.Cancel();
+    decision = reconnect_policy_->OnDisconnected(now);
+    elapsed = reconnect_policy_->GetElapsed(now);
+    // the retry budget is spent, a debugger can still reach us through usb.
+    // keep probing the websocket anyway, nothing re-arms it later.
+    fallback = decision.should_retry && decision.probe > 0 &&
+               IsUsbListening();
+    if (decision.should_retry) {
+      reconnect_task_ = thread::DebugRouterExecutor::GetInstance().PostDelayed(
+          [this]() { Reconnect(); }, decision.delay);
+    }
+  }
+
+  if (fallback) {
+    LOGI("reconnect budget exhausted, wait for usb connection, probe in "
+         << decision.delay.count() << "ms.");
+    ReportReconnect("ReconnectFallback", decision, elapsed);
+  } else if (!decision.should_retry) {
+    LOGI("reconnect budget exhausted, give up.");
+    ReportReconnect("ReconnectGiveUp", decision, elapsed);
+  } else if (decision.budget_exhausted) {
+    LOGI("reconnect budget exhausted, probe in " << decision.delay.count()
+                                                 << "ms.");
+    ReportReconnect("ReconnectCircuitOpen", decision, elapsed);
+  } else if (decision.probe > 0) {
+    LOGI("reconnect probe " << decision.probe << " in "
+                            << decision.delay.count() << "ms.");
+    ReportReconnect("ReconnectProbe", decision, elapsed);
+  } else {
+    LOGI("try to reconnect: " << decision.attempt << " in "
+                              << decision.delay.count() << "ms.");
+    ReportReconnect("ReconnectAttempt", decision, elapsed);
+  }
+  return decision.should_retry && !fallback && !decision.budget_exhausted;
 }
 
-void DebugRouterCore::TryToReconnect() {
-  if (retry_times_.load(std::memory_order_relaxed) < 3) {
-    retry_times_.fetch_add(1);
-    LOGI("try to reconnect: " << retry_times_.load(std::memory_order_relaxed));
+void DebugRouterCore::CancelPendingReconnect() {
+  std::lock_guard<std::mutex> lock(reconnect_mutex_);
+  reconnect_task_.Cancel();
+  reconnect_task_ = thread::TaskHandle();
+}
 
-    thread::DebugRouterExecutor::GetInstance().Post([=]() {
-      std::this_thread::sleep_for(std::chrono::milliseconds(2000));
-      Reconnect();
-    });
+void DebugRouterCore::ResetReconnectPolicy() {
+  std::lock_guard<std::mutex> lock(reconnect_mutex_);
+  if (custom_reconnect_policy_) {
+    reconnect_policy_->Reset();
+  } else {
+    // pick up changes of DebugRouterConfigs
+    reconnect_policy_ = ExponentialBackoffReconnectPolicy::CreateFromConfigs();
+  }
+}
+
+void DebugRouterCore::SetReconnectPolicy(
+    std::unique_ptr<ReconnectPolicy> policy) {
+  std::lock_guard<std::mutex> lock(reconnect_mutex_);
+  custom_reconnect_policy_ = (policy != nullptr);
+  if (policy) {
+    reconnect_policy_ = std::move(policy);
+  } else {
+    reconnect_policy_ = ExponentialBackoffReconnectPolicy::CreateFromConfigs();
+  }
+}
+
+bool DebugRouterCore::IsUsbListening() {
+  for (size_t i = 0; i < kTransceiverCount; ++i) {
+    if (message_transceivers_[i]->GetType() == ConnectionType::kUsb &&
+        message_transceivers_[i]->IsListening()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void DebugRouterCore::ReportReconnect(const std::string &event_name,
+                                      const ReconnectDecision &decision,
+                                      std::chrono::milliseconds elapsed) {
+  Json::Value catagaryJson;
+  catagaryJson["connect_type"] = "websocket";
+  catagaryJson["url"] = server_url_;
+  catagaryJson["attempt"] = decision.attempt;
+  if (decision.probe > 0) {
+    catagaryJson["probe"] = decision.probe;
   }
+  Json::Value metricJson;
+  metricJson["delay_ms"] = static_cast<Json::Int64>(decision.delay.count());
+  metricJson["elapsed_ms"] = static_cast<Json::Int64>(elapsed.count());
+  Report(event_name, catagaryJson.toStyledString(),
+         metricJson.toStyledString(), "");
 }
 
 bool DebugRouterCore::IsConnected() {
@@ -10,24 +10,29 @@
 #include <cstdint>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <shared_mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "debug_router/native/base/copy_on_write.h"
 #include "debug_router/native/core/debug_router_global_handler.h"
 #include "debug_router/native/core/debug_router_message_handler.h"
 #include "debug_router/native/core/debug_router_session_handler.h"
 #include "debug_router/native/core/debug_router_state_listener.h"
+#include "debug_router/native/core/handler_index.h"
 #include "debug_router/native/core/message_transceiver.h"
 #include "debug_router/native/core/native_slot.h"
+#include "debug_router/native/core/reconnect_policy.h"
+#include "debug_router/native/core/screencast_flow_control.h"
+#include "debug_router/native/processor/cdp_method_router.h"
 #include "debug_router/native/report/debug_router_native_report.h"
+#include "debug_router/native/thread/debug_router_executor.h"
+#include "debug_router/native/thread/strand_pool.h"
 
 namespace debugrouter {
-namespace thread {
-class DebugRouterExecutor;
-}
 namespace processor {
 class Processor;
 }
@@ -48,6 +53,9 @@ typedef enum {
 
 class DebugRouterSlot;
 
+using StateListeners =
+    std::vector<std::shared_ptr<core::DebugRouterStateListener>>;
+
 #if ENABLE_MESSAGE_IMPL
 static constexpr size_t kTransceiverCount = 2;
 #else
@@ -74,6 +82,10 @@ class DebugRouterCore : public MessageTransceiverDelegate {
   virtual void OnMessage(
       const std::string &message,
       const std::shared_ptr<MessageTransceiver> &transceiver) override;
+  virtual void OnParsedMessage(
+      const std::string &message, const protocol::MessageEnvelope &envelope,
+      const std::string &payload,
+      const std::shared_ptr<MessageTransceiver> &transceiver) override;
 
   virtual void OnInit(const std::shared_ptr<MessageTransceiver> &transceiver,
                       int32_t code, const std::string &info) override;
@@ -85,14 +97,45 @@ class DebugRouterCore : public MessageTransceiverDelegate {
   void DisconnectAsync();
 
   void Send(const std::string &message);
+  void Send(const OutboundMessage &message);
 
   void SendAsync(const std::string &message);
 
+  // the priority of the message is derived from its type and method, see
+  // GetDefaultPriority
   void SendData(const std::string &data, const std::string &type,
                 int32_t session, int32_t mark, bool is_object);
+  void SendData(const std::string &data, const std::string &type,
+                int32_t session, int32_t mark, bool is_object,
+                MessagePriority priority);
 
   void SendDataAsync(const std::string &data, const std::string &type,
                      int32_t session, int32_t mark, bool is_object);
+  void SendDataAsync(const std::string &data, const std::string &type,
+                     int32_t session, int32_t mark, bool is_object,
+                     MessagePriority priority);
+
+  // sends a Page.screencastFrame of an encoded image, as a binary message if
+  // the debugger enabled them on the current connection
+  void SendScreenCast(int32_t session, const std::string &image,
+                      const std::unordered_map<std::string, float> &metadata);
+  void SendScreenCastAsync(int32_t session, std::string image,
+                           std::unordered_map<std::string, float> metadata);
+  // data is the base64 image of a Page.screencastFrame. Frames that repeat
+  // the previous frame of their session are not assembled nor sent.
+  void SendScreenCastDataAsync(int32_t session, std::string data,
+                               std::unordered_map<std::string, float> metadata);
+  // returns whether binary screencast frames are sent from now on
+  bool EnableBinaryScreencast(bool enable);
+  // frames sent, acked, replaced by a newer frame, dropped and lost
+  ScreencastStats GetScreencastStats();
+
+  // handler answers the CDP messages of method before they are forwarded to
+  // slots, on the thread that received them
+  void AddCdpMethodHandler(const std::string &method,
+                           processor::CdpMethodHandler handler);
+  bool RemoveCdpMethodHandler(const std::string &method);
+  processor::CdpRouteStats GetCdpRouteStats();
 
   int32_t Plug(const std::shared_ptr<core::NativeSlot> &slot);
 
@@ -109,12 +152,20 @@ class DebugRouterCore : public MessageTransceiverDelegate {
               const std::string &metric, const std::string &extra);
 
   int AddGlobalHandler(DebugRouterGlobalHandler *handler);
+  // handler only receives global messages of types, an empty set receives
+  // all of them. Adding a handler again returns its id and keeps its types.
+  int AddGlobalHandler(DebugRouterGlobalHandler *handler,
+                       const std::unordered_set<std::string> &types);
   bool RemoveGlobalHandler(int handler_id);
 
   void AddMessageHandler(DebugRouterMessageHandler *handler);
   bool RemoveMessageHandler(const std::string &handler_name);
 
   int AddSessionHandler(DebugRouterSessionHandler *handler);
+  // handler only receives the messages subscription matches, sessions are
+  // created and destroyed for every handler
+  int AddSessionHandler(DebugRouterSessionHandler *handler,
+                        const HandlerSubscription &subscription);
   bool RemoveSessionHandler(int handler_id);
 
   bool IsValidSchema(const std::string &schema);
@@ -135,6 +186,10 @@ class DebugRouterCore : public MessageTransceiverDelegate {
   void AddStateListener(
       const std::shared_ptr<core::DebugRouterStateListener> &listener);
 
+  // replace the reconnect policy built from DebugRouterConfigs, nullptr
+  // restores it.
+  void SetReconnectPolicy(std::unique_ptr<ReconnectPolicy> policy);
+
   // these two methods are conflictive, only one of them can be enabled
   void EnableAllSessions();
   // for online debug, could only debug needed sessions, work with
@@ -153,9 +208,6 @@ class DebugRouterCore : public MessageTransceiverDelegate {
 
  protected:
   std::shared_mutex slots_mutex_;
-  std::shared_mutex state_listeners_mutex_;
-  std::shared_mutex global_handler_mutex_;
-  std::shared_mutex session_handler_mutex_;
   friend class MessageHandlerCore;
   std::unordered_map<int32_t, std::shared_ptr<core::NativeSlot> > slots_;
   std::string room_id_;
@@ -165,10 +217,9 @@ class DebugRouterCore : public MessageTransceiverDelegate {
       message_handlers_;
   std::unordered_map<std::string, std::string> app_info_;
 
-  // for add global handler and session handler, judge if handler is valid
-  // for remove global handler and session handler
-  std::unordered_map<int, DebugRouterGlobalHandler *> global_handler_map_;
-  std::unordered_map<int, DebugRouterSessionHandler *> session_handler_map_;
+  // read for every message without a lock, added and removed by copying
+  base::CopyOnWrite<HandlerIndex<DebugRouterGlobalHandler>> global_handlers_;
+  base::CopyOnWrite<HandlerIndex<DebugRouterSessionHandler>> session_handlers_;
 
  private:
   void Reconnect();
@@ -181,16 +232,48 @@ class DebugRouterCore : public MessageTransceiverDelegate {
   int32_t max_session_id_;
   std::unique_ptr<report::DebugRouterNativeReport> report_;
   std::unique_ptr<debugrouter::processor::Processor> processor_;
-  std::vector<std::shared_ptr<core::DebugRouterStateListener> >
-      state_listeners_;
-  std::atomic<int> retry_times_;
-  void TryToReconnect();
+  base::CopyOnWrite<StateListeners> state_listeners_;
+  // guards reconnect_policy_, custom_reconnect_policy_ and reconnect_task_
+  std::mutex reconnect_mutex_;
+  std::unique_ptr<ReconnectPolicy> reconnect_policy_;
+  bool custom_reconnect_policy_;
+  // pending delayed Reconnect(), cancelled by Disconnect() and new Connect()
+  thread::TaskHandle reconnect_task_;
+  // returns false once no further reconnect is scheduled by the current
+  // retry budget
+  bool TryToReconnect();
+  void CancelPendingReconnect();
+  void ResetReconnectPolicy();
+  bool IsUsbListening();
+  void ReportReconnect(const std::string &event_name,
+                       const ReconnectDecision &decision,
+                       std::chrono::milliseconds elapsed);
   void NotifyConnectStateByMessage(ConnectionState state);
+  // passes an inbound message to the state listeners
+  void NotifyMessage(const std::string &message);
   std::string GetConnectionStateMsg(ConnectionState state);
   std::atomic<int32_t> usb_port_;
   std::atomic<int> handler_count_;
   std::atomic<WebSocketConnectType> is_first_connect_;
 
+  // negotiated per connection with a BinaryScreencast message
+  std::atomic<bool> binary_screencast_enabled_{false};
+  // frames of SendScreenCastAsync and of screencast SendDataAsync
+  ScreencastFlowControl screencast_flow_control_;
+  // delivers inbound session messages to session handlers and slots, control
+  // messages stay on the DebugRouterExecutor
+  thread::StrandPool session_strands_;
+  // priority overrides the default priority of the message
+  void SendDataInternal(const std::string &data, const std::string &type,
+                        int32_t session, int32_t mark, bool is_object,
+                        std::optional<MessagePriority> priority);
+  void SendDataAsyncInternal(const std::string &data, const std::string &type,
+                             int32_t session, int32_t mark, bool is_object,
+                             std::optional<MessagePriority> priority);
+  void SubmitScreencastFrame(int32_t session, ScreencastFrame frame);
+  void SendScreencastFrame(int32_t session);
+  void OnScreencastFrameAck(int32_t session);
+
   std::atomic<bool> enable_all_sessions_{false};
   std::unordered_set<int32_t> enabled_session_ids_;
   std::shared_mutex enabled_sessions_mutex_;
@@ -0,0 +1,153 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_CORE_HANDLER_INDEX_H_
+#define DEBUGROUTER_NATIVE_CORE_HANDLER_INDEX_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace debugrouter {
+namespace core {
+
+// the messages a handler receives, an empty set matches every session or type
+struct HandlerSubscription {
+  std::unordered_set<int32_t> session_ids;
+  std::unordered_set<std::string> types;
+
+  bool Matches(int32_t session_id, const std::string &type) const {
+    return (session_ids.empty() || session_ids.count(session_id) > 0) &&
+           (types.empty() || types.count(type) > 0);
+  }
+};
+
+/**
+ * Registered handlers with their ids and subscriptions, indexed by session id
+ * and message type so that a message is only dispatched to its subscribers.
+ * The index is rebuilt on every change, it is meant to be published as an
+ * immutable snapshot, see base::CopyOnWrite.
+ */
+template <typename Handler>
+class HandlerIndex {
+ public:
+  // returns the id handler was added with, 0 if it is not added
+  int Find(Handler *handler) const {
+    for (const Entry &entry : entries_) {
+      if (entry.handler == handler) {
+        return entry.id;
+      }
+    }
+    return 0;
+  }
+
+  void Add(int id, Handler *handler, HandlerSubscription subscription) {
+    entries_.push_back({id, handler, std::move(subscription)});
+    Rebuild();
+  }
+
+  bool Remove(int id) {
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [id](const Entry &entry) { return entry.id == id; });
+    if (it == entries_.end()) {
+      return false;
+    }
+    entries_.erase(it);
+    Rebuild();
+    return true;
+  }
+
+  void Clear() {
+    entries_.clear();
+    Rebuild();
+  }
+
+  size_t size() const { return entries_.size(); }
+
+  // calls visit(handler) for every handler, in the order they were added
+  template <typename Visit>
+  void ForEach(Visit visit) const {
+    for (const Entry &entry : entries_) {
+      visit(entry.handler);
+    }
+  }
+
+  // calls visit(handler) for the handlers subscribed to messages of type to
+  // session_id
+  template <typename Visit>
+  void ForEachSubscriber(int32_t session_id, const std::string &type,
+                         Visit visit) const {
+    for (Handler *handler : any_) {
+      visit(handler);
+    }
+    VisitBucket(by_session_, session_id, visit);
+    VisitBucket(by_type_, type, visit);
+    auto it = by_session_and_type_.find(session_id);
+    if (it != by_session_and_type_.end()) {
+      VisitBucket(it->second, type, visit);
+    }
+  }
+
+ private:
+  struct Entry {
+    int id;
+    Handler *handler;
+    HandlerSubscription subscription;
+  };
+
+  template <typename Map, typename Key, typename Visit>
+  static void VisitBucket(const Map &map, const Key &key, Visit &visit) {
+    auto it = map.find(key);
+    if (it != map.end()) {
+      for (Handler *handler : it->second) {
+        visit(handler);
+      }
+    }
+  }
+
+  void Rebuild() {
+    any_.clear();
+    by_session_.clear();
+    by_type_.clear();
+    by_session_and_type_.clear();
+    for (const Entry &entry : entries_) {
+      const auto &sessions = entry.subscription.session_ids;
+      const auto &types = entry.subscription.types;
+      if (sessions.empty() && types.empty()) {
+        any_.push_back(entry.handler);
+      } else if (types.empty()) {
+        for (int32_t session_id : sessions) {
+          by_session_[session_id].push_back(entry.handler);
+        }
+      } else if (sessions.empty()) {
+        for (const std::string &type : types) {
+          by_type_[type].push_back(entry.handler);
+        }
+      } else {
+        for (int32_t session_id : sessions) {
+          for (const std::string &type : types) {
+            by_session_and_type_[session_id][type].push_back(entry.handler);
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<Entry> entries_;
+  // each handler is in exactly one bucket kind, so it is visited once
+  std::vector<Handler *> any_;
+  std::unordered_map<int32_t, std::vector<Handler *>> by_session_;
+  std::unordered_map<std::string, std::vector<Handler *>> by_type_;
+  std::unordered_map<int32_t,
+                     std::unordered_map<std::string, std::vector<Handler *>>>
+      by_session_and_type_;
+};
+
+}  // namespace core
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_CORE_HANDLER_INDEX_H_
@@ -9,6 +9,8 @@
 #include <string>
 
 #include "debug_router/native/core/debug_router_state_listener.h"
+#include "debug_router/native/core/outbound_message.h"
+#include "debug_router/native/protocol/message_envelope.h"
 
 namespace debugrouter {
 namespace core {
@@ -26,6 +28,14 @@ class MessageTransceiverDelegate {
   virtual void OnMessage(
       const std::string &message,
       const std::shared_ptr<MessageTransceiver> &transceiver) = 0;
+  // a message whose envelope the transport has read to route it, payload is
+  // ReadEnvelopeMessage(envelope). The envelope points into message.
+  virtual void OnParsedMessage(
+      const std::string &message, const protocol::MessageEnvelope &envelope,
+      const std::string &payload,
+      const std::shared_ptr<MessageTransceiver> &transceiver) {
+    OnMessage(message, transceiver);
+  }
   virtual void OnInit(const std::shared_ptr<MessageTransceiver> &transceiver,
                       int32_t code, const std::string &info) = 0;
 };
@@ -39,6 +49,14 @@ class MessageTransceiver
   virtual bool Connect(const std::string &url) = 0;
   virtual void Disconnect() = 0;
   virtual void Send(const std::string &data) = 0;
+  // transports that filter or log messages use the envelope instead of
+  // parsing the payload
+  virtual void SendMessage(const OutboundMessage &message) {
+    Send(*message.payload);
+  }
+  // whether SendMessage can send OutboundMessage::binary payloads as binary
+  // frames
+  virtual bool SupportsBinaryMessages() { return false; }
   virtual ConnectionType GetType() = 0;
   virtual void HandleReceivedMessage(const std::string &message);
   virtual void SetDelegate(MessageTransceiverDelegate *delegate);
@@ -46,6 +64,8 @@ class MessageTransceiver
 
   virtual void StartServer() = 0;
   virtual void StopServer() = 0;
+  // whether a server is waiting for a debugger to connect to this device
+  virtual bool IsListening() { return false; }
 
  private:
   MessageTransceiverDelegate *delegate_ = nullptr;
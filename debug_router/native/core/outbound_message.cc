@@ -0,0 +1,147 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/core/outbound_message.h"
+
+#include <algorithm>
+#include <charconv>
+#include <climits>
+
+#include "debug_router/native/log/logging.h"
+#include "debug_router/native/protocol/protocol.h"
+
+namespace debugrouter {
+namespace core {
+
+const int32_t kNoSessionId = -1;
+const int32_t kUnknownSessionId = INT32_MIN;
+
+namespace {
+
+// bytes of a CDP message scanned for its method and id
+constexpr size_t kScanLimit = 512;
+// payloads larger than this are logged by size only
+constexpr size_t kMaxLoggedPayloadSize = 16 * 1024;
+
+bool IsSpace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// the position of the value of key in the outermost object of message, npos
+// if key is not found in its first kScanLimit bytes. key is quoted.
+size_t FindTopLevelValue(const std::string &message, const std::string &key) {
+  size_t limit = std::min(message.size(), kScanLimit);
+  int depth = 0;
+  bool in_string = false;
+  bool expect_key = false;
+  for (size_t i = 0; i < limit; ++i) {
+    char c = message[i];
+    if (in_string) {
+      if (c == '\\') {
+        ++i;
+      } else if (c == '"') {
+        in_string = false;
+      }
+      continue;
+    }
+    if (c == '{') {
+      ++depth;
+      expect_key = depth == 1;
+    } else if (c == '}' || c == ']') {
+      --depth;
+    } else if (c == '[') {
+      ++depth;
+    } else if (c == ',') {
+      expect_key = depth == 1;
+    } else if (c == '"') {
+      // only a key of the outermost object counts
+      if (expect_key && message.compare(i, key.size(), key) == 0) {
+        size_t pos = i + key.size();
+        while (pos < message.size() && IsSpace(message[pos])) {
+          ++pos;
+        }
+        if (pos >= message.size() || message[pos] != ':') {
+          return std::string::npos;
+        }
+        ++pos;
+        while (pos < message.size() && IsSpace(message[pos])) {
+          ++pos;
+        }
+        return pos < message.size() ? pos : std::string::npos;
+      }
+      in_string = true;
+      expect_key = false;
+    }
+  }
+  return std::string::npos;
+}
+
+}  // namespace
+
+std::string FindCdpMethod(const std::string &message) {
+  static const std::string kMethodKey = "\"method\"";
+  size_t pos = FindTopLevelValue(message, kMethodKey);
+  if (pos == std::string::npos || message[pos] != '"') {
+    return "";
+  }
+  size_t end = message.find('"', pos + 1);
+  if (end == std::string::npos) {
+    return "";
+  }
+  return message.substr(pos + 1, end - pos - 1);
+}
+
+int64_t FindCdpId(const std::string &message) {
+  static const std::string kIdKey = "\"id\"";
+  size_t pos = FindTopLevelValue(message, kIdKey);
+  if (pos == std::string::npos) {
+    return -1;
+  }
+  int64_t id = 0;
+  const char *end = message.data() + message.size();
+  auto result = std::from_chars(message.data() + pos, end, id);
+  if (result.ec != std::errc() || id < 0) {
+    return -1;
+  }
+  return id;
+}
+
+MessagePriority GetCdpMethodPriority(const std::string &method) {
+  if (method == "Page.screencastFrame" || method == "Lynx.screenshotCapture") {
+    return MessagePriority::kScreencast;
+  }
+  if (method == "HeapProfiler.addHeapSnapshotChunk" ||
+      method == "Tracing.dataCollected") {
+    return MessagePriority::kBulk;
+  }
+  return MessagePriority::kInteractive;
+}
+
+MessagePriority GetDefaultPriority(const std::string &type,
+                                   const std::string &method) {
+  if (type == protocol::kRemoteDebugProtocolBodyData4CDP) {
+    return GetCdpMethodPriority(method);
+  }
+  return MessagePriority::kInteractive;
+}
+
+void NotifyDropped(const OutboundMessage &message) {
+  if (message.on_dropped) {
+    message.on_dropped();
+  }
+}
+
+void LogOutboundMessage(const char *tag, const OutboundMessage &message) {
+  if (message.priority == MessagePriority::kScreencast) {
+    LOGI(tag << ": [TX]: " << message.method << " Sent.");
+  } else if (message.binary || message.size() > kMaxLoggedPayloadSize) {
+    LOGI(tag << ": [TX]: " << message.method << " " << message.size()
+             << " bytes Sent.");
+  } else {
+    LOGI(tag << ": [TX]: " << *message.payload);
+  }
+}
+
+}  // namespace core
+}  // namespace debugrouter
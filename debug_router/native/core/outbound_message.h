@@ -0,0 +1,90 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_CORE_OUTBOUND_MESSAGE_H_
+#define DEBUGROUTER_NATIVE_CORE_OUTBOUND_MESSAGE_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace debugrouter {
+namespace core {
+
+// session_id of a message that belongs to no session
+extern const int32_t kNoSessionId;
+// session_id of a raw message, the transport has to read it from the payload
+extern const int32_t kUnknownSessionId;
+
+// classes of outgoing messages, from the most to the least urgent. Messages
+// waiting for the socket of a usb client or websocket are sent by class, see
+// socket_server::OutboundScheduler. The DebugRouterExecutor hands them over
+// in order, it only wraps them and never waits for a socket, so no backlog
+// forms there. The interactive and bulk messages of a session keep their
+// order, only kScreencast messages are reordered or dropped by default.
+enum class MessagePriority {
+  // messages of the router itself, e.g. session lists
+  kControl,
+  // CDP responses and events a debugger waits for, e.g. Debugger.paused
+  kInteractive,
+  // large payloads, e.g. heap snapshot chunks and DOM dumps
+  kBulk,
+  // large periodic payloads, e.g. screencast frames and screenshots
+  kScreencast,
+};
+constexpr size_t kMessagePriorityCount = 4;
+
+/**
+ * Envelope of an outgoing message. It is filled where the message is
+ * wrapped, so that transports can filter, prioritize and log a message
+ * without parsing or scanning its payload. The payload is shared and never
+ * copied on its way to the socket.
+ */
+struct OutboundMessage {
+  OutboundMessage() : OutboundMessage(std::string()) {}
+  explicit OutboundMessage(std::string message)
+      : payload(std::make_shared<const std::string>(std::move(message))) {}
+
+  size_t size() const { return payload->size(); }
+
+  std::shared_ptr<const std::string> payload;
+  int32_t session_id = kUnknownSessionId;
+  // type passed to DebugRouterCore::SendData, e.g. "CDP"
+  std::string type;
+  // CDP method of events, empty for responses and raw messages
+  std::string method;
+  // id of the CDP request a response answers, -1 for events and raw messages
+  int64_t request_id = -1;
+  MessagePriority priority = MessagePriority::kInteractive;
+  // sent as a binary frame, only to peers that enabled binary messages
+  bool binary = false;
+  // called when the message is dropped or fails to be sent instead of being
+  // sent, e.g. to release the flow control slot of a screencast frame
+  std::function<void()> on_dropped;
+};
+
+// runs the on_dropped of message, if any
+void NotifyDropped(const OutboundMessage &message);
+
+// reads the "method" of a CDP message. Only the beginning of the message is
+// scanned, CDP events start with their method.
+std::string FindCdpMethod(const std::string &message);
+// reads the "id" of a CDP request or response the same way, -1 if there is
+// none
+int64_t FindCdpId(const std::string &message);
+MessagePriority GetCdpMethodPriority(const std::string &method);
+// the priority of a message of type with method, when its sender did not
+// choose one
+MessagePriority GetDefaultPriority(const std::string &type,
+                                   const std::string &method);
+
+// logs one line for message, bulk, binary and large payloads are not
+// printed.
+void LogOutboundMessage(const char *tag, const OutboundMessage &message);
+
+}  // namespace core
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_CORE_OUTBOUND_MESSAGE_H_
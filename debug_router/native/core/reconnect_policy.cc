@@ -0,0 +1,172 @@
+// Copyright 2024 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/core/reconnect_policy.h"
+
+#include <algorithm>
+
+#include "debug_router/native/core/debug_router_config.h"
+
+namespace debugrouter {
+namespace core {
+
+const std::string kReconnectBaseDelayMs =
+    "debugrouter_reconnect_base_delay_ms";
+const std::string kReconnectMaxDelayMs = "debugrouter_reconnect_max_delay_ms";
+const std::string kReconnectMaxAttempts = "debugrouter_reconnect_max_attempts";
+const std::string kReconnectMaxElapsedMs =
+    "debugrouter_reconnect_max_elapsed_ms";
+const std::string kReconnectCircuitBreakerCooldownMs =
+    "debugrouter_reconnect_circuit_breaker_cooldown_ms";
+
+namespace {
+
+std::chrono::milliseconds ClampDelay(std::chrono::milliseconds delay) {
+  return std::min(std::max(delay, kMinReconnectDelay), kMaxReconnectDelay);
+}
+
+}  // namespace
+
+ExponentialBackoffReconnectPolicy::Options
+ExponentialBackoffReconnectPolicy::Sanitize(const Options &options) {
+  const Options defaults;
+  Options result = options;
+  result.base_delay = ClampDelay(options.base_delay.count() < 0
+                                     ? defaults.base_delay
+                                     : options.base_delay);
+  result.max_delay = ClampDelay(options.max_delay.count() < 0
+                                    ? defaults.max_delay
+                                    : options.max_delay);
+  result.max_delay = std::max(result.max_delay, result.base_delay);
+  if (options.max_attempts < 0) {
+    result.max_attempts = defaults.max_attempts;
+  }
+  result.max_elapsed = ClampDelay(options.max_elapsed.count() < 0
+                                      ? defaults.max_elapsed
+                                      : options.max_elapsed);
+  // 0 disables the circuit breaker
+  if (options.circuit_breaker_cooldown.count() < 0) {
+    result.circuit_breaker_cooldown = defaults.circuit_breaker_cooldown;
+  } else if (options.circuit_breaker_cooldown.count() > 0) {
+    result.circuit_breaker_cooldown =
+        ClampDelay(options.circuit_breaker_cooldown);
+  }
+  return result;
+}
+
+ExponentialBackoffReconnectPolicy::Options
+ExponentialBackoffReconnectPolicy::OptionsFromConfigs() {
+  DebugRouterConfigs &configs = DebugRouterConfigs::GetInstance();
+  Options options;
+  options.base_delay = std::chrono::milliseconds(
+      configs.GetIntConfig(kReconnectBaseDelayMs, options.base_delay.count()));
+  options.max_delay = std::chrono::milliseconds(
+      configs.GetIntConfig(kReconnectMaxDelayMs, options.max_delay.count()));
+  options.max_attempts = static_cast<int32_t>(
+      std::min<int64_t>(configs.GetIntConfig(kReconnectMaxAttempts,
+                                             options.max_attempts),
+                        INT32_MAX));
+  options.max_elapsed = std::chrono::milliseconds(configs.GetIntConfig(
+      kReconnectMaxElapsedMs, options.max_elapsed.count()));
+  options.circuit_breaker_cooldown = std::chrono::milliseconds(
+      configs.GetIntConfig(kReconnectCircuitBreakerCooldownMs,
+                           options.circuit_breaker_cooldown.count()));
+  return Sanitize(options);
+}
+
+std::unique_ptr<ReconnectPolicy>
+ExponentialBackoffReconnectPolicy::CreateFromConfigs() {
+  return std::make_unique<ExponentialBackoffReconnectPolicy>(
+      OptionsFromConfigs());
+}
+
+ExponentialBackoffReconnectPolicy::ExponentialBackoffReconnectPolicy(
+    const Options &options)
+    : ExponentialBackoffReconnectPolicy(options, std::random_device()()) {}
+
+ExponentialBackoffReconnectPolicy::ExponentialBackoffReconnectPolicy(
+    const Options &options, uint32_t seed)
+    : options_(Sanitize(options)),
+      random_(seed),
+      attempts_(0),
+      probes_(0),
+      budget_start_(ReconnectClock::now()),
+      circuit_open_(false) {}
+
+void ExponentialBackoffReconnectPolicy::Reset() {
+  attempts_ = 0;
+  probes_ = 0;
+  circuit_open_ = false;
+}
+
+void ExponentialBackoffReconnectPolicy::OnConnected() { Reset(); }
+
+ReconnectDecision ExponentialBackoffReconnectPolicy::OnDisconnected(
+    ReconnectClock::time_point now) {
+  ReconnectDecision decision;
+  if (circuit_open_) {
+    // the probe failed, wait for another cooldown.
+    decision.should_retry = true;
+    decision.probe = ++probes_;
+    decision.delay = NextProbeDelay();
+    return decision;
+  }
+  if (attempts_ == 0) {
+    budget_start_ = now;
+  }
+  if (attempts_ >= options_.max_attempts ||
+      now - budget_start_ >= options_.max_elapsed) {
+    decision.budget_exhausted = true;
+    if (options_.circuit_breaker_cooldown.count() > 0) {
+      circuit_open_ = true;
+      decision.should_retry = true;
+      decision.probe = ++probes_;
+      decision.delay = NextProbeDelay();
+    }
+    return decision;
+  }
+  attempts_++;
+  decision.should_retry = true;
+  decision.attempt = attempts_;
+  decision.delay = NextBackoff();
+  return decision;
+}
+
+std::chrono::milliseconds ExponentialBackoffReconnectPolicy::NextBackoff() {
+  int64_t cap = options_.base_delay.count();
+  for (int32_t i = 1; i < attempts_ && cap < options_.max_delay.count(); ++i) {
+    cap *= 2;
+  }
+  cap = std::min(cap, static_cast<int64_t>(options_.max_delay.count()));
+  return std::chrono::milliseconds(
+      std::uniform_int_distribution<int64_t>(0, cap)(random_));
+}
+
+std::chrono::milliseconds ExponentialBackoffReconnectPolicy::NextProbeDelay() {
+  // keep probes of different devices apart, but never sooner than half of
+  // the cooldown.
+  int64_t half = options_.circuit_breaker_cooldown.count() / 2;
+  return std::chrono::milliseconds(
+      half + std::uniform_int_distribution<int64_t>(0, half)(random_));
+}
+
+int32_t ExponentialBackoffReconnectPolicy::GetAttempts() const {
+  return attempts_;
+}
+
+std::chrono::milliseconds ExponentialBackoffReconnectPolicy::GetElapsed(
+    ReconnectClock::time_point now) const {
+  if (attempts_ == 0 && !circuit_open_) {
+    return std::chrono::milliseconds(0);
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(now -
+                                                               budget_start_);
+}
+
+bool ExponentialBackoffReconnectPolicy::IsCircuitOpen() const {
+  return circuit_open_;
+}
+
+}  // namespace core
+}  // namespace debugrouter
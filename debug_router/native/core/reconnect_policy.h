@@ -0,0 +1,120 @@
+// Copyright 2024 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_CORE_RECONNECT_POLICY_H_
+#define DEBUGROUTER_NATIVE_CORE_RECONNECT_POLICY_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace debugrouter {
+namespace core {
+
+// DebugRouterConfigs keys of the default reconnect policy, values are
+// decimal integers.
+extern const std::string kReconnectBaseDelayMs;
+extern const std::string kReconnectMaxDelayMs;
+extern const std::string kReconnectMaxAttempts;
+extern const std::string kReconnectMaxElapsedMs;
+// 0 disables the circuit breaker: reconnecting stops once the budget is
+// exhausted.
+extern const std::string kReconnectCircuitBreakerCooldownMs;
+
+using ReconnectClock = std::chrono::steady_clock;
+
+// bounds of the delays of ExponentialBackoffReconnectPolicy
+constexpr std::chrono::milliseconds kMinReconnectDelay{100};
+constexpr std::chrono::milliseconds kMaxReconnectDelay{24 * 3600 * 1000};
+
+struct ReconnectDecision {
+  bool should_retry = false;
+  std::chrono::milliseconds delay{0};
+  // 1-based attempt number inside the current budget, 0 once the budget is
+  // exhausted.
+  int32_t attempt = 0;
+  // 1-based number of the probe this decision schedules while the circuit
+  // breaker is open, 0 otherwise.
+  int32_t probe = 0;
+  // the retry budget has just been exhausted.
+  bool budget_exhausted = false;
+};
+
+/**
+ * Decides whether and when DebugRouterCore reconnects a websocket that was
+ * closed or failed.
+ */
+class ReconnectPolicy {
+ public:
+  virtual ~ReconnectPolicy() = default;
+
+  // a new connection is requested by the user, start a fresh budget.
+  virtual void Reset() = 0;
+  // the connection has been established.
+  virtual void OnConnected() = 0;
+  // the connection has been lost.
+  virtual ReconnectDecision OnDisconnected(ReconnectClock::time_point now) = 0;
+
+  virtual int32_t GetAttempts() const = 0;
+  virtual std::chrono::milliseconds GetElapsed(
+      ReconnectClock::time_point now) const = 0;
+};
+
+/**
+ * Exponential backoff with full jitter: the n-th retry waits a random delay
+ * in [0, min(max_delay, base_delay * 2^(n-1))].
+ *
+ * A budget is bounded by max_attempts and max_elapsed. When it is exhausted
+ * the circuit opens and only a single probe is made per cooldown, so a
+ * restarted server is not hit by every device at the same time and devices
+ * never give up for good.
+ */
+class ExponentialBackoffReconnectPolicy : public ReconnectPolicy {
+ public:
+  struct Options {
+    std::chrono::milliseconds base_delay{1000};
+    std::chrono::milliseconds max_delay{30000};
+    int32_t max_attempts = 8;
+    std::chrono::milliseconds max_elapsed{120000};
+    std::chrono::milliseconds circuit_breaker_cooldown{300000};
+  };
+
+  // an invalid option falls back to its default, the others are kept in
+  // range: delays are at least kMinReconnectDelay and at most
+  // kMaxReconnectDelay, and max_delay is at least base_delay.
+  static Options Sanitize(const Options &options);
+  static Options OptionsFromConfigs();
+  static std::unique_ptr<ReconnectPolicy> CreateFromConfigs();
+
+  explicit ExponentialBackoffReconnectPolicy(const Options &options);
+  ExponentialBackoffReconnectPolicy(const Options &options, uint32_t seed);
+
+  void Reset() override;
+  void OnConnected() override;
+  ReconnectDecision OnDisconnected(ReconnectClock::time_point now) override;
+
+  int32_t GetAttempts() const override;
+  std::chrono::milliseconds GetElapsed(
+      ReconnectClock::time_point now) const override;
+
+  bool IsCircuitOpen() const;
+
+ private:
+  std::chrono::milliseconds NextBackoff();
+  std::chrono::milliseconds NextProbeDelay();
+
+  Options options_;
+  std::mt19937 random_;
+  int32_t attempts_;
+  int32_t probes_;
+  ReconnectClock::time_point budget_start_;
+  bool circuit_open_;
+};
+
+}  // namespace core
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_CORE_RECONNECT_POLICY_H_
@@ -0,0 +1,201 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/core/screencast_flow_control.h"
+
+#include "debug_router/native/core/util.h"
+
+namespace debugrouter {
+namespace core {
+
+const std::string kScreencastMaxFramesInFlight =
+    "debugrouter_screencast_max_frames_in_flight";
+const size_t kDefaultScreencastMaxFramesInFlight = 2;
+const std::string kScreencastAckTimeoutMs =
+    "debugrouter_screencast_ack_timeout_ms";
+const std::chrono::milliseconds kDefaultScreencastAckTimeout{1000};
+const std::string kScreencastSkipDuplicates =
+    "debugrouter_screencast_skip_duplicates";
+const std::string kScreencastKeepAliveMs =
+    "debugrouter_screencast_keep_alive_ms";
+
+ScreencastFlowControl::ScreencastFlowControl(
+    size_t max_frames_in_flight, std::chrono::milliseconds ack_timeout)
+    : max_frames_in_flight_(max_frames_in_flight), ack_timeout_(ack_timeout) {}
+
+bool ScreencastFlowControl::Submit(int32_t session_id, ScreencastFrame frame) {
+  return Submit(session_id, std::move(frame), ScreencastClock::now());
+}
+
+bool ScreencastFlowControl::Submit(int32_t session_id, ScreencastFrame frame,
+                                   ScreencastClock::time_point now) {
+  // hashed outside of the lock, frames are large
+  uint64_t hash = util::HashBytes(frame.data);
+  std::lock_guard<std::mutex> lock(mutex_);
+  Session &session = sessions_[session_id];
+  if (!AcceptFrame(session, frame, hash, now)) {
+    stats_.duplicates++;
+    return false;
+  }
+  if (session.has_frame) {
+    stats_.replaced++;
+  }
+  session.frame = std::move(frame);
+  session.has_frame = true;
+  ExpireFrames(session, now);
+  return ScheduleTake(session);
+}
+
+bool ScreencastFlowControl::TakeFrame(int32_t session_id,
+                                      ScreencastFrame &frame) {
+  return TakeFrame(session_id, frame, ScreencastClock::now());
+}
+
+bool ScreencastFlowControl::TakeFrame(int32_t session_id,
+                                      ScreencastFrame &frame,
+                                      ScreencastClock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sessions_.find(session_id);
+  if (it == sessions_.end()) {
+    return false;
+  }
+  Session &session = it->second;
+  session.take_scheduled = false;
+  ExpireFrames(session, now);
+  if (!session.has_frame || !CanSend(session)) {
+    return false;
+  }
+  frame = std::move(session.frame);
+  session.frame = ScreencastFrame();
+  session.has_frame = false;
+  if (!session.acks_ignored) {
+    session.in_flight.push_back(now);
+  }
+  stats_.sent++;
+  return true;
+}
+
+bool ScreencastFlowControl::OnAck(int32_t session_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sessions_.find(session_id);
+  if (it == sessions_.end()) {
+    return false;
+  }
+  Session &session = it->second;
+  stats_.acked++;
+  session.acks_seen = true;
+  session.acks_ignored = false;
+  if (!session.in_flight.empty()) {
+    session.in_flight.pop_front();
+  }
+  return ScheduleTake(session);
+}
+
+bool ScreencastFlowControl::OnDropped(int32_t session_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sessions_.find(session_id);
+  if (it == sessions_.end()) {
+    return false;
+  }
+  Session &session = it->second;
+  stats_.lost++;
+  // the newest frame was taken last, the older ones may still be acked
+  if (!session.in_flight.empty()) {
+    session.in_flight.pop_back();
+  }
+  return ScheduleTake(session);
+}
+
+void ScreencastFlowControl::RemoveSession(int32_t session_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sessions_.find(session_id);
+  if (it != sessions_.end()) {
+    DropFrame(it->second);
+    sessions_.erase(it);
+  }
+}
+
+void ScreencastFlowControl::Reset(size_t max_frames_in_flight,
+                                  std::chrono::milliseconds ack_timeout) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &item : sessions_) {
+    DropFrame(item.second);
+  }
+  sessions_.clear();
+  max_frames_in_flight_ = max_frames_in_flight;
+  ack_timeout_ = ack_timeout;
+}
+
+void ScreencastFlowControl::SetSkipDuplicates(
+    bool skip, std::chrono::milliseconds keep_alive) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  skip_duplicates_ = skip;
+  keep_alive_ = keep_alive;
+}
+
+ScreencastStats ScreencastFlowControl::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+bool ScreencastFlowControl::AcceptFrame(Session &session,
+                                        const ScreencastFrame &frame,
+                                        uint64_t hash,
+                                        ScreencastClock::time_point now) {
+  if (skip_duplicates_ && session.has_last && session.last_hash == hash &&
+      session.last_size == frame.data.size() &&
+      session.last_kind == frame.kind &&
+      session.last_metadata == frame.metadata &&
+      (keep_alive_.count() == 0 || now - session.last_time < keep_alive_)) {
+    return false;
+  }
+  session.has_last = true;
+  session.last_kind = frame.kind;
+  session.last_hash = hash;
+  session.last_size = frame.data.size();
+  session.last_metadata = frame.metadata;
+  session.last_time = now;
+  return true;
+}
+
+void ScreencastFlowControl::ExpireFrames(Session &session,
+                                         ScreencastClock::time_point now) {
+  if (ack_timeout_.count() == 0 || session.in_flight.empty() ||
+      now - session.in_flight.front() < ack_timeout_) {
+    return;
+  }
+  if (!session.acks_seen) {
+    session.acks_ignored = true;
+    session.in_flight.clear();
+    return;
+  }
+  while (!session.in_flight.empty() &&
+         now - session.in_flight.front() >= ack_timeout_) {
+    session.in_flight.pop_front();
+    stats_.lost++;
+  }
+}
+
+bool ScreencastFlowControl::CanSend(const Session &session) const {
+  return session.acks_ignored || max_frames_in_flight_ == 0 ||
+         session.in_flight.size() < max_frames_in_flight_;
+}
+
+bool ScreencastFlowControl::ScheduleTake(Session &session) {
+  if (!session.has_frame || session.take_scheduled || !CanSend(session)) {
+    return false;
+  }
+  session.take_scheduled = true;
+  return true;
+}
+
+void ScreencastFlowControl::DropFrame(Session &session) {
+  if (session.has_frame) {
+    stats_.dropped++;
+    session.has_frame = false;
+  }
+}
+
+}  // namespace core
+}  // namespace debugrouter
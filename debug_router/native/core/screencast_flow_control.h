@@ -0,0 +1,149 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_CORE_SCREENCAST_FLOW_CONTROL_H_
+#define DEBUGROUTER_NATIVE_CORE_SCREENCAST_FLOW_CONTROL_H_
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace debugrouter {
+namespace core {
+
+// DebugRouterConfigs key of the screencast frames of a session that may be
+// sent and not acked yet, a decimal integer. 0 disables the window.
+extern const std::string kScreencastMaxFramesInFlight;
+extern const size_t kDefaultScreencastMaxFramesInFlight;
+// milliseconds after which a frame that was not acked no longer takes a slot
+// of the window, a decimal integer. 0 keeps the slot until the ack.
+extern const std::string kScreencastAckTimeoutMs;
+extern const std::chrono::milliseconds kDefaultScreencastAckTimeout;
+// "false" sends frames that are identical to the previous frame of their
+// session, they are skipped by default.
+extern const std::string kScreencastSkipDuplicates;
+// a skipped duplicate is sent anyway when the last frame of its session is
+// older than this many milliseconds, 0 never sends duplicates.
+extern const std::string kScreencastKeepAliveMs;
+
+using ScreencastClock = std::chrono::steady_clock;
+
+struct ScreencastFrame {
+  enum class Kind {
+    // data is a Page.screencastFrame CDP message
+    kMessage,
+    // data is the base64 image of a Page.screencastFrame that is assembled
+    // when the frame is sent
+    kData,
+    // data is an encoded image, see DebugRouterSlot::SendScreenCastImage
+    kImage,
+  };
+  Kind kind = Kind::kMessage;
+  std::string data;
+  std::unordered_map<std::string, float> metadata;
+};
+
+struct ScreencastStats {
+  uint64_t sent = 0;
+  uint64_t acked = 0;
+  // frames that were replaced by a newer frame before being sent
+  uint64_t replaced = 0;
+  // frames that were discarded because their session or connection is gone
+  uint64_t dropped = 0;
+  // frames that were identical to the previous frame of their session
+  uint64_t duplicates = 0;
+  // frames the transport dropped or that were not acked in time
+  uint64_t lost = 0;
+};
+
+/**
+ * Paces the screencast frames of each session by Page.screencastFrameAck.
+ * A session keeps one frame waiting to be sent, a newer frame replaces it,
+ * so a slow debugger or link gets the latest frame instead of a growing
+ * queue. At most max_frames_in_flight frames are sent without an ack. A
+ * frame releases its slot when it is acked, when the transport drops it,
+ * see OnDropped, or after ack_timeout; a session that has not acked any
+ * frame by then is taken for a debugger that never acks, its frames are
+ * only coalesced. Frames identical to the previous frame of their session
+ * are skipped, they are compared by a hash of their data and by metadata.
+ *
+ * Submit and OnAck return true when the caller has to schedule one
+ * TakeFrame for the session, at most one is scheduled at a time.
+ */
+class ScreencastFlowControl {
+ public:
+  explicit ScreencastFlowControl(
+      size_t max_frames_in_flight,
+      std::chrono::milliseconds ack_timeout = kDefaultScreencastAckTimeout);
+
+  bool Submit(int32_t session, ScreencastFrame frame);
+  bool Submit(int32_t session, ScreencastFrame frame,
+              ScreencastClock::time_point now);
+  // the frame to send now, false if none is waiting or the window is full.
+  bool TakeFrame(int32_t session, ScreencastFrame &frame);
+  bool TakeFrame(int32_t session, ScreencastFrame &frame,
+                 ScreencastClock::time_point now);
+  bool OnAck(int32_t session);
+  // a frame of session that was taken was dropped or could not be sent, it
+  // will never be acked
+  bool OnDropped(int32_t session);
+
+  // forgets session and its frames, e.g. when its screencast is restarted
+  void RemoveSession(int32_t session);
+  // forgets all sessions, e.g. for a new connection
+  void Reset(size_t max_frames_in_flight,
+             std::chrono::milliseconds ack_timeout =
+                 kDefaultScreencastAckTimeout);
+  // keep_alive of 0 never sends a duplicate
+  void SetSkipDuplicates(bool skip, std::chrono::milliseconds keep_alive);
+
+  ScreencastStats GetStats() const;
+
+ private:
+  struct Session {
+    bool has_frame = false;
+    ScreencastFrame frame;
+    bool take_scheduled = false;
+    bool acks_seen = false;
+    // no frame was acked in time, the window does not apply
+    bool acks_ignored = false;
+    // when the frames in flight were taken, the oldest first
+    std::deque<ScreencastClock::time_point> in_flight;
+    // the last frame that was not skipped
+    bool has_last = false;
+    ScreencastFrame::Kind last_kind = ScreencastFrame::Kind::kMessage;
+    uint64_t last_hash = 0;
+    size_t last_size = 0;
+    std::unordered_map<std::string, float> last_metadata;
+    ScreencastClock::time_point last_time;
+  };
+
+  // false if frame repeats the last frame of session, otherwise it becomes
+  // the last frame
+  bool AcceptFrame(Session &session, const ScreencastFrame &frame,
+                   uint64_t hash, ScreencastClock::time_point now);
+
+  // releases the slots of the frames that were not acked in time
+  void ExpireFrames(Session &session, ScreencastClock::time_point now);
+  bool CanSend(const Session &session) const;
+  // schedules TakeFrame if a frame waits and may be sent
+  bool ScheduleTake(Session &session);
+  void DropFrame(Session &session);
+
+  mutable std::mutex mutex_;
+  size_t max_frames_in_flight_;
+  std::chrono::milliseconds ack_timeout_;
+  bool skip_duplicates_ = true;
+  std::chrono::milliseconds keep_alive_{0};
+  std::unordered_map<int32_t, Session> sessions_;
+  ScreencastStats stats_;
+};
+
+}  // namespace core
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_CORE_SCREENCAST_FLOW_CONTROL_H_
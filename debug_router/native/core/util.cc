@@ -30,7 +30,8 @@ bool CheckHeaderThreeBytes(const char *header) {
   char value[4];
   memcpy(value, header, 4);
   uint32_t value_int = DecodePayloadSize(value, 4);
-  if (value_int != 1) {
+  // version 1, or 2 with routing fields
+  if (value_int != 1 && value_int != 2) {
     return false;
   }
   memcpy(value, header + 4, 4);
@@ -106,5 +107,28 @@ std::string decodeURIComponent(const std::string &url) {
   return result_url_.str();
 }
 
+uint64_t HashBytes(std::string_view data) {
+  constexpr uint64_t kMultiplier = 0x9e3779b97f4a7c15ULL;
+  auto mix = [](uint64_t value) {
+    value ^= value >> 31;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 29;
+    return value;
+  };
+  uint64_t hash = data.size() * kMultiplier;
+  size_t i = 0;
+  for (; i + 8 <= data.size(); i += 8) {
+    uint64_t word;
+    memcpy(&word, data.data() + i, sizeof(word));
+    hash = (hash ^ mix(word)) * kMultiplier;
+  }
+  if (i < data.size()) {
+    uint64_t word = 0;
+    memcpy(&word, data.data() + i, data.size() - i);
+    hash = (hash ^ mix(word)) * kMultiplier;
+  }
+  return mix(hash);
+}
+
 }  // namespace util
 }  // namespace debugrouter
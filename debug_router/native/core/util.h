@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <cstring>
 #include <string>
+#include <string_view>
 
 namespace debugrouter {
 namespace util {
@@ -27,13 +28,17 @@ uint32_t DecodePayloadSize(char *payload, int32_t len);
 // the return value is result, header's len needs equal 16
 bool CheckHeaderFourthByte(const char *header, uint32_t payload_size_int);
 
-// check if header's [0,12) == DebugRouter connect protocol's header
-// the return value is result, header's len needs equal 16
+// check if header's [0,12) == DebugRouter connect protocol's header of
+// version 1 or 2, the return value is result, header's len needs equal 16
 bool CheckHeaderThreeBytes(const char *header);
 
 // decode url
 std::string decodeURIComponent(const std::string &url);
 
+// a fast non-cryptographic 64-bit hash of data, e.g. to find repeated
+// payloads. It reads 8 bytes at a time.
+uint64_t HashBytes(std::string_view data);
+
 }  // namespace util
 }  // namespace debugrouter
 
@@ -14,15 +14,15 @@ DebugRouterSessionHandlerHarmony::DebugRouterSessionHandlerHarmony(
     napi_env env, napi_value js_this)
     : env_(env), js_this_ref_(nullptr) {
   napi_create_reference(env, js_this, 1, &js_this_ref_);
-  napi_get_uv_event_loop(env, &loop_);
+  uv_loop_t *loop = nullptr;
+  napi_get_uv_event_loop(env, &loop);
+  ui_task_runner_ =
+      fml::MessageLoop::EnsureInitializedForCurrentThread(loop).GetTaskRunner();
 }
 
 void DebugRouterSessionHandlerHarmony::OnSessionCreate(int session_id,
                                                        const std::string &url) {
-  auto ui_task_runner =
-      fml::MessageLoop::EnsureInitializedForCurrentThread(loop_)
-          .GetTaskRunner();
-  ui_task_runner->PostTask([weak_ptr = weak_from_this(), session_id, url]() {
+  ui_task_runner_->PostTask([weak_ptr = weak_from_this(), session_id, url]() {
     napi_value js_this;
     auto handler = weak_ptr.lock();
     if (!handler) {
@@ -45,10 +45,7 @@ void DebugRouterSessionHandlerHarmony::OnSessionCreate(int session_id,
 }
 
 void DebugRouterSessionHandlerHarmony::OnSessionDestroy(int session_id) {
-  auto ui_task_runner =
-      fml::MessageLoop::EnsureInitializedForCurrentThread(loop_)
-          .GetTaskRunner();
-  ui_task_runner->PostTask([weak_ptr = weak_from_this(), session_id]() {
+  ui_task_runner_->PostTask([weak_ptr = weak_from_this(), session_id]() {
     napi_value js_this;
     auto handler = weak_ptr.lock();
     if (!handler) {
@@ -71,10 +68,7 @@ void DebugRouterSessionHandlerHarmony::OnSessionDestroy(int session_id) {
 void DebugRouterSessionHandlerHarmony::OnMessage(const std::string &message,
                                                  const std::string &type,
                                                  int session_id) {
-  auto ui_task_runner =
-      fml::MessageLoop::EnsureInitializedForCurrentThread(loop_)
-          .GetTaskRunner();
-  ui_task_runner->PostTask([weak_ptr = weak_from_this(), message, type,
+  ui_task_runner_->PostTask([weak_ptr = weak_from_this(), message, type,
                             session_id]() {
     napi_value js_this;
     auto handler = weak_ptr.lock();
@@ -15,15 +15,15 @@ NativeSlotHarmony::NativeSlotHarmony(napi_env env, napi_value js_this,
                                      const std::string& type)
     : NativeSlot(type, url), env_(env), js_this_ref_(nullptr) {
   napi_create_reference(env, js_this, 1, &js_this_ref_);
-  napi_get_uv_event_loop(env, &loop_);
+  uv_loop_t* loop = nullptr;
+  napi_get_uv_event_loop(env, &loop);
+  ui_task_runner_ =
+      fml::MessageLoop::EnsureInitializedForCurrentThread(loop).GetTaskRunner();
 }
 
 void NativeSlotHarmony::OnMessage(const std::string& message,
                                   const std::string& type) {
-  auto ui_task_runner =
-      fml::MessageLoop::EnsureInitializedForCurrentThread(loop_)
-          .GetTaskRunner();
-  ui_task_runner->PostTask([weak_ptr = weak_from_this(), message, type]() {
+  ui_task_runner_->PostTask([weak_ptr = weak_from_this(), message, type]() {
     napi_value js_this;
     auto handler = weak_ptr.lock();
     if (!handler) {
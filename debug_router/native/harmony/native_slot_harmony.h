@@ -9,6 +9,7 @@
 #include <uv.h>
 
 #include "debug_router/native/core/native_slot.h"
+#include "debug_router/native/harmony/base/fml/task_runner.h"
 
 namespace debugrouter {
 namespace harmony {
@@ -31,7 +32,9 @@ class NativeSlotHarmony
 
   napi_env env_;
   napi_ref js_this_ref_;
-  uv_loop_t* loop_;
+  // the task runner of the JS thread, created there. Every dispatch thread
+  // posts to it, so messages keep their order and no thread creates a loop.
+  fml::RefPtr<fml::TaskRunner> ui_task_runner_;
 };
 
 }  // namespace harmony
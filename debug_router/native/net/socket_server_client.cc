@@ -61,6 +61,19 @@ class ConnectionListener
     }
   }
 
+  void OnParsedMessage(const std::string &message,
+                       const protocol::MessageEnvelope &envelope,
+                       const std::string &payload) override {
+    if (auto client = client_.lock()) {
+      core::MessageTransceiverDelegate *delegate = client->delegate();
+      if (delegate == nullptr) {
+        LOGE("OnMessage: delegate == nullptr, client is already offline.");
+        return;
+      }
+      delegate->OnParsedMessage(message, envelope, payload, client);
+    }
+  }
+
  private:
   std::weak_ptr<core::MessageTransceiver> client_;
 };
@@ -82,7 +95,13 @@ core::ConnectionType SocketServerClient::GetType() {
 }
 
 void SocketServerClient::Send(const std::string &data) {
-  socket_server_->Send(data);
+  SendMessage(core::OutboundMessage(data));
+}
+
+void SocketServerClient::SendMessage(const core::OutboundMessage &message) {
+  if (!socket_server_->Send(message)) {
+    core::NotifyDropped(message);
+  }
 }
 
 void SocketServerClient::HandleReceivedMessage(const std::string &message) {
@@ -101,5 +120,9 @@ void SocketServerClient::StopServer() {
   }
 }
 
+bool SocketServerClient::IsListening() {
+  return socket_server_ && socket_server_->IsListening();
+}
+
 }  // namespace net
 }  // namespace debugrouter
@@ -18,11 +18,14 @@ class SocketServerClient : public core::MessageTransceiver {
   bool Connect(const std::string &url) override;
   void Disconnect() override;
   void Send(const std::string &data) override;
+  void SendMessage(const core::OutboundMessage &message) override;
+  bool SupportsBinaryMessages() override { return true; }
   core::ConnectionType GetType() override;
   void HandleReceivedMessage(const std::string &message) override;
 
   void StartServer() override;
   void StopServer() override;
+  bool IsListening() override;
 
  private:
   std::shared_ptr<debugrouter::socket_server::SocketServer> socket_server_;
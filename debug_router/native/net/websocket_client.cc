@@ -7,6 +7,7 @@
 #include <memory>
 
 #include "debug_router/native/log/logging.h"
+#include "debug_router/native/socket/event_loop.h"
 
 // http://tools.ietf.org/html/rfc6455#section-5.2  Base Framing Protocol
 //
@@ -34,14 +35,19 @@ namespace net {
 
 WebSocketClient::WebSocketClient() {}
 
-WebSocketClient::~WebSocketClient() { DisconnectInternal(); }
+WebSocketClient::~WebSocketClient() {
+  socket_server::EventLoop::GetInstance().PostAndWait(
+      [this]() { DisconnectInternal(); });
+}
 
-void WebSocketClient::Init() { work_thread_.init(); }
+void WebSocketClient::Init() {
+  // the connection runs on the shared EventLoop
+}
 
 bool WebSocketClient::Connect(const std::string &url) {
   LOGI("WebSocketClient::Connect");
   auto self = std::static_pointer_cast<WebSocketClient>(shared_from_this());
-  work_thread_.submit([client_ptr = self, url]() {
+  socket_server::EventLoop::GetInstance().Post([client_ptr = self, url]() {
     client_ptr->DisconnectInternal();
     client_ptr->ConnectInternal(url);
   });
@@ -58,15 +64,14 @@ void WebSocketClient::StopServer() {
 
 void WebSocketClient::ConnectInternal(const std::string &url) {
   LOGI("WebSocketClient::ConnectInternal: use " << url << " to connect.");
-  current_task_ = std::make_unique<WebSocketTask>(shared_from_this(), url);
-  current_task_->init();
+  current_task_ = std::make_shared<WebSocketTask>(shared_from_this(), url);
   current_task_->Start();
 }
 
 void WebSocketClient::Disconnect() {
   LOGI("WebSocketClient::Disconnect");
   auto self = std::static_pointer_cast<WebSocketClient>(shared_from_this());
-  work_thread_.submit(
+  socket_server::EventLoop::GetInstance().Post(
       [client_ptr = self]() { client_ptr->DisconnectInternal(); });
 }
 
@@ -76,7 +81,7 @@ void WebSocketClient::DisconnectInternal() {
     current_task_->Stop();
     LOGI("WebSocketClient::DisconnectInternal: current_task_->Stop() success.");
   }
-  current_task_.reset(nullptr);
+  current_task_.reset();
 }
 
 core::ConnectionType WebSocketClient::GetType() {
@@ -84,10 +89,16 @@ core::ConnectionType WebSocketClient::GetType() {
 }
 
 void WebSocketClient::Send(const std::string &data) {
+  SendMessage(core::OutboundMessage(data));
+}
+
+void WebSocketClient::SendMessage(const core::OutboundMessage &message) {
   auto self = std::static_pointer_cast<WebSocketClient>(shared_from_this());
-  work_thread_.submit([client_ptr = self, data]() {
+  socket_server::EventLoop::GetInstance().Post([client_ptr = self, message]() {
     if (client_ptr->current_task_) {
-      client_ptr->current_task_->SendInternal(data);
+      client_ptr->current_task_->SendInternal(message);
+    } else {
+      core::NotifyDropped(message);
     }
   });
 }
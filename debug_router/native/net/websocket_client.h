@@ -13,7 +13,6 @@
 #include "debug_router/native/base/socket_guard.h"
 #include "debug_router/native/core/message_transceiver.h"
 #include "debug_router/native/net/websocket_task.h"
-#include "debug_router/native/socket/work_thread_executor.h"
 
 #if defined(_WIN32)
 #include <winsock2.h>
@@ -28,7 +27,6 @@
 
 namespace debugrouter {
 namespace base {
-class WorkThreadExecutor;
 class SocketGuard;
 }  // namespace base
 namespace net {
@@ -42,6 +40,8 @@ class WebSocketClient : public core::MessageTransceiver {
   virtual bool Connect(const std::string &url) override;
   virtual void Disconnect() override;
   virtual void Send(const std::string &data) override;
+  void SendMessage(const core::OutboundMessage &message) override;
+  bool SupportsBinaryMessages() override { return true; }
   core::ConnectionType GetType() override;
 
   void StartServer() override;
@@ -51,8 +51,8 @@ class WebSocketClient : public core::MessageTransceiver {
   void DisconnectInternal();
   void ConnectInternal(const std::string &url);
 
-  base::WorkThreadExecutor work_thread_;
-  std::unique_ptr<WebSocketTask> current_task_;
+  // only used on the EventLoop thread
+  std::shared_ptr<WebSocketTask> current_task_;
 };
 }  // namespace net
 }  // namespace debugrouter
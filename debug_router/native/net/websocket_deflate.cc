@@ -0,0 +1,262 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/net/websocket_deflate.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#if ENABLE_WEBSOCKET_DEFLATE
+#include <zlib.h>
+#endif
+
+namespace debugrouter {
+namespace net {
+
+const char kPermessageDeflateOffer[] = "permessage-deflate";
+
+namespace {
+
+std::string Trim(const std::string &value) {
+  size_t begin = value.find_first_not_of(" \t");
+  if (begin == std::string::npos) {
+    return "";
+  }
+  size_t end = value.find_last_not_of(" \t");
+  return value.substr(begin, end - begin + 1);
+}
+
+bool ParseWindowBits(std::string value, int *bits) {
+  if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+    value = value.substr(1, value.size() - 2);
+  }
+  char *end = nullptr;
+  long result = std::strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0' || result < 8 || result > 15) {
+    return false;
+  }
+  *bits = static_cast<int>(result);
+  return true;
+}
+
+}  // namespace
+
+bool ParseWebSocketDeflateResponse(const std::string &extensions,
+                                   bool *negotiated,
+                                   WebSocketDeflateParams *params) {
+  *negotiated = false;
+  *params = WebSocketDeflateParams();
+  std::string value = Trim(extensions);
+  if (value.empty()) {
+    return true;
+  }
+  // only one extension is offered, so only one can be accepted
+  if (value.find(',') != std::string::npos) {
+    return false;
+  }
+  std::vector<std::string> tokens;
+  size_t start = 0;
+  while (true) {
+    size_t pos = value.find(';', start);
+    tokens.push_back(Trim(value.substr(start, pos - start)));
+    if (pos == std::string::npos) {
+      break;
+    }
+    start = pos + 1;
+  }
+  if (tokens[0] != kPermessageDeflateOffer) {
+    return false;
+  }
+  for (size_t i = 1; i < tokens.size(); ++i) {
+    const std::string &token = tokens[i];
+    size_t equal = token.find('=');
+    std::string name = Trim(token.substr(0, equal));
+    std::string argument =
+        equal == std::string::npos ? "" : Trim(token.substr(equal + 1));
+    if (name == "server_no_context_takeover" && argument.empty()) {
+      params->server_no_context_takeover = true;
+    } else if (name == "client_no_context_takeover" && argument.empty()) {
+      params->client_no_context_takeover = true;
+    } else if (name == "server_max_window_bits") {
+      if (!ParseWindowBits(argument, &params->server_max_window_bits)) {
+        return false;
+      }
+    } else {
+      // includes client_max_window_bits, which is not offered
+      return false;
+    }
+  }
+  *negotiated = true;
+  return true;
+}
+
+#if ENABLE_WEBSOCKET_DEFLATE
+
+namespace {
+
+// appended by a sync flush, removed before sending and added back before
+// inflating (RFC 7692 section 7.2.1).
+const unsigned char kDeflateTail[] = {0x00, 0x00, 0xff, 0xff};
+constexpr size_t kOutputChunk = 16 * 1024;
+
+}  // namespace
+
+bool IsWebSocketDeflateSupported() { return true; }
+
+struct WebSocketDeflater::Stream {
+  z_stream z = {};
+  bool initialized = false;
+};
+
+WebSocketDeflater::WebSocketDeflater(const WebSocketDeflateParams &params)
+    : stream_(std::make_unique<Stream>()),
+      no_context_takeover_(params.client_no_context_takeover) {
+  stream_->initialized =
+      deflateInit2(&stream_->z, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                   -params.client_max_window_bits, 8,
+                   Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+WebSocketDeflater::~WebSocketDeflater() {
+  if (stream_->initialized) {
+    deflateEnd(&stream_->z);
+  }
+}
+
+bool WebSocketDeflater::Compress(const char *data, size_t size,
+                                 std::string *out) {
+  if (!stream_->initialized) {
+    return false;
+  }
+  z_stream &z = stream_->z;
+  out->resize(deflateBound(&z, static_cast<uLong>(size)) + 8);
+  z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+  z.avail_in = static_cast<uInt>(size);
+  size_t written = 0;
+  while (true) {
+    if (written == out->size()) {
+      out->resize(out->size() + kOutputChunk);
+    }
+    z.next_out = reinterpret_cast<Bytef *>(&(*out)[written]);
+    z.avail_out = static_cast<uInt>(out->size() - written);
+    int result = deflate(&z, Z_SYNC_FLUSH);
+    written = out->size() - z.avail_out;
+    if (result != Z_OK && result != Z_BUF_ERROR) {
+      return false;
+    }
+    // the flush is complete once deflate leaves output space unused
+    if (z.avail_in == 0 && z.avail_out > 0) {
+      break;
+    }
+  }
+  if (written >= sizeof(kDeflateTail) &&
+      memcmp(out->data() + written - sizeof(kDeflateTail), kDeflateTail,
+             sizeof(kDeflateTail)) == 0) {
+    written -= sizeof(kDeflateTail);
+  }
+  out->resize(written);
+  if (no_context_takeover_) {
+    deflateReset(&z);
+  }
+  return true;
+}
+
+struct WebSocketInflater::Stream {
+  z_stream z = {};
+  bool initialized = false;
+};
+
+WebSocketInflater::WebSocketInflater(const WebSocketDeflateParams &params)
+    : stream_(std::make_unique<Stream>()),
+      no_context_takeover_(params.server_no_context_takeover) {
+  // a 32KB window can inflate data compressed with any smaller window
+  stream_->initialized = inflateInit2(&stream_->z, -15) == Z_OK;
+}
+
+WebSocketInflater::~WebSocketInflater() {
+  if (stream_->initialized) {
+    inflateEnd(&stream_->z);
+  }
+}
+
+bool WebSocketInflater::Decompress(const std::string &data, size_t max_size,
+                                   std::string *out) {
+  if (!stream_->initialized) {
+    return false;
+  }
+  z_stream &z = stream_->z;
+  out->resize(std::max<size_t>(data.size() * 4, kOutputChunk));
+  size_t written = 0;
+  const std::pair<const void *, size_t> inputs[] = {
+      {data.data(), data.size()}, {kDeflateTail, sizeof(kDeflateTail)}};
+  for (const auto &input : inputs) {
+    z.next_in = reinterpret_cast<Bytef *>(const_cast<void *>(input.first));
+    z.avail_in = static_cast<uInt>(input.second);
+    while (true) {
+      if (written == out->size()) {
+        out->resize(out->size() * 2);
+      }
+      z.next_out = reinterpret_cast<Bytef *>(&(*out)[written]);
+      z.avail_out = static_cast<uInt>(out->size() - written);
+      int result = inflate(&z, Z_SYNC_FLUSH);
+      written = out->size() - z.avail_out;
+      if (max_size > 0 && written > max_size) {
+        return false;
+      }
+      if (result == Z_BUF_ERROR && z.avail_in == 0) {
+        break;
+      }
+      if (result == Z_STREAM_END) {
+        // the peer finished the deflate stream, a new one may follow
+        inflateReset(&z);
+      } else if (result != Z_OK) {
+        return false;
+      }
+      if (z.avail_in == 0 && z.avail_out > 0) {
+        break;
+      }
+    }
+  }
+  out->resize(written);
+  if (no_context_takeover_) {
+    inflateReset(&z);
+  }
+  return true;
+}
+
+#else
+
+bool IsWebSocketDeflateSupported() { return false; }
+
+struct WebSocketDeflater::Stream {};
+
+WebSocketDeflater::WebSocketDeflater(const WebSocketDeflateParams &params)
+    : no_context_takeover_(params.client_no_context_takeover) {}
+
+WebSocketDeflater::~WebSocketDeflater() = default;
+
+bool WebSocketDeflater::Compress(const char *data, size_t size,
+                                 std::string *out) {
+  return false;
+}
+
+struct WebSocketInflater::Stream {};
+
+WebSocketInflater::WebSocketInflater(const WebSocketDeflateParams &params)
+    : no_context_takeover_(params.server_no_context_takeover) {}
+
+WebSocketInflater::~WebSocketInflater() = default;
+
+bool WebSocketInflater::Decompress(const std::string &data, size_t max_size,
+                                   std::string *out) {
+  return false;
+}
+
+#endif  // ENABLE_WEBSOCKET_DEFLATE
+
+}  // namespace net
+}  // namespace debugrouter
@@ -0,0 +1,79 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_NET_WEBSOCKET_DEFLATE_H_
+#define DEBUGROUTER_NATIVE_NET_WEBSOCKET_DEFLATE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace debugrouter {
+namespace net {
+
+// value of the Sec-WebSocket-Extensions header offered by the client.
+extern const char kPermessageDeflateOffer[];
+
+// permessage-deflate (RFC 7692) parameters accepted by the server.
+struct WebSocketDeflateParams {
+  bool server_no_context_takeover = false;
+  bool client_no_context_takeover = false;
+  int server_max_window_bits = 15;
+  int client_max_window_bits = 15;
+};
+
+// false when the library is built without zlib, the extension is then
+// never offered.
+bool IsWebSocketDeflateSupported();
+
+// parses the Sec-WebSocket-Extensions value of the upgrade response.
+// Returns false if the server answered with an extension or a parameter the
+// client did not offer, in which case the connection must be failed.
+// *negotiated is false when the server did not accept permessage-deflate.
+bool ParseWebSocketDeflateResponse(const std::string &extensions,
+                                   bool *negotiated,
+                                   WebSocketDeflateParams *params);
+
+/**
+ * Compresses outgoing messages. The LZ77 window is kept between messages
+ * (context takeover) unless the server asked for
+ * client_no_context_takeover.
+ */
+class WebSocketDeflater {
+ public:
+  explicit WebSocketDeflater(const WebSocketDeflateParams &params);
+  ~WebSocketDeflater();
+
+  // replaces *out with the compressed message, without the trailing
+  // 0x00 0x00 0xff 0xff of the sync flush.
+  bool Compress(const char *data, size_t size, std::string *out);
+
+ private:
+  struct Stream;
+  std::unique_ptr<Stream> stream_;
+  bool no_context_takeover_;
+};
+
+/**
+ * Decompresses incoming messages, see WebSocketDeflater.
+ */
+class WebSocketInflater {
+ public:
+  explicit WebSocketInflater(const WebSocketDeflateParams &params);
+  ~WebSocketInflater();
+
+  // fails if the data is corrupted or inflates to more than max_size bytes,
+  // 0 means unlimited.
+  bool Decompress(const std::string &data, size_t max_size, std::string *out);
+
+ private:
+  struct Stream;
+  std::unique_ptr<Stream> stream_;
+  bool no_context_takeover_;
+};
+
+}  // namespace net
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_NET_WEBSOCKET_DEFLATE_H_
@@ -0,0 +1,254 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/net/websocket_frame_reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace debugrouter {
+namespace net {
+
+namespace {
+
+// bytes a frame may grow the buffer by before they arrive, the length in a
+// frame header is not trusted
+constexpr size_t kMaxFillSize = 64 * 1024;
+
+}  // namespace
+
+RingBuffer::RingBuffer(size_t initial_capacity)
+    : data_(new char[std::max<size_t>(initial_capacity, 1)]),
+      capacity_(std::max<size_t>(initial_capacity, 1)),
+      head_(0),
+      size_(0) {}
+
+char *RingBuffer::PrepareWrite(size_t min_size, size_t *writable) {
+  if (capacity_ - size_ < min_size) {
+    Grow(size_ + min_size);
+  }
+  if (size_ == 0) {
+    head_ = 0;
+  }
+  size_t tail = head_ + size_;
+  if (tail >= capacity_) {
+    tail -= capacity_;
+    *writable = head_ - tail;
+  } else {
+    *writable = capacity_ - tail;
+  }
+  return data_.get() + tail;
+}
+
+void RingBuffer::CommitWrite(size_t size) { size_ += size; }
+
+void RingBuffer::Peek(size_t offset, void *out, size_t size) const {
+  size_t start = head_ + offset;
+  if (start >= capacity_) {
+    start -= capacity_;
+  }
+  size_t first = std::min(size, capacity_ - start);
+  memcpy(out, data_.get() + start, first);
+  if (first < size) {
+    memcpy(static_cast<char *>(out) + first, data_.get(), size - first);
+  }
+}
+
+uint8_t RingBuffer::PeekByte(size_t offset) const {
+  size_t index = head_ + offset;
+  if (index >= capacity_) {
+    index -= capacity_;
+  }
+  return static_cast<uint8_t>(data_[index]);
+}
+
+void RingBuffer::Consume(size_t size) {
+  size_ -= size;
+  head_ = size_ == 0 ? 0 : (head_ + size) % capacity_;
+}
+
+void RingBuffer::Grow(size_t min_capacity) {
+  size_t capacity = capacity_;
+  while (capacity < min_capacity) {
+    capacity = capacity > std::numeric_limits<size_t>::max() / 2
+                   ? min_capacity
+                   : capacity * 2;
+  }
+  std::unique_ptr<char[]> data(new char[capacity]);
+  Peek(0, data.get(), size_);
+  data_ = std::move(data);
+  capacity_ = capacity;
+  head_ = 0;
+}
+
+WebSocketFrameReader::WebSocketFrameReader(RecvFunction recv_function,
+                                           size_t initial_capacity)
+    : recv_function_(std::move(recv_function)),
+      buffer_(initial_capacity),
+      recv_count_(0),
+      max_message_size_(0),
+      in_fragmented_message_(false) {}
+
+WebSocketReadStatus WebSocketFrameReader::Fill(size_t min_size) {
+  size_t writable = 0;
+  char *out = buffer_.PrepareWrite(min_size, &writable);
+  int64_t read_size = recv_function_(out, writable);
+  recv_count_++;
+  if (read_size == 0) {
+    return WebSocketReadStatus::kClosed;
+  }
+  if (read_size == kRecvWouldBlock) {
+    return WebSocketReadStatus::kWouldBlock;
+  }
+  if (read_size < 0) {
+    return WebSocketReadStatus::kRecvError;
+  }
+  buffer_.CommitWrite(static_cast<size_t>(read_size));
+  return WebSocketReadStatus::kOk;
+}
+
+WebSocketReadStatus WebSocketFrameReader::ReadFrame(WebSocketFrame &frame) {
+  while (true) {
+    size_t buffered = buffer_.Size();
+    size_t missing = 0;
+    if (buffered < 2) {
+      missing = 2 - buffered;
+    } else {
+      const uint8_t flag_opcode = buffer_.PeekByte(0);
+      const uint8_t mask_payload_len = buffer_.PeekByte(1);
+      const bool masked = (mask_payload_len & 0x80) != 0;
+      size_t header_len = 2;
+      size_t ext_len = 0;
+      if ((mask_payload_len & 0x7f) == 126) {
+        ext_len = 2;
+      } else if ((mask_payload_len & 0x7f) == 127) {
+        ext_len = 8;
+      }
+      header_len += ext_len + (masked ? 4 : 0);
+      if (buffered < header_len) {
+        missing = header_len - buffered;
+      } else {
+        uint64_t payload_len = mask_payload_len & 0x7f;
+        if (ext_len > 0) {
+          payload_len = 0;
+          for (size_t i = 0; i < ext_len; ++i) {
+            payload_len = (payload_len << 8) | buffer_.PeekByte(2 + i);
+          }
+        }
+        if ((max_message_size_ > 0 && payload_len > max_message_size_) ||
+            payload_len > std::numeric_limits<size_t>::max() - header_len) {
+          return WebSocketReadStatus::kMessageTooLarge;
+        }
+        const uint64_t frame_len = header_len + payload_len;
+        if (buffered < frame_len) {
+          missing = static_cast<size_t>(frame_len - buffered);
+        } else {
+          frame.fin = (flag_opcode & 0x80) != 0;
+          frame.rsv = (flag_opcode >> 4) & 0x7;
+          frame.opcode = flag_opcode & 0x0f;
+          frame.masked = masked;
+          frame.payload.resize(static_cast<size_t>(payload_len));
+          if (payload_len > 0) {
+            buffer_.Peek(header_len, &frame.payload[0], frame.payload.size());
+          }
+          if (masked) {
+            uint8_t mask[4];
+            buffer_.Peek(header_len - 4, mask, sizeof(mask));
+            for (size_t i = 0; i < frame.payload.size(); ++i) {
+              frame.payload[i] ^= mask[i & 3];
+            }
+          }
+          buffer_.Consume(static_cast<size_t>(frame_len));
+          return WebSocketReadStatus::kOk;
+        }
+      }
+    }
+    WebSocketReadStatus status = Fill(std::min(missing, kMaxFillSize));
+    if (status != WebSocketReadStatus::kOk) {
+      return status;
+    }
+  }
+}
+
+WebSocketReadStatus WebSocketFrameReader::ReadMessage(WebSocketFrame &message) {
+  while (true) {
+    WebSocketFrame frame;
+    WebSocketReadStatus status = ReadFrame(frame);
+    if (status != WebSocketReadStatus::kOk) {
+      return status;
+    }
+    if (IsWebSocketControlOpcode(frame.opcode)) {
+      // control frames must not be fragmented, payload is at most 125 bytes
+      if (!frame.fin || frame.rsv != 0 || frame.payload.size() > 125 ||
+          frame.opcode > kWebSocketOpcodePong) {
+        return WebSocketReadStatus::kProtocolError;
+      }
+      message = std::move(frame);
+      return WebSocketReadStatus::kOk;
+    }
+    if (frame.opcode == kWebSocketOpcodeContinuation) {
+      // RSV1 of a compressed message is only set on the first fragment
+      if (!in_fragmented_message_ || frame.rsv != 0) {
+        return WebSocketReadStatus::kProtocolError;
+      }
+      if (max_message_size_ > 0 &&
+          fragmented_message_.payload.size() + frame.payload.size() >
+              max_message_size_) {
+        return WebSocketReadStatus::kMessageTooLarge;
+      }
+      fragmented_message_.payload.append(frame.payload);
+      if (frame.fin) {
+        in_fragmented_message_ = false;
+        fragmented_message_.fin = true;
+        message = std::move(fragmented_message_);
+        fragmented_message_ = WebSocketFrame();
+        return WebSocketReadStatus::kOk;
+      }
+      continue;
+    }
+    // only RSV1 is defined, by permessage-deflate
+    if ((frame.opcode != kWebSocketOpcodeText &&
+         frame.opcode != kWebSocketOpcodeBinary) ||
+        (frame.rsv & 0x3) != 0) {
+      return WebSocketReadStatus::kProtocolError;
+    }
+    // a new data message must not start before the previous one is finished
+    if (in_fragmented_message_) {
+      return WebSocketReadStatus::kProtocolError;
+    }
+    if (frame.fin) {
+      message = std::move(frame);
+      return WebSocketReadStatus::kOk;
+    }
+    in_fragmented_message_ = true;
+    fragmented_message_ = std::move(frame);
+  }
+}
+
+WebSocketReadStatus WebSocketFrameReader::ReadLine(std::string &line,
+                                                   size_t max_size) {
+  size_t scanned = 0;
+  while (true) {
+    size_t buffered = buffer_.Size();
+    for (; scanned < buffered && scanned < max_size; ++scanned) {
+      if (buffer_.PeekByte(scanned) == '\n') {
+        line.resize(scanned + 1);
+        buffer_.Peek(0, &line[0], line.size());
+        buffer_.Consume(line.size());
+        return WebSocketReadStatus::kOk;
+      }
+    }
+    if (scanned >= max_size) {
+      return WebSocketReadStatus::kLineTooLong;
+    }
+    WebSocketReadStatus status = Fill(1);
+    if (status != WebSocketReadStatus::kOk) {
+      return status;
+    }
+  }
+}
+
+}  // namespace net
+}  // namespace debugrouter
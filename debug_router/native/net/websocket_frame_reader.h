@@ -0,0 +1,138 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_NET_WEBSOCKET_FRAME_READER_H_
+#define DEBUGROUTER_NATIVE_NET_WEBSOCKET_FRAME_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace debugrouter {
+namespace net {
+
+/**
+ * Growable byte ring buffer. Data is appended at the tail through
+ * PrepareWrite/CommitWrite and consumed from the head.
+ */
+class RingBuffer {
+ public:
+  explicit RingBuffer(size_t initial_capacity);
+
+  size_t Size() const { return size_; }
+  size_t Capacity() const { return capacity_; }
+
+  // Returns a contiguous writable region at the tail. The buffer grows when
+  // less than min_size bytes are free, so the region may still be shorter
+  // than min_size when the free space wraps around.
+  char *PrepareWrite(size_t min_size, size_t *writable);
+  void CommitWrite(size_t size);
+
+  // copies size bytes starting at offset from the head, without consuming.
+  void Peek(size_t offset, void *out, size_t size) const;
+  uint8_t PeekByte(size_t offset) const;
+  void Consume(size_t size);
+
+ private:
+  void Grow(size_t min_capacity);
+
+  std::unique_ptr<char[]> data_;
+  size_t capacity_;
+  size_t head_;
+  size_t size_;
+};
+
+// RFC 6455 section 5.2 opcodes
+constexpr uint8_t kWebSocketOpcodeContinuation = 0x0;
+constexpr uint8_t kWebSocketOpcodeText = 0x1;
+constexpr uint8_t kWebSocketOpcodeBinary = 0x2;
+constexpr uint8_t kWebSocketOpcodeClose = 0x8;
+constexpr uint8_t kWebSocketOpcodePing = 0x9;
+constexpr uint8_t kWebSocketOpcodePong = 0xa;
+
+inline bool IsWebSocketControlOpcode(uint8_t opcode) {
+  return (opcode & 0x8) != 0;
+}
+
+struct WebSocketFrame {
+  bool fin = false;
+  // RSV1-3 bits, RSV1 is 0x4
+  uint8_t rsv = 0;
+  uint8_t opcode = 0;
+  bool masked = false;
+  std::string payload;
+};
+
+enum class WebSocketReadStatus {
+  kOk,
+  // the peer closed the connection
+  kClosed,
+  // recv failed, errno/WSAGetLastError describes the error
+  kRecvError,
+  // a line of the http response exceeds max_size
+  kLineTooLong,
+  // a frame or a reassembled message exceeds the max message size
+  kMessageTooLarge,
+  // unknown opcode, bad continuation sequence or malformed control frame
+  kProtocolError,
+  // a non-blocking recv has no more data, the read can be retried later
+  kWouldBlock,
+};
+
+/**
+ * Reads websocket frames and http lines from a stream socket through a
+ * per-connection RingBuffer, so that partial reads are completed, several
+ * frames can be parsed from one recv and the http upgrade response is not
+ * read byte by byte.
+ */
+class WebSocketFrameReader {
+ public:
+  // same contract as recv(): > 0 bytes read, 0 closed, < 0 error, except
+  // that kRecvWouldBlock is returned when a non-blocking socket has no data.
+  using RecvFunction = std::function<int64_t(char *buffer, size_t size)>;
+  static constexpr int64_t kRecvWouldBlock = -2;
+
+  explicit WebSocketFrameReader(RecvFunction recv_function,
+                                size_t initial_capacity = 16 * 1024);
+
+  // reads until a whole frame is buffered. The payload is unmasked. On
+  // kWouldBlock the partial frame stays buffered and the read can be retried,
+  // this holds for ReadMessage and ReadLine too.
+  WebSocketReadStatus ReadFrame(WebSocketFrame &frame);
+  // reads the next message, continuation frames are reassembled into the
+  // text/binary message that started them. Control frames may arrive between
+  // fragments and are returned as soon as they are read, the partial message
+  // is kept until its final fragment arrives. fin, rsv and opcode are taken
+  // from the first fragment.
+  WebSocketReadStatus ReadMessage(WebSocketFrame &message);
+  // 0 means unlimited.
+  void SetMaxMessageSize(size_t max_message_size) {
+    max_message_size_ = max_message_size;
+  }
+  // reads a line ending with '\n', the terminator is kept.
+  WebSocketReadStatus ReadLine(std::string &line, size_t max_size);
+
+  // number of times recv_function has been called.
+  uint64_t GetRecvCount() const { return recv_count_; }
+  size_t GetBufferedSize() const { return buffer_.Size(); }
+
+ private:
+  // reads at least once, and at most as much as buffer space allows
+  WebSocketReadStatus Fill(size_t min_size);
+
+  RecvFunction recv_function_;
+  RingBuffer buffer_;
+  uint64_t recv_count_;
+  size_t max_message_size_;
+  // message whose final fragment has not been read yet
+  WebSocketFrame fragmented_message_;
+  bool in_fragmented_message_;
+};
+
+}  // namespace net
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_NET_WEBSOCKET_FRAME_READER_H_
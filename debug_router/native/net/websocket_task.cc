@@ -4,8 +4,18 @@
 
 #include "debug_router/native/net/websocket_task.h"
 
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <thread>
+
+#include "debug_router/native/core/debug_router_config.h"
 #include "debug_router/native/core/util.h"
 #include "debug_router/native/log/logging.h"
+#include "debug_router/native/socket/event_loop.h"
+#include "debug_router/native/socket/frame_writer.h"
+#include "debug_router/native/socket/socket_server_type.h"
+#include "debug_router/native/thread/debug_router_executor.h"
 
 #if defined(_WIN32)
 #include <winsock2.h>
@@ -29,6 +39,18 @@ const int kNullSocketGuard = -103;
 const int kUnexpectedOpcode = -104;
 const int kUnexpectedMaskPayloadLen = -105;
 const int kDeflatedMessageUnimplemented = -106;
+const int kMessageTooLarge = -107;
+const int kDeflateNegotiationFailed = -108;
+const int kInflateFailed = -109;
+
+const std::string kWebSocketMaxFrameSize =
+    "debugrouter_websocket_max_frame_size";
+const std::string kWebSocketMaxMessageSize =
+    "debugrouter_websocket_max_message_size";
+const std::string kWebSocketEnableDeflate =
+    "debugrouter_websocket_enable_deflate";
+const std::string kWebSocketDeflateThreshold =
+    "debugrouter_websocket_deflate_threshold";
 
 // Helper function to convert Windows wide string to narrow string for logging
 #ifdef _WIN32
@@ -51,119 +73,301 @@ int GetErrorMessage() {
 #endif
 }
 
-static int readline(SOCKET sock, char *buf, size_t size) {
-  char *out = buf;
-  while (static_cast<size_t>(out - buf) < size) {
-    int res = static_cast<int>(recv(sock, out, 1, 0));
-    if (res == 1) {
-      if (*out++ == '\n') {
-        break;
-      }
-    } else if (res == -1) {
-      break;
+// max length of a line in the http upgrade response
+constexpr size_t kMaxHttpLineSize = 8192;
+constexpr size_t kDefaultMaxFrameSize = 64 * 1024;
+constexpr size_t kDefaultMaxMessageSize = 64 * 1024 * 1024;
+// below this, the deflate block overhead outweighs the savings
+constexpr size_t kDefaultDeflateThreshold = 1024;
+// messages taken from outgoing_messages_ at once
+constexpr size_t kWriteBatchSize = 64;
+// bytes moved into frame_queue_ at once, what a later urgent message may
+// have to wait for besides the socket buffer
+constexpr size_t kMaxFillBytes = 256 * 1024;
+
+// RFC 6455 section 7.4.1 status codes
+constexpr uint16_t kCloseProtocolError = 1002;
+constexpr uint16_t kCloseInvalidPayload = 1007;
+constexpr uint16_t kCloseMessageTooBig = 1009;
+
+namespace {
+
+// writes the header of a client frame, returns its length.
+size_t EncodeFrameHeader(uint8_t *prefix, uint8_t opcode, bool fin,
+                         bool compressed, size_t payload_len) {
+  size_t prefix_len = 2;
+  prefix[0] = opcode | (fin ? 0x80 /*FIN*/ : 0) |
+              (compressed ? 0x40 /*RSV1*/ : 0);
+  if (payload_len > 65535) {
+    prefix[1] = 127;
+    uint64_t len = payload_len;
+    for (int i = 7; i >= 0; --i) {
+      prefix[prefix_len++] = static_cast<uint8_t>(len >> (8 * i));
+    }
+  } else if (payload_len > 125) {
+    prefix[1] = 126;
+    prefix[2] = static_cast<uint8_t>(payload_len >> 8);
+    prefix[3] = static_cast<uint8_t>(payload_len);
+    prefix_len += 2;
+  } else {
+    prefix[1] = static_cast<uint8_t>(payload_len);
+  }
+
+  // All frames sent from client to server have this bit set to 1.
+  prefix[1] |= 0x80 /*MASK*/;
+  memset(prefix + prefix_len, 0, 4);
+  prefix_len += 4;
+  return prefix_len;
+}
+
+bool IsConnectInProgress() {
+#ifdef _WIN32
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EINPROGRESS;
+#endif
+}
+
+bool IsHeader(const std::string &line, const char *name) {
+  size_t len = strlen(name);
+  if (line.size() <= len || line[len] != ':') {
+    return false;
+  }
+  for (size_t i = 0; i < len; ++i) {
+    if (tolower(static_cast<unsigned char>(line[i])) !=
+        tolower(static_cast<unsigned char>(name[i]))) {
+      return false;
     }
   }
-  *out = '\0';
-  return static_cast<int>(out - buf);
+  return true;
 }
 
+}  // namespace
+
 WebSocketTask::WebSocketTask(
     std::shared_ptr<core::MessageTransceiver> transceiver,
     const std::string &url)
     : transceiver_(transceiver),
       url_(url),
+      port_(80),
+      state_(State::kIdle),
+      servinfo_(nullptr),
+      next_address_(nullptr),
+      connect_error_(0),
+      status_line_read_(false),
       socket_guard_(
-          std::make_unique<base::SocketGuard>(socket_server::kInvalidSocket)) {}
-
-WebSocketTask::~WebSocketTask() { shutdown(); }
+          std::make_unique<base::SocketGuard>(socket_server::kInvalidSocket)),
+      is_watching_(false),
+      is_watching_writable_(false),
+      max_frame_size_(static_cast<size_t>(
+          core::DebugRouterConfigs::GetInstance().GetIntConfig(
+              kWebSocketMaxFrameSize, kDefaultMaxFrameSize))),
+      max_message_size_(static_cast<size_t>(
+          core::DebugRouterConfigs::GetInstance().GetIntConfig(
+              kWebSocketMaxMessageSize, kDefaultMaxMessageSize))),
+      deflate_threshold_(static_cast<size_t>(
+          core::DebugRouterConfigs::GetInstance().GetIntConfig(
+              kWebSocketDeflateThreshold, kDefaultDeflateThreshold))) {}
+
+WebSocketTask::~WebSocketTask() {
+  close_socket();
+  if (servinfo_) {
+    freeaddrinfo(servinfo_);
+  }
+}
 
-void WebSocketTask::SendInternal(const std::string &data) {
-  const char *buf = data.data();
-  size_t payloadLen = data.size();
-  uint8_t prefix[14];
-  size_t prefix_len = 2;
+void WebSocketTask::SendInternal(const core::OutboundMessage &message) {
+  if (state_ != State::kOpen || close_sent_.load()) {
+    LOGE("WebSocketTask: not connected, drop message.");
+    core::NotifyDropped(message);
+    return;
+  }
+  if (!outgoing_messages_.put(core::OutboundMessage(message))) {
+    LOGW("WebSocketTask: screencast is behind, drop the oldest frame.");
+  }
+  // a pending backlog is continued once the socket is writable
+  if (frame_queue_.Empty()) {
+    flush_frames();
+  }
+}
 
-  prefix[0] = 1 /*OP_TEXT*/ | 0x80 /*FIN*/;
+bool WebSocketTask::fill_frames() {
+  if (outgoing_messages_.drain_to(write_batch_, kWriteBatchSize,
+                                  kMaxFillBytes) == 0) {
+    return false;
+  }
+  // compressed in the order the frames are sent, as context takeover needs
+  for (const core::OutboundMessage &message : write_batch_) {
+    queue_message(message);
+  }
+  write_batch_.clear();
+  return true;
+}
 
-  if (payloadLen > 65535) {
-    prefix[1] = 127;
-    *reinterpret_cast<uint32_t *>(prefix + 2) = 0;
-    prefix[6] = payloadLen >> 24;
-    prefix[7] = payloadLen >> 16;
-    prefix[8] = payloadLen >> 8;
-    prefix[9] = payloadLen;
-    prefix_len += 8;
-  } else if (payloadLen > 125) {
-    prefix[1] = 126;
-    prefix[2] = payloadLen >> 8;
-    prefix[3] = payloadLen;
-    prefix_len += 2;
-  } else {
-    prefix[1] = payloadLen;
+void WebSocketTask::queue_message(const core::OutboundMessage &message) {
+  core::LogOutboundMessage("WebSocketTask", message);
+  std::shared_ptr<const std::string> data = message.payload;
+
+  // with context takeover the server has to see every message we compressed,
+  // so a compressed message is sent even if it did not get smaller. Binary
+  // messages are encoded images and are never compressed.
+  bool is_compressed = false;
+  if (deflater_ && !message.binary && data->size() >= deflate_threshold_) {
+    auto compressed = std::make_shared<std::string>();
+    is_compressed = deflater_->Compress(data->data(), data->size(),
+                                        compressed.get());
+    if (!is_compressed) {
+      LOGE("WebSocketTask: deflate failed, send uncompressed.");
+      deflater_.reset();
+    } else {
+      data = std::move(compressed);
+    }
   }
 
-  // All frames sent from client to server have this bit set to 1.
-  prefix[1] |= 0x80 /*MASK*/;
-  *reinterpret_cast<uint32_t *>(prefix + prefix_len) = 0;
-  prefix_len += 4;
+  // split large messages so that control frames, e.g. pong replies, can be
+  // sent between the fragments. The fragments share the payload.
+  uint8_t opcode =
+      message.binary ? kWebSocketOpcodeBinary : kWebSocketOpcodeText;
+  size_t begin = 0;
+  size_t remaining = data->size();
+  do {
+    size_t frame_size = remaining;
+    if (max_frame_size_ > 0 && frame_size > max_frame_size_) {
+      frame_size = max_frame_size_;
+    }
+    bool fin = frame_size == remaining;
+    // RSV1 is only set on the first fragment
+    bool rsv1 = is_compressed && opcode != kWebSocketOpcodeContinuation;
+    send_frame(opcode, fin, rsv1, data, begin, begin + frame_size);
+    begin += frame_size;
+    remaining -= frame_size;
+    opcode = kWebSocketOpcodeContinuation;
+  } while (remaining > 0);
+}
 
-  if (!socket_guard_) {
-    onFailure("Socket_guard_ is nullptr.", kNullSocketGuard);
-    return;
-  }
-  if (data.find("Page.screencastFrame") != std::string::npos) {
-    LOGI("WebSocketTask: [TX]: Page.screencastFrame Sent.");
-  } else if (data.find("Lynx.screenshotCapture") != std::string::npos) {
-    LOGI("WebSocketTask: [TX]: Lynx.screenshotCapture Sent.");
-  } else {
-    LOGI("WebSocketTask: [TX]: " << buf);
+void WebSocketTask::send_frame(uint8_t opcode, bool fin, bool compressed,
+                               std::shared_ptr<const std::string> payload,
+                               size_t begin, size_t end, bool urgent) {
+  uint8_t prefix[14];
+  size_t prefix_len =
+      EncodeFrameHeader(prefix, opcode, fin, compressed, end - begin);
+  frame_queue_.Push(reinterpret_cast<const char *>(prefix), prefix_len,
+                    std::move(payload), begin, end, urgent);
+}
+
+bool WebSocketTask::flush_frames() {
+  SocketType socket = socket_guard_->Get();
+  while (true) {
+    if (!frame_queue_.Flush(socket)) {
+      LOGI("send frame error.");
+      // the server asked to close, it may not wait for our close frame
+      if (state_ != State::kClosing) {
+        onFailure("Send frame error.", GetErrorMessage());
+      }
+      close_connection();
+      return false;
+    }
+    if (!frame_queue_.Empty() || close_sent_.load()) {
+      break;
+    }
+    if (fill_frames()) {
+      continue;
+    }
+    if (state_ != State::kClosing) {
+      break;
+    }
+    // the backlog is sent, nothing is sent after the close frame
+    queue_close_frame(closing_status_code_, false);
   }
-  if (send(socket_guard_->Get(), (char *)prefix, prefix_len, 0) == -1) {
-    LOGI("send prefix_len error.");
-    onFailure("Send prefix_len error.", GetErrorMessage());
-    return;
+  if (state_ == State::kClosing && frame_queue_.Empty()) {
+    close_connection();
+    return false;
   }
-  if (send(socket_guard_->Get(), buf, payloadLen, 0) == -1) {
-    LOGI("send buf error.");
-    onFailure("Send buf error.", GetErrorMessage());
-    return;
+  // wait for writable only while frames are pending
+  bool want_writable = !frame_queue_.Empty();
+  if (is_watching_ && want_writable != is_watching_writable_) {
+    is_watching_writable_ = want_writable;
+    socket_server::EventLoop::GetInstance().Update(
+        socket, socket_server::kEventReadable |
+                    (want_writable ? socket_server::kEventWritable : 0));
   }
-  LOGI("send: prefix_len and buf success.");
+  return true;
 }
 
-void WebSocketTask::Start() {
-  submit([this]() { StartInternal(); });
+void WebSocketTask::send_close(uint16_t status_code) {
+  if (close_sent_.load()) {
+    return;
+  }
+  // the connection is closed right after, the backlog would be dropped anyway
+  outgoing_messages_.clear();
+  queue_close_frame(status_code, true);
+  flush_frames();
 }
 
-void WebSocketTask::StartInternal() {
-  if (!do_connect()) {
-    LOGI("Websocket connect failed.");
+void WebSocketTask::close_gracefully(uint16_t status_code) {
+  if (state_ != State::kOpen || close_sent_.load()) {
     return;
   }
-
-  onOpen();
-
-  std::string msg;
-  while (do_read(msg)) {
-    LOGI("[RX]:" << msg);
-    onMessage(msg);
+  // new messages are dropped by SendInternal, nothing is read anymore
+  state_ = State::kClosing;
+  closing_status_code_ = status_code;
+  if (is_watching_) {
+    is_watching_writable_ = true;
+    socket_server::EventLoop::GetInstance().Update(
+        socket_guard_->Get(), socket_server::kEventWritable);
   }
+  flush_frames();
+}
 
-  if (is_connected_.load(std::memory_order_relaxed)) {
-    onClose();
-  }
+void WebSocketTask::queue_close_frame(uint16_t status_code, bool urgent) {
+  close_sent_.store(true);
+  auto payload = std::make_shared<const std::string>(std::string{
+      static_cast<char>(status_code >> 8),
+      static_cast<char>(status_code & 0xff)});
+  LOGI("WebSocketTask: send close frame, status code: " << status_code);
+  send_frame(kWebSocketOpcodeClose, true, false, payload, 0, payload->size(),
+             urgent);
 }
 
-void WebSocketTask::Stop() {
-  LOGI("WebSocketTask::Stop");
-  socket_guard_->Reset();
-  if (is_connected_.load(std::memory_order_relaxed)) {
-    onClose();
+void WebSocketTask::Start() {
+  if (state_ != State::kIdle || !parse_url()) {
+    return;
   }
-  shutdown();
+  state_ = State::kResolving;
+  struct addrinfo ai, *servinfo = nullptr;
+  memset(&ai, 0, sizeof ai);
+  ai.ai_family = AF_INET;  // IPV4
+  ai.ai_socktype = SOCK_STREAM;
+  ai.ai_flags = AI_NUMERICHOST;
+  std::string port = std::to_string(port_);
+  // an ip address, e.g. of the usb forwarded host, resolves without a lookup
+  if (getaddrinfo(host_.c_str(), port.c_str(), &ai, &servinfo) == 0) {
+    on_resolved(0, 0, servinfo);
+    return;
+  }
+  // a host name may block on DNS, resolve it off the loop thread
+  ai.ai_flags = 0;
+  std::weak_ptr<WebSocketTask> weak_task = shared_from_this();
+  std::string host = host_;
+  std::thread([weak_task, host, port, ai]() {
+    struct addrinfo *servinfo = nullptr;
+    int ret = getaddrinfo(host.c_str(), port.c_str(), &ai, &servinfo);
+    int error = GetErrorMessage();
+    socket_server::EventLoop::GetInstance().Post(
+        [weak_task, ret, error, servinfo]() {
+          auto task = weak_task.lock();
+          if (!task || task->state_ != State::kResolving) {
+            if (ret == 0) {
+              freeaddrinfo(servinfo);
+            }
+            return;
+          }
+          task->on_resolved(ret, error, servinfo);
+        });
+  }).detach();
 }
 
-bool WebSocketTask::do_connect() {
+bool WebSocketTask::parse_url() {
   LOGI("WebSocketTask::do_connect");
   url_ = util::decodeURIComponent(url_);
   const char *purl = url_.c_str();
@@ -189,13 +393,14 @@ bool WebSocketTask::do_connect() {
     onFailure("Websocket Task: Parse url error.", kParseUrlErrorCode);
     return false;
   }
+  host_ = host;
+  path_ = path;
+  port_ = port;
+  return true;
+}
 
-  struct addrinfo ai, *servinfo;
-  memset(&ai, 0, sizeof ai);
-  ai.ai_family = AF_INET;  // IPV4
-  ai.ai_socktype = SOCK_STREAM;
-  char str_port[16];
-  snprintf(str_port, sizeof(str_port), "%d", port);
+void WebSocketTask::on_resolved(int ret, int error,
+                                struct addrinfo *servinfo) {
   /*
   Reason why getaddrinfo fails:
   - DNS resolution issues:
@@ -213,40 +418,58 @@ bool WebSocketTask::do_connect() {
     The network environment is isolated, which limits DNS query requests and can
   also cause getaddrinfo to fail to work properly.
   */
-  int ret = getaddrinfo(host, str_port, &ai, &servinfo);
   if (ret != 0) {
+    state_ = State::kClosed;
 #ifdef _WIN32
     LOGE("getaddrinfo Error: " << WideToNarrow(gai_strerror(ret)));
     onFailure("Websocket Task: getaddrinfo Error.", ret);
 #else
     // Other system error; errno is set to indicate the error.
     if (ret == EAI_SYSTEM) {
-      LOGE("getaddrinfo Error: " << strerror(GetErrorMessage()));
-      onFailure("Websocket Task: getaddrinfo Error.", GetErrorMessage());
+      LOGE("getaddrinfo Error: " << strerror(error));
+      onFailure("Websocket Task: getaddrinfo Error.", error);
     } else {
       LOGE("getaddrinfo Error: " << gai_strerror(ret));
       onFailure("Websocket Task: getaddrinfo Error.", ret);
     }
 #endif
-    return false;
+    return;
   }
+  servinfo_ = servinfo;
+  next_address_ = servinfo;
+  connect_next();
+}
 
-  bool is_connect_success = false;
-  for (auto p = servinfo; p != NULL; p = p->ai_next) {
-    auto sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
-    if (sockfd == -1) {
+void WebSocketTask::connect_next() {
+  while (next_address_ != nullptr) {
+    struct addrinfo *p = next_address_;
+    next_address_ = p->ai_next;
+    SocketType sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+    if (sockfd == socket_server::kInvalidSocket) {
       continue;
     }
+    socket_server::SetNonBlocking(sockfd);
     // Upon successful completion, connect() shall return 0; otherwise, -1 shall
-    // be returned and errno set to indicate the error.
-    if (connect(sockfd, p->ai_addr, p->ai_addrlen) != -1) {
+    // be returned and errno set to indicate the error. A non-blocking connect
+    // completes when the socket becomes writable.
+    if (connect(sockfd, p->ai_addr, static_cast<int>(p->ai_addrlen)) == 0 ||
+        IsConnectInProgress()) {
       socket_guard_ = std::make_unique<base::SocketGuard>(sockfd);
-      is_connect_success = true;
-      LOGI("Connect socket success. sockfd: " << sockfd);
-      break;
-    } else {
-      LOGE("connect Error: " << GetErrorMessage());
+      state_ = State::kConnecting;
+      std::weak_ptr<WebSocketTask> weak_task = shared_from_this();
+      socket_server::EventLoop::GetInstance().Watch(
+          sockfd, socket_server::kEventWritable,
+          [weak_task](uint32_t events) {
+            if (auto task = weak_task.lock()) {
+              task->on_socket_event(events);
+            }
+          });
+      is_watching_ = true;
+      is_watching_writable_ = true;
+      return;
     }
+    connect_error_ = GetErrorMessage();
+    LOGE("connect Error: " << connect_error_);
     CLOSESOCKET(sockfd);
   }
   /*
@@ -273,31 +496,84 @@ bool WebSocketTask::do_connect() {
   You can check errmsg by
   https://pubs.opengroup.org/onlinepubs/7908799/xns/syssocket.h.html
   */
-  if (!is_connect_success) {
-    onFailure("Websocket Task: socket connect failed.", GetErrorMessage());
-  }
+  state_ = State::kClosed;
+  freeaddrinfo(servinfo_);
+  servinfo_ = nullptr;
+  LOGE("Connect " << url_.c_str() << " Error: no address connected.");
+  onFailure("Websocket Task: socket connect failed.", connect_error_);
+}
 
-  if (socket_guard_ == nullptr) {
-    LOGE("Connect " << url_.c_str() << "Error: socket_guard_ is nullptr.");
-    return false;
+void WebSocketTask::on_socket_event(uint32_t events) {
+  if (state_ == State::kConnecting) {
+    int error = 0;
+    socklen_t error_len = sizeof(error);
+    if (getsockopt(socket_guard_->Get(), SOL_SOCKET, SO_ERROR,
+                   reinterpret_cast<char *>(&error), &error_len) != 0) {
+      error = GetErrorMessage();
+    }
+    if (error != 0) {
+      connect_error_ = error;
+      LOGE("connect Error: " << error);
+      close_socket();
+      connect_next();
+      return;
+    }
+    on_connected();
+    return;
+  }
+  if ((events & socket_server::kEventWritable) && !flush_frames()) {
+    return;
+  }
+  if (!(events & socket_server::kEventReadable)) {
+    return;
   }
-  freeaddrinfo(servinfo);
+  if (state_ == State::kHandshaking) {
+    do_handshake();
+  } else if (state_ == State::kOpen) {
+    on_readable();
+  }
+}
 
-  char buf[512];
+void WebSocketTask::on_connected() {
+  LOGI("Connect socket success. sockfd: " << socket_guard_->Get());
+  freeaddrinfo(servinfo_);
+  servinfo_ = nullptr;
+  next_address_ = nullptr;
+  socket_server::SetFrameSocketOptions(socket_guard_->Get());
+  state_ = State::kHandshaking;
+  socket_server::EventLoop::GetInstance().Update(
+      socket_guard_->Get(), socket_server::kEventReadable);
+  is_watching_writable_ = false;
+
+  if (IsWebSocketDeflateSupported() &&
+      core::DebugRouterConfigs::GetInstance().GetConfig(
+          kWebSocketEnableDeflate, "true") != "false") {
+    request_extensions_ = std::string("Sec-WebSocket-Extensions: ") +
+                          kPermessageDeflateOffer + "\r\n";
+  }
+  char buf[1024];
   snprintf(buf, sizeof(buf),
            "GET /%s HTTP/1.1\r\n"
            "Host: %s:%d\r\n"
            "Upgrade: websocket\r\n"
            "Connection: Upgrade\r\n"
            "Sec-WebSocket-Key: x3JJHMbDL1EzLkh9GBhXDw==\r\n"
+           "%s"
            "Sec-WebSocket-Version: 13\r\n\r\n",
-           path, host, port);
-  if (send(socket_guard_->Get(), buf, strlen(buf), 0) == -1) {
-    LOGE("send http upgrade error: " << GetErrorMessage());
-    onFailure("Websocket Task: socket send failed.", GetErrorMessage());
-    return false;
+           path_.c_str(), host_.c_str(), port_, request_extensions_.c_str());
+  frame_queue_.Push(nullptr, 0, std::make_shared<const std::string>(buf));
+  if (!flush_frames()) {
+    return;
   }
 
+  frame_reader_ = std::make_unique<WebSocketFrameReader>(
+      [this](char *buffer, size_t size) {
+        return recv_from_socket(buffer, size);
+      });
+  frame_reader_->SetMaxMessageSize(max_message_size_);
+}
+
+void WebSocketTask::do_handshake() {
   /*
   Reason why connect fails:
   - Connection interruption:
@@ -314,96 +590,234 @@ bool WebSocketTask::do_connect() {
     If the amount of data read exceeds the size of the buffer, it may cause data
   loss or reading errors.
   */
-  int status;
-  if (readline(socket_guard_->Get(), buf, sizeof(buf)) < 10 ||
-      sscanf(buf, "HTTP/1.1 %d Switching Protocols\r\n", &status) != 1 ||
-      status != 101) {
-    LOGE("Connect Error: " << url_.c_str());
-    onFailure("Websocket Task: do_connect Switching Protocol failed.",
-              GetErrorMessage());
-    return false;
+  std::string line;
+  while (!status_line_read_) {
+    WebSocketReadStatus read_status =
+        frame_reader_->ReadLine(line, kMaxHttpLineSize);
+    if (read_status == WebSocketReadStatus::kWouldBlock) {
+      return;
+    }
+    int status;
+    if (read_status != WebSocketReadStatus::kOk || line.size() < 10 ||
+        sscanf(line.c_str(), "HTTP/1.1 %d Switching Protocols\r\n",
+               &status) != 1 ||
+        status != 101) {
+      LOGE("Connect Error: " << url_.c_str());
+      onFailure("Websocket Task: do_connect Switching Protocol failed.",
+                GetErrorMessage());
+      close_connection();
+      return;
+    }
+    status_line_read_ = true;
   }
 
-  while (readline(socket_guard_->Get(), buf, sizeof(buf)) > 0 &&
-         buf[0] != '\r') {
-    size_t len = strlen(buf);
-    buf[len - 2] = '\0';
-    LOGI(buf);
+  while (true) {
+    WebSocketReadStatus read_status =
+        frame_reader_->ReadLine(line, kMaxHttpLineSize);
+    if (read_status == WebSocketReadStatus::kWouldBlock) {
+      return;
+    }
+    if (read_status != WebSocketReadStatus::kOk || line[0] == '\r') {
+      break;
+    }
+    line.resize(line.find_last_not_of("\r\n") + 1);
+    LOGI(line);
+    if (IsHeader(line, "Sec-WebSocket-Extensions")) {
+      response_extensions_ = line.substr(line.find(':') + 1);
+    }
   }
-  return true;
-}
 
-bool WebSocketTask::do_read(std::string &msg) {
-  struct {
-    uint8_t flag_opcode;
-    uint8_t mask_payload_len;
-  } head;
+  bool deflate = false;
+  WebSocketDeflateParams deflate_params;
+  if (!ParseWebSocketDeflateResponse(response_extensions_, &deflate,
+                                     &deflate_params) ||
+      (deflate && request_extensions_.empty())) {
+    LOGE("Unexpected Sec-WebSocket-Extensions: " << response_extensions_);
+    onFailure("Websocket Task: unexpected websocket extensions.",
+              kDeflateNegotiationFailed);
+    close_connection();
+    return;
+  }
+  if (deflate) {
+    LOGI("WebSocketTask: permessage-deflate negotiated.");
+    deflater_ = std::make_unique<WebSocketDeflater>(deflate_params);
+    inflater_ = std::make_unique<WebSocketInflater>(deflate_params);
+  }
+  state_ = State::kOpen;
+  onOpen();
+  // frames may have arrived with the upgrade response
+  on_readable();
+}
 
-  if (!socket_guard_) {
-    onFailure("WebSocket do_read: socket_guard_ is nullptr.", kNullSocketGuard);
-    return false;
+void WebSocketTask::on_readable() {
+  std::string msg;
+  while (state_ == State::kOpen) {
+    bool would_block = false;
+    if (!do_read(msg, would_block)) {
+      if (state_ == State::kOpen) {
+        close_connection();
+      }
+      return;
+    }
+    if (would_block) {
+      return;
+    }
+    LOGI("[RX]:" << msg);
+    onMessage(std::move(msg));
   }
+}
 
-  if (recv(socket_guard_->Get(), (char *)&head, sizeof(head), 0) !=
-      sizeof(head)) {
-    LOGE("failed to read websocket message");
-    onFailure(
-        "Failed to read WebSocket message header, incomplete read. recv error.",
-        GetErrorMessage());
-    return false;
+void WebSocketTask::Stop() {
+  LOGI("WebSocketTask::Stop");
+  state_ = State::kClosed;
+  close_socket();
+  if (is_connected_.load(std::memory_order_relaxed)) {
+    onClose();
   }
-  if ((head.flag_opcode & 0x80) == 0) {  // FIN
-    LOGE("read_message not final fragment");
-    onFailure("Received non-final WebSocket message fragment, not supported.",
-              kUnexpectedOpcode);
-    return false;
+}
+
+void WebSocketTask::close_socket() {
+  SocketType socket = socket_guard_->Get();
+  if (socket == socket_server::kInvalidSocket) {
+    return;
   }
-  const uint8_t flags = head.flag_opcode >> 4;
-  if ((head.mask_payload_len & 0x80) != 0) {  // masked payload
-    LOGE("read_message masked");
-    onFailure(
-        "Received unexpected masked WebSocket message payload from server.",
-        kUnexpectedMaskPayloadLen);
-    return false;
+  if (is_watching_) {
+    socket_server::EventLoop::GetInstance().Unwatch(socket);
+    is_watching_ = false;
+    is_watching_writable_ = false;
   }
-  size_t payloadLen = head.mask_payload_len & 0x7f;
-  bool deflated = (flags & 4 /*FLAG_RSV1*/) != 0;
-  if (deflated) {
-    LOGE("deflated message unimplemented");
-    onFailure("Deflated message unimplemented.", kDeflatedMessageUnimplemented);
-    return false;
+  socket_guard_->Reset();
+  frame_queue_.Clear();
+  outgoing_messages_.clear();
+}
+
+void WebSocketTask::close_connection() {
+  state_ = State::kClosed;
+  close_socket();
+  if (is_connected_.load(std::memory_order_relaxed)) {
+    onClose();
   }
+}
 
-  if (payloadLen == 126) {
-    uint8_t len[2];
-    recv(socket_guard_->Get(), (char *)&len, sizeof(len), 0);
-    payloadLen = (len[0] << 8) | len[1];
-  } else if (payloadLen == 127) {
-    uint8_t len[8];
-    recv(socket_guard_->Get(), (char *)&len, sizeof(len), 0);
-    payloadLen = (len[4] << 24) | (len[5] << 16) | (len[6] << 8) | len[7];
+int64_t WebSocketTask::recv_from_socket(char *buffer, size_t size) {
+  while (true) {
+#ifdef _WIN32
+    int64_t result = recv(socket_guard_->Get(), buffer,
+                          static_cast<int>(std::min<size_t>(size, INT_MAX)), 0);
+#else
+    int64_t result = recv(socket_guard_->Get(), buffer, size, 0);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+#endif
+    if (result < 0 && socket_server::IsWouldBlockError()) {
+      return WebSocketFrameReader::kRecvWouldBlock;
+    }
+    return result;
   }
+}
 
-  msg.resize(payloadLen);
+bool WebSocketTask::do_read(std::string &msg, bool &would_block) {
+  if (!socket_guard_ || !frame_reader_) {
+    onFailure("WebSocket do_read: socket_guard_ is nullptr.", kNullSocketGuard);
+    return false;
+  }
 
-  if (static_cast<size_t>(recv(socket_guard_->Get(),
-                               const_cast<char *>(msg.data()), payloadLen,
-                               0)) != payloadLen) {
-    LOGE("failed to read websocket message");
-    onFailure("Failed to read websocket message, recv failed.",
-              GetErrorMessage());
+  WebSocketFrame frame;
+  while (true) {
+    WebSocketReadStatus status = frame_reader_->ReadMessage(frame);
+    if (status == WebSocketReadStatus::kWouldBlock) {
+      would_block = true;
+      return true;
+    }
+    if (status == WebSocketReadStatus::kMessageTooLarge) {
+      LOGE("websocket message exceeds " << max_message_size_ << " bytes");
+      send_close(kCloseMessageTooBig);
+      onFailure("Received WebSocket message too large.", kMessageTooLarge);
+      return false;
+    }
+    if (status == WebSocketReadStatus::kProtocolError) {
+      LOGE("unexpected websocket opcode or fragment");
+      send_close(kCloseProtocolError);
+      onFailure("Received unexpected WebSocket opcode or fragment.",
+                kUnexpectedOpcode);
+      return false;
+    }
+    if (status != WebSocketReadStatus::kOk) {
+      LOGE("failed to read websocket message");
+      onFailure("Failed to read websocket message, recv failed.",
+                GetErrorMessage());
+      return false;
+    }
+    if (frame.masked) {
+      LOGE("read_message masked");
+      onFailure(
+          "Received unexpected masked WebSocket message payload from server.",
+          kUnexpectedMaskPayloadLen);
+      return false;
+    }
+    if (frame.opcode == kWebSocketOpcodePing) {
+      LOGI("WebSocketTask: received ping, send pong.");
+      auto payload =
+          std::make_shared<const std::string>(std::move(frame.payload));
+      send_frame(kWebSocketOpcodePong, true, false, payload, 0,
+                 payload->size(), true);
+      if (!flush_frames()) {
+        return false;
+      }
+      continue;
+    }
+    if (frame.opcode == kWebSocketOpcodePong) {
+      continue;
+    }
+    if (frame.opcode == kWebSocketOpcodeClose) {
+      // echo the status code after the pending messages, onClose is
+      // reported once it is sent.
+      uint16_t status_code = 1000;
+      if (frame.payload.size() >= 2) {
+        status_code = static_cast<uint16_t>(
+            (static_cast<uint8_t>(frame.payload[0]) << 8) |
+            static_cast<uint8_t>(frame.payload[1]));
+      }
+      LOGI("WebSocketTask: received close frame, status code: "
+           << status_code);
+      close_gracefully(status_code);
+      return false;
+    }
+    break;
+  }
+  bool deflated = (frame.rsv & 4 /*FLAG_RSV1*/) != 0;
+  if (deflated && !inflater_) {
+    LOGE("deflated message without permessage-deflate");
+    onFailure("Deflated message unimplemented.", kDeflatedMessageUnimplemented);
     return false;
   }
+  if (deflated) {
+    if (!inflater_->Decompress(frame.payload, max_message_size_, &msg)) {
+      LOGE("failed to inflate websocket message");
+      send_close(kCloseInvalidPayload);
+      onFailure("Failed to inflate websocket message.", kInflateFailed);
+      return false;
+    }
+    LOGI("WebSocketTask::do_read websocket message success.");
+    return true;
+  }
+
+  msg = std::move(frame.payload);
   LOGI("WebSocketTask::do_read websocket message success.");
   return true;
 }
 
+// transceiver callbacks run on DebugRouterExecutor, like those of the usb
+// transport, so that message handling never blocks the EventLoop.
 void WebSocketTask::onOpen() {
   LOGI("WebSocketTask::onOpen");
   is_connected_.store(true, std::memory_order_relaxed);
   auto transceiver = transceiver_.lock();
   if (transceiver) {
-    transceiver->delegate()->OnOpen(transceiver);
+    thread::DebugRouterExecutor::GetInstance().Post([transceiver]() {
+      transceiver->delegate()->OnOpen(transceiver);
+    });
   }
 }
 
@@ -412,7 +826,11 @@ void WebSocketTask::onFailure(const std::string &error_message,
   LOGI("WebSocketTask::onFailure with error_code.");
   auto transceiver = transceiver_.lock();
   if (transceiver) {
-    transceiver->delegate()->OnFailure(transceiver, error_message, error_code);
+    thread::DebugRouterExecutor::GetInstance().Post(
+        [transceiver, error_message, error_code]() {
+          transceiver->delegate()->OnFailure(transceiver, error_message,
+                                             error_code);
+        });
   }
 }
 
@@ -425,15 +843,20 @@ void WebSocketTask::onClose() {
   }
   auto transceiver = transceiver_.lock();
   if (transceiver) {
-    transceiver->delegate()->OnClosed(transceiver);
+    thread::DebugRouterExecutor::GetInstance().Post([transceiver]() {
+      transceiver->delegate()->OnClosed(transceiver);
+    });
   }
 }
 
-void WebSocketTask::onMessage(const std::string &msg) {
+void WebSocketTask::onMessage(std::string msg) {
   LOGI("WebSocketTask::onMessage");
   auto transceiver = transceiver_.lock();
   if (transceiver) {
-    transceiver->delegate()->OnMessage(msg, transceiver);
+    thread::DebugRouterExecutor::GetInstance().Post(
+        [transceiver, msg = std::move(msg)]() {
+          transceiver->delegate()->OnMessage(msg, transceiver);
+        });
   }
 }
 }  // namespace net
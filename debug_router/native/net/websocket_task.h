@@ -5,9 +5,19 @@
 #ifndef DEBUGROUTER_NATIVE_NET_WEBSOCKET_TASK_H_
 #define DEBUGROUTER_NATIVE_NET_WEBSOCKET_TASK_H_
 
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "debug_router/native/base/socket_guard.h"
 #include "debug_router/native/core/message_transceiver.h"
-#include "debug_router/native/socket/work_thread_executor.h"
+#include "debug_router/native/net/websocket_deflate.h"
+#include "debug_router/native/net/websocket_frame_reader.h"
+#include "debug_router/native/socket/frame_writer.h"
+#include "debug_router/native/socket/outbound_scheduler.h"
+
+struct addrinfo;
 
 namespace debugrouter {
 namespace net {
@@ -18,33 +28,122 @@ extern const int kNullSocketGuard;
 extern const int kUnexpectedOpcode;
 extern const int kUnexpectedMaskPayloadLen;
 extern const int kDeflatedMessageUnimplemented;
+extern const int kMessageTooLarge;
+extern const int kDeflateNegotiationFailed;
+extern const int kInflateFailed;
+
+// DebugRouterConfigs keys, values are decimal integers in bytes.
+// outgoing messages larger than this are split into continuation frames,
+// 0 sends every message as a single frame.
+extern const std::string kWebSocketMaxFrameSize;
+// incoming messages larger than this close the connection, 0 is unlimited.
+extern const std::string kWebSocketMaxMessageSize;
+// "false" stops offering permessage-deflate.
+extern const std::string kWebSocketEnableDeflate;
+// outgoing messages smaller than this are sent uncompressed.
+extern const std::string kWebSocketDeflateThreshold;
 
-class WebSocketTask : public base::WorkThreadExecutor {
+/**
+ * One websocket connection, driven by the shared socket_server::EventLoop:
+ * the socket is non-blocking and the task moves through resolving,
+ * connecting, handshaking and open as the socket becomes ready. All methods
+ * must be called on the loop thread, transceiver callbacks are posted to
+ * DebugRouterExecutor.
+ */
+class WebSocketTask : public std::enable_shared_from_this<WebSocketTask> {
  public:
   WebSocketTask(std::shared_ptr<core::MessageTransceiver> transceiver,
                 const std::string &url);
-  virtual ~WebSocketTask() override;
+  virtual ~WebSocketTask();
 
   void Stop();
   void Start();
-  void SendInternal(const std::string &data);
+  void SendInternal(const core::OutboundMessage &message);
 
  private:
-  void StartInternal();
+  enum class State {
+    kIdle,
+    kResolving,
+    kConnecting,
+    kHandshaking,
+    kOpen,
+    // the close frame of the server is answered once the backlog is sent
+    kClosing,
+    kClosed,
+  };
 
-  bool do_connect();
-  bool do_read(std::string &msg);
+  bool parse_url();
+  void on_resolved(int ret, int error, struct addrinfo *servinfo);
+  // starts a non-blocking connect to the next resolved address
+  void connect_next();
+  void on_socket_event(uint32_t events);
+  void on_connected();
+  void do_handshake();
+  void on_readable();
+  // false when reading stops, the caller closes the connection unless it is
+  // closing. would_block is set when no complete message is buffered.
+  bool do_read(std::string &msg, bool &would_block);
+  int64_t recv_from_socket(char *buffer, size_t size);
+  // compresses message and queues its frames
+  void queue_message(const core::OutboundMessage &message);
+  // moves the next batch of outgoing_messages_ into frame_queue_, false if
+  // there was none
+  bool fill_frames();
+  // queues one frame, flush_frames() writes it.
+  void send_frame(uint8_t opcode, bool fin, bool compressed,
+                  std::shared_ptr<const std::string> payload, size_t begin,
+                  size_t end, bool urgent = false);
+  bool flush_frames();
+  // for errors: the pending messages are dropped and the close frame is sent
+  // before the frames that have not started. The caller closes the
+  // connection.
+  void send_close(uint16_t status_code);
+  // stops reading, sends the pending messages and then the close frame, and
+  // closes the connection once it is written.
+  void close_gracefully(uint16_t status_code);
+  void queue_close_frame(uint16_t status_code, bool urgent);
+  void close_socket();
+  void close_connection();
 
   void onOpen();
   void onFailure(const std::string &error_message, int error_code);
   void onClose();
-  void onMessage(const std::string &msg);
+  void onMessage(std::string msg);
 
  private:
   std::weak_ptr<core::MessageTransceiver> transceiver_;
   std::string url_;
+  std::string host_;
+  std::string path_;
+  int port_;
+  State state_;
+  struct addrinfo *servinfo_;
+  struct addrinfo *next_address_;
+  int connect_error_;
+  bool status_line_read_;
+  std::string request_extensions_;
+  std::string response_extensions_;
   std::unique_ptr<base::SocketGuard> socket_guard_;
+  bool is_watching_;
+  bool is_watching_writable_;
+  std::unique_ptr<WebSocketFrameReader> frame_reader_;
+  // messages from SendInternal by priority. They are compressed and moved
+  // into frame_queue_ only once it is empty, so that urgent messages overtake
+  // a backlog of frames. Only stale screencast frames are ever dropped.
+  socket_server::OutboundScheduler outgoing_messages_{
+      socket_server::kMaxQueuedScreencastMessages};
+  std::vector<core::OutboundMessage> write_batch_;
+  socket_server::FrameQueue frame_queue_;
   std::atomic<bool> is_connected_ = {false};
+  std::atomic<bool> close_sent_ = {false};
+  // sent by close_gracefully after the backlog
+  uint16_t closing_status_code_ = 0;
+  size_t max_frame_size_;
+  size_t max_message_size_;
+  size_t deflate_threshold_;
+  // created when permessage-deflate is negotiated
+  std::unique_ptr<WebSocketDeflater> deflater_;
+  std::unique_ptr<WebSocketInflater> inflater_;
 };
 
 }  // namespace net
@@ -0,0 +1,84 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/processor/cdp_method_router.h"
+
+#include <algorithm>
+
+#include "debug_router/native/core/outbound_message.h"
+
+namespace debugrouter {
+namespace processor {
+
+namespace {
+
+template <typename Routes>
+auto FindRoute(Routes &routes, const std::string &method) {
+  return std::lower_bound(
+      routes.begin(), routes.end(), method,
+      [](const auto &route, const std::string &key) {
+        return route.first < key;
+      });
+}
+
+}  // namespace
+
+void CdpMethodRouter::Add(const std::string &method,
+                          CdpMethodHandler handler) {
+  routes_.Update([&](Routes &routes) {
+    auto it = FindRoute(routes, method);
+    if (it != routes.end() && it->first == method) {
+      it->second = std::move(handler);
+    } else {
+      routes.emplace(it, method, std::move(handler));
+    }
+    return true;
+  });
+}
+
+bool CdpMethodRouter::Remove(const std::string &method) {
+  bool removed = false;
+  routes_.Update([&](Routes &routes) {
+    auto it = FindRoute(routes, method);
+    if (it != routes.end() && it->first == method) {
+      routes.erase(it);
+      removed = true;
+    }
+    return removed;
+  });
+  return removed;
+}
+
+bool CdpMethodRouter::Route(int session_id, const std::string &message) {
+  std::shared_ptr<const Routes> routes = routes_.Load();
+  if (routes->empty()) {
+    return false;
+  }
+  messages_.fetch_add(1, std::memory_order_relaxed);
+  std::string method = core::FindCdpMethod(message);
+  if (method.empty()) {
+    return false;
+  }
+  auto it = FindRoute(*routes, method);
+  if (it == routes->end() || it->first != method) {
+    return false;
+  }
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  if (!it->second(session_id, message)) {
+    return false;
+  }
+  handled_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+CdpRouteStats CdpMethodRouter::GetStats() const {
+  CdpRouteStats stats;
+  stats.messages = messages_.load(std::memory_order_relaxed);
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.handled = handled_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace processor
+}  // namespace debugrouter
@@ -0,0 +1,63 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_PROCESSOR_CDP_METHOD_ROUTER_H_
+#define DEBUGROUTER_NATIVE_PROCESSOR_CDP_METHOD_ROUTER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "debug_router/native/base/copy_on_write.h"
+
+namespace debugrouter {
+namespace processor {
+
+// handles a CDP message of session_id natively, returns true if the message
+// is answered and must not be forwarded to the slot of the session
+using CdpMethodHandler =
+    std::function<bool(int session_id, const std::string &message)>;
+
+struct CdpRouteStats {
+  // CDP messages whose method was looked up
+  uint64_t messages = 0;
+  // messages with a native handler
+  uint64_t hits = 0;
+  // messages the native handler answered, they were not forwarded
+  uint64_t handled = 0;
+};
+
+/**
+ * Maps CDP method names to native handlers, so that methods the router can
+ * answer itself do not cross to the platform and back. The handlers are a
+ * flat map sorted by method, published as a snapshot: lookups take no lock.
+ */
+class CdpMethodRouter {
+ public:
+  // replaces the handler of method if it has one
+  void Add(const std::string &method, CdpMethodHandler handler);
+  bool Remove(const std::string &method);
+
+  // runs the handler of the method of message, returns whether the message
+  // was handled
+  bool Route(int session_id, const std::string &message);
+
+  CdpRouteStats GetStats() const;
+
+ private:
+  using Routes = std::vector<std::pair<std::string, CdpMethodHandler>>;
+
+  base::CopyOnWrite<Routes> routes_;
+  std::atomic<uint64_t> messages_{0};
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> handled_{0};
+};
+
+}  // namespace processor
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_PROCESSOR_CDP_METHOD_ROUTER_H_
@@ -4,52 +4,70 @@
 
 #include "debug_router/native/processor/message_assembler.h"
 
+#include "debug_router/native/protocol/message_writer.h"
 #include "debug_router/native/protocol/protocol.h"
 
 namespace debugrouter {
 namespace processor {
 
+namespace json = protocol::json;
+
+namespace {
+
+// bytes of a screencast frame besides its data and metadata
+constexpr size_t kScreenCastFrameOverhead = 128;
+// reserved for each metadata item
+constexpr size_t kScreenCastMetadataItemSize = 32;
+
+}  // namespace
+
 std::string MessageAssembler::AssembleDispatchDocumentUpdated() {
-  Json::Value msg;
-  msg["method"] = "DOM.documentUpdated";
-  msg["params"] = Json::ValueType::objectValue;
-  return msg.toStyledString();
+  return json::Write(
+      json::Object(json::Member(protocol::kKeyMethod, "DOM.documentUpdated"),
+                   json::Member(protocol::kKeyParams, json::Object())));
 }
 
 std::string MessageAssembler::AssembleDispatchFrameNavigated(std::string url) {
-  Json::Value msg;
-  msg["method"] = "Page.frameNavigated";
-  msg["params"] = Json::ValueType::objectValue;
-  msg["params"]["frame"] = Json::ValueType::objectValue;
-  msg["params"]["frame"]["url"] = url;
-  msg["params"]["frame"]["id"] = "";
-  return msg.toStyledString();
+  return json::Write(json::Object(
+      json::Member(protocol::kKeyMethod, "Page.frameNavigated"),
+      json::Member(protocol::kKeyParams,
+                   json::Object(json::Member(
+                       "frame", json::Object(json::Member(protocol::kKeyId, ""),
+                                             json::Member(protocol::kKeyUrl,
+                                                          url)))))));
 }
 
 std::string MessageAssembler::AssembleDispatchScreencastVisibilityChanged(
     bool status) {
-  Json::Value msg;
-  msg["method"] = "Page.screencastVisibilityChanged";
-  msg["params"] = Json::Value(Json::ValueType::objectValue);
-  msg["params"]["visible"] = status;
-  return msg.toStyledString();
+  return json::Write(json::Object(
+      json::Member(protocol::kKeyMethod, "Page.screencastVisibilityChanged"),
+      json::Member(protocol::kKeyParams,
+                   json::Object(json::Member("visible", status)))));
 }
 
 std::string MessageAssembler::AssembleScreenCastFrame(
     int session_id, const std::string &data,
     const std::unordered_map<std::string, float> &metadata) {
-  Json::Value metadata_;
-  Json::Value params_;
-  Json::Value content_;
-  for (const auto &item : metadata) {
-    metadata_[item.first] = item.second;
-  }
-  params_["data"] = data;
-  params_["metadata"] = metadata_;
-  params_["sessionId"] = session_id;
-  content_["method"] = "Page.screencastFrame";
-  content_["params"] = params_;
-  return content_.toStyledString();
+  std::string out;
+  AssembleScreenCastFrame(session_id, data, metadata, out);
+  return out;
+}
+
+void MessageAssembler::AssembleScreenCastFrame(
+    int session_id, const std::string &data,
+    const std::unordered_map<std::string, float> &metadata, std::string &out) {
+  out.clear();
+  // base64 data needs no escaping, the frame fits without growing out
+  out.reserve(data.size() + kScreenCastFrameOverhead +
+              metadata.size() * kScreenCastMetadataItemSize);
+  json::AppendValue(
+      json::Object(json::Member(protocol::kKeyMethod, "Page.screencastFrame"),
+                   json::Member(protocol::kKeyParams,
+                                json::Object(json::Member("data", data),
+                                             json::Member("metadata", metadata),
+                                             json::Member("sessionId",
+                                                          session_id)))),
+      out);
 }
 
 }  // namespace processor
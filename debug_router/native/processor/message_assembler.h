@@ -19,6 +19,10 @@ class MessageAssembler {
   static std::string AssembleScreenCastFrame(
       int session_id, const std::string &data,
       const std::unordered_map<std::string, float> &metadata);
+  // writes the frame into out, reusing its capacity
+  static void AssembleScreenCastFrame(
+      int session_id, const std::string &data,
+      const std::unordered_map<std::string, float> &metadata, std::string &out);
 };
 
 }  // namespace processor
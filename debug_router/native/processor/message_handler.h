@@ -26,6 +26,8 @@ class MessageHandler {
   virtual void ChangeRoomServer(const std::string &url,
                                 const std::string &room) = 0;
   virtual void ReportError(const std::string &error) = 0;
+  // returns whether binary screencast frames are sent from now on
+  virtual bool EnableBinaryScreencast(bool enable) { return false; }
 };
 
 }  // namespace processor
@@ -4,8 +4,13 @@
 
 #include "debug_router/native/processor/processor.h"
 
+#include "debug_router/native/base/string_kernels.h"
 #include "debug_router/native/log/logging.h"
+#include "debug_router/native/processor/message_assembler.h"
 #include "debug_router/native/protocol/events.h"
+#include "debug_router/native/protocol/message_envelope.h"
+#include "debug_router/native/protocol/message_writer.h"
+#include "debug_router/native/protocol/screencast_frame.h"
 #include "json/reader.h"
 
 namespace debugrouter {
@@ -14,10 +19,51 @@ namespace processor {
 const char *kDebugRouterErrorMessage = "DebugRouterError";
 const int kDebugRouterErrorCode = -3;
 
+namespace {
+
+const char *kScreencastFrameMethod = "Page.screencastFrame";
+
+// custom types that are handled by the processor itself
+bool IsControlType(std::string_view type) {
+  static const char *const kControlTypes[] = {
+      protocol::kRemoteDebugProtocolBodyData4Custom4D2RStopAtEntry,
+      protocol::kRemoteDebugProtocolBodyData4Custom4D2RStopLepusAtEntry,
+      protocol::kRemoteDebugProtocolBodyData4Custom4OpenCard,
+      protocol::kRemoteDebugProtocolBodyData4Custom4ListSession,
+      protocol::kRemoteDebugProtocolBodyData4Custom4MessageHandler,
+  };
+  for (const char *control_type : kControlTypes) {
+    if (type == control_type) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
 Processor::Processor(std::unique_ptr<MessageHandler> message_handler)
     : message_handler_(std::move(message_handler)), is_reconnect_(false) {}
 
 void Processor::Process(const std::string &message) {
+  protocol::MessageEnvelope envelope;
+  if (protocol::ParseMessageEnvelope(message, envelope) &&
+      processEnvelope(envelope, nullptr)) {
+    return;
+  }
+  processJson(message);
+}
+
+void Processor::Process(const std::string &message,
+                        const protocol::MessageEnvelope &envelope,
+                        const std::string &payload) {
+  if (processEnvelope(envelope, &payload)) {
+    return;
+  }
+  processJson(message);
+}
+
+void Processor::processJson(const std::string &message) {
   Json::Reader reader;
   Json::Value root;
 #if __cpp_exceptions >= 199711L
@@ -36,6 +82,37 @@ void Processor::Process(const std::string &message) {
 #endif
 }
 
+bool Processor::processEnvelope(const protocol::MessageEnvelope &envelope,
+                                const std::string *payload) {
+  if (envelope.event != protocol::kRemoteDebugServerEvent4Custom ||
+      envelope.type.empty() || IsControlType(envelope.type) ||
+      !envelope.has_sender || !envelope.has_client_id ||
+      !envelope.has_session_id || !envelope.has_message) {
+    return false;
+  }
+  if (envelope.client_id < 0 ||
+      static_cast<protocol::RemoteDebugPrococolClientId>(envelope.client_id) !=
+          client_id_) {
+    return true;
+  }
+  std::string read_payload;
+  if (payload == nullptr) {
+    if (!protocol::ReadEnvelopeMessage(envelope, read_payload)) {
+      return false;
+    }
+    payload = &read_payload;
+  }
+  std::string type(envelope.type);
+  if (type == protocol::kRemoteDebugProtocolBodyData4CDP) {
+    LOGI("CDP Message of session " << envelope.session_id << ": "
+                                   << payload->size() << " bytes");
+  } else {
+    LOGI("extension");
+  }
+  processMessage(type, envelope.session_id, *payload);
+  return true;
+}
+
 void Processor::process(const Json::Value &root) {
   std::shared_ptr<protocol::RemoteDebugProtocolBody> body =
       protocol::RemoteDebugProtocol::Parse(root);
@@ -65,7 +142,8 @@ void Processor::process(const Json::Value &root) {
     if (custom->Is4CDP()) {
       auto cdp = custom->AsCDP();
       if (cdp->client_id_ == client_id_) {
-        LOGI("CDP Message %s" << cdp->message_.c_str());
+        LOGI("CDP Message of session " << cdp->session_id_ << ": "
+                                       << cdp->message_.size() << " bytes");
         processMessage("CDP", cdp->session_id_, cdp->message_);
       }
     } else if (custom->Is4D2RStopAtEntry()) {
@@ -119,16 +197,53 @@ std::string Processor::WrapCustomizedMessage(const std::string &type,
     return wrapStopAtEntryMessage(type, message);
   }
 
-  std::shared_ptr<protocol::CustomData4CDP> cdp_data =
-      std::make_shared<protocol::CustomData4CDP>();
-  cdp_data->client_id_ = client_id_;
-  cdp_data->session_id_ = session_id;
-  cdp_data->message_ = message;
-  cdp_data->is_object_ = isObject;
-  std::shared_ptr<protocol::RemoteDebugProtocolBody> custom =
-      protocol::RemoteDebugProtocol::CreateProtocolBody4Custom(type, client_id_,
-                                                               cdp_data);
-  return protocol::RemoteDebugProtocol::Stringify(custom, mark);
+  return protocol::WriteCustomizedMessage(type, client_id_, session_id, message,
+                                         isObject, mark);
+}
+
+core::OutboundMessage Processor::WrapOutboundMessage(const std::string &type,
+                                                    int session_id,
+                                                    const std::string &message,
+                                                    int mark, bool isObject) {
+  core::OutboundMessage outbound(
+      WrapCustomizedMessage(type, session_id, message, mark, isObject));
+  outbound.type = type;
+  if (type == protocol::kRemoteDebugProtocolBodyData4Custom4R2DStopAtEntry ||
+      type ==
+          protocol::kRemoteDebugProtocolBodyData4Custom4R2DStopLepusAtEntry) {
+    // legacy messages are not bound to a session
+    outbound.session_id = core::kNoSessionId;
+    return outbound;
+  }
+  outbound.session_id = session_id;
+  outbound.method = core::FindCdpMethod(message);
+  if (outbound.method.empty() &&
+      type == protocol::kRemoteDebugProtocolBodyData4CDP) {
+    outbound.request_id = core::FindCdpId(message);
+  }
+  outbound.priority = core::GetDefaultPriority(type, outbound.method);
+  return outbound;
+}
+
+core::OutboundMessage Processor::WrapScreencastFrame(
+    int session_id, const std::string &image,
+    const std::unordered_map<std::string, float> &metadata, bool binary) {
+  if (!binary) {
+    std::string data;
+    base::Base64Encode(image, data);
+    return WrapOutboundMessage(
+        protocol::kRemoteDebugProtocolBodyData4CDP, session_id,
+        MessageAssembler::AssembleScreenCastFrame(session_id, data, metadata),
+        -1);
+  }
+  core::OutboundMessage outbound(protocol::WriteBinaryScreencastFrame(
+      client_id_, session_id, metadata, image));
+  outbound.session_id = session_id;
+  outbound.type = protocol::kRemoteDebugProtocolBodyData4CDP;
+  outbound.method = kScreencastFrameMethod;
+  outbound.priority = core::GetCdpMethodPriority(outbound.method);
+  outbound.binary = true;
+  return outbound;
 }
 
 void Processor::FlushSessionList() { sessionList(); }
@@ -235,11 +350,12 @@ void Processor::HandleAppAction(
     app_message_data_result = std::make_shared<protocol::AppMessageData>(
         method, id, result, protocol::kResult);
   } else {
-    Json::Value error(Json::objectValue);
-    error[protocol::kKeyCode] = kDebugRouterErrorCode;
-    error[protocol::kKeyMessage] = kDebugRouterErrorMessage;
+    std::string error = protocol::json::Write(protocol::json::Object(
+        protocol::json::Member(protocol::kKeyCode, kDebugRouterErrorCode),
+        protocol::json::Member(protocol::kKeyMessage,
+                               kDebugRouterErrorMessage)));
     app_message_data_result = std::make_shared<protocol::AppMessageData>(
-        method, id, error.toStyledString(), protocol::kError);
+        method, id, error, protocol::kError);
   }
   auto app_protocol_data = std::make_shared<protocol::AppProtocolData>(
       client_id_, app_message_data_result);
@@ -252,8 +368,39 @@ void Processor::HandleAppAction(
       protocol::RemoteDebugProtocol::Stringify(body_result));
 }
 
+void Processor::enableBinaryScreencast(bool enable) {
+  if (message_handler_) {
+    bool enabled = message_handler_->EnableBinaryScreencast(enable);
+    LOGI("binary screencast: " << enabled);
+    message_handler_->SendMessage(WrapCustomizedMessage(
+        protocol::kRemoteDebugProtocolBodyData4Custom4BinaryScreencast, -1,
+        enabled ? "true" : "false", -1));
+  }
+}
+
+void Processor::AddCdpMethodHandler(const std::string &method,
+                                    CdpMethodHandler handler) {
+  cdp_method_router_.Add(method, std::move(handler));
+}
+
+bool Processor::RemoveCdpMethodHandler(const std::string &method) {
+  return cdp_method_router_.Remove(method);
+}
+
+CdpRouteStats Processor::GetCdpRouteStats() const {
+  return cdp_method_router_.GetStats();
+}
+
 void Processor::processMessage(const std::string &type, int session_id,
                                const std::string &message) {
+  if (type == protocol::kRemoteDebugProtocolBodyData4Custom4BinaryScreencast) {
+    enableBinaryScreencast(message == "true");
+    return;
+  }
+  if (type == protocol::kRemoteDebugProtocolBodyData4CDP &&
+      cdp_method_router_.Route(session_id, message)) {
+    return;
+  }
   if (message_handler_) {
     message_handler_->OnMessage(type, session_id, message);
   }
@@ -6,8 +6,12 @@
 #define DEBUGROUTER_NATIVE_PROCESSOR_PROCESSOR_H_
 
 #include <string>
+#include <unordered_map>
 
+#include "debug_router/native/core/outbound_message.h"
+#include "debug_router/native/processor/cdp_method_router.h"
 #include "debug_router/native/processor/message_handler.h"
+#include "debug_router/native/protocol/message_envelope.h"
 #include "debug_router/native/protocol/protocol.h"
 
 namespace debugrouter {
@@ -20,11 +24,32 @@ class Processor {
  public:
   explicit Processor(std::unique_ptr<MessageHandler> message_handler);
   void Process(const std::string &message);
+  // message whose envelope a transport has already read, payload is
+  // ReadEnvelopeMessage(envelope)
+  void Process(const std::string &message,
+               const protocol::MessageEnvelope &envelope,
+               const std::string &payload);
   std::string WrapCustomizedMessage(const std::string &type, int session_id,
                                     const std::string &message, int mark,
                                     bool isObject = false);
+  // wraps message like WrapCustomizedMessage, together with what transports
+  // need to know about it without parsing it
+  core::OutboundMessage WrapOutboundMessage(const std::string &type,
+                                            int session_id,
+                                            const std::string &message,
+                                            int mark, bool isObject = false);
+  // a Page.screencastFrame of image, as a BinaryScreencastFrame or as the
+  // base64 CDP event for debuggers without binary messages
+  core::OutboundMessage WrapScreencastFrame(
+      int session_id, const std::string &image,
+      const std::unordered_map<std::string, float> &metadata, bool binary);
   void FlushSessionList();
   void SetIsReconnect(bool is_reconnect);
+  // CDP methods answered natively before their messages reach the handler
+  void AddCdpMethodHandler(const std::string &method,
+                           CdpMethodHandler handler);
+  bool RemoveCdpMethodHandler(const std::string &method);
+  CdpRouteStats GetCdpRouteStats() const;
 
  private:
   void registerDevice();
@@ -35,6 +60,7 @@ class Processor {
   void openCard(const std::string &url);
   void processMessage(const std::string &type, int session_id,
                       const std::string &message);
+  void enableBinaryScreencast(bool enable);
   void HandleAppAction(
       const std::shared_ptr<protocol::RemoteDebugProtocolBodyData4Custom>
           custom_data);
@@ -44,8 +70,16 @@ class Processor {
   debugrouter::protocol::RemoteDebugPrococolClientId client_id_;
   std::unique_ptr<MessageHandler> message_handler_;
   bool is_reconnect_;
+  CdpMethodRouter cdp_method_router_;
 
   void process(const Json::Value &root);
+  // parses message into a Json::Value for process
+  void processJson(const std::string &message);
+  // routes CDP and extension messages without building a Json::Value, false
+  // if the message has to be parsed by processJson. payload is the message
+  // of envelope if it has been read already, or null.
+  bool processEnvelope(const protocol::MessageEnvelope &envelope,
+                       const std::string *payload);
 };
 
 }  // namespace processor
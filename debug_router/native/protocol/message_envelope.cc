@@ -0,0 +1,440 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/protocol/message_envelope.h"
+
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+#include "debug_router/native/protocol/protocol.h"
+
+namespace debugrouter {
+namespace protocol {
+
+namespace {
+
+// deeper documents are left to Json::Reader
+constexpr int kMaxDepth = 128;
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+// scans the text once, only the envelope fields are kept and every other
+// value is validated and skipped.
+class EnvelopeScanner {
+ public:
+  explicit EnvelopeScanner(std::string_view text) : text_(text), pos_(0) {}
+
+  bool Parse(MessageEnvelope &envelope) {
+    envelope = MessageEnvelope();
+    bool result = ParseObject(1, [&](std::string_view key) {
+      if (key == kKeyEvent) {
+        return ReadStringMember(2, envelope.event);
+      }
+      if (key == kKeyData) {
+        return ParseData(envelope);
+      }
+      return SkipValue(2);
+    });
+    return result && Peek() == '\0' && pos_ == text_.size();
+  }
+
+  bool ParseValue() {
+    return SkipValue(1) && Peek() == '\0' && pos_ == text_.size();
+  }
+
+ private:
+  bool ParseData(MessageEnvelope &envelope) {
+    // a repeated key replaces the earlier value, as in Json::Reader
+    envelope.type = std::string_view();
+    envelope.has_sender = false;
+    ResetPayload(envelope);
+    if (Peek() != '{') {
+      return SkipValue(2);
+    }
+    return ParseObject(2, [&](std::string_view key) {
+      if (key == kKeyType) {
+        return ReadStringMember(3, envelope.type);
+      }
+      if (key == kKeySender) {
+        return ReadIntMember(3, envelope.has_sender, envelope.sender);
+      }
+      if (key == kKeyData) {
+        return ParsePayload(envelope);
+      }
+      return SkipValue(3);
+    });
+  }
+
+  bool ParsePayload(MessageEnvelope &envelope) {
+    ResetPayload(envelope);
+    if (Peek() != '{') {
+      return SkipValue(3);
+    }
+    return ParseObject(3, [&](std::string_view key) {
+      if (key == kKeyClientId) {
+        return ReadIntMember(4, envelope.has_client_id, envelope.client_id);
+      }
+      if (key == kKeySessionId) {
+        return ReadIntMember(4, envelope.has_session_id,
+                             envelope.session_id);
+      }
+      if (key == kKeyMessage) {
+        return ReadMessageMember(envelope);
+      }
+      return SkipValue(4);
+    });
+  }
+
+  static void ResetPayload(MessageEnvelope &envelope) {
+    envelope.has_client_id = false;
+    envelope.has_session_id = false;
+    envelope.has_message = false;
+    envelope.message_is_string = false;
+    envelope.message = std::string_view();
+  }
+
+  bool ReadMessageMember(MessageEnvelope &envelope) {
+    envelope.has_message = false;
+    char c = Peek();
+    if (c == '"') {
+      bool has_escape = false;
+      if (!ReadString(envelope.message, has_escape)) {
+        return false;
+      }
+      envelope.message_is_string = true;
+      envelope.has_message = true;
+      return true;
+    }
+    if (c == '{') {
+      size_t begin = pos_;
+      if (!SkipValue(4)) {
+        return false;
+      }
+      envelope.message = text_.substr(begin, pos_ - begin);
+      envelope.message_is_string = false;
+      envelope.has_message = true;
+      return true;
+    }
+    return SkipValue(4);
+  }
+
+  // a value that is not a string leaves value empty
+  bool ReadStringMember(int depth, std::string_view &value) {
+    value = std::string_view();
+    if (Peek() != '"') {
+      return SkipValue(depth);
+    }
+    bool has_escape = false;
+    return ReadString(value, has_escape) && !has_escape;
+  }
+
+  // a value that is not a number leaves has_value false
+  bool ReadIntMember(int depth, bool &has_value, int32_t &value) {
+    has_value = false;
+    char c = Peek();
+    if (c != '-' && !IsDigit(c)) {
+      return SkipValue(depth);
+    }
+    size_t begin = pos_;
+    bool is_integer = false;
+    if (!SkipNumber(is_integer) || !is_integer) {
+      return false;
+    }
+    int64_t number = 0;
+    auto result =
+        std::from_chars(text_.data() + begin, text_.data() + pos_, number);
+    if (result.ec != std::errc() ||
+        number < std::numeric_limits<int32_t>::min() ||
+        number > std::numeric_limits<int32_t>::max()) {
+      return false;
+    }
+    value = static_cast<int32_t>(number);
+    has_value = true;
+    return true;
+  }
+
+  // calls on_member for each key, on_member consumes the value.
+  template <typename OnMember>
+  bool ParseObject(int depth, OnMember on_member) {
+    if (depth > kMaxDepth || !Consume('{')) {
+      return false;
+    }
+    if (Consume('}')) {
+      return true;
+    }
+    do {
+      std::string_view key;
+      bool has_escape = false;
+      if (Peek() != '"' || !ReadString(key, has_escape) || has_escape ||
+          !Consume(':') || !on_member(key)) {
+        return false;
+      }
+    } while (Consume(','));
+    return Consume('}');
+  }
+
+  bool SkipValue(int depth) {
+    switch (Peek()) {
+      case '{':
+        return ParseObject(depth, [&](std::string_view key) {
+          return SkipValue(depth + 1);
+        });
+      case '[':
+        if (depth > kMaxDepth) {
+          return false;
+        }
+        ++pos_;
+        if (Consume(']')) {
+          return true;
+        }
+        do {
+          if (!SkipValue(depth + 1)) {
+            return false;
+          }
+        } while (Consume(','));
+        return Consume(']');
+      case '"': {
+        std::string_view value;
+        bool has_escape = false;
+        return ReadString(value, has_escape);
+      }
+      case 't':
+        return ConsumeLiteral("true");
+      case 'f':
+        return ConsumeLiteral("false");
+      case 'n':
+        return ConsumeLiteral("null");
+      default: {
+        bool is_integer = false;
+        return SkipNumber(is_integer);
+      }
+    }
+  }
+
+  // content is the string between the quotes, escapes are kept.
+  bool ReadString(std::string_view &content, bool &has_escape) {
+    size_t begin = ++pos_;
+    const char *data = text_.data();
+    // memchr skips long strings much faster than a loop over the bytes
+    while (pos_ < text_.size()) {
+      const void *found = memchr(data + pos_, '"', text_.size() - pos_);
+      if (!found) {
+        return false;
+      }
+      size_t quote = static_cast<const char *>(found) - data;
+      size_t backslashes = 0;
+      while (quote - backslashes > begin &&
+             data[quote - backslashes - 1] == '\\') {
+        ++backslashes;
+      }
+      pos_ = quote + 1;
+      // an odd number of backslashes escapes the quote
+      if (backslashes % 2 == 0) {
+        content = text_.substr(begin, quote - begin);
+        has_escape = has_escape ||
+                     memchr(data + begin, '\\', quote - begin) != nullptr;
+        return true;
+      }
+      has_escape = true;
+    }
+    return false;
+  }
+
+  bool SkipNumber(bool &is_integer) {
+    size_t size = text_.size();
+    if (pos_ < size && text_[pos_] == '-') {
+      ++pos_;
+    }
+    if (!SkipDigits()) {
+      return false;
+    }
+    is_integer = true;
+    if (pos_ < size && text_[pos_] == '.') {
+      ++pos_;
+      is_integer = false;
+      if (!SkipDigits()) {
+        return false;
+      }
+    }
+    if (pos_ < size && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+      ++pos_;
+      is_integer = false;
+      if (pos_ < size && (text_[pos_] == '+' || text_[pos_] == '-')) {
+        ++pos_;
+      }
+      if (!SkipDigits()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool SkipDigits() {
+    size_t begin = pos_;
+    while (pos_ < text_.size() && IsDigit(text_[pos_])) {
+      ++pos_;
+    }
+    return pos_ > begin;
+  }
+
+  bool ConsumeLiteral(std::string_view literal) {
+    if (text_.compare(pos_, literal.size(), literal) != 0) {
+      return false;
+    }
+    pos_ += literal.size();
+    return true;
+  }
+
+  bool Consume(char c) {
+    if (Peek() != c) {
+      return false;
+    }
+    ++pos_;
+    return true;
+  }
+
+  // the next character after whitespace, '\0' at the end
+  char Peek() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\n' || text_[pos_] == '\r' ||
+            text_[pos_] == '\t')) {
+      ++pos_;
+    }
+    return pos_ < text_.size() ? text_[pos_] : '\0';
+  }
+
+  std::string_view text_;
+  size_t pos_;
+};
+
+bool ReadHex4(std::string_view text, size_t pos, uint32_t &value) {
+  if (pos + 4 > text.size()) {
+    return false;
+  }
+  value = 0;
+  for (size_t i = pos; i < pos + 4; ++i) {
+    char c = text[i];
+    value <<= 4;
+    if (IsDigit(c)) {
+      value |= c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      value |= c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      value |= c - 'A' + 10;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+void AppendUtf8(uint32_t code_point, std::string &out) {
+  if (code_point <= 0x7f) {
+    out.push_back(static_cast<char>(code_point));
+  } else if (code_point <= 0x7ff) {
+    out.push_back(static_cast<char>(0xc0 | (code_point >> 6)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  } else if (code_point <= 0xffff) {
+    out.push_back(static_cast<char>(0xe0 | (code_point >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  } else {
+    out.push_back(static_cast<char>(0xf0 | (code_point >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3f)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  }
+}
+
+// decodes a JSON string content like Json::Reader does
+bool Unescape(std::string_view text, std::string &out) {
+  out.clear();
+  out.reserve(text.size());
+  size_t pos = 0;
+  while (pos < text.size()) {
+    const void *found =
+        memchr(text.data() + pos, '\\', text.size() - pos);
+    size_t escape = found ? static_cast<const char *>(found) - text.data()
+                          : text.size();
+    out.append(text.data() + pos, escape - pos);
+    if (escape + 1 >= text.size()) {
+      return escape == text.size();
+    }
+    pos = escape + 2;
+    switch (text[escape + 1]) {
+      case '"':
+        out.push_back('"');
+        break;
+      case '\\':
+        out.push_back('\\');
+        break;
+      case '/':
+        out.push_back('/');
+        break;
+      case 'b':
+        out.push_back('\b');
+        break;
+      case 'f':
+        out.push_back('\f');
+        break;
+      case 'n':
+        out.push_back('\n');
+        break;
+      case 'r':
+        out.push_back('\r');
+        break;
+      case 't':
+        out.push_back('\t');
+        break;
+      case 'u': {
+        uint32_t code_point = 0;
+        if (!ReadHex4(text, pos, code_point)) {
+          return false;
+        }
+        pos += 4;
+        if (code_point >= 0xd800 && code_point <= 0xdbff) {
+          // the second half of a surrogate pair has to follow
+          uint32_t low = 0;
+          if (text.compare(pos, 2, "\\u") != 0 ||
+              !ReadHex4(text, pos + 2, low) || low < 0xdc00 || low > 0xdfff) {
+            return false;
+          }
+          pos += 6;
+          code_point = 0x10000 + ((code_point & 0x3ff) << 10) + (low & 0x3ff);
+        }
+        AppendUtf8(code_point, out);
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool ParseMessageEnvelope(std::string_view text, MessageEnvelope &envelope) {
+  return EnvelopeScanner(text).Parse(envelope);
+}
+
+bool IsJsonValue(std::string_view text) {
+  return EnvelopeScanner(text).ParseValue();
+}
+
+bool ReadEnvelopeMessage(const MessageEnvelope &envelope,
+                         std::string &message) {
+  if (!envelope.has_message) {
+    return false;
+  }
+  if (!envelope.message_is_string) {
+    message.assign(envelope.message.data(), envelope.message.size());
+    return true;
+  }
+  return Unescape(envelope.message, message);
+}
+
+}  // namespace protocol
+}  // namespace debugrouter
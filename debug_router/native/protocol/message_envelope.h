@@ -0,0 +1,58 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_PROTOCOL_MESSAGE_ENVELOPE_H_
+#define DEBUGROUTER_NATIVE_PROTOCOL_MESSAGE_ENVELOPE_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace debugrouter {
+namespace protocol {
+
+/**
+ * The routing fields of an inbound message:
+ *
+ *   {"event": "Customized",
+ *    "data": {"type": "CDP", "sender": 1,
+ *             "data": {"client_id": 2, "session_id": 3, "message": ...}}}
+ *
+ * They are read in one pass without building a Json::Value, the message is
+ * only located. Views point into the parsed text.
+ */
+struct MessageEnvelope {
+  std::string_view event;
+  // data.type
+  std::string_view type;
+  bool has_sender = false;
+  int32_t sender = 0;
+  // data.data.client_id
+  bool has_client_id = false;
+  int32_t client_id = 0;
+  // data.data.session_id
+  bool has_session_id = false;
+  int32_t session_id = 0;
+  // data.data.message: the escaped content of a string, or a whole object
+  bool has_message = false;
+  bool message_is_string = false;
+  std::string_view message;
+};
+
+// false if text is not a JSON object or the envelope uses something the
+// scanner does not handle, e.g. escaped keys or non-integer ids. Callers
+// parse text with Json::Reader then.
+bool ParseMessageEnvelope(std::string_view text, MessageEnvelope &envelope);
+
+// true if text is exactly one JSON value
+bool IsJsonValue(std::string_view text);
+
+// the message of envelope as passed to slots, a string is unescaped. False if
+// there is none or it has an invalid escape.
+bool ReadEnvelopeMessage(const MessageEnvelope &envelope, std::string &message);
+
+}  // namespace protocol
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_PROTOCOL_MESSAGE_ENVELOPE_H_
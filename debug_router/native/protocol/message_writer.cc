@@ -0,0 +1,165 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/protocol/message_writer.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "debug_router/native/base/string_kernels.h"
+#include "debug_router/native/log/logging.h"
+#include "debug_router/native/protocol/message_envelope.h"
+#include "debug_router/native/protocol/protocol.h"
+
+namespace debugrouter {
+namespace protocol {
+
+namespace {
+
+// digits of the widest 64 bit integer and a sign
+constexpr size_t kMaxIntSize = 20;
+
+template <typename Integer>
+void AppendInt(Integer value, std::string &out) {
+  char buffer[kMaxIntSize];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  if (result.ec != std::errc()) {
+    LOGE("AppendInt: failed to format " << value);
+    out.push_back('0');
+    return;
+  }
+  out.append(buffer, result.ptr - buffer);
+}
+
+// a locale may format the decimal point as ','
+void AppendNumber(char *buffer, int size, std::string &out) {
+  for (int i = 0; i < size; ++i) {
+    if (buffer[i] == ',') {
+      buffer[i] = '.';
+    }
+  }
+  out.append(buffer, size);
+}
+
+// escaped_size is base::JsonEscapedSize(value)
+void AppendEscapedString(std::string_view value, size_t escaped_size,
+                         std::string &out) {
+  out.push_back('"');
+  if (escaped_size == value.size()) {
+    out.append(value);
+  } else {
+    size_t begin = out.size();
+    out.resize(begin + escaped_size);
+    base::JsonEscape(value, &out[begin]);
+  }
+  out.push_back('"');
+}
+
+void AppendKey(const char *key, std::string &out) {
+  out.push_back('"');
+  out.append(key);
+  out.append("\":");
+}
+
+}  // namespace
+
+size_t JsonStringSize(std::string_view value) {
+  return base::JsonEscapedSize(value) + 2;
+}
+
+void AppendJsonString(std::string_view value, std::string &out) {
+  AppendEscapedString(value, base::JsonEscapedSize(value), out);
+}
+
+std::string WriteCustomizedMessage(std::string_view type, uint32_t client_id,
+                                   int32_t session_id,
+                                   std::string_view message, bool is_object,
+                                   int32_t mark) {
+  if (is_object && !IsJsonValue(message)) {
+    LOGW("WriteCustomizedMessage: message is not valid JSON.");
+    message = "null";
+  }
+  // the message is escaped with the size counted here
+  size_t message_size =
+      is_object ? message.size() : base::JsonEscapedSize(message);
+  // keys are written in the order Json::Value sorts them
+  size_t size =
+      128 + 4 * kMaxIntSize + JsonStringSize(type) + message_size + 2;
+  std::string out;
+  out.reserve(size);
+  out.push_back('{');
+  AppendKey(kKeyData, out);
+  out.push_back('{');
+  AppendKey(kKeyData, out);
+  out.push_back('{');
+  AppendKey(kKeyClientId, out);
+  AppendInt(client_id, out);
+  out.push_back(',');
+  AppendKey(kKeyMessage, out);
+  if (is_object) {
+    out.append(message);
+  } else {
+    AppendEscapedString(message, message_size, out);
+  }
+  out.push_back(',');
+  AppendKey(kKeySessionId, out);
+  AppendInt(session_id, out);
+  out.append("},");
+  AppendKey(kKeySender, out);
+  AppendInt(client_id, out);
+  out.push_back(',');
+  AppendKey(kKeyType, out);
+  AppendJsonString(type, out);
+  out.append("},");
+  AppendKey(kKeyEvent, out);
+  AppendJsonString(kRemoteDebugServerEvent4Custom, out);
+  if (mark > -1) {
+    out.push_back(',');
+    AppendKey(kKeyMark, out);
+    AppendInt(mark, out);
+  }
+  out.push_back('}');
+  return out;
+}
+
+namespace json {
+
+void AppendInteger(int64_t value, std::string &out) { AppendInt(value, out); }
+
+void AppendInteger(uint64_t value, std::string &out) { AppendInt(value, out); }
+
+void AppendValue(float value, std::string &out) {
+  if (!std::isfinite(value)) {
+    out.append("null");
+    return;
+  }
+  // 9 significant digits always read back as the same float
+  char buffer[32];
+  int size = 0;
+  for (int precision = 6; precision <= 9; ++precision) {
+    size = snprintf(buffer, sizeof(buffer), "%.*g", precision,
+                    static_cast<double>(value));
+    if (precision == 9 || strtof(buffer, nullptr) == value) {
+      break;
+    }
+  }
+  AppendNumber(buffer, size, out);
+}
+
+void AppendValue(double value, std::string &out) {
+  if (!std::isfinite(value)) {
+    out.append("null");
+    return;
+  }
+  char buffer[32];
+  int size = snprintf(buffer, sizeof(buffer), "%.17g", value);
+  AppendNumber(buffer, size, out);
+}
+
+}  // namespace json
+
+}  // namespace protocol
+}  // namespace debugrouter
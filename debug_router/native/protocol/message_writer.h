@@ -0,0 +1,168 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_PROTOCOL_MESSAGE_WRITER_H_
+#define DEBUGROUTER_NATIVE_PROTOCOL_MESSAGE_WRITER_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+
+namespace debugrouter {
+namespace protocol {
+
+// size of value written by AppendJsonString, quotes included
+size_t JsonStringSize(std::string_view value);
+// appends value as a quoted JSON string, escaped like Json::Value does
+void AppendJsonString(std::string_view value, std::string &out);
+
+/**
+ * Writes the Customized envelope of a CDP or extension message:
+ *
+ *   {"data":{"data":{"client_id":..,"message":..,"session_id":..},
+ *            "sender":..,"type":..},"event":"Customized","mark":..}
+ *
+ * into one buffer of the exact size. It is the compact form of what
+ * Processor::WrapCustomizedMessage built with Json::Value. An object message
+ * is copied verbatim instead of being parsed and written again, one that is
+ * not valid JSON is written as null. mark is omitted when negative.
+ */
+std::string WriteCustomizedMessage(std::string_view type, uint32_t client_id,
+                                   int32_t session_id,
+                                   std::string_view message, bool is_object,
+                                   int32_t mark);
+
+/**
+ * Compact writers for messages of a fixed shape. The shape is spelled out
+ * with Object and Member, the templates expand to the appends for it:
+ *
+ *   json::AppendValue(
+ *       json::Object(json::Member("method", "Page.enable"),
+ *                    json::Member("params",
+ *                                 json::Object(json::Member("a", true)))),
+ *       out);
+ *
+ * Members keep a reference to their value, so the shape has to be written in
+ * the expression that builds it.
+ */
+namespace json {
+
+// a value that is already serialized JSON
+struct Raw {
+  std::string_view json;
+};
+
+template <typename T>
+struct MemberRef {
+  std::string_view key;
+  const T &value;
+};
+
+template <typename... T>
+struct ObjectRef {
+  std::tuple<MemberRef<T>...> members;
+};
+
+template <typename T>
+MemberRef<T> Member(std::string_view key, const T &value) {
+  return {key, value};
+}
+
+template <typename... T>
+ObjectRef<T...> Object(MemberRef<T>... members) {
+  return {std::tuple<MemberRef<T>...>(members...)};
+}
+
+inline void AppendValue(std::string_view value, std::string &out) {
+  AppendJsonString(value, out);
+}
+
+inline void AppendValue(const std::string &value, std::string &out) {
+  AppendJsonString(value, out);
+}
+
+inline void AppendValue(const char *value, std::string &out) {
+  AppendJsonString(value, out);
+}
+
+inline void AppendValue(bool value, std::string &out) {
+  out.append(value ? "true" : "false");
+}
+
+void AppendInteger(int64_t value, std::string &out);
+void AppendInteger(uint64_t value, std::string &out);
+
+template <typename T,
+          typename std::enable_if<std::is_integral<T>::value &&
+                                      !std::is_same<T, bool>::value,
+                                  int>::type = 0>
+void AppendValue(T value, std::string &out) {
+  using Integer = typename std::conditional<std::is_signed<T>::value, int64_t,
+                                            uint64_t>::type;
+  AppendInteger(static_cast<Integer>(value), out);
+}
+
+// the shortest form that reads back as the same float, null if not finite
+void AppendValue(float value, std::string &out);
+void AppendValue(double value, std::string &out);
+
+inline void AppendValue(Raw value, std::string &out) {
+  out.append(value.json);
+}
+
+template <typename T>
+void AppendValue(const std::unordered_map<std::string, T> &map,
+                 std::string &out) {
+  out.push_back('{');
+  bool first = true;
+  for (const auto &item : map) {
+    if (!first) {
+      out.push_back(',');
+    }
+    first = false;
+    AppendJsonString(item.first, out);
+    out.push_back(':');
+    AppendValue(item.second, out);
+  }
+  out.push_back('}');
+}
+
+template <typename T>
+void AppendMember(const MemberRef<T> &member, bool &first, std::string &out) {
+  if (!first) {
+    out.push_back(',');
+  }
+  first = false;
+  AppendJsonString(member.key, out);
+  out.push_back(':');
+  AppendValue(member.value, out);
+}
+
+template <typename... T>
+void AppendValue(const ObjectRef<T...> &object, std::string &out) {
+  out.push_back('{');
+  bool first = true;
+  std::apply(
+      [&](const auto &...members) { (AppendMember(members, first, out), ...); },
+      object.members);
+  out.push_back('}');
+}
+
+// the compact JSON of value
+template <typename T>
+std::string Write(const T &value) {
+  std::string out;
+  AppendValue(value, out);
+  return out;
+}
+
+}  // namespace json
+
+}  // namespace protocol
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_PROTOCOL_MESSAGE_WRITER_H_
@@ -35,6 +35,8 @@ const char *kRemoteDebugProtocolBodyData4Custom4R2DStopLepusAtEntry =
     "R2DStopLepusAtEntry";
 const char *kRemoteDebugProtocolBodyData4Custom4OpenCard = "OpenCard";
 const char *kRemoteDebugProtocolBodyData4Custom4OpenType4Url = "url";
+const char *kRemoteDebugProtocolBodyData4Custom4BinaryScreencast =
+    "BinaryScreencast";
 
 const char *kKeyId = "id";
 const char *kKeyRoom = "room";
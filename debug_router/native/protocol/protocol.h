@@ -11,6 +11,7 @@
 
 #include "debug_router/native/log/logging.h"
 #include "debug_router/native/protocol/md5.h"
+#include "debug_router/native/protocol/message_writer.h"
 #include "json/json.h"
 
 namespace debugrouter {
@@ -38,6 +39,9 @@ extern const char *kRemoteDebugProtocolBodyData4Custom4D2RStopLepusAtEntry;
 extern const char *kRemoteDebugProtocolBodyData4Custom4R2DStopLepusAtEntry;
 extern const char *kRemoteDebugProtocolBodyData4Custom4OpenCard;
 extern const char *kRemoteDebugProtocolBodyData4Custom4OpenType4Url;
+// "true" from the debugger enables binary screencast frames, the router
+// answers with the resulting state
+extern const char *kRemoteDebugProtocolBodyData4Custom4BinaryScreencast;
 
 extern const char *kKeyId;
 extern const char *kKeyRoom;
@@ -202,22 +206,32 @@ struct AppMessageData : public Stringifiable {
   AppMessageDataUnionType union_type_;
 
   void Stringify(Json::Value &ref) override {
-    Json::Value value(Json::objectValue);
-    value[kKeyMethod] = method_;
-    value[kKeyId] = id_;
+    const char *key = nullptr;
+    const std::string *content = nullptr;
     switch (union_type_) {
       case kParams:
-        value[kKeyParams] = params_;
+        key = kKeyParams;
+        content = &params_;
         break;
       case kResult:
-        value[kKeyResult] = result_;
+        key = kKeyResult;
+        content = &result_;
         break;
       case kError:
-        value[kKeyError] = error_;
+        key = kKeyError;
+        content = &error_;
       default:
         LOGE("AppMessageData Stringify: unknown type");
     }
-    ref[kKeyMessage] = value.toStyledString();
+    if (content) {
+      ref[kKeyMessage] = json::Write(
+          json::Object(json::Member(kKeyId, id_),
+                       json::Member(kKeyMethod, method_),
+                       json::Member(std::string_view(key), *content)));
+    } else {
+      ref[kKeyMessage] = json::Write(json::Object(
+          json::Member(kKeyId, id_), json::Member(kKeyMethod, method_)));
+    }
   }
 
   ~AppMessageData() {}
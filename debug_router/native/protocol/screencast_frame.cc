@@ -0,0 +1,62 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/protocol/screencast_frame.h"
+
+#include "debug_router/native/core/util.h"
+#include "debug_router/native/protocol/message_writer.h"
+#include "debug_router/native/protocol/protocol.h"
+
+namespace debugrouter {
+namespace protocol {
+
+const uint32_t kBinaryMessageKind4ScreencastFrame = 1;
+
+namespace {
+
+// kind and header_size
+constexpr size_t kFramePrefixSize = 8;
+
+uint32_t ReadUInt32(std::string_view payload, size_t offset) {
+  char value[4];
+  payload.copy(value, sizeof(value), offset);
+  return util::DecodePayloadSize(value, sizeof(value));
+}
+
+}  // namespace
+
+std::string WriteBinaryScreencastFrame(
+    uint32_t client_id, int32_t session_id,
+    const std::unordered_map<std::string, float> &metadata,
+    std::string_view image) {
+  std::string header = json::Write(json::Object(
+      json::Member(kKeyClientId, client_id), json::Member("metadata", metadata),
+      json::Member(kKeySessionId, session_id)));
+  std::string frame;
+  frame.reserve(kFramePrefixSize + header.size() + image.size());
+  frame.resize(kFramePrefixSize);
+  util::IntToCharArray(kBinaryMessageKind4ScreencastFrame, &frame[0]);
+  util::IntToCharArray(static_cast<uint32_t>(header.size()), &frame[4]);
+  frame.append(header);
+  frame.append(image);
+  return frame;
+}
+
+bool ReadBinaryScreencastFrame(std::string_view payload,
+                               BinaryScreencastFrame &frame) {
+  if (payload.size() < kFramePrefixSize ||
+      ReadUInt32(payload, 0) != kBinaryMessageKind4ScreencastFrame) {
+    return false;
+  }
+  uint32_t header_size = ReadUInt32(payload, 4);
+  if (payload.size() - kFramePrefixSize < header_size) {
+    return false;
+  }
+  frame.header = payload.substr(kFramePrefixSize, header_size);
+  frame.image = payload.substr(kFramePrefixSize + header_size);
+  return true;
+}
+
+}  // namespace protocol
+}  // namespace debugrouter
@@ -0,0 +1,52 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_PROTOCOL_SCREENCAST_FRAME_H_
+#define DEBUGROUTER_NATIVE_PROTOCOL_SCREENCAST_FRAME_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace debugrouter {
+namespace protocol {
+
+// kind of a binary message, the first 4 bytes of its payload
+extern const uint32_t kBinaryMessageKind4ScreencastFrame;
+
+/**
+ * A screencast frame sent as a binary message once the debugger enabled
+ * them with a BinaryScreencast message:
+ *
+ *  struct BinaryScreencastFrame {
+ *    uint32_t kind,             // [0, 4) kBinaryMessageKind4ScreencastFrame
+ *    uint32_t header_size,      // [4, 8)
+ *    char header[header_size],  // {"client_id":..,"metadata":{..},
+ *                               //  "session_id":..}
+ *    char image[],              // the encoded image, e.g. JPEG or PNG
+ *  }
+ *
+ * Integers are big-endian like the USB frame header. Unlike
+ * Page.screencastFrame the image is neither base64-encoded nor embedded in a
+ * JSON string.
+ */
+struct BinaryScreencastFrame {
+  std::string_view header;
+  std::string_view image;
+};
+
+std::string WriteBinaryScreencastFrame(
+    uint32_t client_id, int32_t session_id,
+    const std::unordered_map<std::string, float> &metadata,
+    std::string_view image);
+
+// false if payload is not a screencast frame. Views point into payload.
+bool ReadBinaryScreencastFrame(std::string_view payload,
+                               BinaryScreencastFrame &frame);
+
+}  // namespace protocol
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_PROTOCOL_SCREENCAST_FRAME_H_
@@ -0,0 +1,435 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/socket/event_loop.h"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+
+#include "debug_router/native/base/no_destructor.h"
+#include "debug_router/native/log/logging.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#else
+#include <poll.h>
+#endif
+#endif
+
+namespace debugrouter {
+namespace socket_server {
+
+namespace {
+
+struct ReadyEvent {
+  SocketType socket;
+  uint32_t events;
+};
+
+void CloseSocketHandle(SocketType socket) {
+#ifdef _WIN32
+  closesocket(socket);
+#else
+  close(socket);
+#endif
+}
+
+}  // namespace
+
+#if defined(__linux__)
+// max events returned by one epoll_wait
+constexpr int kMaxEvents = 64;
+
+class Poller {
+ public:
+  Poller() : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)) {
+    if (epoll_fd_ < 0) {
+      LOGE("EventLoop: epoll_create1 error: " << errno);
+    }
+  }
+
+  ~Poller() {
+    if (epoll_fd_ >= 0) {
+      close(epoll_fd_);
+    }
+  }
+
+  bool Add(SocketType socket, uint32_t events) {
+    return Control(EPOLL_CTL_ADD, socket, events);
+  }
+
+  bool Modify(SocketType socket, uint32_t events) {
+    return Control(EPOLL_CTL_MOD, socket, events);
+  }
+
+  void Remove(SocketType socket) {
+    struct epoll_event event = {};
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket, &event);
+  }
+
+  void Wait(std::vector<ReadyEvent> &ready) {
+    struct epoll_event events[kMaxEvents];
+    int count = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+    if (count < 0) {
+      if (errno != EINTR) {
+        LOGE("EventLoop: epoll_wait error: " << errno);
+      }
+      return;
+    }
+    for (int i = 0; i < count; ++i) {
+      uint32_t ready_events = 0;
+      if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+        ready_events |= kEventReadable;
+      }
+      if (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+        ready_events |= kEventWritable;
+      }
+      ready.push_back({events[i].data.fd, ready_events});
+    }
+  }
+
+ private:
+  bool Control(int operation, SocketType socket, uint32_t events) {
+    struct epoll_event event = {};
+    event.data.fd = socket;
+    if (events & kEventReadable) {
+      event.events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (events & kEventWritable) {
+      event.events |= EPOLLOUT;
+    }
+    if (epoll_ctl(epoll_fd_, operation, socket, &event) != 0) {
+      LOGE("EventLoop: epoll_ctl error: " << errno << " socket: " << socket);
+      return false;
+    }
+    return true;
+  }
+
+  int epoll_fd_;
+};
+#else
+#ifdef _WIN32
+typedef WSAPOLLFD PollFd;
+#else
+typedef struct pollfd PollFd;
+#endif
+
+class Poller {
+ public:
+  bool Add(SocketType socket, uint32_t events) {
+    PollFd fd = {};
+    fd.fd = socket;
+    fd.events = ToPollEvents(events);
+    fds_.push_back(fd);
+    return true;
+  }
+
+  bool Modify(SocketType socket, uint32_t events) {
+    auto it = Find(socket);
+    if (it == fds_.end()) {
+      return false;
+    }
+    it->events = ToPollEvents(events);
+    return true;
+  }
+
+  void Remove(SocketType socket) {
+    auto it = Find(socket);
+    if (it != fds_.end()) {
+      fds_.erase(it);
+    }
+  }
+
+  void Wait(std::vector<ReadyEvent> &ready) {
+    // callbacks may change fds_, poll a copy
+    std::vector<PollFd> fds = fds_;
+#ifdef _WIN32
+    int count = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), -1);
+#else
+    int count = poll(fds.data(), static_cast<nfds_t>(fds.size()), -1);
+#endif
+    if (count < 0) {
+#ifndef _WIN32
+      if (errno == EINTR) {
+        return;
+      }
+#endif
+      LOGE("EventLoop: poll error.");
+      return;
+    }
+    for (const PollFd &fd : fds) {
+      if (fd.revents == 0) {
+        continue;
+      }
+      uint32_t ready_events = 0;
+      if (fd.revents & (POLLIN | POLLERR | POLLHUP | POLLNVAL)) {
+        ready_events |= kEventReadable;
+      }
+      if (fd.revents & (POLLOUT | POLLERR | POLLHUP)) {
+        ready_events |= kEventWritable;
+      }
+      ready.push_back({fd.fd, ready_events});
+    }
+  }
+
+ private:
+  static short ToPollEvents(uint32_t events) {
+    short poll_events = 0;
+    if (events & kEventReadable) {
+      poll_events |= POLLIN;
+    }
+    if (events & kEventWritable) {
+      poll_events |= POLLOUT;
+    }
+    return poll_events;
+  }
+
+  std::vector<PollFd>::iterator Find(SocketType socket) {
+    return std::find_if(fds_.begin(), fds_.end(),
+                        [socket](const PollFd &fd) { return fd.fd == socket; });
+  }
+
+  std::vector<PollFd> fds_;
+};
+#endif
+
+EventLoop &EventLoop::GetInstance() {
+  static base::NoDestructor<EventLoop> instance;
+  return *instance;
+}
+
+EventLoop::EventLoop()
+    : poller_(std::make_unique<Poller>()),
+      wakeup_pending_(false),
+      wakeup_read_(kInvalidSocket),
+      wakeup_write_(kInvalidSocket),
+      running_(true) {
+#ifdef _WIN32
+  WSADATA wsa_data;
+  int startup_result = WSAStartup(MAKEWORD(2, 2), &wsa_data);
+  if (startup_result != 0) {
+    LOGE("EventLoop: WSAStartup failed: " << startup_result);
+  }
+  // a udp socket connected to itself, readable when a byte is sent to it
+  SocketType wakeup = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int addr_len = sizeof(addr);
+  if (wakeup == kInvalidSocket ||
+      bind(wakeup, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      getsockname(wakeup, (struct sockaddr *)&addr, &addr_len) != 0 ||
+      connect(wakeup, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    LOGE("EventLoop: create wakeup socket error: " << WSAGetLastError());
+  }
+  u_long non_blocking = 1;
+  ioctlsocket(wakeup, FIONBIO, &non_blocking);
+  wakeup_read_ = wakeup;
+  wakeup_write_ = wakeup;
+#elif defined(__linux__)
+  // a counter that is readable while it is not 0, one fd and one read
+  int wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeup < 0) {
+    LOGE("EventLoop: create wakeup eventfd error: " << errno);
+  } else {
+    wakeup_read_ = wakeup;
+    wakeup_write_ = wakeup;
+  }
+#else
+  int fds[2];
+  if (pipe(fds) != 0) {
+    LOGE("EventLoop: create wakeup pipe error: " << errno);
+  } else {
+    for (int fd : fds) {
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    wakeup_read_ = fds[0];
+    wakeup_write_ = fds[1];
+  }
+#endif
+  poller_->Add(wakeup_read_, kEventReadable);
+  thread_ = std::thread([this]() { Run(); });
+}
+
+EventLoop::~EventLoop() {
+  running_.store(false);
+  Wakeup();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  poller_->Remove(wakeup_read_);
+  CloseSocketHandle(wakeup_read_);
+  if (wakeup_write_ != wakeup_read_) {
+    CloseSocketHandle(wakeup_write_);
+  }
+}
+
+bool EventLoop::IsInLoopThread() const {
+  return std::this_thread::get_id() == thread_id_.load();
+}
+
+void EventLoop::Post(Task task) {
+  bool wakeup = false;
+  {
+    std::lock_guard<std::mutex> lock(task_mutex_);
+    tasks_.push_back(std::move(task));
+    wakeup = !wakeup_pending_;
+    wakeup_pending_ = true;
+  }
+  if (wakeup) {
+    Wakeup();
+  }
+}
+
+void EventLoop::PostAndWait(Task task) {
+  if (IsInLoopThread()) {
+    task();
+    return;
+  }
+  std::promise<void> done;
+  std::future<void> future = done.get_future();
+  Post([&task, &done]() {
+    task();
+    done.set_value();
+  });
+  future.wait();
+}
+
+void EventLoop::Watch(SocketType socket, uint32_t events,
+                      EventCallback callback) {
+  if (socket == kInvalidSocket) {
+    return;
+  }
+  auto watcher = std::make_shared<Watcher>();
+  watcher->events = events;
+  watcher->callback = std::move(callback);
+  if (watchers_.count(socket) > 0) {
+    poller_->Modify(socket, events);
+  } else if (!poller_->Add(socket, events)) {
+    return;
+  }
+  watchers_[socket] = std::move(watcher);
+}
+
+void EventLoop::Update(SocketType socket, uint32_t events) {
+  auto it = watchers_.find(socket);
+  if (it == watchers_.end() || it->second->events == events) {
+    return;
+  }
+  it->second->events = events;
+  poller_->Modify(socket, events);
+}
+
+void EventLoop::Unwatch(SocketType socket) {
+  auto it = watchers_.find(socket);
+  if (it == watchers_.end()) {
+    return;
+  }
+  poller_->Remove(socket);
+  watchers_.erase(it);
+}
+
+void EventLoop::Close(SocketType socket) {
+  if (socket == kInvalidSocket) {
+    return;
+  }
+  auto close_task = [this, socket]() {
+    Unwatch(socket);
+    CloseSocketHandle(socket);
+  };
+  if (IsInLoopThread()) {
+    close_task();
+  } else {
+    Post(close_task);
+  }
+}
+
+void EventLoop::Run() {
+  thread_id_.store(std::this_thread::get_id());
+  LOGI("EventLoop: start.");
+  std::vector<ReadyEvent> ready;
+  while (running_.load()) {
+    ready.clear();
+    poller_->Wait(ready);
+    for (const ReadyEvent &event : ready) {
+      if (event.socket == wakeup_read_) {
+        DrainWakeup();
+        continue;
+      }
+      auto it = watchers_.find(event.socket);
+      if (it == watchers_.end()) {
+        continue;
+      }
+      // keeps the watcher alive if the callback unwatches the socket
+      std::shared_ptr<Watcher> watcher = it->second;
+      uint32_t events = event.events & (watcher->events | kEventReadable);
+      if (events != 0) {
+        watcher->callback(events);
+      }
+    }
+    RunTasks();
+  }
+  // tasks posted while stopping, PostAndWait callers wait for them
+  RunTasks();
+  LOGI("EventLoop: stop.");
+}
+
+void EventLoop::Wakeup() {
+#ifdef _WIN32
+  char byte = 1;
+  send(wakeup_write_, &byte, 1, 0);
+#elif defined(__linux__)
+  uint64_t one = 1;
+  ssize_t result = write(wakeup_write_, &one, sizeof(one));
+  (void)result;
+#else
+  char byte = 1;
+  // a full pipe already wakes the loop
+  ssize_t result = write(wakeup_write_, &byte, 1);
+  (void)result;
+#endif
+}
+
+void EventLoop::DrainWakeup() {
+#ifdef _WIN32
+  char buffer[64];
+  while (recv(wakeup_read_, buffer, sizeof(buffer), 0) > 0) {
+  }
+#elif defined(__linux__)
+  // reading resets the counter
+  uint64_t count;
+  ssize_t result = read(wakeup_read_, &count, sizeof(count));
+  (void)result;
+#else
+  char buffer[64];
+  while (read(wakeup_read_, buffer, sizeof(buffer)) > 0) {
+  }
+#endif
+}
+
+void EventLoop::RunTasks() {
+  std::vector<Task> tasks;
+  {
+    std::lock_guard<std::mutex> lock(task_mutex_);
+    tasks.swap(tasks_);
+    wakeup_pending_ = false;
+  }
+  for (Task &task : tasks) {
+    task();
+  }
+}
+
+}  // namespace socket_server
+}  // namespace debugrouter
@@ -0,0 +1,98 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_SOCKET_EVENT_LOOP_H_
+#define DEBUGROUTER_NATIVE_SOCKET_EVENT_LOOP_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "debug_router/native/socket/socket_server_type.h"
+
+namespace debugrouter {
+namespace socket_server {
+
+constexpr uint32_t kEventReadable = 1 << 0;
+constexpr uint32_t kEventWritable = 1 << 1;
+
+class Poller;
+
+/**
+ * Single reactor thread that owns every socket of the transports: the listen
+ * socket of SocketServer, the UsbClient sockets and the WebSocketTask
+ * socket. Sockets are non-blocking and their owners are state machines
+ * driven by readiness callbacks, so connections do not need threads of
+ * their own.
+ *
+ * The backend is epoll on Linux/Android and poll (WSAPoll on Windows)
+ * elsewhere. The loop sleeps without a timeout, posted tasks wake it through
+ * an eventfd on Linux/Android, a pipe or a udp socket elsewhere, so idle
+ * connections cost no wakeups and stopping one takes one round trip.
+ */
+class EventLoop {
+ public:
+  using Task = std::function<void()>;
+  // called on the loop thread with the ready events. Errors and hang-ups are
+  // reported as readable, and also as writable when writable is watched, so
+  // that the following recv/send reports them.
+  using EventCallback = std::function<void(uint32_t events)>;
+
+  // the loop shared by all transports, started on first use.
+  static EventLoop &GetInstance();
+
+  // starts the loop thread, the destructor stops and joins it.
+  EventLoop();
+  ~EventLoop();
+
+  // can be called from any thread, tasks run in order on the loop thread.
+  void Post(Task task);
+  // runs task on the loop thread and waits for it to finish, runs it
+  // directly when called on the loop thread.
+  void PostAndWait(Task task);
+  bool IsInLoopThread() const;
+
+  // the following must be called on the loop thread. A socket has to be
+  // unwatched before it is closed.
+  void Watch(SocketType socket, uint32_t events, EventCallback callback);
+  void Update(SocketType socket, uint32_t events);
+  void Unwatch(SocketType socket);
+  // unwatches and closes the socket on the loop thread, can be called from
+  // any thread.
+  void Close(SocketType socket);
+
+ private:
+  void Run();
+  void Wakeup();
+  void DrainWakeup();
+  void RunTasks();
+
+  struct Watcher {
+    uint32_t events;
+    EventCallback callback;
+  };
+
+  std::unique_ptr<Poller> poller_;
+  // watchers are shared so that a callback can unwatch its own socket
+  std::unordered_map<SocketType, std::shared_ptr<Watcher>> watchers_;
+  std::mutex task_mutex_;
+  std::vector<Task> tasks_;
+  // set when the wakeup socket has been written and tasks_ not run yet
+  bool wakeup_pending_;
+  SocketType wakeup_read_;
+  SocketType wakeup_write_;
+  std::atomic<bool> running_;
+  std::atomic<std::thread::id> thread_id_;
+  std::thread thread_;
+};
+
+}  // namespace socket_server
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_SOCKET_EVENT_LOOP_H_
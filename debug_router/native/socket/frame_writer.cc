@@ -0,0 +1,216 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/socket/frame_writer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "debug_router/native/log/logging.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+namespace debugrouter {
+namespace socket_server {
+
+namespace {
+
+// slices passed to one syscall, below the IOV_MAX of every platform
+constexpr size_t kMaxSlicesPerWrite = 64;
+// FrameQueue::Flush gathers frames into one write up to this many bytes, so
+// that an urgent frame does not wait for a long write
+constexpr size_t kMaxBytesPerWrite = 256 * 1024;
+
+#ifdef _WIN32
+using IoSlice = WSABUF;
+
+void SetSlice(IoSlice &slice, const FrameSlice &frame_slice) {
+  slice.buf = const_cast<char *>(frame_slice.data);
+  slice.len = static_cast<ULONG>(frame_slice.size);
+}
+
+// returns bytes written or -1
+int64_t WriteOnce(SocketType socket, IoSlice *slices, size_t count) {
+  DWORD sent = 0;
+  if (WSASend(socket, slices, static_cast<DWORD>(count), &sent, 0, nullptr,
+              nullptr) != 0) {
+    return -1;
+  }
+  return static_cast<int64_t>(sent);
+}
+#else
+using IoSlice = struct iovec;
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+// SO_NOSIGPIPE is set in SetFrameSocketOptions
+constexpr int kSendFlags = 0;
+#endif
+
+void SetSlice(IoSlice &slice, const FrameSlice &frame_slice) {
+  slice.iov_base = const_cast<char *>(frame_slice.data);
+  slice.iov_len = frame_slice.size;
+}
+
+int64_t WriteOnce(SocketType socket, IoSlice *slices, size_t count) {
+  struct msghdr message = {};
+  message.msg_iov = slices;
+  message.msg_iovlen = count;
+  while (true) {
+    ssize_t sent = sendmsg(socket, &message, kSendFlags);
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    return static_cast<int64_t>(sent);
+  }
+}
+#endif
+
+}  // namespace
+
+void SetFrameSocketOptions(SocketType socket) {
+  if (socket == kInvalidSocket) {
+    return;
+  }
+  int enable = 1;
+  if (setsockopt(socket, IPPROTO_TCP, TCP_NODELAY,
+                 reinterpret_cast<const char *>(&enable),
+                 sizeof(enable)) != 0) {
+    LOGW("SetFrameSocketOptions: failed to set TCP_NODELAY.");
+  }
+#if !defined(_WIN32) && !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+  if (setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable)) !=
+      0) {
+    LOGW("SetFrameSocketOptions: failed to set SO_NOSIGPIPE.");
+  }
+#endif
+}
+
+bool SetNonBlocking(SocketType socket) {
+#ifdef _WIN32
+  u_long non_blocking = 1;
+  return ioctlsocket(socket, FIONBIO, &non_blocking) == 0;
+#else
+  int flags = fcntl(socket, F_GETFL);
+  return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool IsWouldBlockError() {
+#ifdef _WIN32
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+int64_t WriteSomeSlices(SocketType socket, const FrameSlice *slices,
+                        size_t count) {
+  IoSlice io_slices[kMaxSlicesPerWrite];
+  size_t io_count = 0;
+  for (size_t i = 0; i < count && io_count < kMaxSlicesPerWrite; ++i) {
+    if (slices[i].size > 0) {
+      SetSlice(io_slices[io_count++], slices[i]);
+    }
+  }
+  if (io_count == 0) {
+    return 0;
+  }
+  int64_t sent = WriteOnce(socket, io_slices, io_count);
+  if (sent < 0) {
+    return IsWouldBlockError() ? 0 : -1;
+  }
+  return sent;
+}
+
+void FrameQueue::Push(const char *header, size_t header_size,
+                      std::shared_ptr<const std::string> payload, size_t begin,
+                      size_t end, bool urgent) {
+  Frame frame;
+  header_size = std::min(header_size, kMaxHeaderSize);
+  if (header_size > 0) {
+    memcpy(frame.header, header, header_size);
+  }
+  frame.header_size = header_size;
+  frame.payload = std::move(payload);
+  frame.begin = begin;
+  frame.end = end;
+  frame.written = 0;
+  if (!urgent) {
+    frames_.push_back(std::move(frame));
+    return;
+  }
+  // a partially written frame has to be finished first
+  auto it = frames_.begin();
+  if (it != frames_.end() && it->written > 0) {
+    ++it;
+  }
+  frames_.insert(it, std::move(frame));
+}
+
+size_t FrameQueue::AppendSlices(const Frame &frame, FrameSlice *slices,
+                                size_t &count) {
+  size_t payload_size = frame.end - frame.begin;
+  const char *payload =
+      payload_size > 0 ? frame.payload->data() + frame.begin : nullptr;
+  if (frame.written < frame.header_size) {
+    slices[count++] = {frame.header + frame.written,
+                       frame.header_size - frame.written};
+    slices[count++] = {payload, payload_size};
+  } else {
+    size_t offset = frame.written - frame.header_size;
+    slices[count++] = {payload + offset, payload_size - offset};
+  }
+  return frame.header_size + payload_size - frame.written;
+}
+
+bool FrameQueue::Flush(SocketType socket) {
+  FrameSlice slices[kMaxSlicesPerWrite];
+  while (!frames_.empty()) {
+    // the frames from the front, up to the slice and byte budgets
+    size_t count = 0;
+    size_t bytes = 0;
+    for (auto it = frames_.begin(); it != frames_.end() &&
+                                    count + 2 <= kMaxSlicesPerWrite &&
+                                    bytes < kMaxBytesPerWrite;
+         ++it) {
+      bytes += AppendSlices(*it, slices, count);
+    }
+    int64_t sent = WriteSomeSlices(socket, slices, count);
+    if (sent < 0) {
+      return false;
+    }
+    if (sent == 0 && bytes > 0) {
+      return true;
+    }
+    // pops the written frames, the last one may be written partially
+    size_t remaining = static_cast<size_t>(sent);
+    while (!frames_.empty()) {
+      Frame &frame = frames_.front();
+      size_t left =
+          frame.header_size + frame.end - frame.begin - frame.written;
+      if (remaining < left) {
+        frame.written += remaining;
+        break;
+      }
+      remaining -= left;
+      frames_.pop_front();
+    }
+  }
+  return true;
+}
+
+}  // namespace socket_server
+}  // namespace debugrouter
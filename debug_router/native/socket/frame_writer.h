@@ -0,0 +1,94 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_SOCKET_FRAME_WRITER_H_
+#define DEBUGROUTER_NATIVE_SOCKET_FRAME_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "debug_router/native/socket/socket_server_type.h"
+
+namespace debugrouter {
+namespace socket_server {
+
+struct FrameSlice {
+  const char *data;
+  size_t size;
+};
+
+// sets TCP_NODELAY so that small frames are not delayed by Nagle, and
+// SO_NOSIGPIPE on platforms without MSG_NOSIGNAL.
+void SetFrameSocketOptions(SocketType socket);
+
+// puts the socket into non-blocking mode.
+bool SetNonBlocking(SocketType socket);
+// true if the last socket call failed because it would block.
+bool IsWouldBlockError();
+
+// writes as much of the slices as the socket accepts with a single gather
+// write (sendmsg/WSASend) of at most 64 slices, so a header and a payload go
+// out in one syscall without being copied into a single buffer. EINTR is
+// retried and a closed peer never raises SIGPIPE. Returns the bytes
+// written, 0 if the socket would block, or -1 on error.
+int64_t WriteSomeSlices(SocketType socket, const FrameSlice *slices,
+                        size_t count);
+
+/**
+ * Frames waiting to be written to a non-blocking socket. A frame is a small
+ * header copied into the queue and a range of a shared payload, so the
+ * fragments of a message and the copies sent to several sockets do not copy
+ * the payload.
+ */
+class FrameQueue {
+ public:
+  static constexpr size_t kMaxHeaderSize = 32;
+
+  // payload[begin, end) is written after the header. Urgent frames, e.g.
+  // websocket pongs, are written before the queued frames that have not
+  // started yet.
+  void Push(const char *header, size_t header_size,
+            std::shared_ptr<const std::string> payload, size_t begin,
+            size_t end, bool urgent = false);
+  void Push(const char *header, size_t header_size,
+            std::shared_ptr<const std::string> payload) {
+    size_t size = payload ? payload->size() : 0;
+    Push(header, header_size, std::move(payload), 0, size);
+  }
+
+  // writes queued frames until the queue is empty or the socket would
+  // block. Consecutive frames are gathered into one write, up to a byte
+  // budget. Returns false on error.
+  bool Flush(SocketType socket);
+
+  bool Empty() const { return frames_.empty(); }
+  size_t Size() const { return frames_.size(); }
+  void Clear() { frames_.clear(); }
+
+ private:
+  struct Frame {
+    char header[kMaxHeaderSize];
+    size_t header_size;
+    std::shared_ptr<const std::string> payload;
+    size_t begin;
+    size_t end;
+    // bytes of header and payload already written
+    size_t written;
+  };
+
+  // appends the unwritten parts of frame, at most 2 slices, and returns
+  // their size
+  static size_t AppendSlices(const Frame &frame, FrameSlice *slices,
+                             size_t &count);
+
+  std::deque<Frame> frames_;
+};
+
+}  // namespace socket_server
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_SOCKET_FRAME_WRITER_H_
@@ -0,0 +1,246 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/socket/outbound_scheduler.h"
+
+#include <algorithm>
+#include <optional>
+
+namespace debugrouter {
+namespace socket_server {
+
+namespace {
+
+constexpr size_t kControlLane =
+    static_cast<size_t>(core::MessagePriority::kControl);
+constexpr size_t kInteractiveLane =
+    static_cast<size_t>(core::MessagePriority::kInteractive);
+constexpr size_t kBulkLane = static_cast<size_t>(core::MessagePriority::kBulk);
+constexpr size_t kScreencastLane =
+    static_cast<size_t>(core::MessagePriority::kScreencast);
+// bytes a session sends in one turn, a lane sends its weight times more
+constexpr int64_t kQuantum = 16 * 1024;
+// weights of the interactive, bulk and screencast lanes
+constexpr int64_t kLaneWeights[core::kMessagePriorityCount] = {0, 8, 2, 1};
+
+size_t GetLane(const core::OutboundMessage &message) {
+  return std::min(static_cast<size_t>(message.priority),
+                  core::kMessagePriorityCount - 1);
+}
+
+}  // namespace
+
+OutboundScheduler::OutboundScheduler(size_t screencast_capacity) {
+  lanes_[kScreencastLane].capacity = screencast_capacity;
+}
+
+void OutboundScheduler::set_limit(core::MessagePriority priority,
+                                  size_t capacity, OverflowPolicy policy) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Lane &lane = lanes_[std::min(static_cast<size_t>(priority),
+                               core::kMessagePriorityCount - 1)];
+  lane.capacity = capacity;
+  lane.policy = policy;
+  // waiting producers may fit now, or have to drop instead
+  not_full_.notify_all();
+}
+
+bool OutboundScheduler::put(core::OutboundMessage &&message) {
+  std::optional<core::OutboundMessage> dropped;
+  bool queued = true;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    size_t lane_index = GetLane(message);
+    Lane &lane = lanes_[lane_index];
+    auto is_full = [this, &lane, lane_index]() {
+      return lane.capacity > 0 && CountLocked(lane_index) >= lane.capacity;
+    };
+    if (is_full() && lane.policy == OverflowPolicy::kBlock) {
+      waiting_producers_++;
+      not_full_.wait(lock, [&]() {
+        return !is_full() || lane.policy != OverflowPolicy::kBlock;
+      });
+      waiting_producers_--;
+    }
+    if (is_full()) {
+      switch (lane.policy) {
+        case OverflowPolicy::kBlock:
+          break;
+        case OverflowPolicy::kDropOldest:
+          dropped = DropOldestLocked(lane_index);
+          break;
+        case OverflowPolicy::kDropNewest:
+          dropped_++;
+          dropped = std::move(message);
+          queued = false;
+          break;
+        case OverflowPolicy::kDropLowerPriority: {
+          size_t victim = core::kMessagePriorityCount - 1;
+          while (lanes_[victim].size == 0) {
+            victim--;
+          }
+          dropped = DropOldestLocked(victim);
+          break;
+        }
+      }
+    }
+    if (queued) {
+      if (lane.turns.Empty() && lane_index != kControlLane) {
+        weighted_lanes_.Add(lane_index);
+      }
+      auto &entries = lane.sessions[message.session_id];
+      if (entries.empty()) {
+        lane.turns.Add(message.session_id);
+      }
+      entries.push_back(Entry{std::move(message), next_sequence_++});
+      lane.size++;
+      size_++;
+      high_water_mark_ = std::max(high_water_mark_, size_);
+    }
+  }
+  // outside of the lock, the callback may send again
+  if (dropped) {
+    core::NotifyDropped(*dropped);
+  }
+  return !dropped;
+}
+
+size_t OutboundScheduler::drain_to(std::vector<core::OutboundMessage> &out,
+                                   size_t max_count, size_t max_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count = 0;
+  size_t bytes = 0;
+  core::OutboundMessage message;
+  while (count < max_count && bytes < max_bytes && TakeLocked(message)) {
+    bytes += message.size();
+    out.push_back(std::move(message));
+    count++;
+  }
+  if (count > 0 && waiting_producers_ > 0) {
+    not_full_.notify_all();
+  }
+  return count;
+}
+
+size_t OutboundScheduler::CountLocked(size_t lane_index) const {
+  if (lanes_[lane_index].policy != OverflowPolicy::kDropLowerPriority) {
+    return lanes_[lane_index].size;
+  }
+  size_t count = 0;
+  for (size_t i = lane_index; i < core::kMessagePriorityCount; ++i) {
+    count += lanes_[i].size;
+  }
+  return count;
+}
+
+bool OutboundScheduler::TakeLocked(core::OutboundMessage &message) {
+  size_t lane_index = kControlLane;
+  if (lanes_[kControlLane].turns.Empty()) {
+    if (weighted_lanes_.Empty()) {
+      return false;
+    }
+    lane_index = weighted_lanes_.Next(
+        [](size_t lane) { return kLaneWeights[lane] * kQuantum; });
+  }
+  Lane &lane = lanes_[lane_index];
+  int32_t session_id = lane.turns.Next([](int32_t) { return kQuantum; });
+  auto it = lane.sessions.find(session_id);
+  // the interactive and bulk messages of a session keep their order, e.g. a
+  // heap snapshot is complete before the response that ends it. The turn
+  // sends an older message of the session from the other lane first.
+  if (lane_index == kInteractiveLane || lane_index == kBulkLane) {
+    size_t other_index =
+        lane_index == kInteractiveLane ? kBulkLane : kInteractiveLane;
+    Lane &other = lanes_[other_index];
+    auto other_it = other.sessions.find(session_id);
+    if (other_it != other.sessions.end() &&
+        other_it->second.front().sequence < it->second.front().sequence) {
+      message = std::move(other_it->second.front().message);
+      other_it->second.pop_front();
+      if (other_it->second.empty()) {
+        RemoveSessionLocked(other_index, session_id);
+      }
+      other.size--;
+      size_--;
+      size_t cost = std::max<size_t>(message.size(), 1);
+      lane.turns.Charge(cost, true);
+      weighted_lanes_.Charge(cost, true);
+      return true;
+    }
+  }
+  message = std::move(it->second.front().message);
+  it->second.pop_front();
+  bool session_has_more = !it->second.empty();
+  if (!session_has_more) {
+    lane.sessions.erase(it);
+  }
+  // empty messages still take a turn
+  size_t cost = std::max<size_t>(message.size(), 1);
+  lane.turns.Charge(cost, session_has_more);
+  if (lane_index != kControlLane) {
+    weighted_lanes_.Charge(cost, !lane.turns.Empty());
+  }
+  lane.size--;
+  size_--;
+  return true;
+}
+
+core::OutboundMessage OutboundScheduler::DropOldestLocked(size_t lane_index) {
+  Lane &lane = lanes_[lane_index];
+  auto oldest = lane.sessions.begin();
+  for (auto it = lane.sessions.begin(); it != lane.sessions.end(); ++it) {
+    if (it->second.front().sequence < oldest->second.front().sequence) {
+      oldest = it;
+    }
+  }
+  core::OutboundMessage message = std::move(oldest->second.front().message);
+  oldest->second.pop_front();
+  if (oldest->second.empty()) {
+    RemoveSessionLocked(lane_index, oldest->first);
+  }
+  lane.size--;
+  size_--;
+  dropped_++;
+  return message;
+}
+
+void OutboundScheduler::RemoveSessionLocked(size_t lane_index,
+                                            int32_t session_id) {
+  Lane &lane = lanes_[lane_index];
+  lane.sessions.erase(session_id);
+  lane.turns.Remove(session_id);
+  if (lane.turns.Empty() && lane_index != kControlLane) {
+    weighted_lanes_.Remove(lane_index);
+  }
+}
+
+void OutboundScheduler::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (Lane &lane : lanes_) {
+    lane.sessions.clear();
+    lane.turns.Clear();
+    lane.size = 0;
+  }
+  weighted_lanes_.Clear();
+  size_ = 0;
+  not_full_.notify_all();
+}
+
+size_t OutboundScheduler::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+size_t OutboundScheduler::high_water_mark() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return high_water_mark_;
+}
+
+uint64_t OutboundScheduler::dropped() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dropped_;
+}
+
+}  // namespace socket_server
+}  // namespace debugrouter
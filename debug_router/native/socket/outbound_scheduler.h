@@ -0,0 +1,199 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_SOCKET_OUTBOUND_SCHEDULER_H_
+#define DEBUGROUTER_NATIVE_SOCKET_OUTBOUND_SCHEDULER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "debug_router/native/core/outbound_message.h"
+
+namespace debugrouter {
+namespace socket_server {
+
+// deficit round robin over keys that have something to send: a key is served
+// while it has credit, and gets quantum(key) bytes more at each of its turns
+template <typename Key>
+class DeficitRoundRobin {
+ public:
+  bool Empty() const { return order_.empty(); }
+
+  // key has something to send again
+  void Add(Key key) { order_.push_back(key); }
+
+  // key has nothing to send anymore
+  void Remove(Key key) {
+    for (auto it = order_.begin(); it != order_.end(); ++it) {
+      if (*it == key) {
+        if (it == order_.begin()) {
+          turn_started_ = false;
+        }
+        order_.erase(it);
+        break;
+      }
+    }
+    ForgiveCredit(key);
+  }
+
+  // the key to serve next, the order must not be empty
+  template <typename Quantum>
+  Key Next(Quantum quantum) {
+    while (true) {
+      Key key = order_.front();
+      int64_t &deficit = deficits_[key];
+      if (!turn_started_) {
+        deficit += quantum(key);
+        turn_started_ = true;
+      }
+      if (deficit > 0) {
+        return key;
+      }
+      EndTurn();
+    }
+  }
+
+  // charges cost to the key Next returned, has_more is false when it has
+  // nothing left to send
+  void Charge(size_t cost, bool has_more) {
+    Key key = order_.front();
+    deficits_[key] -= static_cast<int64_t>(cost);
+    if (!has_more) {
+      order_.pop_front();
+      turn_started_ = false;
+      ForgiveCredit(key);
+    } else if (deficits_[key] <= 0) {
+      EndTurn();
+    }
+  }
+
+  void Clear() {
+    order_.clear();
+    deficits_.clear();
+    turn_started_ = false;
+  }
+
+ private:
+  void EndTurn() {
+    order_.push_back(order_.front());
+    order_.pop_front();
+    turn_started_ = false;
+  }
+
+  // unused credit is lost when a key goes idle, a debt is kept so that one
+  // large message does not give it more than its share
+  void ForgiveCredit(Key key) {
+    auto it = deficits_.find(key);
+    if (it != deficits_.end() && it->second >= 0) {
+      deficits_.erase(it);
+    }
+  }
+
+  std::deque<Key> order_;
+  std::unordered_map<Key, int64_t> deficits_;
+  bool turn_started_ = false;
+};
+
+// what put does when the class of a message is at its capacity
+enum class OverflowPolicy {
+  // waits until the consumer takes a message of the class. Only for
+  // producers other than the consumer's thread.
+  kBlock,
+  // the oldest message of the class is dropped
+  kDropOldest,
+  // the new message is dropped
+  kDropNewest,
+  // the capacity bounds the class together with the less urgent ones, the
+  // oldest message of the least urgent of them that has one is dropped
+  kDropLowerPriority,
+};
+
+/**
+ * Queue of the outgoing messages of one connection, many producers and one
+ * consumer. Messages are taken by core::MessagePriority: control messages
+ * first, then the interactive, bulk and screencast classes share the
+ * connection by weight, so that a backlog of frames or of a heap snapshot
+ * does not hold back a Debugger.paused of another session, and is never
+ * starved either. Within a class, sessions take turns by bytes.
+ *
+ * The interactive and bulk messages of one session keep their order across
+ * both classes, as CDP requires: a response must not overtake the events
+ * sent before it. The messages of one session and class keep their order.
+ *
+ * Each class has a capacity and an OverflowPolicy, see set_limit. Only the
+ * screencast class is bounded by default.
+ */
+class OutboundScheduler {
+ public:
+  // screencast_capacity bounds the screencast class, 0 is unbounded. Once it
+  // is full, the oldest screencast message is dropped for a new one, a newer
+  // frame replaces it anyway. The other classes are lossless and unbounded,
+  // they are bounded by their producers.
+  explicit OutboundScheduler(size_t screencast_capacity = 0);
+
+  OutboundScheduler(const OutboundScheduler &) = delete;
+  OutboundScheduler &operator=(const OutboundScheduler &) = delete;
+
+  // bounds the messages of priority to capacity, 0 is unbounded
+  void set_limit(core::MessagePriority priority, size_t capacity,
+                 OverflowPolicy policy);
+
+  // false if message or a queued message was dropped, the on_dropped of the
+  // dropped message is called
+  bool put(core::OutboundMessage &&message);
+
+  // appends up to max_count messages to out in the order they are to be
+  // sent, stops once max_bytes are taken. Returns their count.
+  size_t drain_to(std::vector<core::OutboundMessage> &out, size_t max_count,
+                  size_t max_bytes);
+
+  void clear();
+  size_t size() const;
+  // the largest size the queue has had
+  size_t high_water_mark() const;
+  // messages dropped because their class was full
+  uint64_t dropped() const;
+
+ private:
+  struct Entry {
+    core::OutboundMessage message;
+    // order of put, the smallest is the oldest
+    uint64_t sequence;
+  };
+  struct Lane {
+    std::unordered_map<int32_t, std::deque<Entry>> sessions;
+    DeficitRoundRobin<int32_t> turns;
+    size_t size = 0;
+    size_t capacity = 0;
+    OverflowPolicy policy = OverflowPolicy::kDropOldest;
+  };
+
+  // called with mutex_ held
+  // the messages the capacity of lane counts
+  size_t CountLocked(size_t lane) const;
+  bool TakeLocked(core::OutboundMessage &message);
+  core::OutboundMessage DropOldestLocked(size_t lane);
+  void RemoveSessionLocked(size_t lane, int32_t session_id);
+
+  mutable std::mutex mutex_;
+  // signaled when a message is taken while producers wait for room
+  std::condition_variable not_full_;
+  int waiting_producers_ = 0;
+  Lane lanes_[core::kMessagePriorityCount];
+  // the lanes after the control lane, which is always served first
+  DeficitRoundRobin<size_t> weighted_lanes_;
+  size_t size_ = 0;
+  size_t high_water_mark_ = 0;
+  uint64_t dropped_ = 0;
+  uint64_t next_sequence_ = 0;
+};
+
+}  // namespace socket_server
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_SOCKET_OUTBOUND_SCHEDULER_H_
@@ -11,7 +11,6 @@
 
 #include "debug_router/native/core/util.h"
 #include "debug_router/native/log/logging.h"
-#include "debug_router/native/socket/usb_client.h"
 
 namespace debugrouter {
 namespace socket_server {
@@ -74,47 +73,10 @@ int32_t SocketServerPosix::InitSocket() {
   return port;
 }
 
-void SocketServerPosix::Start() {
-  if (socket_fd_ == kInvalidSocket) {
-    int32_t port = kInvalidPort;
-    port = InitSocket();
-    if (port == kInvalidPort) {
-      return;
-    }
-    NotifyInit(0, "port:" + std::to_string(port));
-  }
-  LOGI("server socket:" << socket_fd_);
+SocketType SocketServerPosix::Accept() {
   struct sockaddr_in addr;
   socklen_t addrLen = sizeof(addr);
-  SocketType accept_socket_fd =
-      accept(socket_fd_, (struct sockaddr *)(&addr), &addrLen);
-  if (accept_socket_fd == kInvalidSocket) {
-    Close();
-    LOGE("accept socket error:" << GetErrorMessage());
-    NotifyInit(GetErrorMessage(), "accept socket error");
-    return;
-  }
-  LOGI("accept usbclient socket:" << accept_socket_fd);
-  if (temp_usb_client_) {
-    LOGI("close last connector, destroy temp_usb_client_.");
-    temp_usb_client_->Stop();
-  }
-  LOGI("create a new usb client.");
-  temp_usb_client_ = std::make_shared<UsbClient>(accept_socket_fd);
-  std::shared_ptr<ClientListener> listener =
-      std::make_shared<ClientListener>(shared_from_this());
-  temp_usb_client_->Init();
-  temp_usb_client_->StartUp(listener);
-}
-
-void SocketServerPosix::CloseSocket(int socket_fd) {
-  LOGI("CloseSocket" << socket_fd);
-  if (socket_fd == kInvalidSocket) {
-    return;
-  }
-  if (close(socket_fd) != 0) {
-    LOGE("close socket error:" << GetErrorMessage());
-  }
+  return accept(socket_fd_, (struct sockaddr *)(&addr), &addrLen);
 }
 
 }  // namespace socket_server
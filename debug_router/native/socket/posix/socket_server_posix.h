@@ -17,9 +17,8 @@ class SocketServerPosix : public SocketServer {
 
  private:
   inline int GetErrorMessage() override { return errno; }
-  int32_t InitSocket();
-  void Start() override;
-  void CloseSocket(int socket_fd) override;
+  int32_t InitSocket() override;
+  SocketType Accept() override;
 };
 
 }  // namespace socket_server
@@ -8,12 +8,34 @@
 #else
 #include "debug_router/native/socket/posix/socket_server_posix.h"
 #endif
+
+#include <algorithm>
+
 #include "debug_router/native/core/util.h"
+#include "debug_router/native/protocol/message_envelope.h"
+#include "debug_router/native/protocol/message_writer.h"
+#include "debug_router/native/protocol/protocol.h"
+#include "debug_router/native/socket/event_loop.h"
+#include "debug_router/native/socket/frame_writer.h"
 #include "debug_router/native/thread/debug_router_executor.h"
 
 namespace debugrouter {
 namespace socket_server {
 
+// delay before listening again after the server socket failed
+constexpr std::chrono::milliseconds kRestartDelay(1000);
+// requests that are never answered are forgotten past this many
+constexpr size_t kMaxPendingRequests = 4096;
+
+constexpr char kStartScreencastMethod[] = "Page.startScreencast";
+constexpr char kStopScreencastMethod[] = "Page.stopScreencast";
+constexpr char kScreencastFrameMethod[] = "Page.screencastFrame";
+constexpr char kScreencastFrameAckMethod[] = "Page.screencastFrameAck";
+// answers a screencast request of a client that does not drive it
+constexpr char kScreencastBusyError[] =
+    "{\"code\":-32000,\"message\":\"screencast is driven by another "
+    "client\"}";
+
 std::shared_ptr<SocketServer> SocketServer::CreateSocketServer(
     const std::shared_ptr<SocketServerConnectionListener> &listener) {
 #ifdef _WIN32
@@ -25,26 +47,206 @@ std::shared_ptr<SocketServer> SocketServer::CreateSocketServer(
 
 SocketServer::SocketServer(
     const std::shared_ptr<SocketServerConnectionListener> &listener)
-    : listener_(listener), usb_client_(nullptr) {}
+    : listener_(listener) {}
 
-bool SocketServer::Send(const std::string &message) {
-  if (!usb_client_) {
+bool SocketServer::Send(const core::OutboundMessage &message) {
+  std::lock_guard<std::mutex> lock(clients_lock_);
+  if (usb_clients_.empty()) {
     LOGI("SocketServerApi Send: client is null.");
     return false;
   }
-  return usb_client_->Send(message);
+  // looked up even for one client, so that answered requests are forgotten
+  if (auto requester = TakeRequesterLocked(message)) {
+    return requester->Send(message);
+  }
+  if (screencast_client_ && message.method == kScreencastFrameMethod) {
+    if (message.binary && !screencast_client_->IsBinaryScreencast()) {
+      return false;
+    }
+    return screencast_client_->Send(message);
+  }
+  if (usb_clients_.size() == 1 && !message.binary) {
+    return usb_clients_[0]->Send(message);
+  }
+  // the clients queue copies of message that share its payload
+  bool sent = false;
+  for (const auto &client : usb_clients_) {
+    if (message.binary && !client->IsBinaryScreencast()) {
+      continue;
+    }
+    if (client->IsSubscribed(message.session_id)) {
+      sent = client->Send(message) || sent;
+    }
+  }
+  return sent;
+}
+
+void SocketServer::RecordRequestLocked(const std::shared_ptr<UsbClient> &client,
+                                       int32_t session_id, int64_t id) {
+  if (requesters_.size() >= kMaxPendingRequests) {
+    LOGW("SocketServerApi: too many unanswered requests, forget them.");
+    requesters_.clear();
+  }
+  requesters_[{session_id, id}].push_back(client);
+}
+
+std::shared_ptr<UsbClient> SocketServer::TakeRequesterLocked(
+    const core::OutboundMessage &message) {
+  if (message.request_id < 0 || requesters_.empty()) {
+    return nullptr;
+  }
+  auto it = requesters_.find({message.session_id, message.request_id});
+  if (it == requesters_.end()) {
+    return nullptr;
+  }
+  std::shared_ptr<UsbClient> client = it->second.front();
+  it->second.pop_front();
+  if (it->second.empty()) {
+    requesters_.erase(it);
+  }
+  return client;
+}
+
+bool SocketServer::FilterScreencastLocked(
+    const std::shared_ptr<UsbClient> &client,
+    const protocol::MessageEnvelope &envelope, const std::string &payload,
+    std::string &reply, std::string &sync) {
+  bool is_binary =
+      envelope.type ==
+      protocol::kRemoteDebugProtocolBodyData4Custom4BinaryScreencast;
+  std::string method;
+  if (!is_binary) {
+    if (envelope.type != protocol::kRemoteDebugProtocolBodyData4CDP) {
+      return true;
+    }
+    method = core::FindCdpMethod(payload);
+    if (method != kStartScreencastMethod && method != kStopScreencastMethod &&
+        method != kScreencastFrameAckMethod) {
+      return true;
+    }
+  }
+  uint32_t client_id = static_cast<uint32_t>(envelope.client_id);
+  if (screencast_client_ && screencast_client_ != client) {
+    LOGI("SocketServerApi: screencast is driven by another client.");
+    if (is_binary) {
+      reply = protocol::WriteCustomizedMessage(envelope.type, client_id,
+                                               core::kNoSessionId, "false",
+                                               false, -1);
+      return false;
+    }
+    int64_t id = core::FindCdpId(payload);
+    if (id >= 0) {
+      std::string error = "{\"id\":" + std::to_string(id) +
+                          ",\"error\":" + kScreencastBusyError + "}";
+      reply = protocol::WriteCustomizedMessage(
+          envelope.type, client_id, envelope.session_id, error, true, -1);
+    }
+    return false;
+  }
+  if (is_binary) {
+    // negotiated per client, passed on while no other client drives it
+    binary_screencast_ = payload == "true";
+    client->SetBinaryScreencast(binary_screencast_);
+    return true;
+  }
+  if (method == kStopScreencastMethod) {
+    screencast_client_ = nullptr;
+  } else if (method == kStartScreencastMethod && !screencast_client_) {
+    screencast_client_ = client;
+    if (client->IsBinaryScreencast() != binary_screencast_) {
+      // the previous client left binary frames in another state
+      binary_screencast_ = client->IsBinaryScreencast();
+      sync = protocol::WriteCustomizedMessage(
+          protocol::kRemoteDebugProtocolBodyData4Custom4BinaryScreencast,
+          client_id, core::kNoSessionId, binary_screencast_ ? "true" : "false",
+          false, -1);
+    }
+  }
+  return true;
+}
+
+void SocketServer::ForgetClientLocked(
+    const std::shared_ptr<UsbClient> &client) {
+  if (screencast_client_ == client) {
+    screencast_client_ = nullptr;
+  }
+  for (auto it = requesters_.begin(); it != requesters_.end();) {
+    auto &clients = it->second;
+    clients.erase(std::remove(clients.begin(), clients.end(), client),
+                  clients.end());
+    if (clients.empty()) {
+      it = requesters_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+bool SocketServer::IsConnectedClient(const std::shared_ptr<UsbClient> &client) {
+  std::lock_guard<std::mutex> lock(clients_lock_);
+  return std::find(usb_clients_.begin(), usb_clients_.end(), client) !=
+         usb_clients_.end();
+}
+
+bool SocketServer::RemoveClient(const std::shared_ptr<UsbClient> &client,
+                                bool &is_last) {
+  std::lock_guard<std::mutex> lock(clients_lock_);
+  pending_clients_.erase(
+      std::remove(pending_clients_.begin(), pending_clients_.end(), client),
+      pending_clients_.end());
+  auto it = std::find(usb_clients_.begin(), usb_clients_.end(), client);
+  if (it == usb_clients_.end()) {
+    return false;
+  }
+  usb_clients_.erase(it);
+  ForgetClientLocked(client);
+  is_last = usb_clients_.empty();
+  return true;
+}
+
+std::vector<std::shared_ptr<UsbClient>> SocketServer::TakeClients(
+    bool include_pending) {
+  std::lock_guard<std::mutex> lock(clients_lock_);
+  std::vector<std::shared_ptr<UsbClient>> clients;
+  clients.swap(usb_clients_);
+  requesters_.clear();
+  screencast_client_ = nullptr;
+  if (include_pending) {
+    clients.insert(clients.end(), pending_clients_.begin(),
+                   pending_clients_.end());
+    pending_clients_.clear();
+  }
+  return clients;
 }
 
 void SocketServer::HandleOnOpenStatus(std::shared_ptr<UsbClient> client,
                                       int32_t code, const std::string &reason) {
   thread::DebugRouterExecutor::GetInstance().Post([=]() {
-    std::shared_ptr<UsbClient> old_client_ = usb_client_;
-    LOGI("SocketServerApi OnOpen: replace old client.");
-    if (old_client_) {
-      LOGI("SocketServerApi HandleOnOpenStatus: stop old client.");
-      old_client_->Stop();
+    std::shared_ptr<UsbClient> oldest_client;
+    bool is_first = false;
+    size_t count = 0;
+    {
+      std::lock_guard<std::mutex> lock(clients_lock_);
+      pending_clients_.erase(std::remove(pending_clients_.begin(),
+                                         pending_clients_.end(), client),
+                             pending_clients_.end());
+      if (usb_clients_.size() >= kMaxUsbClients) {
+        oldest_client = usb_clients_.front();
+        usb_clients_.erase(usb_clients_.begin());
+        ForgetClientLocked(oldest_client);
+      }
+      is_first = usb_clients_.empty();
+      usb_clients_.push_back(client);
+      count = usb_clients_.size();
+    }
+    LOGI("SocketServerApi OnOpen: " << count << " clients connected.");
+    if (oldest_client) {
+      LOGI("SocketServerApi HandleOnOpenStatus: stop oldest client.");
+      oldest_client->Stop();
+    }
+    if (!is_first) {
+      return;
     }
-    usb_client_ = client;
     if (auto listener = listener_.lock()) {
       listener->OnStatusChanged(kConnected, code, reason);
     }
@@ -54,11 +256,49 @@ void SocketServer::HandleOnOpenStatus(std::shared_ptr<UsbClient> client,
 void SocketServer::HandleOnMessageStatus(std::shared_ptr<UsbClient> client,
                                          const std::string &message) {
   thread::DebugRouterExecutor::GetInstance().Post([=]() {
-    if (!usb_client_ || usb_client_ != client) {
-      LOGI("SocketServerApi OnMessage: client is null or not match.");
+    if (!IsConnectedClient(client)) {
+      LOGI("SocketServerApi OnMessage: client is not connected.");
       return;
     }
-    if (auto listener = listener_.lock()) {
+    // the client receives the messages of the sessions it talks to
+    protocol::MessageEnvelope envelope;
+    bool parsed = protocol::ParseMessageEnvelope(message, envelope);
+    if (parsed && envelope.has_session_id) {
+      client->Subscribe(envelope.session_id);
+    }
+    std::string payload;
+    // the listener gets the parsed envelope so it is not parsed twice, a
+    // message the scanner cannot read goes on as it is
+    if (parsed && envelope.has_message) {
+      parsed = protocol::ReadEnvelopeMessage(envelope, payload);
+    }
+    std::string reply;
+    std::string sync;
+    if (parsed) {
+      std::lock_guard<std::mutex> lock(clients_lock_);
+      if (!FilterScreencastLocked(client, envelope, payload, reply, sync)) {
+        if (!reply.empty()) {
+          client->Send(reply);
+        }
+        return;
+      }
+      int64_t id = envelope.type == protocol::kRemoteDebugProtocolBodyData4CDP
+                       ? core::FindCdpId(payload)
+                       : -1;
+      if (envelope.has_session_id && id >= 0) {
+        RecordRequestLocked(client, envelope.session_id, id);
+      }
+    }
+    auto listener = listener_.lock();
+    if (!listener) {
+      return;
+    }
+    if (!sync.empty()) {
+      listener->OnMessage(sync);
+    }
+    if (parsed) {
+      listener->OnParsedMessage(message, envelope, payload);
+    } else {
       listener->OnMessage(message);
     }
   });
@@ -68,19 +308,16 @@ void SocketServer::HandleOnCloseStatus(std::shared_ptr<UsbClient> client,
                                        ConnectionStatus status, int32_t code,
                                        const std::string &reason) {
   thread::DebugRouterExecutor::GetInstance().Post([=]() {
-    if (!usb_client_ || usb_client_ != client) {
-      LOGI(
-          "SocketServerApi OnClose: curr client is null or not match, stop "
-          "error client.");
-      client->Stop();
-      if (auto listener = listener_.lock()) {
-        listener->OnStatusChanged(status, code, reason);
-      }
+    client->Stop();
+    bool is_last = false;
+    if (!RemoveClient(client, is_last)) {
+      LOGI("SocketServerApi OnClose: client is not connected.");
+      return;
+    }
+    LOGI("SocketServerApi HandleOnCloseStatus: close client for OnClose.");
+    if (!is_last) {
       return;
     }
-    LOGI("SocketServerApi HandleOnCloseStatus: close curr client for OnClose.");
-    usb_client_->Stop();
-    usb_client_ = nullptr;
     if (auto listener = listener_.lock()) {
       listener->OnStatusChanged(status, code, reason);
     }
@@ -91,16 +328,16 @@ void SocketServer::HandleOnErrorStatus(std::shared_ptr<UsbClient> client,
                                        ConnectionStatus status, int32_t code,
                                        const std::string &reason) {
   thread::DebugRouterExecutor::GetInstance().Post([=]() {
-    if (!usb_client_ || usb_client_ != client) {
-      LOGI(
-          "SocketServerApi OnError: client is null or not match, stop error "
-          "client.");
-      client->Stop();
+    client->Stop();
+    bool is_last = false;
+    if (!RemoveClient(client, is_last)) {
+      LOGI("SocketServerApi OnError: client is not connected.");
+      return;
+    }
+    LOGI("SocketServerApi HandleOnErrorStatus: close client for OnError.");
+    if (!is_last) {
       return;
     }
-    LOGI("SocketServerApi HandleOnErrorStatus: close curr client for OnError.");
-    usb_client_->Stop();
-    usb_client_ = nullptr;
     if (auto listener = listener_.lock()) {
       listener->OnStatusChanged(status, code, reason);
     }
@@ -117,9 +354,10 @@ void SocketServer::NotifyInit(int32_t code, const std::string &info) {
 
 void SocketServer::setEnableServer(bool enable) {
   LOGI("SocketServer::setEnableServer:" << enable);
-  // notify only when transition from false to true
+  // start only when transition from false to true
   if (!is_running_.exchange(enable, std::memory_order_relaxed) && enable) {
-    running_condition_.notify_one();
+    EventLoop::GetInstance().Post(
+        [socket_server = shared_from_this()]() { socket_server->Start(); });
   }
 }
 
@@ -127,69 +365,120 @@ void SocketServer::StartServer() { setEnableServer(true); }
 
 void SocketServer::StopServer() {
   setEnableServer(false);
-  // Close socket if it's valid
-  if (socket_fd_ != kInvalidSocket) {
-#ifdef _WIN32
-    shutdown(socket_fd_, SD_BOTH);
-#else
-    shutdown(socket_fd_, SHUT_RDWR);
-#endif
+  Close();
+  for (const auto &client : TakeClients(true)) {
+    client->Stop();
   }
+}
 
-  Close();
-  if (usb_client_) {
-    usb_client_->Stop();
+bool SocketServer::IsListening() {
+  return is_running_.load(std::memory_order_relaxed) &&
+         socket_fd_ != kInvalidSocket;
+}
+
+void SocketServer::Start() {
+  if (!is_running_.load(std::memory_order_relaxed) ||
+      socket_fd_ != kInvalidSocket) {
+    return;
   }
-  if (temp_usb_client_) {
-    temp_usb_client_->Stop();
+  LOGI("Init start.");
+  int32_t port = InitSocket();
+  if (port == kInvalidPort) {
+    RetryStart();
+    return;
   }
+  if (!SetNonBlocking(socket_fd_)) {
+    LOGE("set non-blocking error:" << GetErrorMessage());
+    Close();
+    NotifyInit(GetErrorMessage(), "set non-blocking error");
+    RetryStart();
+    return;
+  }
+  NotifyInit(0, "port:" + std::to_string(port));
+  LOGI("server socket:" << socket_fd_.load());
+  std::weak_ptr<SocketServer> weak_server = shared_from_this();
+  EventLoop::GetInstance().Watch(socket_fd_, kEventReadable,
+                                 [weak_server](uint32_t events) {
+                                   if (auto server = weak_server.lock()) {
+                                     server->OnAcceptable();
+                                   }
+                                 });
+}
+
+void SocketServer::RetryStart() {
+  std::weak_ptr<SocketServer> weak_server = shared_from_this();
+  thread::DebugRouterExecutor::GetInstance().PostDelayed(
+      [weak_server]() {
+        EventLoop::GetInstance().Post([weak_server]() {
+          if (auto server = weak_server.lock()) {
+            server->Start();
+          }
+        });
+      },
+      kRestartDelay);
 }
 
-void SocketServer::ThreadFunc(std::shared_ptr<SocketServer> socket_server) {
-  int count = 0;
-  while (true) {
+void SocketServer::OnAcceptable() {
+  while (socket_fd_ != kInvalidSocket) {
+    SocketType accept_socket_fd = Accept();
+    if (accept_socket_fd == kInvalidSocket) {
+      if (IsWouldBlockError()) {
+        return;
+      }
+      LOGE("accept socket error:" << GetErrorMessage());
+      NotifyInit(GetErrorMessage(), "accept socket error");
+      Close();
+      RetryStart();
+      return;
+    }
+    LOGI("accept usbclient socket:" << accept_socket_fd);
+    std::shared_ptr<UsbClient> oldest_client;
+    auto client = std::make_shared<UsbClient>(accept_socket_fd);
     {
-      std::unique_lock lock(socket_server->running_mutex_);
-      socket_server->running_condition_.wait(lock, [=]() {
-        return socket_server->is_running_.load(std::memory_order_relaxed) ==
-               true;
-      });
+      std::lock_guard<std::mutex> lock(clients_lock_);
+      if (pending_clients_.size() >= kMaxUsbClients) {
+        oldest_client = pending_clients_.front();
+        pending_clients_.erase(pending_clients_.begin());
+      }
+      pending_clients_.push_back(client);
+    }
+    if (oldest_client) {
+      LOGI("close the oldest connector that sent no frame.");
+      oldest_client->Stop();
     }
-    LOGI("Init start:" << count);
-    socket_server->Start();
-    count++;
+    LOGI("create a new usb client.");
+    std::shared_ptr<ClientListener> listener =
+        std::make_shared<ClientListener>(shared_from_this());
+    client->Init();
+    client->StartUp(listener);
   }
 }
 
 void SocketServer::Init() {
-  std::thread listen_thread(ThreadFunc, shared_from_this());
-  listen_thread.detach();
+  // the server socket is created by StartServer on the EventLoop thread
+  LOGI("SocketServer::Init");
 }
 
 // close server socket
 void SocketServer::Close() {
-  LOGI("SocketServer::Close server socket_fd_:" << socket_fd_);
-  CloseSocket(socket_fd_);
-  socket_fd_ = kInvalidSocket;
+  SocketType socket_fd = socket_fd_.exchange(kInvalidSocket);
+  LOGI("SocketServer::Close server socket_fd_:" << socket_fd);
+  EventLoop::GetInstance().Close(socket_fd);
 }
 
 void SocketServer::Disconnect() {
   thread::DebugRouterExecutor::GetInstance().Post([=]() {
-    if (usb_client_) {
-      LOGI("SocketServerApi Disconnect: stop curr client.");
-      usb_client_->Stop();
-      usb_client_ = nullptr;
+    for (const auto &client : TakeClients(false)) {
+      LOGI("SocketServerApi Disconnect: stop client.");
+      client->Stop();
     }
   });
 }
 
 SocketServer::~SocketServer() {
   LOGI("SocketServer::~SocketServer");
-  if (usb_client_) {
-    usb_client_->Stop();
-  }
-  if (temp_usb_client_) {
-    temp_usb_client_->Stop();
+  for (const auto &client : TakeClients(true)) {
+    client->Stop();
   }
   Close();
 }
@@ -5,12 +5,17 @@
 #ifndef DEBUGROUTER_NATIVE_SOCKET_SOCKET_SERVER_API_H
 #define DEBUGROUTER_NATIVE_SOCKET_SOCKET_SERVER_API_H
 
+#include <deque>
+#include <map>
 #include <mutex>
 #include <queue>
 #include <string>
 #include <thread>
+#include <vector>
 
+#include "debug_router/native/core/outbound_message.h"
 #include "debug_router/native/log/logging.h"
+#include "debug_router/native/protocol/message_envelope.h"
 #include "debug_router/native/socket/count_down_latch.h"
 #include "debug_router/native/socket/socket_server_type.h"
 #include "debug_router/native/socket/usb_client_listener.h"
@@ -24,8 +29,26 @@ class SocketServerConnectionListener {
   virtual void OnStatusChanged(ConnectionStatus status, int32_t code,
                                const std::string &info) = 0;
   virtual void OnMessage(const std::string &message) = 0;
+  // a message whose envelope the server has already parsed, payload is the
+  // envelope message read as a string
+  virtual void OnParsedMessage(const std::string &message,
+                               const protocol::MessageEnvelope &envelope,
+                               const std::string &payload) {
+    OnMessage(message);
+  }
 };
 
+/**
+ * Listens for debugger connectors, several of them can be connected at
+ * once, e.g. DevTools and a profiler. Outgoing messages are fanned out to
+ * every connected client, each with its own queue, so a slow client does
+ * not stall the others. While several clients are connected, a message of
+ * a session only goes to the clients that sent messages to that session, or
+ * to no session yet. A CDP response only goes to the client that sent its
+ * request. One client at a time drives the screencast, the others are
+ * refused until it stops. The listener sees one connection, open while any
+ * client is.
+ */
 class SocketServer : public std::enable_shared_from_this<SocketServer> {
  public:
   explicit SocketServer(
@@ -33,7 +56,7 @@ class SocketServer : public std::enable_shared_from_this<SocketServer> {
   virtual ~SocketServer();
 
   void Init();
-  bool Send(const std::string &message);
+  bool Send(const core::OutboundMessage &message);
   void Disconnect();
 
   void HandleOnOpenStatus(std::shared_ptr<UsbClient> client, int32_t code,
@@ -52,16 +75,46 @@ class SocketServer : public std::enable_shared_from_this<SocketServer> {
 
   void StartServer();
   void StopServer();
+  bool IsListening();
 
  protected:
-  static void ThreadFunc(std::shared_ptr<SocketServer> socket_server);
-
-  virtual void Start() = 0;
+  // the following run on the EventLoop thread
+  void Start();
+  void OnAcceptable();
+  void RetryStart();
+
+  // creates, binds and listens socket_fd_, returns the port or kInvalidPort
+  virtual int32_t InitSocket() = 0;
+  // accepts one connection of the non-blocking socket_fd_
+  virtual SocketType Accept() = 0;
   virtual int GetErrorMessage() = 0;
-  virtual void CloseSocket(int socket_fd) = 0;
   void Close();
   void NotifyInit(int32_t code, const std::string &info);
 
+  bool IsConnectedClient(const std::shared_ptr<UsbClient> &client);
+  // removes client from the clients, false if it was not connected.
+  // is_last tells if no client is connected anymore.
+  bool RemoveClient(const std::shared_ptr<UsbClient> &client, bool &is_last);
+  // removes and returns the connected clients, and the pending ones if
+  // include_pending
+  std::vector<std::shared_ptr<UsbClient>> TakeClients(bool include_pending);
+
+  // the following need clients_lock_
+  // remembers that client sent the CDP request id to session_id
+  void RecordRequestLocked(const std::shared_ptr<UsbClient> &client,
+                           int32_t session_id, int64_t id);
+  // the client that sent the request message answers, null if unknown
+  std::shared_ptr<UsbClient> TakeRequesterLocked(
+      const core::OutboundMessage &message);
+  // decides whether the screencast message of client is passed on. reply
+  // answers a refused one, sync is a message the listener has to see first.
+  bool FilterScreencastLocked(const std::shared_ptr<UsbClient> &client,
+                              const protocol::MessageEnvelope &envelope,
+                              const std::string &payload, std::string &reply,
+                              std::string &sync);
+  // forgets the requests and the screencast of a client that left
+  void ForgetClientLocked(const std::shared_ptr<UsbClient> &client);
+
   void setEnableServer(bool enable);
 
   std::weak_ptr<SocketServerConnectionListener> listener_;
@@ -69,15 +122,28 @@ class SocketServer : public std::enable_shared_from_this<SocketServer> {
   std::condition_variable queue_available_;
   std::unique_ptr<CountDownLatch> latch_;
   std::mutex queue_lock_;
-  std::shared_ptr<UsbClient> usb_client_;
-  std::shared_ptr<UsbClient> temp_usb_client_;
 
-  volatile SocketType socket_fd_ = kInvalidSocket;
+  std::mutex clients_lock_;
+  // clients that sent their first frame, the oldest first
+  std::vector<std::shared_ptr<UsbClient>> usb_clients_;
+  // accepted clients that have not sent a frame yet
+  std::vector<std::shared_ptr<UsbClient>> pending_clients_;
+  // senders of the unanswered CDP requests by session and id, the oldest
+  // first if clients reuse an id
+  std::map<std::pair<int32_t, int64_t>,
+           std::deque<std::shared_ptr<UsbClient>>>
+      requesters_;
+  // the client that started the screencast. Frames only go to it and only
+  // its acks reach the flow control, other clients cannot drive it.
+  std::shared_ptr<UsbClient> screencast_client_;
+  // the binary screencast state last passed on to the listener
+  bool binary_screencast_ = false;
+
+  // only written on the EventLoop thread
+  std::atomic<SocketType> socket_fd_ = {kInvalidSocket};
 
  private:
   std::atomic<bool> is_running_{false};
-  std::condition_variable running_condition_;
-  std::mutex running_mutex_;
 };
 
 // ClientListener
@@ -22,9 +22,17 @@ const int kFrameHeaderLen = 16;
 const int kPayloadSizeLen = 4;
 const int kThreadCount = 3;
 const uint64_t kMaxMessageLength = ((uint64_t)1) << 32;
+const size_t kMaxFragmentedMessageLength = 64 * 1024 * 1024;
+const size_t kMaxQueuedScreencastMessages = 64;
+const size_t kMaxUsbClients = 4;
 const int32_t kPTFrameTypeTextMessage = 101;
+const int32_t kPTFrameTypeBinaryMessage = 102;
 const int32_t kFrameDefaultTag = 0;
 const int32_t kFrameProtocolVersion = 1;
+const int32_t kFrameProtocolVersion2 = 2;
+const int kFrameRoutingLen = 12;
+const uint8_t kFrameFlagCompressed = 1 << 0;
+const uint8_t kFrameFlagMoreFragments = 1 << 1;
 
 }  // namespace socket_server
 }  // namespace debugrouter
@@ -5,6 +5,7 @@
 #ifndef DEBUGROUTER_NATIVE_SOCKET_SOCKET_SERVER_TYPE_H
 #define DEBUGROUTER_NATIVE_SOCKET_SOCKET_SERVER_TYPE_H
 
+#include <cstddef>
 #include <cstdint>
 #ifdef _WIN32
 #include "WinSock2.h"
@@ -50,14 +51,62 @@ extern const int kThreadCount;
 // message size limit
 extern const uint64_t kMaxMessageLength;
 
+// bytes of a message a peer sends in version 2 fragments, a peer that sends
+// more is disconnected
+extern const size_t kMaxFragmentedMessageLength;
+
+// screencast messages a connection queues for its socket, the oldest is
+// dropped for a new one. Other messages are never dropped.
+extern const size_t kMaxQueuedScreencastMessages;
+
+// connected clients of a SocketServer, the oldest is closed for one more.
+// Clients that have not sent a frame yet are counted separately.
+extern const size_t kMaxUsbClients;
+
 // message_type
 extern const int32_t kPTFrameTypeTextMessage;
+// a binary payload, e.g. a BinaryScreencastFrame, only sent to debuggers that
+// enabled binary messages
+extern const int32_t kPTFrameTypeBinaryMessage;
 
 // flag
 extern const int32_t kFrameDefaultTag;
 
 // protocol version
 extern const int32_t kFrameProtocolVersion;
+// protocol version of frames with routing fields. A client sends them once
+// its peer has sent one, and reads both versions.
+extern const int32_t kFrameProtocolVersion2;
+
+// bytes of the routing fields of a version 2 frame, between the size and
+// the payload length
+extern const int kFrameRoutingLen;
+
+// message class of a version 2 frame
+enum FrameMessageClass {
+  kFrameClassControl = 0,
+  kFrameClassCdp = 1,
+  kFrameClassScreencast = 2,
+  kFrameClassBinary = 3,
+};
+
+// flags of a version 2 frame
+// the payload is compressed, not supported yet, such frames are dropped
+extern const uint8_t kFrameFlagCompressed;
+// the payload continues in the next frame
+extern const uint8_t kFrameFlagMoreFragments;
+
+// routing fields of a version 2 frame
+struct FrameRouting {
+  // a session, kNoSessionId, or kUnknownSessionId if the receiver has to
+  // read it from the payload
+  int32_t session_id;
+  // FrameMessageClass
+  uint8_t message_class;
+  uint8_t flags;
+  // counts the frames each side sends, from 0
+  uint32_t sequence;
+};
 
 }  // namespace socket_server
 }  // namespace debugrouter
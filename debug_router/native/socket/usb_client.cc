@@ -4,11 +4,16 @@
 
 #include "debug_router/native/socket/usb_client.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 
 #include "debug_router/native/core/debug_router_core.h"
 #include "debug_router/native/core/util.h"
 #include "debug_router/native/log/logging.h"
+#include "debug_router/native/protocol/message_envelope.h"
+#include "debug_router/native/protocol/protocol.h"
+#include "debug_router/native/socket/event_loop.h"
 #include "debug_router/native/socket/socket_server_api.h"
 #include "third_party/jsoncpp/include/json/reader.h"
 #include "third_party/jsoncpp/include/json/value.h"
@@ -18,20 +23,31 @@
 #else
 #include <errno.h>
 #include <sys/socket.h>
-#include <sys/time.h>
 #include <unistd.h>
 #endif
 
 namespace debugrouter {
 namespace socket_server {
 
-const char *kMessageQuit = "quit";
+// bytes requested from recv() at a time
+constexpr size_t kReadChunkSize = 16 * 1024;
 
-// SO_RCVTIMEO timeout for recv() in UsbClient::Read()
-// Chosen as a balance between:
-//   - Low latency for Stop() to complete (max wait 0.5s)
-//   - Low CPU overhead (not waking up too frequently)
-const int kUsbClientRecvTimeoutMs = 500;
+// kFrameHeaderLen + kPayloadSizeLen
+constexpr size_t kWrappedHeaderLen = 20;
+// kFrameHeaderLen + kFrameRoutingLen + kPayloadSizeLen
+constexpr size_t kWrappedHeaderLenV2 = 32;
+
+// messages taken from outgoing_message_queue_ in one lock round trip
+constexpr size_t kWriteBatchSize = 64;
+// bytes moved into frame_queue_ at once, what a later urgent message may
+// have to wait for besides the socket buffer
+constexpr size_t kMaxFillBytes = 256 * 1024;
+
+uint32_t ReadUInt32(const char *data) {
+  char value[4];
+  memcpy(value, data, 4);
+  return util::DecodePayloadSize(value, 4);
+}
 
 int GetErrorMessage() {
 #ifdef _WIN32
@@ -43,65 +59,85 @@ int GetErrorMessage() {
 
 UsbClient::UsbClient(SocketType socket_fd) : socket_guard_(socket_fd) {
   LOGI("UsbClient: Constructor.");
+  SetFrameSocketOptions(socket_guard_.Get());
+}
 
-  // Set SO_RCVTIMEO to avoid permanent blocking
-  SocketType sock = socket_guard_.Get();
-  if (sock != kInvalidSocket) {
-#ifdef _WIN32
-    DWORD timeout = kUsbClientRecvTimeoutMs;
-    if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char *)&timeout,
-                   sizeof(timeout)) == SOCKET_ERROR) {
-      LOGE("UsbClient: Failed to set SO_RCVTIMEO: " << WSAGetLastError());
-    }
-#else
-    struct timeval timeout;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = kUsbClientRecvTimeoutMs * 1000;
-    if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) ==
-        -1) {
-      LOGE("UsbClient: Failed to set SO_RCVTIMEO: " << errno);
-    }
-#endif
+void UsbClient::SetConnectStatus(USBConnectStatus status) {
+  connect_status_.store(status);
+}
+
+void UsbClient::Subscribe(int32_t session_id) {
+  if (session_id <= 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+  if (std::find(subscribed_sessions_.begin(), subscribed_sessions_.end(),
+                session_id) == subscribed_sessions_.end()) {
+    subscribed_sessions_.push_back(session_id);
   }
 }
 
-void UsbClient::SetConnectStatus(USBConnectStatus status) {
-  work_thread_.submit([client_ptr = shared_from_this(), status]() {
-    client_ptr->connect_status_ = status;
-  });
+bool UsbClient::IsSubscribed(int32_t session_id) const {
+  if (session_id <= 0) {
+    return true;
+  }
+  std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+  return subscribed_sessions_.empty() ||
+         std::find(subscribed_sessions_.begin(), subscribed_sessions_.end(),
+                   session_id) != subscribed_sessions_.end();
+}
+
+void UsbClient::SetBinaryScreencast(bool enabled) {
+  binary_screencast_.store(enabled, std::memory_order_relaxed);
+}
+
+bool UsbClient::IsBinaryScreencast() const {
+  return binary_screencast_.load(std::memory_order_relaxed);
 }
 
 void UsbClient::Init() {
-  work_thread_.init();
-  read_thread_.init();
-  write_thread_.init();
-  dispatch_thread_.init();
+  // the socket is driven by the EventLoop, recv/send must not block it
+  if (!SetNonBlocking(socket_guard_.Get())) {
+    LOGE("UsbClient: set non-blocking error: " << GetErrorMessage());
+  }
 }
 
 void UsbClient::StartUp(const std::shared_ptr<UsbClientListener> &listener) {
   LOGI("UsbClient: StartUp.");
-  work_thread_.submit([client_ptr = shared_from_this(), listener]() {
-    client_ptr->StartInternal(listener);
-  });
+  EventLoop::GetInstance().Post(
+      [client_ptr = shared_from_this(), listener]() {
+        client_ptr->StartInternal(listener);
+      });
 }
 
 void UsbClient::StartInternal(
     const std::shared_ptr<UsbClientListener> &listener) {
   LOGI("UsbClient: StartInternal.");
-  stopping_.store(false, std::memory_order_relaxed);
-  connect_status_ = USBConnectStatus::CONNECTING;
+  SocketType socket = socket_guard_.Get();
+  if (socket == kInvalidSocket) {
+    LOGE("UsbClient: StartInternal: socket has been closed.");
+    return;
+  }
+  connect_status_.store(USBConnectStatus::CONNECTING);
   LOGI("StartInternal, listener is:" << listener.get());
   listener_ = listener;
-  StartReader();
-  StartWriter();
+  std::weak_ptr<UsbClient> weak_client = shared_from_this();
+  EventLoop::GetInstance().Watch(socket, kEventReadable,
+                                 [weak_client](uint32_t events) {
+                                   if (auto client = weak_client.lock()) {
+                                     client->OnSocketEvent(events);
+                                   }
+                                 });
+  is_watching_ = true;
 }
 
-bool UsbClient::ReadAndCheckMessageHeader(char *header) {
-  if (!Read(header, kFrameHeaderLen)) {
-    LOGE("read header data error.");
-    return false;
+void UsbClient::OnSocketEvent(uint32_t events) {
+  if (events & kEventWritable) {
+    FlushFrames();
+  }
+  if ((events & kEventReadable) && socket_guard_.Get() != kInvalidSocket) {
+    ReadMessage();
   }
-  return util::CheckHeaderThreeBytes(header);
 }
 
 /**
@@ -129,326 +165,412 @@ bool UsbClient::ReadAndCheckMessageHeader(char *header) {
  *
  *  At DebugRouter, we use term 'header' represent version, type and tag.
  *
- *  checkMessageHeader will check header's value.
+ *  ParseMessages will check header's value.
  */
-
-bool UsbClient::Read(char *buffer, uint32_t read_size) {
-  int64_t start = 0;
-  while (start < read_size) {
+void UsbClient::ReadMessage() {
+  while (true) {
+    size_t buffered = read_buffer_.size();
+    read_buffer_.resize(buffered + kReadChunkSize);
     int64_t read_data_len =
-        recv(socket_guard_.Get(), buffer + start, read_size - start, 0);
-    if (read_data_len <= 0) {
-      // Check if it's a timeout error
-#ifdef _WIN32
-      int error = WSAGetLastError();
-      if (error == WSAEWOULDBLOCK || error == WSAETIMEDOUT) {
-        // Timeout, check if we're stopping
-        if (stopping_.load(std::memory_order_relaxed)) {
-          LOGE("Read: stopping, exit read loop");
-          return false;
-        }
-        // Continue to next iteration to check again
-        continue;
+        recv(socket_guard_.Get(), &read_buffer_[buffered],
+             static_cast<int>(kReadChunkSize), 0);
+    if (read_data_len > 0) {
+      read_buffer_.resize(buffered + static_cast<size_t>(read_data_len));
+      if (!ParseMessages()) {
+        return;
       }
-#else
-      int error = errno;
-      if (error == EAGAIN || error == EWOULDBLOCK || error == ETIMEDOUT) {
-        // Timeout, check if we're stopping
-        if (stopping_.load(std::memory_order_relaxed)) {
-          LOGE("Read: stopping, exit read loop");
-          return false;
-        }
-        // Continue to next iteration to check again
-        continue;
-      }
-#endif
-      LOGE("Read: read_data_len <= 0 :"
-           << "read target count:" << (read_size - start) << " read_data_len:"
-           << read_data_len << " error:" << GetErrorMessage());
-      return false;
+      continue;
     }
-    start = start + read_data_len;
-  }
-  if (start != read_size) {
-    LOGE("Read: read data count > read_size");
-    return false;
+    read_buffer_.resize(buffered);
+    if (read_data_len < 0 && IsWouldBlockError()) {
+      return;
+    }
+#ifndef _WIN32
+    if (read_data_len < 0 && errno == EINTR) {
+      continue;
+    }
+#endif
+    LOGE("Read: read_data_len <= 0 :"
+         << " read_data_len:" << read_data_len
+         << " error:" << GetErrorMessage());
+    // the peer closed the connection or the socket failed, a frame cut in
+    // the middle is reported as a payload error
+    OnReadError(read_buffer_.size() > read_offset_
+                    ? "read payload data error."
+                    : "ReadAndCheckMessageHeader error: don't match "
+                      "DebugRouter protocol");
+    return;
   }
-  return true;
 }
 
-void UsbClient::ReadMessage() {
-  LOGI("UsbClient: ReadMessage:" << socket_guard_.Get());
-  bool isFirst = true;
+bool UsbClient::ParseMessages() {
   while (true) {
-    // Check if we're stopping
-    if (stopping_.load(std::memory_order_relaxed)) {
-      LOGI("UsbClient: ReadMessage: stopping, exit loop");
+    size_t available = read_buffer_.size() - read_offset_;
+    if (available < static_cast<size_t>(kFrameHeaderLen)) {
       break;
     }
-
-    char header[kFrameHeaderLen];
-    memset(header, 0, kFrameHeaderLen);
-    LOGI("UsbClient: start check message header.");
-    if (!ReadAndCheckMessageHeader(header)) {
+    const char *header = read_buffer_.data() + read_offset_;
+    if (!util::CheckHeaderThreeBytes(header)) {
       LOGW("UsbClient: don't match DebugRouter protocol:");
       // need DebugRouterReport to report invailed client.
       for (int i = 0; i < kFrameHeaderLen; i++) {
         LOGE("header " << i << " : #" << util::CharToUInt32(header[i]) << "#");
       }
-      if (!isFirst && listener_) {
-        listener_->OnError(shared_from_this(), GetErrorMessage(),
-                           "ReadAndCheckMessageHeader error: don't match "
-                           "DebugRouter protocol");
-      }
-      break;
+      OnReadError(
+          "ReadAndCheckMessageHeader error: don't match DebugRouter protocol");
+      return false;
     }
-    if (isFirst) {
+    if (is_first_frame_) {
       LOGI("UsbClient: handle first frame.");
+      is_first_frame_ = false;
       if (listener_) {
         is_connected_.store(true, std::memory_order_relaxed);
         listener_->OnOpen(shared_from_this(), ConnectionStatus::kConnected,
                           "Init Success!");
       }
-      isFirst = false;
     }
-    char payload_size[kPayloadSizeLen];
-    if (!Read(payload_size, kPayloadSizeLen)) {
-      LOGE("read payload data error: " << GetErrorMessage());
-      if (listener_) {
-        listener_->OnError(shared_from_this(), GetErrorMessage(),
-                           "read payload size data error.");
-      }
+    bool is_v2 = ReadUInt32(header) ==
+                 static_cast<uint32_t>(kFrameProtocolVersion2);
+    size_t header_len = is_v2 ? kWrappedHeaderLenV2 : kWrappedHeaderLen;
+    if (available < header_len) {
       break;
     }
-
     uint32_t payload_size_int =
-        util::DecodePayloadSize(payload_size, kPayloadSizeLen);
-
-    if (!util::CheckHeaderFourthByte(header, payload_size_int)) {
+        ReadUInt32(header + header_len - kPayloadSizeLen);
+    if (!util::CheckHeaderFourthByte(
+            header, payload_size_int + (is_v2 ? kFrameRoutingLen : 0))) {
       LOGE("CheckHeader failed: Drop This Frame!");
       for (int i = 0; i < kFrameHeaderLen; i++) {
         LOGE("header " << i << " : #" << util::CharToUInt32(header[i]) << "#");
       }
+      read_offset_ += header_len;
       continue;
     }
-    std::unique_ptr<char[]> payload(new char[payload_size_int]);
-    if (!Read(payload.get(), payload_size_int)) {
-      LOGI("read payload data error: " << GetErrorMessage());
-      if (listener_) {
-        listener_->OnError(shared_from_this(), GetErrorMessage(),
-                           "read payload data error:");
-      }
+    if (available - header_len < payload_size_int) {
       break;
     }
-
-    std::string payload_str(payload.get(), payload_size_int);
+    std::string payload_str(header + header_len, payload_size_int);
+    read_offset_ += header_len + payload_size_int;
 
     LOGI("[RX]:" << payload_str);
-
-    // Check if all sessions are enabled
-    bool enable_all_sessions =
-        core::DebugRouterCore::GetInstance().isEnableAllSessions();
-
-    // Only parse JSON if not all sessions are enabled
-    if (!enable_all_sessions) {
-      // get sessionID from payload_str
-      int32_t session_id = -1;
-      Json::Reader reader;
-      Json::Value root;
-      if (reader.parse(payload_str, root)) {
-        if (root.isObject() && root["data"].isObject() &&
-            root["data"]["data"].isObject()) {
-          const Json::Value &session_id_value =
-              root["data"]["data"]["session_id"];
-          if (session_id_value.isNumeric()) {
-            session_id = session_id_value.asInt();
-          }
+    if (!is_v2) {
+      if (!IsActiveSessionMessage(payload_str)) {
+        continue;
+      }
+    } else {
+      FrameRouting routing = ReadFrameRouting(header);
+      if (!use_v2_frames_) {
+        LOGI("UsbClient: peer sent a version 2 frame, send version 2.");
+        use_v2_frames_ = true;
+      }
+      // a lost or reordered frame would corrupt the message being
+      // reassembled, the connection is closed instead
+      if (routing.sequence != next_peer_sequence_) {
+        LOGE("UsbClient: frame " << routing.sequence << " received, "
+                                 << next_peer_sequence_ << " expected.");
+        fragments_.clear();
+        OnReadError("frame sequence error.");
+        return false;
+      }
+      next_peer_sequence_ = routing.sequence + 1;
+      bool more_fragments = routing.flags & kFrameFlagMoreFragments;
+      if (routing.flags & kFrameFlagCompressed) {
+        if (!more_fragments && fragments_.empty()) {
+          LOGE("UsbClient: compressed frames are not supported, drop it.");
+          continue;
         }
+        // the rest of the message could not be read either
+        LOGE("UsbClient: compressed fragments are not supported.");
+        fragments_.clear();
+        OnReadError("compressed fragments error.");
+        return false;
+      }
+      if ((more_fragments || !fragments_.empty()) &&
+          fragments_.size() + payload_str.size() >
+              kMaxFragmentedMessageLength) {
+        LOGE("UsbClient: fragmented message exceeds "
+             << kMaxFragmentedMessageLength << " bytes.");
+        fragments_.clear();
+        OnReadError("fragmented message too large.");
+        return false;
+      }
+      if (more_fragments) {
+        fragments_ += payload_str;
+        continue;
+      }
+      if (!fragments_.empty()) {
+        payload_str = std::move(fragments_) + payload_str;
+        fragments_.clear();
       }
-      LOGI("Extracted session_id: " << session_id);
-      if (session_id > 0 &&
-          !core::DebugRouterCore::GetInstance().isActiveSession(session_id)) {
-        LOGW("Drop message for inactive session_id: " << session_id);
+      // the session is known without parsing the payload
+      if (!IsActiveSession(routing.session_id, payload_str)) {
         continue;
       }
     }
-
-    incoming_message_queue_.put(std::move(payload_str));
+    if (payload_str.empty()) {
+      LOGI("UsbClient: receive empty message.");
+    } else if (listener_) {
+      LOGI("UsbClient: listener exists, do OnMessage.");
+      listener_->OnMessage(shared_from_this(), payload_str);
+    }
+    // OnMessage may have stopped this client
+    if (socket_guard_.Get() == kInvalidSocket) {
+      return false;
+    }
   }
-  // end read loop.
-  LOGI("UsbClient: ReadMessage finished.");
-  if (listener_ && is_connected_.exchange(false, std::memory_order_relaxed)) {
-    listener_->OnClose(shared_from_this(), GetErrorMessage(),
-                       "ReadMessage finished");
+  // drop the parsed bytes
+  if (read_offset_ == read_buffer_.size()) {
+    read_buffer_.clear();
+    read_offset_ = 0;
+  } else if (read_offset_ > 0) {
+    read_buffer_.erase(0, read_offset_);
+    read_offset_ = 0;
   }
-  LOGI("UsbClient: ReadMessage thread exit.");
-  incoming_message_queue_.put(std::move(kMessageQuit));
-  outgoing_message_queue_.put(std::move(kMessageQuit));
+  return true;
 }
 
-void UsbClient::StartReader() {
-  LOGI("UsbClient: start reader thread.");
-  StartMessageDispatcher();
-  read_thread_.submit(
-      [client_ptr = shared_from_this()]() { client_ptr->ReadMessage(); });
+void UsbClient::OnReadError(const std::string &reason) {
+  LOGI("UsbClient: ReadMessage finished.");
+  // a client that never sent a valid frame is closed silently
+  if (!is_first_frame_ && listener_) {
+    listener_->OnError(shared_from_this(), GetErrorMessage(), reason);
+  }
+  DisconnectInternal();
 }
 
-void UsbClient::MessageDispatcher() {
-  while (true) {
-    std::string message = "";
-    message = incoming_message_queue_.take();
-
-    if (message == kMessageQuit) {
-      LOGI("UsbClient: MessageDispatcherFunc receive MESSAGE_QUIT.");
-      break;
+bool UsbClient::IsActiveSessionMessage(const std::string &message) {
+  // Check if all sessions are enabled
+  if (core::DebugRouterCore::GetInstance().isEnableAllSessions()) {
+    return true;
+  }
+  // Only parse JSON if not all sessions are enabled
+  int32_t session_id = -1;
+  protocol::MessageEnvelope envelope;
+  if (protocol::ParseMessageEnvelope(message, envelope)) {
+    if (envelope.has_session_id) {
+      session_id = envelope.session_id;
     }
-
-    if (message.length() > 0) {
-      if (listener_) {
-        LOGI("UsbClient: listener exists, do OnMessage.");
-        listener_->OnMessage(shared_from_this(), message);
+  } else {
+    // e.g. a session_id that is not an integer
+    Json::Reader reader;
+    Json::Value root;
+    if (reader.parse(message, root) && root.isObject() &&
+        root["data"].isObject() && root["data"]["data"].isObject()) {
+      const Json::Value &session_id_value = root["data"]["data"]["session_id"];
+      if (session_id_value.isNumeric()) {
+        session_id = session_id_value.asInt();
       }
-    } else {
-      LOGI("UsbClient: MessageDispatcherFunc receive empty message.");
     }
   }
-  LOGI("UsbClient: message dispatcher finished.");
+  LOGI("Extracted session_id: " << session_id);
+  if (session_id > 0 &&
+      !core::DebugRouterCore::GetInstance().isActiveSession(session_id)) {
+    LOGW("Drop message for inactive session_id: " << session_id);
+    return false;
+  }
+  return true;
 }
 
-void UsbClient::StartMessageDispatcher() {
-  LOGI("UsbClient: startMessageDispatcher.");
-
-  dispatch_thread_.submit(
-      [client_ptr = shared_from_this()]() { client_ptr->MessageDispatcher(); });
+bool UsbClient::IsActiveSession(int32_t session_id,
+                                const std::string &payload) {
+  if (session_id == core::kUnknownSessionId) {
+    return IsActiveSessionMessage(payload);
+  }
+  if (core::DebugRouterCore::GetInstance().isEnableAllSessions()) {
+    return true;
+  }
+  if (session_id > 0 &&
+      !core::DebugRouterCore::GetInstance().isActiveSession(session_id)) {
+    LOGW("Drop message for inactive session_id: " << session_id);
+    return false;
+  }
+  return true;
 }
 
-void UsbClient::WrapHeader(const std::string &message, std::string &result) {
-  const uint32_t total_size =
-      static_cast<uint32_t>(kFrameHeaderLen + kPayloadSizeLen + message.size());
-  result.resize(total_size);
-  char *buffer = &result[0];
+void UsbClient::WrapHeader(uint32_t payload_size, char *header,
+                           int32_t type) {
   char char_array[4];
   // write kFrameProtocolVersion
   util::IntToCharArray(kFrameProtocolVersion, char_array);
-  memcpy(buffer, char_array, 4);
+  memcpy(header, char_array, 4);
 
-  // write kPTFrameTypeTextMessage
-  util::IntToCharArray(kPTFrameTypeTextMessage, char_array);
-  memcpy(buffer + 4, char_array, 4);
+  // write the message type
+  util::IntToCharArray(type, char_array);
+  memcpy(header + 4, char_array, 4);
 
   // write kFrameDefaultTag
   util::IntToCharArray(kFrameDefaultTag, char_array);
-  memcpy(buffer + 8, char_array, 4);
+  memcpy(header + 8, char_array, 4);
 
   // write len
   uint32_t len =
-      static_cast<uint32_t>(kFrameHeaderLen + kPayloadSizeLen + message.size());
+      static_cast<uint32_t>(kFrameHeaderLen + kPayloadSizeLen + payload_size);
   util::IntToCharArray(len, char_array);
-  memcpy(buffer + 12, char_array, 4);
+  memcpy(header + 12, char_array, 4);
+
+  // write payload_size
+  util::IntToCharArray(payload_size, char_array);
+  memcpy(header + 16, char_array, 4);
+}
 
-  // write message.size()
-  util::IntToCharArray(static_cast<uint32_t>(message.size()), char_array);
-  memcpy(buffer + 16, char_array, 4);
+void UsbClient::WrapHeaderV2(uint32_t payload_size,
+                             const FrameRouting &routing, char *header,
+                             int32_t type) {
+  util::IntToCharArray(kFrameProtocolVersion2, header);
+  util::IntToCharArray(type, header + 4);
+  util::IntToCharArray(kFrameDefaultTag, header + 8);
+  util::IntToCharArray(
+      static_cast<uint32_t>(kFrameRoutingLen + kPayloadSizeLen + payload_size),
+      header + 12);
+  util::IntToCharArray(static_cast<uint32_t>(routing.session_id), header + 16);
+  header[20] = static_cast<char>(routing.message_class);
+  header[21] = static_cast<char>(routing.flags);
+  header[22] = 0;
+  header[23] = 0;
+  util::IntToCharArray(routing.sequence, header + 24);
+  util::IntToCharArray(payload_size, header + 28);
+}
 
-  // write message
-  memcpy(buffer + 20, message.c_str(), message.size());
+FrameRouting UsbClient::ReadFrameRouting(const char *header) {
+  FrameRouting routing;
+  routing.session_id = static_cast<int32_t>(ReadUInt32(header + 16));
+  routing.message_class = static_cast<uint8_t>(header[20]);
+  routing.flags = static_cast<uint8_t>(header[21]);
+  routing.sequence = ReadUInt32(header + 24);
+  return routing;
+}
+
+FrameRouting UsbClient::GetFrameRouting(const core::OutboundMessage &message) {
+  FrameRouting routing;
+  routing.session_id = message.session_id;
+  if (message.binary) {
+    routing.message_class = kFrameClassBinary;
+  } else if (message.priority == core::MessagePriority::kScreencast) {
+    routing.message_class = kFrameClassScreencast;
+  } else if (message.type == protocol::kRemoteDebugProtocolBodyData4CDP) {
+    routing.message_class = kFrameClassCdp;
+  } else {
+    routing.message_class = kFrameClassControl;
+  }
+  routing.flags = 0;
+  routing.sequence = next_sequence_++;
+  return routing;
 }
 
 void UsbClient::WriteMessage() {
-  LOGI("UsbClient: WriteMessage:" << socket_guard_.Get());
-  while (true) {
-    std::string message;
-    message = outgoing_message_queue_.take();
+  write_pending_.store(false);
+  if (socket_guard_.Get() == kInvalidSocket) {
+    return;
+  }
+  FlushFrames();
+}
 
-    if (message == kMessageQuit) {
-      LOGI("UsbClient: WriteMessage receive MESSAGE_QUIT.");
-      break;
+bool UsbClient::FillFrames() {
+  if (outgoing_message_queue_.drain_to(write_batch_, kWriteBatchSize,
+                                       kMaxFillBytes) == 0) {
+    return false;
+  }
+  for (const core::OutboundMessage &message : write_batch_) {
+    if (message.size() == 0) {
+      LOGI("UsbClient: WriteMessage receive empty message.");
+      continue;
     }
-
-    // Check if all sessions are enabled
-    bool enable_all_sessions =
-        core::DebugRouterCore::GetInstance().isEnableAllSessions();
-
-    // Only parse JSON if not all sessions are enabled
-    if (!enable_all_sessions) {
-      int32_t session_id = -1;
-      // get sessionID from message
-      Json::Reader reader;
-      Json::Value root;
-      if (reader.parse(message, root)) {
-        if (root.isObject() && root["data"].isObject() &&
-            root["data"]["data"].isObject()) {
-          const Json::Value &session_id_value =
-              root["data"]["data"]["session_id"];
-          if (session_id_value.isNumeric()) {
-            session_id = session_id_value.asInt();
-          }
-        }
-      }
-      LOGI("Extracted session_id: " << session_id);
-      if (session_id > 0 &&
-          !core::DebugRouterCore::GetInstance().isActiveSession(session_id)) {
-        LOGW("Drop message for inactive session_id: " << session_id);
-        continue;
-      }
+    if (!IsActiveSessionMessage(message)) {
+      continue;
     }
-    if (message.length() > 0) {
-      if (message.find("Page.screencastFrame") != std::string::npos) {
-        LOGI("UsbClient: [TX]: Page.screencastFrame Sent.");
-      } else if (message.find("Lynx.screenshotCapture") != std::string::npos) {
-        LOGI("UsbClient: [TX]: Lynx.screenshotCapture Sent.");
-      } else {
-        LOGI("UsbClient: [TX]:");
-        LOGI(message);
-      }
-      std::string result_message;
-      WrapHeader(message, result_message);
-      if (send(socket_guard_.Get(), result_message.c_str(),
-               result_message.size(), 0) == -1) {
-        LOGE("send error: " << GetErrorMessage() << " message:" << message);
-        if (listener_) {
-          listener_->OnError(shared_from_this(), GetErrorMessage(),
-                             "UsbClient::WriteMessage send data failed.");
-        }
-        break;
-      }
+    core::LogOutboundMessage("UsbClient", message);
+    // the header is copied into the queue, the payload is written from
+    // the shared message itself
+    char header[kWrappedHeaderLenV2];
+    uint32_t payload_size = static_cast<uint32_t>(message.size());
+    int32_t type = message.binary ? kPTFrameTypeBinaryMessage
+                                  : kPTFrameTypeTextMessage;
+    if (use_v2_frames_) {
+      WrapHeaderV2(payload_size, GetFrameRouting(message), header, type);
+      frame_queue_.Push(header, kWrappedHeaderLenV2, message.payload);
     } else {
-      LOGI("UsbClient: WriteMessage receive empty message.");
+      WrapHeader(payload_size, header, type);
+      frame_queue_.Push(header, kWrappedHeaderLen, message.payload);
     }
   }
-  LOGI("UsbClient: WriteMessage finished.");
-  if (listener_ && is_connected_.exchange(false, std::memory_order_relaxed)) {
-    listener_->OnClose(shared_from_this(), GetErrorMessage(),
-                       "writer thread finished");
-  }
-  LOGI("UsbClient: WriteMessage thread exit.");
+  write_batch_.clear();
+  return true;
 }
 
-void UsbClient::StartWriter() {
-  LOGI("UsbClient: start writer thread.");
-  write_thread_.submit(
-      [client_ptr = shared_from_this()]() { client_ptr->WriteMessage(); });
+void UsbClient::FlushFrames() {
+  SocketType socket = socket_guard_.Get();
+  // frames are taken by priority whenever the socket has written the
+  // previous ones
+  do {
+    if (!frame_queue_.Flush(socket)) {
+      LOGE("send error: " << GetErrorMessage());
+      if (listener_) {
+        listener_->OnError(shared_from_this(), GetErrorMessage(),
+                           "UsbClient::WriteMessage send data failed.");
+      }
+      DisconnectInternal();
+      return;
+    }
+  } while (frame_queue_.Empty() && FillFrames());
+  // wait for writable only while frames are pending
+  bool want_writable = !frame_queue_.Empty();
+  if (is_watching_ && want_writable != is_watching_writable_) {
+    is_watching_writable_ = want_writable;
+    EventLoop::GetInstance().Update(
+        socket, kEventReadable | (want_writable ? kEventWritable : 0));
+  }
 }
 
 void UsbClient::DisconnectInternal() {
   LOGI("UsbClient: DisconnectInternal.");
-  // Set stopping flag to true
-  stopping_.store(true, std::memory_order_relaxed);
-  incoming_message_queue_.put(std::move(kMessageQuit));
-  outgoing_message_queue_.put(std::move(kMessageQuit));
-  socket_guard_.Reset();
+  SocketType socket = socket_guard_.Get();
+  if (socket != kInvalidSocket) {
+    if (is_watching_) {
+      EventLoop::GetInstance().Unwatch(socket);
+      is_watching_ = false;
+      is_watching_writable_ = false;
+    }
+    socket_guard_.Reset();
+  }
+  frame_queue_.Clear();
+  read_buffer_.clear();
+  read_offset_ = 0;
+  fragments_.clear();
+  connect_status_.store(USBConnectStatus::DISCONNECTED);
+  if (listener_ && is_connected_.exchange(false, std::memory_order_relaxed)) {
+    // not reported when the last reference is being destroyed
+    if (auto client_ptr = weak_from_this().lock()) {
+      listener_->OnClose(client_ptr, GetErrorMessage(),
+                         "ReadMessage finished");
+    }
+  }
 }
 
 bool UsbClient::Send(const std::string &message) {
+  return Send(core::OutboundMessage(message));
+}
+
+bool UsbClient::Send(const core::OutboundMessage &message) {
   LOGI("UsbClient: Send.");
   if (message.size() >
       (kMaxMessageLength - kFrameHeaderLen - kPayloadSizeLen)) {
     LOGE("current protocol only support 1UL << 32 bytes message");
     return false;
   }
-  work_thread_.submit([client_ptr = shared_from_this(), message]() {
-    client_ptr->SendInternal(message);
-  });
+  if (connect_status_.load() != USBConnectStatus::CONNECTED) {
+    LOGI("current usb client is not connected, drop " << message.size()
+                                                      << " bytes.");
+    core::NotifyDropped(message);
+    return true;
+  }
+  if (!outgoing_message_queue_.put(core::OutboundMessage(message))) {
+    LOGW("UsbClient: screencast is behind, drop the oldest frame.");
+  }
+  // one write task drains everything queued before it runs
+  if (!write_pending_.exchange(true)) {
+    EventLoop::GetInstance().Post(
+        [client_ptr = shared_from_this()]() { client_ptr->WriteMessage(); });
+  }
   return true;
 }
 
@@ -456,24 +578,8 @@ void UsbClient::Stop() {
   LOGI("UsbClient: Stop.");
   auto start_time = std::chrono::steady_clock::now();
 
-  LOGI("UsbClient: Stop - begin DisconnectInternal");
-  DisconnectInternal();
-
-  LOGI("UsbClient: Stop - begin dispatch_thread shutdown");
-  dispatch_thread_.shutdown();
-
-  LOGI("UsbClient: Stop - begin write_thread shutdown");
-  write_thread_.shutdown();
-
-  LOGI("UsbClient: Stop - begin read_thread shutdown");
-  read_thread_.shutdown();
-
-  LOGI("UsbClient: Stop - begin work_thread shutdown");
-  work_thread_.shutdown();
-
-  incoming_message_queue_.clear();
+  EventLoop::GetInstance().PostAndWait([this]() { DisconnectInternal(); });
   outgoing_message_queue_.clear();
-  connect_status_ = USBConnectStatus::DISCONNECTED;
 
   auto end_time = std::chrono::steady_clock::now();
   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -482,16 +588,6 @@ void UsbClient::Stop() {
   LOGI("UsbClient: Stop finished in " << duration << "ms");
 }
 
-void UsbClient::SendInternal(const std::string &message) {
-  LOGI("UsbClient: SendInternal.");
-  if (connect_status_ != USBConnectStatus::CONNECTED) {
-    LOGI("current usb client is not connected:" << message);
-    return;
-  }
-  std::string non_const_message = message;
-  outgoing_message_queue_.put(std::move(non_const_message));
-}
-
 UsbClient::~UsbClient() {
   LOGI("UsbClient: ~UsbClient.");
   Stop();
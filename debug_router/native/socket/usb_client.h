@@ -5,31 +5,34 @@
 #ifndef DEBUGROUTER_NATIVE_SOCKET_USB_CLIENT_H_
 #define DEBUGROUTER_NATIVE_SOCKET_USB_CLIENT_H_
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
 #include "debug_router/native/base/socket_guard.h"
-#include "debug_router/native/socket/blocking_queue.h"
-#include "debug_router/native/socket/count_down_latch.h"
+#include "debug_router/native/core/outbound_message.h"
+#include "debug_router/native/socket/frame_writer.h"
+#include "debug_router/native/socket/outbound_scheduler.h"
 #include "debug_router/native/socket/socket_server_type.h"
 #include "debug_router/native/socket/usb_client_listener.h"
-#include "debug_router/native/socket/work_thread_executor.h"
 
 namespace debugrouter {
-namespace base {
-class WorkThreadExecutor;
-}
 namespace socket_server {
 class UsbClientListener;
 
-extern const char *kMessageQuit;
-
-// Client of socket_server
+// Client of socket_server. The socket is non-blocking and driven by the
+// shared EventLoop, listener callbacks are called on the loop thread.
 class UsbClient : public std::enable_shared_from_this<UsbClient> {
  public:
   void Init();
-  // below three functions work only on one work thread
   void StartUp(const std::shared_ptr<UsbClientListener> &listener);
   // true means the message are added to message queue
   bool Send(const std::string &message);
+  bool Send(const core::OutboundMessage &message);
 
+  // closes the socket, returns once the loop no longer uses it.
   void Stop();
 
   explicit UsbClient(SocketType socket_fd);
@@ -37,22 +40,39 @@ class UsbClient : public std::enable_shared_from_this<UsbClient> {
 
   void SetConnectStatus(USBConnectStatus status);
 
+  // records that the peer sent a message to session_id
+  void Subscribe(int32_t session_id);
+  // true if the peer sent messages to session_id or to no session yet.
+  // Messages of no session are for every peer.
+  bool IsSubscribed(int32_t session_id) const;
+
+  // whether the peer enabled binary screencast frames
+  void SetBinaryScreencast(bool enabled);
+  bool IsBinaryScreencast() const;
+
  private:
+  // the following run on the EventLoop thread
   void StartInternal(const std::shared_ptr<UsbClientListener> &listener);
   void DisconnectInternal();
-  void SendInternal(const std::string &message);
-
-  void StartReader();
-  void StartWriter();
-  void StartMessageDispatcher();
+  void OnSocketEvent(uint32_t events);
   void ReadMessage();
-  void MessageDispatcher();
+  // dispatches the complete messages in read_buffer_, false when the
+  // connection has been closed.
+  bool ParseMessages();
+  void OnReadError(const std::string &reason);
   void WriteMessage();
-
-  bool Read(char *buffer, uint32_t read_size);
-  bool ReadAndCheckMessageHeader(char *header);
-
-  void CloseClientSocket(SocketType socket_fd_);
+  // moves the next messages of outgoing_message_queue_ into frame_queue_,
+  // false if there were none
+  bool FillFrames();
+  void FlushFrames();
+
+  // false if the message belongs to an inactive session
+  static bool IsActiveSessionMessage(const std::string &message);
+  // parses the payload only if session_id is kUnknownSessionId
+  static bool IsActiveSession(int32_t session_id, const std::string &payload);
+  static bool IsActiveSessionMessage(const core::OutboundMessage &message) {
+    return IsActiveSession(message.session_id, *message.payload);
+  }
   /**
    *  The DebugRouter message structure is:
    *
@@ -60,8 +80,8 @@ class UsbClient : public std::enable_shared_from_this<UsbClient> {
    *   uint32_t version, // [0,4) protocol version, current version is
    *   kFrameProtocolVersion
    *
-   *   uint32_t type, // [4, 8) message_type, DebugRouter only use text message,
-   *   current type is kPTFrameTypeTextMessage
+   *   uint32_t type, // [4, 8) message_type, kPTFrameTypeTextMessage, or
+   *   kPTFrameTypeBinaryMessage for binary messages
    *
    *   uint32_t tag, // [8, 12) unused, the value remains unchanged at
    *   kFrameDefaultTag
@@ -78,27 +98,76 @@ class UsbClient : public std::enable_shared_from_this<UsbClient> {
    *
    *  At DebugRouter, we use term 'header' represent version, type and tag.
    *
-   *  WrapHeader add header for message
+   *  WrapHeader writes the header and PayLoad.len of a message of
+   *  payload_size bytes, header must hold kFrameHeaderLen + kPayloadSizeLen
+   *  bytes. The content is written separately, see FrameQueue.
+   */
+  static void WrapHeader(uint32_t payload_size, char *header,
+                         int32_t type = kPTFrameTypeTextMessage);
+
+  /**
+   *  A version 2 frame has routing fields between the size and PayLoad.len,
+   *  so that the receiver does not parse the payload to route it:
+   *
+   *  struct message {
+   *   uint32_t version, // [0,4) kFrameProtocolVersion2
+   *   uint32_t type, // [4, 8) as in version 1
+   *   uint32_t tag, // [8, 12) kFrameDefaultTag
+   *   uint32_t size, // [12, 16) bytes after size, kFrameRoutingLen +
+   *   kPayloadSizeLen + content
+   *   int32_t session_id, // [16, 20)
+   *   uint8_t message_class, // [20] FrameMessageClass
+   *   uint8_t flags, // [21] kFrameFlagCompressed, kFrameFlagMoreFragments
+   *   uint16_t reserved, // [22, 24) 0
+   *   uint32_t sequence, // [24, 28)
+   *   uint32_t len, // [28, 32) content length
+   *   uint8_t[len] content
+   *  }
+   *
+   *  header must hold kFrameHeaderLen + kFrameRoutingLen + kPayloadSizeLen
+   *  bytes.
    */
-  static void WrapHeader(const std::string &message, std::string &result);
+  static void WrapHeaderV2(uint32_t payload_size, const FrameRouting &routing,
+                           char *header,
+                           int32_t type = kPTFrameTypeTextMessage);
+  // reads the routing fields of a version 2 header
+  static FrameRouting ReadFrameRouting(const char *header);
+  // the routing fields of an outgoing message
+  FrameRouting GetFrameRouting(const core::OutboundMessage &message);
 
  private:
-  BlockingQueue<std::string> incoming_message_queue_;
-  BlockingQueue<std::string> outgoing_message_queue_;
+  // messages from Send by priority. They are moved into frame_queue_ on the
+  // loop thread only once it is empty, so that urgent messages overtake a
+  // backlog of frames. Only stale screencast frames are ever dropped.
+  OutboundScheduler outgoing_message_queue_{kMaxQueuedScreencastMessages};
+  std::atomic<bool> write_pending_ = {false};
 
-  base::WorkThreadExecutor work_thread_;
-  base::WorkThreadExecutor read_thread_;
-  base::WorkThreadExecutor write_thread_;
-  base::WorkThreadExecutor dispatch_thread_;
+  // below are only used on the loop thread
   std::shared_ptr<UsbClientListener> listener_;
-  USBConnectStatus connect_status_ = USBConnectStatus::DISCONNECTED;
-  std::unique_ptr<CountDownLatch> latch_;
-
+  std::vector<core::OutboundMessage> write_batch_;
+  FrameQueue frame_queue_;
+  // received bytes, parsed from read_offset_
+  std::string read_buffer_;
+  size_t read_offset_ = 0;
+  bool is_first_frame_ = true;
+  // set once the peer sent a version 2 frame
+  bool use_v2_frames_ = false;
+  uint32_t next_sequence_ = 0;
+  uint32_t next_peer_sequence_ = 0;
+  // payloads of version 2 frames that have more fragments, at most
+  // kMaxFragmentedMessageLength bytes
+  std::string fragments_;
+  bool is_watching_ = false;
+  bool is_watching_writable_ = false;
+
+  std::atomic<USBConnectStatus> connect_status_ = {
+      USBConnectStatus::DISCONNECTED};
   base::SocketGuard socket_guard_;
-  // mutex for close socket_fd_
-  std::mutex mutex_;
   std::atomic<bool> is_connected_ = {false};
-  std::atomic<bool> stopping_ = {false};
+
+  mutable std::mutex subscriptions_mutex_;
+  std::vector<int32_t> subscribed_sessions_;
+  std::atomic<bool> binary_screencast_ = {false};
 };
 
 }  // namespace socket_server
@@ -74,38 +74,8 @@ int32_t SocketServerWin::InitSocket() {
   return port;
 }
 
-void SocketServerWin::Start() {
-  int32_t port = kInvalidPort;
-  if (socket_fd_ == kInvalidSocket) {
-    port = InitSocket();
-    if (port == kInvalidPort) {
-      return;
-    }
-  }
-  NotifyInit(0, "port:" + std::to_string(port));
-  LOGI("server socket:" << socket_fd_);
-  SocketType accept_socket_fd = accept(socket_fd_, NULL, NULL);
-  if (accept_socket_fd == kInvalidSocket) {
-    Close();
-    LOGE("accept socket error:" << GetErrorMessage());
-    NotifyInit(GetErrorMessage(), "accept socket error");
-    return;
-  }
-  auto temp_usb_client = std::make_shared<UsbClient>(accept_socket_fd);
-  std::shared_ptr<ClientListener> listener =
-      std::make_shared<ClientListener>(shared_from_this());
-  temp_usb_client->Init();
-  temp_usb_client->StartUp(listener);
-}
-
-void SocketServerWin::CloseSocket(int socket_fd) {
-  LOGI("CloseSocket" << socket_fd);
-  if (socket_fd == kInvalidSocket) {
-    return;
-  }
-  if (closesocket(socket_fd) != 0) {
-    LOGE("close socket error:" << GetErrorMessage());
-  }
+SocketType SocketServerWin::Accept() {
+  return accept(socket_fd_, NULL, NULL);
 }
 
 }  // namespace socket_server
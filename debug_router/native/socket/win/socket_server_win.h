@@ -18,9 +18,8 @@ class SocketServerWin : public SocketServer {
  private:
   inline int GetErrorMessage() override { return WSAGetLastError(); }
 
-  int32_t InitSocket();
-  void Start() override;
-  void CloseSocket(int socket_fd) override;
+  int32_t InitSocket() override;
+  SocketType Accept() override;
 };
 
 }  // namespace socket_server
@@ -0,0 +1,72 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/processor/cdp_method_router.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace processor {
+
+TEST(CdpMethodRouterTestSuite, RoutesByMethod) {
+  CdpMethodRouter router;
+  std::vector<std::string> calls;
+  for (const char *method : {"Runtime.enable", "DebugRouter.ping",
+                             "Page.screencastFrameAck"}) {
+    std::string name(method);
+    router.Add(name, [&calls, name](int session_id, const std::string &) {
+      calls.push_back(name + ":" + std::to_string(session_id));
+      return name != "Page.screencastFrameAck";
+    });
+  }
+
+  EXPECT_TRUE(router.Route(1, "{\"id\":1,\"method\":\"Runtime.enable\"}"));
+  EXPECT_TRUE(router.Route(2, "{\"id\":2,\"method\":\"DebugRouter.ping\"}"));
+  // observed but still forwarded
+  EXPECT_FALSE(router.Route(
+      3, "{\"id\":3,\"method\":\"Page.screencastFrameAck\",\"params\":{}}"));
+  EXPECT_FALSE(router.Route(4, "{\"id\":4,\"method\":\"Runtime.evaluate\"}"));
+  EXPECT_FALSE(router.Route(5, "{\"id\":5,\"result\":{}}"));
+  EXPECT_EQ(calls,
+            std::vector<std::string>({"Runtime.enable:1", "DebugRouter.ping:2",
+                                      "Page.screencastFrameAck:3"}));
+
+  CdpRouteStats stats = router.GetStats();
+  EXPECT_EQ(stats.messages, 5u);
+  EXPECT_EQ(stats.hits, 3u);
+  EXPECT_EQ(stats.handled, 2u);
+}
+
+TEST(CdpMethodRouterTestSuite, ReplacesAndRemoves) {
+  CdpMethodRouter router;
+  const std::string message = "{\"id\":1,\"method\":\"Runtime.enable\"}";
+  // nothing is counted while no method is routed
+  EXPECT_FALSE(router.Route(1, message));
+  EXPECT_EQ(router.GetStats().messages, 0u);
+
+  int first = 0;
+  int second = 0;
+  router.Add("Runtime.enable", [&](int, const std::string &) {
+    first++;
+    return true;
+  });
+  router.Add("Runtime.enable", [&](int, const std::string &) {
+    second++;
+    return true;
+  });
+  EXPECT_TRUE(router.Route(1, message));
+  EXPECT_EQ(first, 0);
+  EXPECT_EQ(second, 1);
+
+  EXPECT_TRUE(router.Remove("Runtime.enable"));
+  EXPECT_FALSE(router.Remove("Runtime.enable"));
+  EXPECT_FALSE(router.Route(1, message));
+  EXPECT_EQ(second, 1);
+}
+
+}  // namespace processor
+}  // namespace debugrouter
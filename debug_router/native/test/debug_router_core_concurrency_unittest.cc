@@ -3,12 +3,18 @@
 // LICENSE file in the root directory of this source tree.
 
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
 #include "debug_router/native/core/debug_router_core.h"
 #include "debug_router/native/core/debug_router_global_handler.h"
 #include "debug_router/native/core/debug_router_session_handler.h"
+#include "debug_router/native/processor/processor.h"
+#include "debug_router/native/socket/count_down_latch.h"
 #include "gtest/gtest.h"
 
 namespace debugrouter {
@@ -22,6 +28,19 @@ class TestGlobalHandler : public DebugRouterGlobalHandler {
   }
 };
 
+// counts the messages it receives
+class CountingGlobalHandler : public DebugRouterGlobalHandler {
+ public:
+  void OpenCard(const std::string &url) override {}
+  void OnMessage(const std::string &message, const std::string &type) override {
+    count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  size_t count() const { return count_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<size_t> count_{0};
+};
+
 class TestSessionHandler : public DebugRouterSessionHandler {
  public:
   virtual ~TestSessionHandler() = default;
@@ -31,6 +50,76 @@ class TestSessionHandler : public DebugRouterSessionHandler {
                  int session_id) override {}
 };
 
+class TestTransceiver : public MessageTransceiver {
+ public:
+  explicit TestTransceiver(socket_server::CountDownLatch &latch)
+      : latch_(latch) {}
+  bool Connect(const std::string &url) override { return true; }
+  void Disconnect() override {}
+  void Send(const std::string &data) override { latch_.CountDown(); }
+  ConnectionType GetType() override { return ConnectionType::kWebSocket; }
+  void StartServer() override {}
+  void StopServer() override {}
+
+ private:
+  socket_server::CountDownLatch &latch_;
+};
+
+// records what is sent to the debugger
+class RecordingTransceiver : public MessageTransceiver {
+ public:
+  bool Connect(const std::string &url) override { return true; }
+  void Disconnect() override {}
+  void Send(const std::string &data) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sent_.push_back(data);
+  }
+  ConnectionType GetType() override { return ConnectionType::kWebSocket; }
+  void StartServer() override {}
+  void StopServer() override {}
+
+  std::vector<std::string> sent() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sent_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::string> sent_;
+};
+
+// a usb server that waits for a debugger
+class ListeningUsbTransceiver : public MessageTransceiver {
+ public:
+  bool Connect(const std::string &url) override { return true; }
+  void Disconnect() override {}
+  void Send(const std::string &data) override {}
+  ConnectionType GetType() override { return ConnectionType::kUsb; }
+  void StartServer() override {}
+  void StopServer() override {}
+  bool IsListening() override { return true; }
+};
+
+// records the messages of its sessions
+class RecordingSessionHandler : public DebugRouterSessionHandler {
+ public:
+  explicit RecordingSessionHandler(socket_server::CountDownLatch &latch)
+      : latch_(latch) {}
+  void OnSessionCreate(int session_id, const std::string &url) override {}
+  void OnSessionDestroy(int session_id) override {}
+  void OnMessage(const std::string &message, const std::string &type,
+                 int session_id) override {
+    messages_.push_back(message);
+    latch_.CountDown();
+  }
+
+  const std::vector<std::string> &messages() const { return messages_; }
+
+ private:
+  socket_server::CountDownLatch &latch_;
+  std::vector<std::string> messages_;
+};
+
 class DebugRouterCoreConcurrencyTest : public ::testing::Test {
  protected:
   void SetUp() override {
@@ -45,23 +134,90 @@ class DebugRouterCoreConcurrencyTest : public ::testing::Test {
   }
 
   void ClearGlobalHandlers() {
-    std::unique_lock lock(core_->global_handler_mutex_);
-    core_->global_handler_map_.clear();
+    core_->global_handlers_.Update(
+        [](HandlerIndex<DebugRouterGlobalHandler> &h) {
+          h.Clear();
+          return true;
+        });
   }
 
   size_t GetGlobalHandlerCount() {
-    std::shared_lock lock(core_->global_handler_mutex_);
-    return core_->global_handler_map_.size();
+    return core_->global_handlers_.Load()->size();
   }
 
   void ClearSessionHandlers() {
-    std::unique_lock lock(core_->session_handler_mutex_);
-    core_->session_handler_map_.clear();
+    core_->session_handlers_.Update(
+        [](HandlerIndex<DebugRouterSessionHandler> &h) {
+          h.Clear();
+          return true;
+        });
   }
 
   size_t GetSessionHandlerCount() {
-    std::shared_lock lock(core_->session_handler_mutex_);
-    return core_->session_handler_map_.size();
+    return core_->session_handlers_.Load()->size();
+  }
+
+  void SetConnected(const std::shared_ptr<MessageTransceiver> &transceiver) {
+    core_->current_transceiver_ = transceiver;
+    core_->connection_state_.store(CONNECTED);
+  }
+
+  void ResetConnection() {
+    core_->CancelPendingReconnect();
+    core_->connection_state_.store(DISCONNECTED);
+    core_->current_transceiver_ = nullptr;
+    core_->ResetReconnectPolicy();
+  }
+
+  bool TryToReconnect() { return core_->TryToReconnect(); }
+
+  void SetReconnectPolicy(std::unique_ptr<ReconnectPolicy> policy) {
+    core_->SetReconnectPolicy(std::move(policy));
+  }
+
+  bool HasPendingReconnect() {
+    std::lock_guard<std::mutex> lock(core_->reconnect_mutex_);
+    return core_->reconnect_task_.IsValid() &&
+           !core_->reconnect_task_.IsCancelled();
+  }
+
+  // replaces the usb transceiver of core_, returns the one it replaced
+  std::shared_ptr<MessageTransceiver> ReplaceUsbTransceiver(
+      const std::shared_ptr<MessageTransceiver> &transceiver) {
+    for (auto &current : core_->message_transceivers_) {
+      if (current->GetType() == ConnectionType::kUsb) {
+        std::shared_ptr<MessageTransceiver> replaced = current;
+        current = transceiver;
+        return replaced;
+      }
+    }
+    return nullptr;
+  }
+
+  // the processor of core_ accepts messages of client_id from now on
+  void InitProcessor(int client_id) {
+    core_->processor_->Process("{\"event\":\"Initialize\",\"data\":" +
+                               std::to_string(client_id) + "}");
+  }
+
+  // delivers message to the global handlers the way the host does
+  void DispatchGlobalMessage(int client_id, const std::string &message) {
+    core_->processor_->Process(
+        "{\"event\":\"Customized\",\"data\":{\"type\":\"Test\","
+        "\"data\":{\"client_id\":" +
+        std::to_string(client_id) + ",\"session_id\":-1,\"message\":\"" +
+        message + "\"},\"sender\":1}}");
+  }
+
+  // delivers the escaped CDP message to session_id the way the host does
+  void DispatchCdpMessage(int client_id, int session_id,
+                          const std::string &message) {
+    core_->processor_->Process(
+        "{\"event\":\"Customized\",\"data\":{\"type\":\"CDP\","
+        "\"data\":{\"client_id\":" +
+        std::to_string(client_id) +
+        ",\"session_id\":" + std::to_string(session_id) +
+        ",\"message\":\"" + message + "\"},\"sender\":1}}");
   }
 
   DebugRouterCore *core_;
@@ -187,6 +343,53 @@ TEST_F(DebugRouterCoreConcurrencyTest, ConcurrentAddAndRemoveGlobalHandlers) {
             static_cast<size_t>(handlers.size() + kNumThreads / 2));
 }
 
+TEST_F(DebugRouterCoreConcurrencyTest, DispatchWhileHandlersChange) {
+  constexpr int kClientId = 7;
+  constexpr size_t kMessages = 20000;
+  InitProcessor(kClientId);
+  CountingGlobalHandler stable;
+  core_->AddGlobalHandler(&stable);
+
+  // writers keep adding and removing handlers while messages are dispatched
+  std::atomic<bool> done(false);
+  std::atomic<size_t> registrations(0);
+  std::vector<std::thread> writers;
+  std::vector<std::unique_ptr<CountingGlobalHandler>> churn;
+  for (int i = 0; i < 2; ++i) {
+    churn.push_back(std::make_unique<CountingGlobalHandler>());
+  }
+  for (auto &handler : churn) {
+    writers.emplace_back([&, handler = handler.get(), this]() {
+      while (!done.load(std::memory_order_relaxed)) {
+        int id = core_->AddGlobalHandler(handler);
+        core_->RemoveGlobalHandler(id);
+        registrations.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kMessages; ++i) {
+    DispatchGlobalMessage(kClientId, "m");
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  done = true;
+  for (auto &t : writers) {
+    t.join();
+  }
+
+  // a handler that stays registered sees every message
+  EXPECT_EQ(stable.count(), kMessages);
+  for (auto &handler : churn) {
+    EXPECT_LE(handler->count(), kMessages);
+  }
+  EXPECT_EQ(GetGlobalHandlerCount(), static_cast<size_t>(1));
+  RecordProperty("dispatches_per_second",
+                 static_cast<int>(kMessages / seconds));
+  RecordProperty("registrations", static_cast<int>(registrations.load()));
+}
+
 TEST_F(DebugRouterCoreConcurrencyTest, ConcurrentAddSameSessionHandler) {
   TestSessionHandler handler;
   std::vector<std::thread> threads;
@@ -307,5 +510,71 @@ TEST_F(DebugRouterCoreConcurrencyTest, ConcurrentAddAndRemoveSessionHandlers) {
             static_cast<size_t>(handlers.size() + kNumThreads / 2));
 }
 
+TEST_F(DebugRouterCoreConcurrencyTest, SendAsyncNotBlockedByReconnect) {
+  socket_server::CountDownLatch latch(1);
+  SetConnected(std::make_shared<TestTransceiver>(latch));
+  // schedule every allowed retry, each of them waits before reconnecting
+  for (int i = 0; i < 3; ++i) {
+    TryToReconnect();
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  core_->SendAsync("message");
+  latch.Await();
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  EXPECT_LT(elapsed.count(), 500);
+
+  ResetConnection();
+}
+
+TEST_F(DebugRouterCoreConcurrencyTest, ProbeWhileUsbIsListening) {
+  ExponentialBackoffReconnectPolicy::Options options;
+  options.max_attempts = 0;
+  options.circuit_breaker_cooldown = std::chrono::milliseconds(600000);
+  SetReconnectPolicy(
+      std::make_unique<ExponentialBackoffReconnectPolicy>(options, 42));
+  std::shared_ptr<MessageTransceiver> usb =
+      ReplaceUsbTransceiver(std::make_shared<ListeningUsbTransceiver>());
+  ASSERT_NE(usb, nullptr);
+
+  // the websocket leg gives up, but the room is still probed
+  EXPECT_FALSE(TryToReconnect());
+  EXPECT_TRUE(HasPendingReconnect());
+  EXPECT_FALSE(TryToReconnect());
+  EXPECT_TRUE(HasPendingReconnect());
+
+  ReplaceUsbTransceiver(usb);
+  SetReconnectPolicy(nullptr);
+  ResetConnection();
+}
+
+TEST_F(DebugRouterCoreConcurrencyTest, PingIsAnsweredByTheRouter) {
+  constexpr int kClientId = 7;
+  constexpr int kSession = 9;
+  InitProcessor(kClientId);
+  auto transceiver = std::make_shared<RecordingTransceiver>();
+  SetConnected(transceiver);
+  socket_server::CountDownLatch latch(1);
+  RecordingSessionHandler handler(latch);
+  core_->AddSessionHandler(&handler);
+  uint64_t handled = core_->GetCdpRouteStats().handled;
+
+  DispatchCdpMessage(kClientId, kSession,
+                     "{\\\"id\\\":3,\\\"method\\\":\\\"DebugRouter.ping\\\"}");
+  DispatchCdpMessage(kClientId, kSession,
+                     "{\\\"id\\\":4,\\\"method\\\":\\\"Runtime.enable\\\"}");
+  // the messages of a session are handled in order, the ping is not forwarded
+  latch.Await();
+  const std::string forwarded = "{\"id\":4,\"method\":\"Runtime.enable\"}";
+  EXPECT_EQ(handler.messages(), std::vector<std::string>({forwarded}));
+  EXPECT_EQ(core_->GetCdpRouteStats().handled, handled + 1);
+  std::vector<std::string> sent = transceiver->sent();
+  ASSERT_EQ(sent.size(), 1u);
+  EXPECT_NE(sent[0].find("{\"id\":3,\"result\":{}}"), std::string::npos);
+
+  ResetConnection();
+}
+
 }  // namespace core
 }  // namespace debugrouter
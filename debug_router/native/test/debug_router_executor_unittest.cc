@@ -0,0 +1,74 @@
+// Copyright 2024 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/thread/debug_router_executor.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "debug_router/native/socket/count_down_latch.h"
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace thread {
+
+TEST(DebugRouterExecutorTestSuite, DelayedTasksRunInDeadlineOrder) {
+  auto &executor = DebugRouterExecutor::GetInstance();
+  executor.Start();
+  std::vector<int> order;
+  std::mutex order_mutex;
+  socket_server::CountDownLatch latch(3);
+  auto record = [&](int value) {
+    return [&, value]() {
+      {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        order.push_back(value);
+      }
+      latch.CountDown();
+    };
+  };
+  executor.PostDelayed(record(3), std::chrono::milliseconds(60));
+  executor.PostDelayed(record(1), std::chrono::milliseconds(20));
+  executor.PostDelayed(record(2), std::chrono::milliseconds(40));
+  latch.Await();
+  EXPECT_EQ(order, std::vector<int>({1, 2, 3}));
+}
+
+TEST(DebugRouterExecutorTestSuite, CancelledTaskDoesNotRun) {
+  auto &executor = DebugRouterExecutor::GetInstance();
+  executor.Start();
+  std::atomic<bool> cancelled_ran(false);
+  TaskHandle handle = executor.PostDelayed(
+      [&]() { cancelled_ran.store(true); }, std::chrono::milliseconds(20));
+  EXPECT_TRUE(handle.IsValid());
+  handle.Cancel();
+  EXPECT_TRUE(handle.IsCancelled());
+
+  socket_server::CountDownLatch latch(1);
+  executor.PostDelayed([&]() { latch.CountDown(); },
+                       std::chrono::milliseconds(40));
+  latch.Await();
+  EXPECT_FALSE(cancelled_ran.load());
+}
+
+TEST(DebugRouterExecutorTestSuite, PendingDelayedTaskDoesNotBlockPost) {
+  auto &executor = DebugRouterExecutor::GetInstance();
+  executor.Start();
+  TaskHandle handle =
+      executor.PostDelayed([]() {}, std::chrono::milliseconds(10000));
+
+  socket_server::CountDownLatch latch(1);
+  auto start = TaskClock::now();
+  executor.Post([&]() { latch.CountDown(); }, false);
+  latch.Await();
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      TaskClock::now() - start);
+  EXPECT_LT(elapsed.count(), 500);
+  handle.Cancel();
+}
+
+}  // namespace thread
+}  // namespace debugrouter
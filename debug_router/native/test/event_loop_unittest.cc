@@ -0,0 +1,137 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/socket/event_loop.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "debug_router/native/socket/count_down_latch.h"
+#include "debug_router/native/socket/frame_writer.h"
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace socket_server {
+
+TEST(EventLoopTestSuite, PostRunsInOrderOnLoopThread) {
+  EventLoop loop;
+  std::vector<int> order;
+  std::atomic<bool> in_loop_thread = {true};
+  for (int i = 0; i < 100; ++i) {
+    loop.Post([&, i]() {
+      if (!loop.IsInLoopThread()) {
+        in_loop_thread = false;
+      }
+      order.push_back(i);
+    });
+  }
+  loop.PostAndWait([]() {});
+  EXPECT_FALSE(loop.IsInLoopThread());
+  EXPECT_TRUE(in_loop_thread);
+  ASSERT_EQ(order.size(), 100u);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(order[i], i);
+  }
+}
+
+TEST(EventLoopTestSuite, PostAndWaitOnLoopThreadRunsDirectly) {
+  EventLoop loop;
+  bool nested_ran = false;
+  loop.PostAndWait([&]() {
+    loop.PostAndWait([&]() { nested_ran = true; });
+    EXPECT_TRUE(nested_ran);
+  });
+  EXPECT_TRUE(nested_ran);
+}
+
+TEST(EventLoopTestSuite, ReadableAndWritable) {
+  EventLoop loop;
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  ASSERT_TRUE(SetNonBlocking(fds[0]));
+  std::string received;
+  CountDownLatch readable(1);
+  CountDownLatch writable(1);
+  std::atomic<bool> writable_reported = {false};
+  loop.PostAndWait([&]() {
+    loop.Watch(fds[0], kEventReadable | kEventWritable, [&](uint32_t events) {
+      if (events & kEventWritable) {
+        // stop polling for writable once it is reported
+        loop.Update(fds[0], kEventReadable);
+        if (!writable_reported.exchange(true)) {
+          writable.CountDown();
+        }
+      }
+      if (events & kEventReadable) {
+        char buffer[16];
+        ssize_t size = recv(fds[0], buffer, sizeof(buffer), 0);
+        if (size > 0) {
+          received.append(buffer, size);
+          readable.CountDown();
+        }
+      }
+    });
+  });
+  writable.Await();
+  ASSERT_EQ(write(fds[1], "ping", 4), 4);
+  readable.Await();
+  loop.PostAndWait([&]() { loop.Unwatch(fds[0]); });
+  EXPECT_EQ(received, "ping");
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(EventLoopTestSuite, UnwatchInsideCallback) {
+  EventLoop loop;
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  std::atomic<int> calls = {0};
+  CountDownLatch called(1);
+  loop.PostAndWait([&]() {
+    loop.Watch(fds[0], kEventReadable, [&](uint32_t events) {
+      // the data is never read, the socket stays readable
+      loop.Unwatch(fds[0]);
+      calls++;
+      called.CountDown();
+    });
+  });
+  ASSERT_EQ(write(fds[1], "x", 1), 1);
+  called.Await();
+  // a few more iterations of the loop
+  for (int i = 0; i < 10; ++i) {
+    loop.PostAndWait([]() {});
+  }
+  EXPECT_EQ(calls.load(), 1);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(EventLoopTestSuite, CloseReportsHangUpToPeer) {
+  EventLoop loop;
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  CountDownLatch closed(1);
+  loop.PostAndWait([&]() {
+    loop.Watch(fds[1], kEventReadable, [&](uint32_t events) {
+      char buffer[4];
+      if (recv(fds[1], buffer, sizeof(buffer), 0) == 0) {
+        loop.Unwatch(fds[1]);
+        closed.CountDown();
+      }
+    });
+    loop.Watch(fds[0], kEventReadable, [](uint32_t events) {});
+  });
+  // from another thread, closed on the loop thread
+  loop.Close(fds[0]);
+  closed.Await();
+  close(fds[1]);
+}
+
+}  // namespace socket_server
+}  // namespace debugrouter
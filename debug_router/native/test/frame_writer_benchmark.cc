@@ -0,0 +1,123 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+// Measures how many 200 byte messages per second UsbClient writes to a
+// loopback TCP connection: one gather write per frame, as FrameQueue::Flush
+// did before, and the frames of a drained batch gathered into few writes.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "debug_router/native/socket/frame_writer.h"
+
+namespace {
+
+using debugrouter::socket_server::FrameQueue;
+
+constexpr size_t kMessages = 1000000;
+constexpr size_t kMessageSize = 200;
+constexpr size_t kHeaderSize = 20;
+
+// connects a client to a listener on 127.0.0.1, returns the two ends
+bool Connect(int &client, int &server) {
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t length = sizeof(address);
+  if (bind(listener, reinterpret_cast<sockaddr *>(&address), length) != 0 ||
+      listen(listener, 1) != 0 ||
+      getsockname(listener, reinterpret_cast<sockaddr *>(&address),
+                  &length) != 0) {
+    close(listener);
+    return false;
+  }
+  client = socket(AF_INET, SOCK_STREAM, 0);
+  if (connect(client, reinterpret_cast<sockaddr *>(&address), length) != 0) {
+    close(listener);
+    return false;
+  }
+  server = accept(listener, nullptr, nullptr);
+  close(listener);
+  debugrouter::socket_server::SetFrameSocketOptions(client);
+  return server >= 0;
+}
+
+template <typename Write>
+void Measure(const char *name, size_t batch, Write write) {
+  int client = -1;
+  int server = -1;
+  if (!Connect(client, server)) {
+    printf("  %-8s connect failed\n", name);
+    return;
+  }
+  size_t expected = kMessages * (kHeaderSize + kMessageSize);
+  std::thread reader([server, expected]() {
+    char buffer[256 * 1024];
+    size_t received = 0;
+    while (received < expected) {
+      ssize_t size = read(server, buffer, sizeof(buffer));
+      if (size <= 0) {
+        break;
+      }
+      received += size;
+    }
+  });
+  auto payload =
+      std::make_shared<const std::string>(std::string(kMessageSize, 'x'));
+  char header[kHeaderSize] = {};
+  auto start = std::chrono::steady_clock::now();
+  for (size_t sent = 0; sent < kMessages; sent += batch) {
+    write(client, header, payload, batch);
+  }
+  reader.join();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  printf("  %-8s batch %4zu %8.2f M messages/s %8.0f MB/s\n", name, batch,
+         kMessages / seconds / 1e6, expected / seconds / 1e6);
+  close(client);
+  close(server);
+}
+
+void Run(size_t batch) {
+  Measure("frame", batch,
+          [](int socket, const char *header,
+             const std::shared_ptr<const std::string> &payload,
+             size_t count) {
+            FrameQueue queue;
+            for (size_t i = 0; i < count; ++i) {
+              queue.Push(header, kHeaderSize, payload);
+              queue.Flush(socket);
+            }
+          });
+  FrameQueue queue;
+  Measure("gather", batch,
+          [&queue](int socket, const char *header,
+                   const std::shared_ptr<const std::string> &payload,
+                   size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+              queue.Push(header, kHeaderSize, payload);
+            }
+            // the socket blocks, so Flush writes everything
+            queue.Flush(socket);
+          });
+}
+
+}  // namespace
+
+int main() {
+  for (size_t batch : {1, 8, 64, 512}) {
+    Run(batch);
+  }
+  return 0;
+}
@@ -0,0 +1,134 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/socket/frame_writer.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace socket_server {
+
+namespace {
+
+std::string ReadAll(int fd) {
+  std::string result;
+  char buffer[64 * 1024];
+  while (true) {
+    ssize_t size = read(fd, buffer, sizeof(buffer));
+    if (size <= 0) {
+      return result;
+    }
+    result.append(buffer, size);
+  }
+}
+
+// flushes queue into the non-blocking fd until it is empty
+bool FlushAll(FrameQueue &queue, int fd) {
+  while (!queue.Empty()) {
+    if (!queue.Flush(fd)) {
+      return false;
+    }
+    pollfd writable = {fd, POLLOUT, 0};
+    poll(&writable, 1, 1000);
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(FrameWriterTestSuite, PartialWritesOfLargeFrame) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+  // larger than the socket buffer, so sendmsg returns partial writes
+  std::string payload(4 * 1024 * 1024, 0);
+  for (size_t i = 0; i < payload.size(); ++i) {
+    payload[i] = static_cast<char>(i * 31);
+  }
+  std::string received;
+  std::thread reader([&]() { received = ReadAll(fds[1]); });
+  FrameQueue queue;
+  queue.Push("header", 6, std::make_shared<const std::string>(payload));
+  EXPECT_TRUE(FlushAll(queue, fds[0]));
+  close(fds[0]);
+  reader.join();
+  close(fds[1]);
+  EXPECT_TRUE(received == "header" + payload);
+}
+
+TEST(FrameWriterTestSuite, WriteSomeSlicesSkipsEmptySlices) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  std::vector<std::string> parts;
+  std::vector<FrameSlice> slices;
+  std::string expected;
+  for (int i = 0; i < 300; ++i) {
+    parts.push_back(i % 3 == 0 ? "" : std::to_string(i) + ",");
+  }
+  size_t written_slices = 0;
+  for (const auto &part : parts) {
+    slices.push_back({part.data(), part.size()});
+    // one write takes at most 64 slices, empty ones are not counted
+    if (!part.empty() && written_slices < 64) {
+      expected += part;
+      written_slices++;
+    }
+  }
+  EXPECT_EQ(WriteSomeSlices(fds[0], slices.data(), slices.size()),
+            static_cast<int64_t>(expected.size()));
+  close(fds[0]);
+  EXPECT_EQ(ReadAll(fds[1]), expected);
+  close(fds[1]);
+}
+
+TEST(FrameWriterTestSuite, QueueGathersFrames) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+  // small frames, empty ones and frames larger than the socket buffer and
+  // the byte budget, so that gathers end in partial frames
+  FrameQueue queue;
+  std::string expected;
+  for (int i = 0; i < 1000; ++i) {
+    std::string header = "h" + std::to_string(i) + ":";
+    auto payload = std::make_shared<const std::string>(
+        i % 100 == 99 ? std::string(600 * 1024 + i, static_cast<char>(i))
+                      : std::string(i % 7 == 0 ? 0 : 200, 'p'));
+    queue.Push(header.data(), i % 5 == 0 ? 0 : header.size(), payload);
+    expected += (i % 5 == 0 ? "" : header) + *payload;
+  }
+  std::string received;
+  std::thread reader([&]() { received = ReadAll(fds[1]); });
+  EXPECT_TRUE(FlushAll(queue, fds[0]));
+  close(fds[0]);
+  reader.join();
+  close(fds[1]);
+  EXPECT_EQ(received.size(), expected.size());
+  EXPECT_TRUE(received == expected);
+}
+
+TEST(FrameWriterTestSuite, ClosedPeerFailsWithoutSignal) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  SetFrameSocketOptions(fds[0]);
+  close(fds[1]);
+  FrameQueue queue;
+  queue.Push("h", 1, std::make_shared<const std::string>(1024, 'x'));
+  // without MSG_NOSIGNAL/SO_NOSIGPIPE this would kill the test with SIGPIPE
+  EXPECT_FALSE(queue.Flush(fds[0]));
+  close(fds[0]);
+}
+
+}  // namespace socket_server
+}  // namespace debugrouter
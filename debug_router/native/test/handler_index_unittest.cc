@@ -0,0 +1,90 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/core/handler_index.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace core {
+
+namespace {
+
+struct TestHandler {
+  std::string name;
+};
+
+HandlerSubscription Subscribe(std::unordered_set<int32_t> session_ids,
+                              std::unordered_set<std::string> types) {
+  HandlerSubscription subscription;
+  subscription.session_ids = std::move(session_ids);
+  subscription.types = std::move(types);
+  return subscription;
+}
+
+// the names of the handlers a message of type to session_id goes to, sorted
+std::vector<std::string> Subscribers(const HandlerIndex<TestHandler> &index,
+                                     int32_t session_id,
+                                     const std::string &type) {
+  std::vector<std::string> names;
+  index.ForEachSubscriber(session_id, type, [&](TestHandler *handler) {
+    names.push_back(handler->name);
+  });
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+}  // namespace
+
+TEST(HandlerIndexTestSuite, DispatchesToSubscribers) {
+  TestHandler all{"all"};
+  TestHandler cdp{"cdp"};
+  TestHandler session{"session"};
+  TestHandler session_cdp{"session_cdp"};
+  HandlerIndex<TestHandler> index;
+  index.Add(1, &all, HandlerSubscription());
+  index.Add(2, &cdp, Subscribe({}, {"CDP"}));
+  index.Add(3, &session, Subscribe({3, 4}, {}));
+  index.Add(4, &session_cdp, Subscribe({3}, {"CDP", "Extension"}));
+
+  using Names = std::vector<std::string>;
+  EXPECT_EQ(Subscribers(index, 3, "CDP"),
+            Names({"all", "cdp", "session", "session_cdp"}));
+  EXPECT_EQ(Subscribers(index, 3, "Extension"),
+            Names({"all", "session", "session_cdp"}));
+  EXPECT_EQ(Subscribers(index, 4, "CDP"), Names({"all", "cdp", "session"}));
+  EXPECT_EQ(Subscribers(index, 5, "CDP"), Names({"all", "cdp"}));
+  EXPECT_EQ(Subscribers(index, 5, "Other"), Names({"all"}));
+}
+
+TEST(HandlerIndexTestSuite, AddsAndRemoves) {
+  TestHandler first{"first"};
+  TestHandler second{"second"};
+  HandlerIndex<TestHandler> index;
+  index.Add(7, &first, Subscribe({1}, {}));
+  index.Add(8, &second, Subscribe({1}, {}));
+  EXPECT_EQ(index.Find(&first), 7);
+  EXPECT_EQ(index.size(), 2u);
+
+  EXPECT_TRUE(index.Remove(7));
+  EXPECT_FALSE(index.Remove(7));
+  EXPECT_EQ(index.Find(&first), 0);
+  EXPECT_EQ(Subscribers(index, 1, "CDP"), std::vector<std::string>({"second"}));
+
+  // every handler is visited whatever it subscribed to
+  std::vector<TestHandler *> visited;
+  index.ForEach([&](TestHandler *handler) { visited.push_back(handler); });
+  EXPECT_EQ(visited, std::vector<TestHandler *>({&second}));
+  index.Clear();
+  EXPECT_EQ(index.size(), 0u);
+  EXPECT_TRUE(Subscribers(index, 1, "CDP").empty());
+}
+
+}  // namespace core
+}  // namespace debugrouter
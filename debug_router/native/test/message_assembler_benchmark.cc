@@ -0,0 +1,96 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+// Measures the cost and output size of assembling a Page.screencastFrame:
+// the Json::Value and toStyledString code MessageAssembler used before, and
+// the compact writer with a new and with a reused buffer.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+#include "debug_router/native/processor/message_assembler.h"
+#include "json/value.h"
+
+namespace {
+
+constexpr size_t kBytesPerRun = 256 * 1024 * 1024;
+
+std::string StyledScreenCastFrame(
+    int session_id, const std::string &data,
+    const std::unordered_map<std::string, float> &metadata) {
+  Json::Value metadata_;
+  Json::Value params_;
+  Json::Value content_;
+  for (const auto &item : metadata) {
+    metadata_[item.first] = item.second;
+  }
+  params_["data"] = data;
+  params_["metadata"] = metadata_;
+  params_["sessionId"] = session_id;
+  content_["method"] = "Page.screencastFrame";
+  content_["params"] = params_;
+  return content_.toStyledString();
+}
+
+std::string Base64Data(size_t size) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string data(size, 'A');
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = kAlphabet[(i * 7 + i / 64) % 64];
+  }
+  return data;
+}
+
+template <typename Assemble>
+void Measure(const char *name, const std::string &data, Assemble assemble) {
+  size_t count = std::max<size_t>(kBytesPerRun / data.size(), 16);
+  size_t bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; ++i) {
+    bytes += assemble();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  printf("  %-8s %10zu B %10.0f frames/s %8.1f us/frame\n", name,
+         bytes / count, count / seconds, seconds / count * 1e6);
+}
+
+void Run(size_t size) {
+  std::string data = Base64Data(size);
+  std::unordered_map<std::string, float> metadata = {
+      {"offsetTop", 0},          {"pageScaleFactor", 1},
+      {"deviceWidth", 1080},     {"deviceHeight", 2340},
+      {"scrollOffsetX", 0},      {"scrollOffsetY", 0},
+      {"timestamp", 1.7e9f}};
+  printf("frame data %zu B\n", data.size());
+  Measure("styled", data, [&]() {
+    return StyledScreenCastFrame(1, data, metadata).size();
+  });
+  Measure("writer", data, [&]() {
+    return debugrouter::processor::MessageAssembler::AssembleScreenCastFrame(
+               1, data, metadata)
+        .size();
+  });
+  std::string out;
+  Measure("reused", data, [&]() {
+    debugrouter::processor::MessageAssembler::AssembleScreenCastFrame(
+        1, data, metadata, out);
+    return out.size();
+  });
+}
+
+}  // namespace
+
+int main() {
+  const size_t sizes[] = {50 * 1024, 300 * 1024, 1024 * 1024};
+  for (size_t size : sizes) {
+    Run(size);
+  }
+  return 0;
+}
@@ -0,0 +1,89 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+// Measures how fast an inbound CDP message is routed: Json::Reader with
+// RemoteDebugProtocol::Parse against the envelope scanner. The CDP message is
+// a string of mostly base64 data, like DOM.setFileInputFiles or large
+// Runtime.evaluate expressions.
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "debug_router/native/protocol/message_envelope.h"
+#include "debug_router/native/protocol/protocol.h"
+#include "json/reader.h"
+#include "json/writer.h"
+
+namespace {
+
+// total bytes parsed for each size
+constexpr size_t kBytesPerRun = 256 * 1024 * 1024;
+
+std::string InboundMessage(size_t size) {
+  Json::Value cdp;
+  cdp["id"] = 1;
+  cdp["method"] = "Runtime.evaluate";
+  std::string data;
+  while (data.size() < size) {
+    data += "QUJDREVGR0hJSktMTU5PUFFSU1RVVldYWVphYmNkZWZnaGlqa2xtbm9w";
+  }
+  data.resize(size);
+  cdp["params"]["expression"] = data;
+  Json::Value root;
+  root["event"] = "Customized";
+  root["data"]["type"] = "CDP";
+  root["data"]["sender"] = 1;
+  root["data"]["data"]["client_id"] = 2;
+  root["data"]["data"]["session_id"] = 3;
+  root["data"]["data"]["message"] = Json::FastWriter().write(cdp);
+  return Json::FastWriter().write(root);
+}
+
+template <typename Route>
+double MessagesPerSecond(const std::string &text, size_t count, Route route) {
+  size_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; ++i) {
+    checksum += route(text);
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  if (checksum == 0) {
+    printf("unexpected empty message\n");
+  }
+  return count / seconds;
+}
+
+void Run(size_t size) {
+  std::string text = InboundMessage(size);
+  size_t count = std::max<size_t>(kBytesPerRun / text.size(), 4);
+  double reader = MessagesPerSecond(text, count, [](const std::string &text) {
+    Json::Reader reader;
+    Json::Value root;
+    reader.parse(text, root);
+    auto body = debugrouter::protocol::RemoteDebugProtocol::Parse(root);
+    return body->AsCustom()->AsCDP()->message_.size();
+  });
+  double envelope = MessagesPerSecond(text, count, [](const std::string &text) {
+    debugrouter::protocol::MessageEnvelope envelope;
+    std::string message;
+    debugrouter::protocol::ParseMessageEnvelope(text, envelope);
+    debugrouter::protocol::ReadEnvelopeMessage(envelope, message);
+    return message.size();
+  });
+  printf("message %9zu B: reader %9.0f msg/s, envelope %9.0f msg/s, %5.1fx\n",
+         text.size(), reader, envelope, envelope / reader);
+}
+
+}  // namespace
+
+int main() {
+  const size_t sizes[] = {1024, 100 * 1024, 10 * 1024 * 1024};
+  for (size_t size : sizes) {
+    Run(size);
+  }
+  return 0;
+}
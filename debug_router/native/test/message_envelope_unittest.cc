@@ -0,0 +1,205 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/protocol/message_envelope.h"
+
+#include <string>
+#include <vector>
+
+#include "debug_router/native/processor/processor.h"
+#include "debug_router/native/protocol/protocol.h"
+#include "gtest/gtest.h"
+#include "json/reader.h"
+
+namespace debugrouter {
+namespace protocol {
+
+namespace {
+
+std::string CustomMessage(const std::string &type, const std::string &payload) {
+  return "{\"event\":\"Customized\",\"data\":{\"type\":\"" + type +
+         "\",\"sender\":1,\"data\":" + payload + "}}";
+}
+
+// the message slots receive through the Json::Value path
+std::string ParseWithReader(const std::string &text) {
+  Json::Reader reader;
+  Json::Value root;
+  reader.parse(text, root);
+  auto body = RemoteDebugProtocol::Parse(root);
+  if (!body || !body->IsProtocolBody4Custom()) {
+    return "<none>";
+  }
+  return body->AsCustom()->AsCDP()->message_;
+}
+
+class RecordingHandler : public processor::MessageHandler {
+ public:
+  explicit RecordingHandler(std::vector<std::string> *events)
+      : events_(events) {}
+  std::string GetRoomId() override { return ""; }
+  std::unordered_map<std::string, std::string> GetClientInfo() override {
+    return {};
+  }
+  std::unordered_map<int, std::string> GetSessionList() override {
+    return {};
+  }
+  void OnMessage(const std::string &type, int session_id,
+                 const std::string &message) override {
+    events_->push_back(type + ":" + std::to_string(session_id) + ":" +
+                       message);
+  }
+  void SendMessage(const std::string &message) override {
+    events_->push_back("send");
+  }
+  void OpenCard(const std::string &url) override {}
+  std::string HandleAppAction(const std::string &method,
+                              const std::string &params) override {
+    return "";
+  }
+  void ChangeRoomServer(const std::string &url,
+                        const std::string &room) override {}
+  void ReportError(const std::string &error) override {}
+
+ private:
+  std::vector<std::string> *events_;
+};
+
+}  // namespace
+
+TEST(MessageEnvelopeTestSuite, ReadsRoutingFields) {
+  std::string text = CustomMessage(
+      "CDP",
+      "{\"client_id\":2,\"session_id\":-3,\"extra\":[1,{\"a\":null}],"
+      "\"message\":\"{\\\"id\\\":1,\\\"method\\\":\\\"Page.enable\\\"}\"}");
+  MessageEnvelope envelope;
+  ASSERT_TRUE(ParseMessageEnvelope(text, envelope));
+  EXPECT_EQ(envelope.event, "Customized");
+  EXPECT_EQ(envelope.type, "CDP");
+  EXPECT_TRUE(envelope.has_sender);
+  EXPECT_EQ(envelope.sender, 1);
+  EXPECT_TRUE(envelope.has_client_id);
+  EXPECT_EQ(envelope.client_id, 2);
+  EXPECT_TRUE(envelope.has_session_id);
+  EXPECT_EQ(envelope.session_id, -3);
+  EXPECT_TRUE(envelope.message_is_string);
+  std::string message;
+  ASSERT_TRUE(ReadEnvelopeMessage(envelope, message));
+  EXPECT_EQ(message, "{\"id\":1,\"method\":\"Page.enable\"}");
+  EXPECT_EQ(message, ParseWithReader(text));
+}
+
+TEST(MessageEnvelopeTestSuite, UnescapesLikeReader) {
+  std::string text = CustomMessage(
+      "CDP",
+      "{\"client_id\":2,\"session_id\":3,\"message\":"
+      "\"a\\\\b\\/c\\n\\t\\u00e9\\u4e2d\\ud83d\\ude00\"}");
+  MessageEnvelope envelope;
+  ASSERT_TRUE(ParseMessageEnvelope(text, envelope));
+  std::string message;
+  ASSERT_TRUE(ReadEnvelopeMessage(envelope, message));
+  EXPECT_EQ(message, ParseWithReader(text));
+
+  // an escaped backslash before the closing quote
+  text = CustomMessage(
+      "CDP", "{\"client_id\":2,\"session_id\":3,\"message\":\"x\\\\\"}");
+  ASSERT_TRUE(ParseMessageEnvelope(text, envelope));
+  ASSERT_TRUE(ReadEnvelopeMessage(envelope, message));
+  EXPECT_EQ(message, "x\\");
+
+  // an unpaired high surrogate is an error
+  text = CustomMessage(
+      "CDP", "{\"client_id\":2,\"session_id\":3,\"message\":\"\\ud83d\"}");
+  ASSERT_TRUE(ParseMessageEnvelope(text, envelope));
+  EXPECT_FALSE(ReadEnvelopeMessage(envelope, message));
+}
+
+TEST(MessageEnvelopeTestSuite, ObjectMessageIsASpan) {
+  std::string text = CustomMessage(
+      "CDP", "{\"client_id\":2,\"session_id\":3,\"message\":{\"id\": 1}}");
+  MessageEnvelope envelope;
+  ASSERT_TRUE(ParseMessageEnvelope(text, envelope));
+  EXPECT_FALSE(envelope.message_is_string);
+  EXPECT_EQ(envelope.message, "{\"id\": 1}");
+  EXPECT_EQ(envelope.message.data(), text.data() + text.find("{\"id\""));
+}
+
+TEST(MessageEnvelopeTestSuite, LeavesUnusualInputToReader) {
+  MessageEnvelope envelope;
+  EXPECT_FALSE(ParseMessageEnvelope("", envelope));
+  EXPECT_FALSE(ParseMessageEnvelope("[]", envelope));
+  EXPECT_FALSE(ParseMessageEnvelope("{\"event\":\"x\"", envelope));
+  EXPECT_FALSE(ParseMessageEnvelope("{\"event\":\"x\"} trailing", envelope));
+  EXPECT_FALSE(ParseMessageEnvelope("{\"a\":tru}", envelope));
+  EXPECT_FALSE(ParseMessageEnvelope("{\"a\":1.}", envelope));
+  // escaped keys and non-integer ids
+  EXPECT_FALSE(ParseMessageEnvelope("{\"ev\\u0065nt\":\"x\"}", envelope));
+  EXPECT_FALSE(ParseMessageEnvelope(
+      CustomMessage("CDP", "{\"session_id\":1.5}"), envelope));
+  EXPECT_FALSE(ParseMessageEnvelope(
+      CustomMessage("CDP", "{\"session_id\":4294967296}"), envelope));
+  std::string deep(1000, '[');
+  EXPECT_FALSE(ParseMessageEnvelope("{\"a\":" + deep + "}", envelope));
+
+  // values of other types are not an error
+  ASSERT_TRUE(ParseMessageEnvelope(
+      "{\"event\":1,\"data\":{\"type\":[],\"data\":{\"session_id\":\"1\"}}}",
+      envelope));
+  EXPECT_TRUE(envelope.event.empty());
+  EXPECT_TRUE(envelope.type.empty());
+  EXPECT_FALSE(envelope.has_session_id);
+  EXPECT_FALSE(envelope.has_message);
+}
+
+TEST(MessageEnvelopeTestSuite, ProcessorRoutesMessages) {
+  std::vector<std::string> events;
+  processor::Processor processor(std::make_unique<RecordingHandler>(&events));
+  processor.Process("{\"event\":\"Initialize\",\"data\":2}");
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0], "send");
+
+  processor.Process(CustomMessage(
+      "CDP", "{\"client_id\":2,\"session_id\":3,\"message\":\"{}\"}"));
+  processor.Process(CustomMessage(
+      "Ext", "{\"client_id\":2,\"session_id\":4,\"message\":{\"a\":1}}"));
+  // for another client
+  processor.Process(CustomMessage(
+      "CDP", "{\"client_id\":5,\"session_id\":3,\"message\":\"{}\"}"));
+  // control messages take the Json::Value path
+  processor.Process(CustomMessage("ListSession", "{\"client_id\":2}"));
+  ASSERT_EQ(events.size(), 4u);
+  EXPECT_EQ(events[1], "CDP:3:{}");
+  EXPECT_EQ(events[2], "Ext:4:{\"a\":1}");
+  EXPECT_EQ(events[3], "send");
+}
+
+TEST(MessageEnvelopeTestSuite, ProcessorAnswersNativeMethods) {
+  std::vector<std::string> events;
+  processor::Processor processor(std::make_unique<RecordingHandler>(&events));
+  processor.Process("{\"event\":\"Initialize\",\"data\":2}");
+  processor.AddCdpMethodHandler(
+      "DebugRouter.ping", [&](int session_id, const std::string &message) {
+        events.push_back("native:" + std::to_string(session_id));
+        return true;
+      });
+
+  processor.Process(
+      CustomMessage("CDP",
+                    "{\"client_id\":2,\"session_id\":3,\"message\":{"
+                    "\"id\":1,\"method\":\"DebugRouter.ping\"}}"));
+  processor.Process(
+      CustomMessage("CDP",
+                    "{\"client_id\":2,\"session_id\":3,\"message\":{"
+                    "\"id\":2,\"method\":\"DOM.enable\"}}"));
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[1], "native:3");
+  EXPECT_EQ(events[2], "CDP:3:{\"id\":2,\"method\":\"DOM.enable\"}");
+  processor::CdpRouteStats stats = processor.GetCdpRouteStats();
+  EXPECT_EQ(stats.messages, 2u);
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.handled, 1u);
+}
+
+}  // namespace protocol
+}  // namespace debugrouter
@@ -0,0 +1,182 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/protocol/message_writer.h"
+
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+#include "debug_router/native/processor/message_assembler.h"
+#include "debug_router/native/protocol/message_envelope.h"
+#include "debug_router/native/protocol/protocol.h"
+#include "gtest/gtest.h"
+#include "json/reader.h"
+#include "json/writer.h"
+
+namespace debugrouter {
+namespace protocol {
+
+namespace {
+
+// the envelope as written with Json::Value
+std::string StringifyWithValue(const std::string &type, uint32_t client_id,
+                               int32_t session_id, const std::string &message,
+                               bool is_object, int32_t mark) {
+  auto cdp_data = std::make_shared<CustomData4CDP>();
+  cdp_data->client_id_ = client_id;
+  cdp_data->session_id_ = session_id;
+  cdp_data->message_ = message;
+  cdp_data->is_object_ = is_object;
+  return RemoteDebugProtocol::Stringify(
+      RemoteDebugProtocol::CreateProtocolBody4Custom(type, client_id,
+                                                     cdp_data),
+      mark);
+}
+
+Json::Value Parse(const std::string &text) {
+  Json::Reader reader;
+  Json::Value root;
+  EXPECT_TRUE(reader.parse(text, root)) << text;
+  return root;
+}
+
+}  // namespace
+
+TEST(MessageWriterTestSuite, EscapesLikeJsonValue) {
+  std::string all_bytes;
+  for (int c = 1; c < 256; ++c) {
+    all_bytes.push_back(static_cast<char>(c));
+  }
+  all_bytes += "\xe4\xb8\xad/\"\\";
+  std::string expected = Json::FastWriter().write(Json::Value(all_bytes));
+  // FastWriter ends with a newline
+  expected.pop_back();
+  std::string written;
+  AppendJsonString(all_bytes, written);
+  EXPECT_EQ(written, expected);
+  EXPECT_EQ(JsonStringSize(all_bytes), written.size());
+
+  written.clear();
+  AppendJsonString(std::string("a\0b", 3), written);
+  EXPECT_EQ(written, "\"a\\u0000b\"");
+}
+
+TEST(MessageWriterTestSuite, SameValueAsJsonValue) {
+  struct {
+    std::string type;
+    std::string message;
+    bool is_object;
+    int32_t mark;
+  } cases[] = {
+      {"CDP", "{\"id\":1,\"result\":{\"data\":\"a\\nb\"}}", false, -1},
+      {"CDP", "{\"id\":1,\"result\":{\"data\":\"a\\nb\"}}", true, 7},
+      {"Ext\"", std::string("\t\x01\0end", 6), false, 0},
+      {"CDP", " [1, 2.5, {\"a\": null}] ", true, -1},
+  };
+  for (const auto &item : cases) {
+    std::string written = WriteCustomizedMessage(
+        item.type, 4000000000u, -2, item.message, item.is_object, item.mark);
+    EXPECT_EQ(Parse(written), Parse(StringifyWithValue(
+                                  item.type, 4000000000u, -2, item.message,
+                                  item.is_object, item.mark)))
+        << written;
+  }
+
+  // instead of what Json::Reader parsed before the error
+  std::string written =
+      WriteCustomizedMessage("CDP", 1, 2, "{\"id\":", true, -1);
+  EXPECT_TRUE(Parse(written)["data"]["data"]["message"].isNull());
+}
+
+TEST(MessageWriterTestSuite, ObjectIsCopiedVerbatim) {
+  std::string message = "{\"b\": 1,  \"a\": [true]}";
+  std::string written = WriteCustomizedMessage("CDP", 1, 2, message, true, -1);
+  EXPECT_NE(written.find(message), std::string::npos);
+  MessageEnvelope envelope;
+  ASSERT_TRUE(ParseMessageEnvelope(written, envelope));
+  EXPECT_EQ(envelope.event, kRemoteDebugServerEvent4Custom);
+  EXPECT_EQ(envelope.type, "CDP");
+  EXPECT_EQ(envelope.sender, 1);
+  EXPECT_EQ(envelope.client_id, 1);
+  EXPECT_EQ(envelope.session_id, 2);
+  EXPECT_EQ(envelope.message, message);
+}
+
+TEST(MessageWriterTestSuite, WritesFixedShapes) {
+  std::unordered_map<std::string, float> metadata = {{"scale", 0.1f}};
+  std::string written = json::Write(json::Object(
+      json::Member("s", "a\"b"), json::Member("i", -12),
+      json::Member("t", true), json::Member("f", 1.5f), json::Member("d", 0.25),
+      json::Member("raw", json::Raw{"[1,2]"}),
+      json::Member("o", json::Object(json::Member("m", metadata))),
+      json::Member("e", json::Object())));
+  EXPECT_EQ(written,
+            "{\"s\":\"a\\\"b\",\"i\":-12,\"t\":true,\"f\":1.5,\"d\":0.25,"
+            "\"raw\":[1,2],\"o\":{\"m\":{\"scale\":0.1}},\"e\":{}}");
+
+  // floats are written in their shortest exact form
+  for (float value : {0.1f, 1.0f / 3, 16777216.0f, -2.5e-8f, 3.4e38f}) {
+    std::string number;
+    json::AppendValue(value, number);
+    EXPECT_EQ(strtof(number.c_str(), nullptr), value) << number;
+  }
+  std::string nan;
+  json::AppendValue(std::numeric_limits<float>::quiet_NaN(), nan);
+  EXPECT_EQ(nan, "null");
+}
+
+TEST(MessageWriterTestSuite, Writes64BitIntegers) {
+  EXPECT_EQ(json::Write(json::Object(
+                json::Member("timestamp", 1760000000000LL),
+                json::Member("min", std::numeric_limits<int64_t>::min()),
+                json::Member("max", std::numeric_limits<uint64_t>::max()))),
+            "{\"timestamp\":1760000000000,\"min\":-9223372036854775808,"
+            "\"max\":18446744073709551615}");
+  std::string written = WriteCustomizedMessage(
+      "CDP", std::numeric_limits<uint32_t>::max(),
+      std::numeric_limits<int32_t>::min(), "{}", true, -1);
+  Json::Value root = Parse(written);
+  EXPECT_EQ(root["data"]["data"]["client_id"].asUInt(),
+            std::numeric_limits<uint32_t>::max());
+  EXPECT_EQ(root["data"]["data"]["session_id"].asInt(),
+            std::numeric_limits<int32_t>::min());
+}
+
+TEST(MessageWriterTestSuite, AssemblerMessages) {
+  Json::Value frame =
+      Parse(processor::MessageAssembler::AssembleScreenCastFrame(
+          3, "aGVsbG8=", {{"offsetTop", 10}, {"pageScaleFactor", 0.5f}}));
+  EXPECT_EQ(frame["method"], "Page.screencastFrame");
+  EXPECT_EQ(frame["params"]["data"], "aGVsbG8=");
+  EXPECT_EQ(frame["params"]["sessionId"], 3);
+  EXPECT_EQ(frame["params"]["metadata"]["offsetTop"].asDouble(), 10.0);
+  EXPECT_EQ(frame["params"]["metadata"]["pageScaleFactor"].asDouble(), 0.5);
+
+  // the buffer is reused
+  std::string out;
+  out.reserve(4096);
+  const char *data = out.data();
+  processor::MessageAssembler::AssembleScreenCastFrame(1, "AAAA", {}, out);
+  EXPECT_EQ(out.data(), data);
+  EXPECT_EQ(out,
+            "{\"method\":\"Page.screencastFrame\",\"params\":{"
+            "\"data\":\"AAAA\",\"metadata\":{},\"sessionId\":1}}");
+
+  Json::Value navigated = Parse(
+      processor::MessageAssembler::AssembleDispatchFrameNavigated("a\"b"));
+  EXPECT_EQ(navigated["method"], "Page.frameNavigated");
+  EXPECT_EQ(navigated["params"]["frame"]["url"], "a\"b");
+  EXPECT_EQ(navigated["params"]["frame"]["id"], "");
+  EXPECT_EQ(processor::MessageAssembler::AssembleDispatchDocumentUpdated(),
+            "{\"method\":\"DOM.documentUpdated\",\"params\":{}}");
+  EXPECT_EQ(
+      processor::MessageAssembler::AssembleDispatchScreencastVisibilityChanged(
+          false),
+      "{\"method\":\"Page.screencastVisibilityChanged\",\"params\":{"
+      "\"visible\":false}}");
+}
+
+}  // namespace protocol
+}  // namespace debugrouter
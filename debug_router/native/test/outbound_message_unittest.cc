@@ -0,0 +1,73 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/core/outbound_message.h"
+
+#include <string>
+
+#include "debug_router/native/processor/message_assembler.h"
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace core {
+
+TEST(OutboundMessageTestSuite, FindCdpMethod) {
+  EXPECT_EQ(FindCdpMethod("{\"method\":\"DOM.documentUpdated\"}"),
+            "DOM.documentUpdated");
+  EXPECT_EQ(FindCdpMethod("{\"id\":1, \"method\" : \"Page.enable\"}"),
+            "Page.enable");
+  // styled messages of MessageAssembler
+  EXPECT_EQ(FindCdpMethod(
+                processor::MessageAssembler::AssembleScreenCastFrame(
+                    1, "data", {{"offsetTop", 0}})),
+            "Page.screencastFrame");
+  // responses have no method, nested keys and values are not one
+  EXPECT_EQ(FindCdpMethod("{\"id\":1,\"result\":{\"method\":\"x\"}}"), "");
+  EXPECT_EQ(FindCdpMethod("{\"id\":\"method\",\"result\":{}}"), "");
+  EXPECT_EQ(FindCdpMethod("{\"a\":\"\\\"method\\\"\",\"b\":1}"), "");
+  EXPECT_EQ(FindCdpMethod("not json"), "");
+  EXPECT_EQ(FindCdpMethod(""), "");
+  // only the beginning of a message is scanned
+  std::string late = "{\"params\":\"" + std::string(4096, 'x') +
+                     "\",\"method\":\"Page.enable\"}";
+  EXPECT_EQ(FindCdpMethod(late), "");
+}
+
+TEST(OutboundMessageTestSuite, FindCdpId) {
+  EXPECT_EQ(FindCdpId("{\"id\":12,\"result\":{}}"), 12);
+  EXPECT_EQ(FindCdpId("{\"method\":\"Page.enable\", \"id\" : 7}"), 7);
+  EXPECT_EQ(FindCdpId("{\"id\":1760000000000}"), 1760000000000LL);
+  // events have no id, nested ids and invalid ones are not one
+  EXPECT_EQ(FindCdpId("{\"method\":\"x\",\"params\":{\"id\":3}}"), -1);
+  EXPECT_EQ(FindCdpId("{\"id\":\"3\"}"), -1);
+  EXPECT_EQ(FindCdpId("{\"id\":-3}"), -1);
+  EXPECT_EQ(FindCdpId("not json"), -1);
+}
+
+TEST(OutboundMessageTestSuite, Priority) {
+  EXPECT_EQ(GetCdpMethodPriority("Page.screencastFrame"),
+            MessagePriority::kScreencast);
+  EXPECT_EQ(GetCdpMethodPriority("Lynx.screenshotCapture"),
+            MessagePriority::kScreencast);
+  EXPECT_EQ(GetCdpMethodPriority("HeapProfiler.addHeapSnapshotChunk"),
+            MessagePriority::kBulk);
+  EXPECT_EQ(GetCdpMethodPriority("DOM.documentUpdated"),
+            MessagePriority::kInteractive);
+  EXPECT_EQ(GetCdpMethodPriority(""), MessagePriority::kInteractive);
+
+  // only the method counts, a large response is still interactive
+  EXPECT_EQ(GetDefaultPriority("CDP", ""), MessagePriority::kInteractive);
+  EXPECT_EQ(GetDefaultPriority("CDP", "Page.screencastFrame"),
+            MessagePriority::kScreencast);
+  EXPECT_EQ(GetDefaultPriority("Ext", "Page.screencastFrame"),
+            MessagePriority::kInteractive);
+
+  OutboundMessage message("{}");
+  EXPECT_EQ(message.size(), 2u);
+  EXPECT_EQ(message.session_id, kUnknownSessionId);
+  EXPECT_EQ(message.priority, MessagePriority::kInteractive);
+}
+
+}  // namespace core
+}  // namespace debugrouter
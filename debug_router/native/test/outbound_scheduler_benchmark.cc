@@ -0,0 +1,141 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+// Measures how fast one consumer receives OutboundMessages from 1, 4 and 8
+// producers: the unbounded queue UsbClient used before, which copies each
+// message out under its own lock, and OutboundScheduler with batches of
+// drain_to, unbounded and bounded with OverflowPolicy::kBlock.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "debug_router/native/core/outbound_message.h"
+#include "debug_router/native/socket/outbound_scheduler.h"
+
+namespace {
+
+using debugrouter::core::MessagePriority;
+using debugrouter::core::OutboundMessage;
+using debugrouter::socket_server::OutboundScheduler;
+using debugrouter::socket_server::OverflowPolicy;
+
+constexpr size_t kMessages = 400000;
+constexpr size_t kBatchSize = 64;
+constexpr size_t kCapacity = 1024;
+
+// the queue UsbClient used before OutboundScheduler
+template <typename T>
+class UnboundedQueue {
+ public:
+  void put(T &&value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.push(std::move(value));
+    cond_var_.notify_one();
+  }
+
+  T take() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_var_.wait(lock, [this] { return !queue_.empty(); });
+    T value = queue_.front();
+    queue_.pop();
+    return value;
+  }
+
+ private:
+  std::queue<T> queue_;
+  std::mutex mutex_;
+  std::condition_variable cond_var_;
+};
+
+OutboundMessage MakeMessage() {
+  OutboundMessage message(std::string(200, 'x'));
+  message.type = "CDP";
+  message.method = "Runtime.consoleAPICalled";
+  return message;
+}
+
+// runs producers, one session each, that put kMessages in total while
+// receive takes them
+template <typename Queue, typename Receive>
+void Measure(const char *name, int producers, Queue &queue, Receive receive) {
+  OutboundMessage message = MakeMessage();
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&queue, &message, producers, p]() {
+      OutboundMessage copy = message;
+      copy.session_id = p + 1;
+      for (size_t i = 0; i < kMessages / producers; ++i) {
+        queue.put(OutboundMessage(copy));
+      }
+    });
+  }
+  size_t expected = kMessages / producers * producers;
+  size_t bytes = 0;
+  for (size_t received = 0; received < expected;) {
+    received += receive(bytes);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  printf("  %-10s %2d producers %8.2f M messages/s %10zu B\n", name,
+         producers, expected / seconds / 1e6, bytes / expected);
+}
+
+// the consumer of a scheduler polls it, as the event loop does when the
+// socket is writable
+size_t Drain(OutboundScheduler &scheduler,
+             std::vector<OutboundMessage> &batch, size_t &bytes) {
+  size_t count = scheduler.drain_to(batch, kBatchSize, SIZE_MAX);
+  if (count == 0) {
+    std::this_thread::yield();
+  }
+  for (const OutboundMessage &message : batch) {
+    bytes += message.size();
+  }
+  batch.clear();
+  return count;
+}
+
+void Run(int producers) {
+  {
+    UnboundedQueue<OutboundMessage> queue;
+    Measure("baseline", producers, queue, [&](size_t &bytes) -> size_t {
+      bytes += queue.take().size();
+      return 1;
+    });
+  }
+  std::vector<OutboundMessage> batch;
+  {
+    OutboundScheduler scheduler;
+    Measure("scheduler", producers, scheduler,
+            [&](size_t &bytes) { return Drain(scheduler, batch, bytes); });
+  }
+  {
+    OutboundScheduler scheduler;
+    scheduler.set_limit(MessagePriority::kInteractive, kCapacity,
+                        OverflowPolicy::kBlock);
+    Measure("blocking", producers, scheduler,
+            [&](size_t &bytes) { return Drain(scheduler, batch, bytes); });
+  }
+}
+
+}  // namespace
+
+int main() {
+  for (int producers : {1, 4, 8}) {
+    Run(producers);
+  }
+  return 0;
+}
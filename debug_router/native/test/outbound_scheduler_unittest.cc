@@ -0,0 +1,231 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/socket/outbound_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace socket_server {
+
+namespace {
+
+using core::MessagePriority;
+using core::OutboundMessage;
+
+OutboundMessage Message(const std::string &text, int32_t session_id,
+                        MessagePriority priority, size_t size = 0) {
+  OutboundMessage message(text + std::string(size, ' '));
+  message.session_id = session_id;
+  message.priority = priority;
+  return message;
+}
+
+// the texts of the next count messages
+std::vector<std::string> Take(OutboundScheduler &scheduler, size_t count) {
+  std::vector<OutboundMessage> messages;
+  scheduler.drain_to(messages, count, SIZE_MAX);
+  std::vector<std::string> texts;
+  for (const OutboundMessage &message : messages) {
+    texts.push_back(message.payload->substr(0, message.payload->find(' ')));
+  }
+  return texts;
+}
+
+}  // namespace
+
+TEST(OutboundSchedulerTestSuite, UrgentMessagesOvertakeBacklog) {
+  OutboundScheduler scheduler;
+  for (int i = 0; i < 3; ++i) {
+    scheduler.put(Message("frame", 1, MessagePriority::kScreencast, 100000));
+  }
+  EXPECT_EQ(Take(scheduler, 1), std::vector<std::string>({"frame"}));
+  // the frame used up the turns of its lane
+  scheduler.put(Message("paused", 1, MessagePriority::kInteractive));
+  scheduler.put(Message("result", 2, MessagePriority::kInteractive));
+  scheduler.put(Message("sessions", -1, MessagePriority::kControl));
+  EXPECT_EQ(Take(scheduler, 3),
+            std::vector<std::string>({"sessions", "paused", "result"}));
+  EXPECT_EQ(scheduler.size(), 2u);
+  EXPECT_EQ(Take(scheduler, 10), std::vector<std::string>({"frame", "frame"}));
+  EXPECT_EQ(scheduler.size(), 0u);
+}
+
+TEST(OutboundSchedulerTestSuite, SharesByWeight) {
+  OutboundScheduler scheduler;
+  // 1 KB messages of three sessions, more than the lanes send in a round
+  for (int i = 0; i < 400; ++i) {
+    scheduler.put(Message("cdp", 1, MessagePriority::kInteractive, 1024));
+    scheduler.put(Message("bulk", 2, MessagePriority::kBulk, 1024));
+    scheduler.put(Message("frame", 3, MessagePriority::kScreencast, 1024));
+  }
+  std::map<std::string, int> counts;
+  for (const std::string &text : Take(scheduler, 330)) {
+    counts[text]++;
+  }
+  // 8 : 2 : 1, no lane is starved
+  EXPECT_NEAR(counts["cdp"], 240, 16);
+  EXPECT_NEAR(counts["bulk"], 60, 16);
+  EXPECT_NEAR(counts["frame"], 30, 16);
+}
+
+TEST(OutboundSchedulerTestSuite, SessionsTakeTurns) {
+  OutboundScheduler scheduler;
+  // a heap snapshot of session 1 is queued before a dump of session 2
+  for (int i = 0; i < 100; ++i) {
+    scheduler.put(Message("s1-" + std::to_string(i), 1, MessagePriority::kBulk,
+                          8 * 1024));
+  }
+  scheduler.put(Message("s2-0", 2, MessagePriority::kBulk, 8 * 1024));
+  scheduler.put(Message("s2-1", 2, MessagePriority::kBulk, 8 * 1024));
+  std::vector<std::string> texts = Take(scheduler, 6);
+  EXPECT_EQ(texts, std::vector<std::string>(
+                       {"s1-0", "s1-1", "s2-0", "s2-1", "s1-2", "s1-3"}));
+}
+
+TEST(OutboundSchedulerTestSuite, KeepsSessionOrderAcrossClasses) {
+  OutboundScheduler scheduler;
+  // a heap snapshot of session 1 and the response that completes it
+  for (int i = 0; i < 20; ++i) {
+    scheduler.put(Message("chunk", 1, MessagePriority::kBulk, 8 * 1024));
+  }
+  scheduler.put(Message("snapshot-done", 1, MessagePriority::kInteractive));
+  // session 2 is not held back by the snapshot
+  scheduler.put(Message("paused", 2, MessagePriority::kInteractive));
+  std::vector<std::string> texts = Take(scheduler, 22);
+  ASSERT_EQ(texts.size(), 22u);
+  EXPECT_EQ(texts.back(), "snapshot-done");
+  // it waits for one round of the bulk lane at most
+  auto paused = std::find(texts.begin(), texts.end(), "paused");
+  EXPECT_LT(paused - texts.begin(), 8);
+  EXPECT_EQ(std::count(texts.begin(), texts.end(), "chunk"), 20);
+}
+
+TEST(OutboundSchedulerTestSuite, DropsOnlyScreencastWhenFull) {
+  OutboundScheduler scheduler(2);
+  const MessagePriority kFrame = MessagePriority::kScreencast;
+  const MessagePriority kCdp = MessagePriority::kInteractive;
+  const MessagePriority kHeap = MessagePriority::kBulk;
+  std::vector<std::string> dropped;
+  for (const char *text : {"frame1", "frame2"}) {
+    OutboundMessage frame = Message(text, 1, kFrame);
+    frame.on_dropped = [&dropped, text]() { dropped.push_back(text); };
+    EXPECT_TRUE(scheduler.put(std::move(frame)));
+  }
+  // the lossless classes are not bounded
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(scheduler.put(Message("cdp", 1, kCdp)));
+    EXPECT_TRUE(scheduler.put(Message("heap", 1, kHeap)));
+  }
+  // the oldest frame makes room for a new one
+  EXPECT_FALSE(scheduler.put(Message("frame3", 1, kFrame)));
+  EXPECT_EQ(scheduler.dropped(), 1u);
+  // its sender is told, e.g. to release its flow control slot
+  EXPECT_EQ(dropped, std::vector<std::string>({"frame1"}));
+  EXPECT_EQ(scheduler.size(), 12u);
+  std::vector<std::string> taken = Take(scheduler, 12);
+  EXPECT_EQ(std::count(taken.begin(), taken.end(), "cdp"), 5);
+  EXPECT_EQ(std::count(taken.begin(), taken.end(), "heap"), 5);
+  EXPECT_EQ(std::count(taken.begin(), taken.end(), "frame1"), 0);
+  EXPECT_EQ(std::count(taken.begin(), taken.end(), "frame2"), 1);
+  EXPECT_EQ(std::count(taken.begin(), taken.end(), "frame3"), 1);
+}
+
+TEST(OutboundSchedulerTestSuite, DropsNewestOrOldestWhenFull) {
+  OutboundScheduler scheduler;
+  scheduler.set_limit(MessagePriority::kInteractive, 2,
+                      OverflowPolicy::kDropNewest);
+  scheduler.set_limit(MessagePriority::kBulk, 1, OverflowPolicy::kDropOldest);
+  std::vector<std::string> dropped;
+  auto put = [&](const std::string &text, MessagePriority priority) {
+    OutboundMessage message = Message(text, 1, priority);
+    message.on_dropped = [&dropped, text]() { dropped.push_back(text); };
+    return scheduler.put(std::move(message));
+  };
+  EXPECT_TRUE(put("cdp1", MessagePriority::kInteractive));
+  EXPECT_TRUE(put("cdp2", MessagePriority::kInteractive));
+  EXPECT_FALSE(put("cdp3", MessagePriority::kInteractive));
+  EXPECT_TRUE(put("heap1", MessagePriority::kBulk));
+  EXPECT_FALSE(put("heap2", MessagePriority::kBulk));
+  EXPECT_EQ(dropped, std::vector<std::string>({"cdp3", "heap1"}));
+  EXPECT_EQ(scheduler.dropped(), 2u);
+  EXPECT_EQ(Take(scheduler, 4),
+            std::vector<std::string>({"cdp1", "cdp2", "heap2"}));
+}
+
+TEST(OutboundSchedulerTestSuite, DropsLowerPriorityClassWhenFull) {
+  OutboundScheduler scheduler;
+  scheduler.set_limit(MessagePriority::kInteractive, 3,
+                      OverflowPolicy::kDropLowerPriority);
+  std::vector<std::string> dropped;
+  auto put = [&](const std::string &text, int32_t session_id,
+                 MessagePriority priority) {
+    OutboundMessage message = Message(text, session_id, priority);
+    message.on_dropped = [&dropped, text]() { dropped.push_back(text); };
+    return scheduler.put(std::move(message));
+  };
+  EXPECT_TRUE(put("frame", 3, MessagePriority::kScreencast));
+  EXPECT_TRUE(put("heap", 2, MessagePriority::kBulk));
+  EXPECT_TRUE(put("cdp1", 1, MessagePriority::kInteractive));
+  // the less urgent classes make room first, then the oldest of the class
+  EXPECT_FALSE(put("cdp2", 1, MessagePriority::kInteractive));
+  EXPECT_FALSE(put("cdp3", 1, MessagePriority::kInteractive));
+  EXPECT_FALSE(put("cdp4", 1, MessagePriority::kInteractive));
+  EXPECT_EQ(dropped, std::vector<std::string>({"frame", "heap", "cdp1"}));
+  // control messages are not counted
+  EXPECT_TRUE(put("sessions", 0, MessagePriority::kControl));
+  EXPECT_EQ(Take(scheduler, 5),
+            std::vector<std::string>({"sessions", "cdp2", "cdp3", "cdp4"}));
+}
+
+TEST(OutboundSchedulerTestSuite, BlocksUntilTaken) {
+  OutboundScheduler scheduler;
+  scheduler.set_limit(MessagePriority::kBulk, 2, OverflowPolicy::kBlock);
+  EXPECT_TRUE(scheduler.put(Message("heap1", 1, MessagePriority::kBulk)));
+  EXPECT_TRUE(scheduler.put(Message("heap2", 1, MessagePriority::kBulk)));
+  std::atomic<bool> put_done(false);
+  std::thread producer([&]() {
+    EXPECT_TRUE(scheduler.put(Message("heap3", 1, MessagePriority::kBulk)));
+    put_done = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(put_done);
+  // other classes are not held back
+  EXPECT_TRUE(
+      scheduler.put(Message("cdp", 2, MessagePriority::kInteractive)));
+
+  EXPECT_EQ(Take(scheduler, 1), std::vector<std::string>({"heap1"}));
+  producer.join();
+  EXPECT_TRUE(put_done);
+  EXPECT_EQ(scheduler.dropped(), 0u);
+  std::vector<std::string> texts = Take(scheduler, 4);
+  EXPECT_EQ(std::count(texts.begin(), texts.end(), "heap3"), 1);
+  EXPECT_EQ(texts.size(), 3u);
+}
+
+TEST(OutboundSchedulerTestSuite, DrainsUpToBytes) {
+  OutboundScheduler scheduler;
+  for (int i = 0; i < 4; ++i) {
+    scheduler.put(Message("m", 1, MessagePriority::kInteractive, 999));
+  }
+  std::vector<OutboundMessage> messages;
+  // the message that crosses max_bytes is still taken
+  EXPECT_EQ(scheduler.drain_to(messages, 10, 1500), 2u);
+  EXPECT_EQ(scheduler.drain_to(messages, 1, SIZE_MAX), 1u);
+  scheduler.clear();
+  EXPECT_EQ(scheduler.drain_to(messages, 10, SIZE_MAX), 0u);
+  EXPECT_EQ(messages.size(), 3u);
+}
+
+}  // namespace socket_server
+}  // namespace debugrouter
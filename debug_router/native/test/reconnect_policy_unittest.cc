@@ -0,0 +1,172 @@
+// Copyright 2024 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/core/reconnect_policy.h"
+
+#include "debug_router/native/core/debug_router_config.h"
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace core {
+
+namespace {
+
+ExponentialBackoffReconnectPolicy::Options TestOptions() {
+  ExponentialBackoffReconnectPolicy::Options options;
+  options.base_delay = std::chrono::milliseconds(100);
+  options.max_delay = std::chrono::milliseconds(1000);
+  options.max_attempts = 6;
+  options.max_elapsed = std::chrono::milliseconds(60000);
+  options.circuit_breaker_cooldown = std::chrono::milliseconds(10000);
+  return options;
+}
+
+}  // namespace
+
+TEST(ReconnectPolicyTestSuite, BackoffIsJitteredAndCapped) {
+  ExponentialBackoffReconnectPolicy policy(TestOptions(), 42);
+  auto now = ReconnectClock::now();
+  const int64_t caps[] = {100, 200, 400, 800, 1000, 1000};
+  for (int64_t cap : caps) {
+    ReconnectDecision decision = policy.OnDisconnected(now);
+    EXPECT_TRUE(decision.should_retry);
+    EXPECT_FALSE(decision.budget_exhausted);
+    EXPECT_GE(decision.delay.count(), 0);
+    EXPECT_LE(decision.delay.count(), cap);
+  }
+  EXPECT_EQ(policy.GetAttempts(), 6);
+}
+
+TEST(ReconnectPolicyTestSuite, CircuitOpensWhenAttemptsExhausted) {
+  ExponentialBackoffReconnectPolicy policy(TestOptions(), 42);
+  auto now = ReconnectClock::now();
+  for (int i = 0; i < 6; ++i) {
+    policy.OnDisconnected(now);
+  }
+  ReconnectDecision decision = policy.OnDisconnected(now);
+  EXPECT_TRUE(decision.budget_exhausted);
+  EXPECT_TRUE(decision.should_retry);
+  EXPECT_EQ(decision.attempt, 0);
+  EXPECT_EQ(decision.probe, 1);
+  EXPECT_GE(decision.delay.count(), 5000);
+  EXPECT_LE(decision.delay.count(), 10000);
+  EXPECT_TRUE(policy.IsCircuitOpen());
+
+  // a failed probe keeps the circuit open without reporting exhaustion again
+  decision = policy.OnDisconnected(now);
+  EXPECT_FALSE(decision.budget_exhausted);
+  EXPECT_TRUE(decision.should_retry);
+  EXPECT_EQ(decision.attempt, 0);
+  EXPECT_EQ(decision.probe, 2);
+
+  policy.OnConnected();
+  EXPECT_FALSE(policy.IsCircuitOpen());
+  decision = policy.OnDisconnected(now);
+  EXPECT_EQ(decision.attempt, 1);
+  EXPECT_EQ(decision.probe, 0);
+}
+
+TEST(ReconnectPolicyTestSuite, ElapsedBudget) {
+  ExponentialBackoffReconnectPolicy policy(TestOptions(), 42);
+  auto now = ReconnectClock::now();
+  EXPECT_EQ(policy.OnDisconnected(now).attempt, 1);
+  ReconnectDecision decision =
+      policy.OnDisconnected(now + std::chrono::milliseconds(60000));
+  EXPECT_TRUE(decision.budget_exhausted);
+  EXPECT_EQ(policy.GetElapsed(now + std::chrono::milliseconds(60000)).count(),
+            60000);
+}
+
+TEST(ReconnectPolicyTestSuite, GiveUpWithoutCircuitBreaker) {
+  auto options = TestOptions();
+  options.max_attempts = 1;
+  options.circuit_breaker_cooldown = std::chrono::milliseconds(0);
+  ExponentialBackoffReconnectPolicy policy(options, 42);
+  auto now = ReconnectClock::now();
+  EXPECT_TRUE(policy.OnDisconnected(now).should_retry);
+  ReconnectDecision decision = policy.OnDisconnected(now);
+  EXPECT_TRUE(decision.budget_exhausted);
+  EXPECT_FALSE(decision.should_retry);
+
+  policy.Reset();
+  EXPECT_TRUE(policy.OnDisconnected(now).should_retry);
+}
+
+TEST(ReconnectPolicyTestSuite, OptionsFromConfigs) {
+  auto &configs = DebugRouterConfigs::GetInstance();
+  configs.SetConfig(kReconnectBaseDelayMs, "250");
+  configs.SetConfig(kReconnectMaxAttempts, "invalid");
+  auto options = ExponentialBackoffReconnectPolicy::OptionsFromConfigs();
+  EXPECT_EQ(options.base_delay.count(), 250);
+  EXPECT_EQ(options.max_attempts,
+            ExponentialBackoffReconnectPolicy::Options().max_attempts);
+  configs.SetConfig(kReconnectBaseDelayMs, "");
+  configs.SetConfig(kReconnectMaxAttempts, "");
+}
+
+TEST(ReconnectPolicyTestSuite, NegativeConfigsFallBackToDefaults) {
+  auto &configs = DebugRouterConfigs::GetInstance();
+  const std::string keys[] = {kReconnectBaseDelayMs, kReconnectMaxDelayMs,
+                              kReconnectMaxAttempts, kReconnectMaxElapsedMs,
+                              kReconnectCircuitBreakerCooldownMs};
+  for (const std::string &key : keys) {
+    configs.SetConfig(key, "-1");
+  }
+  auto options = ExponentialBackoffReconnectPolicy::OptionsFromConfigs();
+  ExponentialBackoffReconnectPolicy::Options defaults;
+  EXPECT_EQ(options.base_delay, defaults.base_delay);
+  EXPECT_EQ(options.max_delay, defaults.max_delay);
+  EXPECT_EQ(options.max_attempts, defaults.max_attempts);
+  EXPECT_EQ(options.max_elapsed, defaults.max_elapsed);
+  EXPECT_EQ(options.circuit_breaker_cooldown,
+            defaults.circuit_breaker_cooldown);
+  for (const std::string &key : keys) {
+    configs.SetConfig(key, "");
+  }
+}
+
+TEST(ReconnectPolicyTestSuite, InvalidOptionsAreSanitized) {
+  ExponentialBackoffReconnectPolicy::Options options;
+  options.base_delay = std::chrono::milliseconds(-1);
+  options.max_delay = std::chrono::milliseconds(-5);
+  options.max_attempts = -1;
+  options.max_elapsed = std::chrono::milliseconds(-1);
+  options.circuit_breaker_cooldown = std::chrono::milliseconds(-1);
+  auto sanitized = ExponentialBackoffReconnectPolicy::Sanitize(options);
+  ExponentialBackoffReconnectPolicy::Options defaults;
+  EXPECT_EQ(sanitized.base_delay, defaults.base_delay);
+  EXPECT_EQ(sanitized.max_delay, defaults.max_delay);
+  EXPECT_EQ(sanitized.max_attempts, defaults.max_attempts);
+  EXPECT_EQ(sanitized.max_elapsed, defaults.max_elapsed);
+  EXPECT_EQ(sanitized.circuit_breaker_cooldown,
+            defaults.circuit_breaker_cooldown);
+
+  // zero delays would reconnect in a busy loop, max_delay follows base_delay
+  options.base_delay = std::chrono::milliseconds(0);
+  options.max_delay = std::chrono::milliseconds(0);
+  options.circuit_breaker_cooldown = std::chrono::milliseconds(0);
+  sanitized = ExponentialBackoffReconnectPolicy::Sanitize(options);
+  EXPECT_EQ(sanitized.base_delay, kMinReconnectDelay);
+  EXPECT_EQ(sanitized.max_delay, kMinReconnectDelay);
+  EXPECT_EQ(sanitized.circuit_breaker_cooldown.count(), 0);
+  options.base_delay = std::chrono::milliseconds(5000);
+  options.max_delay = std::chrono::milliseconds(1000);
+  EXPECT_EQ(ExponentialBackoffReconnectPolicy::Sanitize(options).max_delay,
+            std::chrono::milliseconds(5000));
+
+  // the policy retries with delays in range
+  options.base_delay = std::chrono::milliseconds(-1);
+  options.max_delay = std::chrono::milliseconds(-1);
+  ExponentialBackoffReconnectPolicy policy(options, 42);
+  auto now = ReconnectClock::now();
+  for (int i = 0; i < defaults.max_attempts; ++i) {
+    ReconnectDecision decision = policy.OnDisconnected(now);
+    EXPECT_TRUE(decision.should_retry);
+    EXPECT_GE(decision.delay.count(), 0);
+    EXPECT_LE(decision.delay, defaults.max_delay);
+  }
+}
+
+}  // namespace core
+}  // namespace debugrouter
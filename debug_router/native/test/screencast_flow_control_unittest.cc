@@ -0,0 +1,214 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/core/screencast_flow_control.h"
+
+#include <string>
+
+#include "debug_router/native/core/util.h"
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace core {
+
+namespace {
+
+ScreencastFrame Frame(const std::string &data) {
+  ScreencastFrame frame;
+  frame.data = data;
+  return frame;
+}
+
+}  // namespace
+
+TEST(ScreencastFlowControlTestSuite, LatestFrameWins) {
+  ScreencastFlowControl flow_control(2);
+  EXPECT_TRUE(flow_control.Submit(1, Frame("a")));
+  // a take is already scheduled
+  EXPECT_FALSE(flow_control.Submit(1, Frame("b")));
+  EXPECT_FALSE(flow_control.Submit(1, Frame("c")));
+  ScreencastFrame frame;
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame));
+  EXPECT_EQ(frame.data, "c");
+  EXPECT_FALSE(flow_control.TakeFrame(1, frame));
+
+  ScreencastStats stats = flow_control.GetStats();
+  EXPECT_EQ(stats.sent, 1u);
+  EXPECT_EQ(stats.replaced, 2u);
+  EXPECT_EQ(stats.dropped, 0u);
+}
+
+TEST(ScreencastFlowControlTestSuite, AckWindow) {
+  ScreencastFlowControl flow_control(2);
+  ScreencastClock::time_point now = ScreencastClock::now();
+  ScreencastFrame frame;
+  ASSERT_TRUE(flow_control.Submit(1, Frame("a"), now));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame, now));
+  ASSERT_TRUE(flow_control.Submit(1, Frame("b"), now));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame, now));
+  // the window applies before the first ack too
+  EXPECT_FALSE(flow_control.Submit(1, Frame("c"), now));
+  EXPECT_FALSE(flow_control.TakeFrame(1, frame, now));
+  EXPECT_TRUE(flow_control.OnAck(1));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame, now));
+  EXPECT_EQ(frame.data, "c");
+  EXPECT_FALSE(flow_control.Submit(1, Frame("d"), now));
+  EXPECT_FALSE(flow_control.Submit(1, Frame("e"), now));
+  EXPECT_FALSE(flow_control.TakeFrame(1, frame, now));
+  // other sessions have their own window
+  EXPECT_TRUE(flow_control.Submit(2, Frame("x"), now));
+
+  // an ack releases the latest waiting frame
+  EXPECT_TRUE(flow_control.OnAck(1));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame, now));
+  EXPECT_EQ(frame.data, "e");
+  EXPECT_FALSE(flow_control.Submit(1, Frame("f"), now));
+  EXPECT_TRUE(flow_control.OnAck(1));
+  EXPECT_FALSE(flow_control.OnAck(1));
+
+  ScreencastStats stats = flow_control.GetStats();
+  EXPECT_EQ(stats.sent, 4u);
+  EXPECT_EQ(stats.acked, 4u);
+  EXPECT_EQ(stats.replaced, 1u);
+  EXPECT_EQ(stats.lost, 0u);
+}
+
+TEST(ScreencastFlowControlTestSuite, DroppedFrameReleasesSlot) {
+  ScreencastFlowControl flow_control(1, std::chrono::milliseconds(1000));
+  ScreencastClock::time_point now = ScreencastClock::now();
+  ScreencastFrame frame;
+  ASSERT_TRUE(flow_control.Submit(1, Frame("a"), now));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame, now));
+  EXPECT_FALSE(flow_control.OnAck(1));
+  ASSERT_TRUE(flow_control.Submit(1, Frame("b"), now));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame, now));
+  EXPECT_FALSE(flow_control.Submit(1, Frame("c"), now));
+
+  // the transport dropped b, it is never acked
+  EXPECT_TRUE(flow_control.OnDropped(1));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame, now));
+  EXPECT_EQ(frame.data, "c");
+  EXPECT_FALSE(flow_control.OnAck(1));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(flow_control.Submit(1, Frame(std::to_string(i)), now));
+    ASSERT_TRUE(flow_control.TakeFrame(1, frame, now));
+    EXPECT_EQ(frame.data, std::to_string(i));
+    EXPECT_FALSE(flow_control.OnAck(1));
+  }
+
+  // a frame lost on the way is released after the ack timeout
+  ASSERT_TRUE(flow_control.Submit(1, Frame("d"), now));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame, now));
+  EXPECT_FALSE(flow_control.Submit(
+      1, Frame("e"), now + std::chrono::milliseconds(999)));
+  EXPECT_TRUE(flow_control.Submit(1, Frame("f"),
+                                  now + std::chrono::milliseconds(1000)));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame,
+                                     now + std::chrono::milliseconds(1000)));
+  EXPECT_EQ(frame.data, "f");
+
+  ScreencastStats stats = flow_control.GetStats();
+  EXPECT_EQ(stats.sent, 8u);
+  EXPECT_EQ(stats.lost, 2u);
+}
+
+TEST(ScreencastFlowControlTestSuite, DebuggerThatNeverAcks) {
+  ScreencastFlowControl flow_control(2, std::chrono::milliseconds(1000));
+  ScreencastClock::time_point now = ScreencastClock::now();
+  ScreencastClock::time_point later = now + std::chrono::milliseconds(1000);
+  ScreencastFrame frame;
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(flow_control.Submit(1, Frame(std::to_string(i)), now));
+    ASSERT_TRUE(flow_control.TakeFrame(1, frame, now));
+  }
+  EXPECT_FALSE(flow_control.Submit(1, Frame("2"), now));
+
+  // no frame was acked in time, frames are only coalesced from now on
+  EXPECT_TRUE(flow_control.Submit(1, Frame("3"), later));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame, later));
+  EXPECT_EQ(frame.data, "3");
+  for (int i = 4; i < 8; ++i) {
+    EXPECT_TRUE(flow_control.Submit(1, Frame(std::to_string(i)), later));
+    EXPECT_TRUE(flow_control.TakeFrame(1, frame, later));
+  }
+  EXPECT_EQ(flow_control.GetStats().lost, 0u);
+
+  // until it acks after all
+  EXPECT_FALSE(flow_control.OnAck(1));
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(flow_control.Submit(1, Frame("a" + std::to_string(i)), later));
+    ASSERT_TRUE(flow_control.TakeFrame(1, frame, later));
+  }
+  EXPECT_FALSE(flow_control.Submit(1, Frame("b"), later));
+}
+
+TEST(ScreencastFlowControlTestSuite, DropsOnResetAndRemove) {
+  ScreencastFlowControl flow_control(1);
+  EXPECT_TRUE(flow_control.Submit(1, Frame("a")));
+  EXPECT_TRUE(flow_control.Submit(2, Frame("b")));
+  flow_control.RemoveSession(1);
+  ScreencastFrame frame;
+  EXPECT_FALSE(flow_control.TakeFrame(1, frame));
+  flow_control.Reset(0);
+  EXPECT_FALSE(flow_control.TakeFrame(2, frame));
+  EXPECT_EQ(flow_control.GetStats().dropped, 2u);
+
+  // a window of 0 never holds frames back
+  ASSERT_TRUE(flow_control.Submit(1, Frame("c")));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame));
+  flow_control.OnAck(1);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(flow_control.Submit(1, Frame(std::to_string(i))));
+    EXPECT_TRUE(flow_control.TakeFrame(1, frame));
+  }
+}
+
+TEST(ScreencastFlowControlTestSuite, SkipsDuplicates) {
+  // no window, frames are only held back as duplicates
+  ScreencastFlowControl flow_control(0);
+  flow_control.SetSkipDuplicates(true, std::chrono::milliseconds(1000));
+  ScreencastClock::time_point now = ScreencastClock::now();
+  ScreencastFrame frame;
+  ASSERT_TRUE(flow_control.Submit(1, Frame("a"), now));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame));
+  EXPECT_FALSE(flow_control.Submit(1, Frame("a"), now));
+  EXPECT_FALSE(flow_control.TakeFrame(1, frame));
+  // other sessions, metadata and data are not duplicates
+  EXPECT_TRUE(flow_control.Submit(2, Frame("a"), now));
+  ScreencastFrame scaled = Frame("a");
+  scaled.metadata["pageScaleFactor"] = 2;
+  EXPECT_TRUE(flow_control.Submit(1, scaled, now));
+  EXPECT_FALSE(flow_control.Submit(1, scaled, now));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame));
+  EXPECT_TRUE(flow_control.Submit(1, Frame("b"), now));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame));
+
+  // a keep-alive after a second
+  EXPECT_FALSE(flow_control.Submit(1, Frame("b"),
+                                   now + std::chrono::milliseconds(999)));
+  EXPECT_TRUE(flow_control.Submit(1, Frame("b"),
+                                  now + std::chrono::milliseconds(1000)));
+  EXPECT_EQ(flow_control.GetStats().duplicates, 3u);
+
+  flow_control.SetSkipDuplicates(false, std::chrono::milliseconds(0));
+  ASSERT_TRUE(flow_control.TakeFrame(1, frame));
+  EXPECT_TRUE(flow_control.Submit(1, Frame("b"), now));
+}
+
+TEST(ScreencastFlowControlTestSuite, HashBytes) {
+  std::string data(1000, 'x');
+  uint64_t hash = util::HashBytes(data);
+  EXPECT_EQ(util::HashBytes(data), hash);
+  // every byte, including the tail, and the size change the hash
+  for (size_t i : {0, 7, 8, 500, 999}) {
+    std::string changed = data;
+    changed[i] = 'y';
+    EXPECT_NE(util::HashBytes(changed), hash) << i;
+  }
+  EXPECT_NE(util::HashBytes(data.substr(0, 999)), hash);
+  EXPECT_NE(util::HashBytes(std::string(1, '\0')), util::HashBytes(""));
+}
+
+}  // namespace core
+}  // namespace debugrouter
@@ -0,0 +1,133 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/protocol/screencast_frame.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "debug_router/native/processor/processor.h"
+#include "debug_router/native/protocol/message_envelope.h"
+#include "debug_router/native/protocol/protocol.h"
+#include "gtest/gtest.h"
+#include "json/reader.h"
+
+namespace debugrouter {
+namespace protocol {
+
+namespace {
+
+Json::Value Parse(std::string_view text) {
+  Json::Reader reader;
+  Json::Value root;
+  EXPECT_TRUE(reader.parse(text.data(), text.data() + text.size(), root))
+      << text;
+  return root;
+}
+
+class BinaryScreencastHandler : public processor::MessageHandler {
+ public:
+  explicit BinaryScreencastHandler(std::vector<std::string> *sent)
+      : sent_(sent) {}
+  std::string GetRoomId() override { return ""; }
+  std::unordered_map<std::string, std::string> GetClientInfo() override {
+    return {};
+  }
+  std::unordered_map<int, std::string> GetSessionList() override {
+    return {};
+  }
+  void OnMessage(const std::string &type, int session_id,
+                 const std::string &message) override {}
+  void SendMessage(const std::string &message) override {
+    sent_->push_back(message);
+  }
+  void OpenCard(const std::string &url) override {}
+  std::string HandleAppAction(const std::string &method,
+                              const std::string &params) override {
+    return "";
+  }
+  void ChangeRoomServer(const std::string &url,
+                        const std::string &room) override {}
+  void ReportError(const std::string &error) override {}
+  // like a transport that only sends text
+  bool EnableBinaryScreencast(bool enable) override { return false; }
+
+ private:
+  std::vector<std::string> *sent_;
+};
+
+}  // namespace
+
+TEST(ScreencastFrameTestSuite, WritesAndReadsFrame) {
+  std::string image("\xff\xd8\xff\xe0\0\x10JFIF", 10);
+  std::string payload =
+      WriteBinaryScreencastFrame(7, 3, {{"pageScaleFactor", 0.5f}}, image);
+  BinaryScreencastFrame frame;
+  ASSERT_TRUE(ReadBinaryScreencastFrame(payload, frame));
+  EXPECT_EQ(frame.image, image);
+  Json::Value header = Parse(frame.header);
+  EXPECT_EQ(header["client_id"], 7);
+  EXPECT_EQ(header["session_id"], 3);
+  EXPECT_EQ(header["metadata"]["pageScaleFactor"].asDouble(), 0.5);
+  // the image is only preceded by the prefix and the header
+  EXPECT_EQ(payload.size(), 8 + frame.header.size() + image.size());
+
+  EXPECT_FALSE(ReadBinaryScreencastFrame(payload.substr(0, 7), frame));
+  EXPECT_FALSE(ReadBinaryScreencastFrame(
+      payload.substr(0, 8 + frame.header.size() - 1), frame));
+  payload[3] = 2;
+  EXPECT_FALSE(ReadBinaryScreencastFrame(payload, frame));
+}
+
+TEST(ScreencastFrameTestSuite, ProcessorWrapsFrame) {
+  std::vector<std::string> sent;
+  processor::Processor processor(
+      std::make_unique<BinaryScreencastHandler>(&sent));
+  processor.Process("{\"event\":\"Initialize\",\"data\":2}");
+  std::string image("\x89PNG\r\n\x1a\n\0\0", 10);
+
+  core::OutboundMessage binary =
+      processor.WrapScreencastFrame(3, image, {}, true);
+  EXPECT_TRUE(binary.binary);
+  EXPECT_EQ(binary.session_id, 3);
+  EXPECT_EQ(binary.method, "Page.screencastFrame");
+  EXPECT_EQ(binary.priority, core::MessagePriority::kScreencast);
+  BinaryScreencastFrame frame;
+  ASSERT_TRUE(ReadBinaryScreencastFrame(*binary.payload, frame));
+  EXPECT_EQ(frame.image, image);
+  EXPECT_EQ(Parse(frame.header)["client_id"], 2);
+
+  // the fallback is the Page.screencastFrame event of today
+  core::OutboundMessage text =
+      processor.WrapScreencastFrame(3, image, {}, false);
+  EXPECT_FALSE(text.binary);
+  EXPECT_EQ(text.method, "Page.screencastFrame");
+  MessageEnvelope envelope;
+  ASSERT_TRUE(ParseMessageEnvelope(*text.payload, envelope));
+  std::string message;
+  ASSERT_TRUE(ReadEnvelopeMessage(envelope, message));
+  Json::Value event = Parse(message);
+  EXPECT_EQ(event["params"]["data"], "iVBORw0KGgoAAA==");
+  EXPECT_EQ(event["params"]["sessionId"], 3);
+}
+
+TEST(ScreencastFrameTestSuite, ProcessorAnswersNegotiation) {
+  std::vector<std::string> sent;
+  processor::Processor processor(
+      std::make_unique<BinaryScreencastHandler>(&sent));
+  processor.Process("{\"event\":\"Initialize\",\"data\":2}");
+  sent.clear();
+  processor.Process(
+      "{\"event\":\"Customized\",\"data\":{\"type\":\"BinaryScreencast\","
+      "\"sender\":1,\"data\":{\"client_id\":2,\"session_id\":-1,"
+      "\"message\":\"true\"}}}");
+  ASSERT_EQ(sent.size(), 1u);
+  Json::Value answer = Parse(sent[0]);
+  EXPECT_EQ(answer["data"]["type"], "BinaryScreencast");
+  EXPECT_EQ(answer["data"]["data"]["message"], "false");
+}
+
+}  // namespace protocol
+}  // namespace debugrouter
@@ -0,0 +1,108 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+// Counts heap allocations and measures the speed of wrapping an outgoing CDP
+// message: the Json::Value envelope that Processor used to build, the
+// direct writer, and Processor::WrapOutboundMessage as called by
+// DebugRouterCore::SendData.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "debug_router/native/processor/processor.h"
+#include "debug_router/native/protocol/message_writer.h"
+#include "debug_router/native/protocol/protocol.h"
+
+namespace {
+
+std::atomic<size_t> g_allocations = {0};
+
+}  // namespace
+
+void *operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  void *p = malloc(size == 0 ? 1 : size);
+  if (!p) {
+    abort();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+
+void operator delete(void *p, size_t size) noexcept { free(p); }
+
+namespace {
+
+constexpr size_t kBytesPerRun = 64 * 1024 * 1024;
+
+std::string CdpMessage(size_t size) {
+  std::string message =
+      "{\"method\":\"Runtime.consoleAPICalled\",\"params\":{\"type\":\"log\","
+      "\"args\":[{\"type\":\"string\",\"value\":\"";
+  while (message.size() < size) {
+    message += "line of console output\\n";
+  }
+  return message + "\"}]}}";
+}
+
+template <typename Wrap>
+void Measure(const char *name, const std::string &message, Wrap wrap) {
+  size_t count = std::max<size_t>(kBytesPerRun / message.size(), 16);
+  size_t bytes = 0;
+  size_t allocations = g_allocations.load();
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; ++i) {
+    bytes += wrap();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  allocations = g_allocations.load() - allocations;
+  printf("  %-8s %8.1f allocs/msg %10.0f msg/s %8.0f MB/s\n", name,
+         static_cast<double>(allocations) / count, count / seconds,
+         bytes / seconds / 1024 / 1024);
+}
+
+void Run(size_t size, bool is_object) {
+  std::string message = CdpMessage(size);
+  printf("message %zu B, is_object %d\n", message.size(), is_object);
+  Measure("value", message, [&]() {
+    auto cdp_data = std::make_shared<debugrouter::protocol::CustomData4CDP>();
+    cdp_data->client_id_ = 1;
+    cdp_data->session_id_ = 2;
+    cdp_data->message_ = message;
+    cdp_data->is_object_ = is_object;
+    return debugrouter::protocol::RemoteDebugProtocol::Stringify(
+               debugrouter::protocol::RemoteDebugProtocol::
+                   CreateProtocolBody4Custom("CDP", 1, cdp_data),
+               -1)
+        .size();
+  });
+  Measure("writer", message, [&]() {
+    return debugrouter::protocol::WriteCustomizedMessage("CDP", 1, 2, message,
+                                                         is_object, -1)
+        .size();
+  });
+  debugrouter::processor::Processor processor(nullptr);
+  Measure("envelope", message, [&]() {
+    return processor.WrapOutboundMessage("CDP", 2, message, -1, is_object)
+        .size();
+  });
+}
+
+}  // namespace
+
+int main() {
+  const size_t sizes[] = {200, 4 * 1024, 100 * 1024};
+  for (size_t size : sizes) {
+    Run(size, false);
+    Run(size, true);
+  }
+  return 0;
+}
@@ -0,0 +1,303 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/socket/socket_server_api.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "debug_router/native/core/debug_router_core.h"
+#include "debug_router/native/core/util.h"
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace socket_server {
+
+namespace {
+
+class TestConnectionListener : public SocketServerConnectionListener {
+ public:
+  void OnInit(int32_t code, const std::string &info) override {
+    Record("init:" + info);
+  }
+  void OnStatusChanged(ConnectionStatus status, int32_t code,
+                       const std::string &info) override {
+    Record("status:" + std::to_string(status));
+  }
+  void OnMessage(const std::string &message) override {
+    Record("message:" + message);
+  }
+  void OnParsedMessage(const std::string &message,
+                       const protocol::MessageEnvelope &envelope,
+                       const std::string &payload) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      payloads_.push_back(payload);
+    }
+    Record("message:" + message);
+  }
+
+  // waits until count events have been recorded
+  std::vector<std::string> WaitForEvents(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait_for(lock, std::chrono::seconds(5),
+                        [&]() { return events_.size() >= count; });
+    return events_;
+  }
+
+  // the envelope messages passed on with OnParsedMessage
+  std::vector<std::string> GetPayloads() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return payloads_;
+  }
+
+ private:
+  void Record(const std::string &event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back(event);
+    condition_.notify_all();
+  }
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::vector<std::string> events_;
+  std::vector<std::string> payloads_;
+};
+
+std::string EncodeFrame(const std::string &payload) {
+  char header[20];
+  util::IntToCharArray(kFrameProtocolVersion, header);
+  util::IntToCharArray(kPTFrameTypeTextMessage, header + 4);
+  util::IntToCharArray(kFrameDefaultTag, header + 8);
+  util::IntToCharArray(static_cast<uint32_t>(payload.size() + 4), header + 12);
+  util::IntToCharArray(static_cast<uint32_t>(payload.size()), header + 16);
+  return std::string(header, sizeof(header)) + payload;
+}
+
+// a CDP message of the host to session_id, message is escaped
+std::string CdpMessage(int session_id, const std::string &message = "{}") {
+  return "{\"event\":\"Customized\",\"data\":{\"type\":\"CDP\",\"data\":{"
+         "\"client_id\":1,\"session_id\":" +
+         std::to_string(session_id) + ",\"message\":\"" + message +
+         "\"},\"sender\":1}}";
+}
+
+int ConnectTo(int port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) !=
+      0) {
+    close(fd);
+    return -1;
+  }
+  timeval timeout = {5, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  return fd;
+}
+
+bool WriteString(int fd, const std::string &data) {
+  return write(fd, data.data(), data.size()) ==
+         static_cast<ssize_t>(data.size());
+}
+
+// the payload of the next frame, empty on timeout
+std::string ReadPayload(int fd) {
+  char header[20];
+  size_t read_size = 0;
+  while (read_size < sizeof(header)) {
+    ssize_t ret = read(fd, header + read_size, sizeof(header) - read_size);
+    if (ret <= 0) {
+      return "";
+    }
+    read_size += ret;
+  }
+  std::string payload(util::DecodePayloadSize(header + 16, 4), 0);
+  read_size = 0;
+  while (read_size < payload.size()) {
+    ssize_t ret = read(fd, &payload[read_size], payload.size() - read_size);
+    if (ret <= 0) {
+      return "";
+    }
+    read_size += ret;
+  }
+  return payload;
+}
+
+core::OutboundMessage SessionMessage(const std::string &text,
+                                     int32_t session_id) {
+  core::OutboundMessage message(text);
+  message.session_id = session_id;
+  return message;
+}
+
+// an escaped CDP request of method
+std::string CdpRequest(int id, const std::string &method) {
+  return "{\\\"id\\\":" + std::to_string(id) + ",\\\"method\\\":\\\"" +
+         method + "\\\"}";
+}
+
+}  // namespace
+
+TEST(SocketServerTestSuite, FansOutToSeveralClients) {
+  core::DebugRouterCore::GetInstance().EnableSingleSession(5);
+  core::DebugRouterCore::GetInstance().EnableSingleSession(6);
+  auto listener = std::make_shared<TestConnectionListener>();
+  auto server = SocketServer::CreateSocketServer(listener);
+  server->StartServer();
+  std::vector<std::string> events = listener->WaitForEvents(1);
+  ASSERT_EQ(events.size(), 1u);
+  ASSERT_EQ(events[0].rfind("init:port:", 0), 0u);
+  int port = std::stoi(events[0].substr(10));
+
+  int devtools = ConnectTo(port);
+  int profiler = ConnectTo(port);
+  ASSERT_GE(devtools, 0);
+  ASSERT_GE(profiler, 0);
+  ASSERT_TRUE(WriteString(devtools, EncodeFrame(CdpMessage(5))));
+  events = listener->WaitForEvents(3);
+  ASSERT_TRUE(WriteString(profiler, EncodeFrame(CdpMessage(6))));
+  // the listener sees one connection for both clients
+  events = listener->WaitForEvents(4);
+  ASSERT_EQ(events.size(), 4u);
+  EXPECT_EQ(events[1], "status:0");
+  EXPECT_EQ(events[2], "message:" + CdpMessage(5));
+  EXPECT_EQ(events[3], "message:" + CdpMessage(6));
+  // the server passes on the envelope it has parsed
+  EXPECT_EQ(listener->GetPayloads(), std::vector<std::string>({"{}", "{}"}));
+
+  // messages of no session go to both, the others to their subscribers
+  EXPECT_TRUE(server->Send(SessionMessage("all", core::kNoSessionId)));
+  EXPECT_TRUE(server->Send(SessionMessage("five", 5)));
+  EXPECT_TRUE(server->Send(SessionMessage("six", 6)));
+  EXPECT_FALSE(server->Send(SessionMessage("seven", 7)));
+  EXPECT_EQ(ReadPayload(devtools), "all");
+  EXPECT_EQ(ReadPayload(devtools), "five");
+  EXPECT_EQ(ReadPayload(profiler), "all");
+  EXPECT_EQ(ReadPayload(profiler), "six");
+
+  // the connection stays open until the last client leaves
+  close(devtools);
+  EXPECT_TRUE(server->Send(SessionMessage("six again", 6)));
+  EXPECT_EQ(ReadPayload(profiler), "six again");
+  close(profiler);
+  events = listener->WaitForEvents(5);
+  ASSERT_EQ(events.size(), 5u);
+  EXPECT_EQ(events[4], "status:" + std::to_string(kError));
+  EXPECT_FALSE(server->Send(SessionMessage("none", core::kNoSessionId)));
+  server->StopServer();
+}
+
+TEST(SocketServerTestSuite, SendsResponsesToTheirRequester) {
+  core::DebugRouterCore::GetInstance().EnableSingleSession(5);
+  auto listener = std::make_shared<TestConnectionListener>();
+  auto server = SocketServer::CreateSocketServer(listener);
+  server->StartServer();
+  std::vector<std::string> events = listener->WaitForEvents(1);
+  ASSERT_EQ(events.size(), 1u);
+  int port = std::stoi(events[0].substr(10));
+
+  int devtools = ConnectTo(port);
+  int profiler = ConnectTo(port);
+  ASSERT_GE(devtools, 0);
+  ASSERT_GE(profiler, 0);
+  // both clients talk to session 5 and use the same request id
+  ASSERT_TRUE(
+      WriteString(devtools, EncodeFrame(CdpMessage(5, "{\\\"id\\\":1}"))));
+  listener->WaitForEvents(3);
+  ASSERT_TRUE(
+      WriteString(profiler, EncodeFrame(CdpMessage(5, "{\\\"id\\\":1}"))));
+  events = listener->WaitForEvents(4);
+  ASSERT_EQ(events.size(), 4u);
+
+  core::OutboundMessage response = SessionMessage("first", 5);
+  response.request_id = 1;
+  EXPECT_TRUE(server->Send(response));
+  response = SessionMessage("second", 5);
+  response.request_id = 1;
+  EXPECT_TRUE(server->Send(response));
+  // events still go to every subscriber
+  EXPECT_TRUE(server->Send(SessionMessage("event", 5)));
+  EXPECT_EQ(ReadPayload(devtools), "first");
+  EXPECT_EQ(ReadPayload(devtools), "event");
+  EXPECT_EQ(ReadPayload(profiler), "second");
+  EXPECT_EQ(ReadPayload(profiler), "event");
+
+  close(devtools);
+  close(profiler);
+  listener->WaitForEvents(5);
+  server->StopServer();
+}
+
+TEST(SocketServerTestSuite, OneClientDrivesTheScreencast) {
+  core::DebugRouterCore::GetInstance().EnableSingleSession(5);
+  auto listener = std::make_shared<TestConnectionListener>();
+  auto server = SocketServer::CreateSocketServer(listener);
+  server->StartServer();
+  std::vector<std::string> events = listener->WaitForEvents(1);
+  ASSERT_EQ(events.size(), 1u);
+  int port = std::stoi(events[0].substr(10));
+
+  int devtools = ConnectTo(port);
+  int profiler = ConnectTo(port);
+  ASSERT_GE(devtools, 0);
+  ASSERT_GE(profiler, 0);
+  ASSERT_TRUE(WriteString(
+      devtools, EncodeFrame(CdpMessage(5, CdpRequest(1, "Page.enable")))));
+  listener->WaitForEvents(3);
+  ASSERT_TRUE(WriteString(
+      devtools,
+      EncodeFrame(CdpMessage(5, CdpRequest(2, "Page.startScreencast")))));
+  listener->WaitForEvents(4);
+  // the profiler is refused while devtools drives the screencast
+  ASSERT_TRUE(WriteString(
+      profiler,
+      EncodeFrame(CdpMessage(5, CdpRequest(1, "Page.startScreencast")))));
+  std::string reply = ReadPayload(profiler);
+  EXPECT_NE(reply.find("{\"id\":1,\"error\":{\"code\":-32000"),
+            std::string::npos);
+  EXPECT_EQ(listener->WaitForEvents(4).size(), 4u);
+
+  // frames only go to devtools, binary ones not before it enabled them
+  core::OutboundMessage frame = SessionMessage("frame", 5);
+  frame.method = "Page.screencastFrame";
+  EXPECT_TRUE(server->Send(frame));
+  frame.binary = true;
+  EXPECT_FALSE(server->Send(frame));
+  EXPECT_TRUE(server->Send(SessionMessage("event", 5)));
+  EXPECT_EQ(ReadPayload(devtools), "frame");
+  EXPECT_EQ(ReadPayload(devtools), "event");
+  EXPECT_EQ(ReadPayload(profiler), "event");
+
+  // the profiler may start it once devtools stopped
+  ASSERT_TRUE(WriteString(
+      devtools,
+      EncodeFrame(CdpMessage(5, CdpRequest(3, "Page.stopScreencast")))));
+  listener->WaitForEvents(5);
+  ASSERT_TRUE(WriteString(
+      profiler,
+      EncodeFrame(CdpMessage(5, CdpRequest(2, "Page.startScreencast")))));
+  events = listener->WaitForEvents(6);
+  ASSERT_EQ(events.size(), 6u);
+  EXPECT_EQ(events[5],
+            "message:" + CdpMessage(5, CdpRequest(2, "Page.startScreencast")));
+
+  close(devtools);
+  close(profiler);
+  listener->WaitForEvents(7);
+  server->StopServer();
+}
+
+}  // namespace socket_server
+}  // namespace debugrouter
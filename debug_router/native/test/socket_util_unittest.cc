@@ -59,4 +59,8 @@ TEST(SocketUtilTestSuite, TestCheckHeader) {
 
   EXPECT_EQ(true, debugrouter::util::CheckHeaderThreeBytes(header));
   EXPECT_EQ(true, debugrouter::util::CheckHeaderFourthByte(header, 27));
+  header[3] = 2;
+  EXPECT_EQ(true, debugrouter::util::CheckHeaderThreeBytes(header));
+  header[3] = 3;
+  EXPECT_EQ(false, debugrouter::util::CheckHeaderThreeBytes(header));
 }
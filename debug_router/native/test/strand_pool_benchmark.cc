@@ -0,0 +1,87 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+// Measures how long the messages of 20 fast sessions wait while one session
+// has a slow slot callback: all sessions on one thread, as the executor
+// dispatched them before, and one strand per session on a pool of 4 threads.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "debug_router/native/socket/count_down_latch.h"
+#include "debug_router/native/thread/strand_pool.h"
+
+namespace {
+
+using debugrouter::socket_server::CountDownLatch;
+using debugrouter::thread::StrandPool;
+using Clock = std::chrono::steady_clock;
+
+constexpr int kFastSessions = 20;
+constexpr int kRounds = 20;
+constexpr int kFastMessagesPerRound = 5;
+// a big DOM dump of the slow session blocks its slot for this long
+constexpr auto kSlowCallback = std::chrono::milliseconds(20);
+constexpr auto kFastCallback = std::chrono::microseconds(20);
+
+void Spin(std::chrono::microseconds duration) {
+  auto end = Clock::now() + duration;
+  while (Clock::now() < end) {
+  }
+}
+
+double Millis(Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// posts every message at once, strand_of maps a session to its strand
+template <typename StrandOf>
+void Measure(const char *name, size_t threads, StrandOf strand_of) {
+  StrandPool pool(threads);
+  int fast_count = kRounds * kFastSessions * kFastMessagesPerRound;
+  CountDownLatch done(fast_count + kRounds);
+  std::mutex mutex;
+  std::vector<double> latencies;
+  latencies.reserve(fast_count);
+  auto start = Clock::now();
+  for (int round = 0; round < kRounds; ++round) {
+    pool.Post(strand_of(0), [&]() {
+      std::this_thread::sleep_for(kSlowCallback);
+      done.CountDown();
+    });
+    for (int session = 1; session <= kFastSessions; ++session) {
+      for (int i = 0; i < kFastMessagesPerRound; ++i) {
+        auto posted = Clock::now();
+        pool.Post(strand_of(session), [&, posted]() {
+          Spin(kFastCallback);
+          double latency = Millis(Clock::now() - posted);
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            latencies.push_back(latency);
+          }
+          done.CountDown();
+        });
+      }
+    }
+  }
+  done.Await();
+  double total = Millis(Clock::now() - start);
+  std::sort(latencies.begin(), latencies.end());
+  printf("  %-8s %zu threads  fast p50 %8.2f ms  p99 %8.2f ms  max %8.2f ms"
+         "  total %8.2f ms\n",
+         name, threads, latencies[latencies.size() / 2],
+         latencies[latencies.size() * 99 / 100], latencies.back(), total);
+}
+
+}  // namespace
+
+int main() {
+  Measure("serial", 1, [](int session) { return 0; });
+  Measure("strands", 4, [](int session) { return session; });
+  return 0;
+}
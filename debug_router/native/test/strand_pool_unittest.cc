@@ -0,0 +1,92 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/thread/strand_pool.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "debug_router/native/socket/count_down_latch.h"
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace thread {
+
+TEST(StrandPoolTestSuite, KeepsStrandOrder) {
+  constexpr int kStrands = 8;
+  constexpr int kTasks = 1000;
+  StrandPool pool(4);
+  std::mutex mutex;
+  std::vector<std::vector<int>> order(kStrands);
+  std::atomic<int> running(0);
+  std::atomic<bool> overlapped(false);
+  socket_server::CountDownLatch latch(kStrands * kTasks);
+  for (int i = 0; i < kTasks; ++i) {
+    for (int strand = 0; strand < kStrands; ++strand) {
+      pool.Post(strand, [&, strand, i]() {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          order[strand].push_back(i);
+        }
+        latch.CountDown();
+      });
+    }
+  }
+  // a strand never runs two tasks at once
+  for (int i = 0; i < kTasks; ++i) {
+    pool.Post(kStrands, [&]() {
+      if (running.fetch_add(1) != 0) {
+        overlapped = true;
+      }
+      running.fetch_sub(1);
+    });
+  }
+  latch.Await();
+  for (int strand = 0; strand < kStrands; ++strand) {
+    ASSERT_EQ(order[strand].size(), static_cast<size_t>(kTasks));
+    for (int i = 0; i < kTasks; ++i) {
+      EXPECT_EQ(order[strand][i], i);
+    }
+  }
+  EXPECT_FALSE(overlapped);
+}
+
+TEST(StrandPoolTestSuite, SlowStrandDoesNotBlockOthers) {
+  StrandPool pool(2);
+  socket_server::CountDownLatch fast_done(1);
+  socket_server::CountDownLatch slow_done(1);
+  // strand 1 waits for strand 2, which would never run on a single thread
+  pool.Post(1, [&]() {
+    fast_done.Await();
+    slow_done.CountDown();
+  });
+  pool.Post(2, [&]() { fast_done.CountDown(); });
+  slow_done.Await();
+  EXPECT_EQ(pool.thread_count(), 2u);
+}
+
+TEST(StrandPoolTestSuite, StrandsAreNotTiedToAThread) {
+  StrandPool pool(2);
+  socket_server::CountDownLatch blocked(1);
+  socket_server::CountDownLatch done(2);
+  // strand 0 holds a thread until strands 2 and 4 ran on the other one
+  pool.Post(0, [&]() {
+    blocked.Await();
+    done.CountDown();
+  });
+  pool.Post(2, [&]() { done.CountDown(); });
+  pool.Post(4, [&]() { blocked.CountDown(); });
+  done.Await();
+}
+
+TEST(StrandPoolTestSuite, DestroyedBeforeFirstPost) {
+  // no thread is started until a task is posted
+  StrandPool pool(4);
+  EXPECT_EQ(pool.thread_count(), 4u);
+}
+
+}  // namespace thread
+}  // namespace debugrouter
@@ -0,0 +1,176 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/base/string_kernels.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "json/writer.h"
+
+namespace debugrouter {
+namespace base {
+
+namespace {
+
+// the levels this CPU has, the scalar one first
+std::vector<KernelLevel> AvailableLevels() {
+  KernelLevel previous = SetKernelLevel(KernelLevel::kAvx2);
+  KernelLevel best = GetKernelLevel();
+  SetKernelLevel(previous);
+  std::vector<KernelLevel> levels;
+  for (int level = 0; level <= static_cast<int>(best); ++level) {
+    levels.push_back(static_cast<KernelLevel>(level));
+  }
+  return levels;
+}
+
+class ScopedKernelLevel {
+ public:
+  explicit ScopedKernelLevel(KernelLevel level)
+      : previous_(SetKernelLevel(level)) {}
+  ~ScopedKernelLevel() { SetKernelLevel(previous_); }
+
+ private:
+  KernelLevel previous_;
+};
+
+std::string Escape(std::string_view data) {
+  std::string out(JsonEscapedSize(data), '\0');
+  char *end = JsonEscape(data, &out[0]);
+  EXPECT_EQ(end, out.data() + out.size());
+  return out;
+}
+
+// bytes of which about one in density is escaped
+std::string RandomText(std::mt19937 &random, size_t size, int density) {
+  static const char kEscaped[] = {'"', '\\', '\n', '\t', '\x01', '\x1f', '\0'};
+  std::string text;
+  for (size_t i = 0; i < size; ++i) {
+    if (random() % density == 0) {
+      text.push_back(kEscaped[random() % sizeof(kEscaped)]);
+    } else {
+      text.push_back(static_cast<char>(0x20 + random() % 0xe0));
+    }
+  }
+  return text;
+}
+
+}  // namespace
+
+TEST(StringKernelsTestSuite, EscapesLikeJsonValue) {
+  std::string all_bytes;
+  for (int c = 0; c < 256; ++c) {
+    all_bytes.push_back(static_cast<char>(c));
+  }
+  // twice, so that every byte is also seen by the vector loops
+  all_bytes += all_bytes;
+  std::string expected = Json::FastWriter().write(Json::Value(
+      all_bytes.data(), all_bytes.data() + all_bytes.size()));
+  // without the quotes and the newline FastWriter ends with
+  expected = expected.substr(1, expected.size() - 3);
+  for (KernelLevel level : AvailableLevels()) {
+    ScopedKernelLevel scoped(level);
+    EXPECT_EQ(Escape(all_bytes), expected) << static_cast<int>(level);
+  }
+}
+
+TEST(StringKernelsTestSuite, EscapesLikeScalar) {
+  std::mt19937 random(7);
+  std::vector<KernelLevel> levels = AvailableLevels();
+  for (int density : {1, 3, 40, 100000}) {
+    for (size_t size = 0; size < 300; size += 1 + size / 16) {
+      std::string text = RandomText(random, size, density);
+      // at every alignment of the input
+      for (size_t offset = 0; offset < 4 && offset <= size; ++offset) {
+        std::string tail = text.substr(offset);
+        std::string expected;
+        {
+          ScopedKernelLevel scoped(KernelLevel::kScalar);
+          expected = Escape(tail);
+        }
+        for (KernelLevel level : levels) {
+          ScopedKernelLevel scoped(level);
+          EXPECT_EQ(Escape(std::string_view(text).substr(offset)), expected)
+              << size << " " << static_cast<int>(level);
+        }
+      }
+    }
+  }
+}
+
+TEST(StringKernelsTestSuite, Base64Encode) {
+  const char *cases[][2] = {
+      {"", ""},         {"f", "Zg=="},         {"fo", "Zm8="},
+      {"foo", "Zm9v"},  {"foob", "Zm9vYg=="},  {"fooba", "Zm9vYmE="},
+      {"foobar", "Zm9vYmFy"},
+  };
+  for (const auto &item : cases) {
+    std::string out = "x";
+    Base64Encode(item[0], out);
+    EXPECT_EQ(out, std::string("x") + item[1]);
+  }
+  std::string out;
+  Base64Encode(std::string("\xff\x00\xfe", 3), out);
+  EXPECT_EQ(out, "/wD+");
+  EXPECT_EQ(Base64EncodedSize(4), 8u);
+}
+
+TEST(StringKernelsTestSuite, Base64RoundTrip) {
+  std::mt19937 random(11);
+  std::vector<KernelLevel> levels = AvailableLevels();
+  for (size_t size = 0; size < 400; size += 1 + size / 32) {
+    std::string data;
+    for (size_t i = 0; i < size; ++i) {
+      data.push_back(static_cast<char>(random()));
+    }
+    std::string expected;
+    {
+      ScopedKernelLevel scoped(KernelLevel::kScalar);
+      Base64Encode(data, expected);
+    }
+    for (KernelLevel level : levels) {
+      ScopedKernelLevel scoped(level);
+      std::string encoded;
+      Base64Encode(data, encoded);
+      EXPECT_EQ(encoded, expected) << size << " " << static_cast<int>(level);
+      std::string decoded = "x";
+      EXPECT_TRUE(Base64Decode(encoded, decoded));
+      EXPECT_EQ(decoded, "x" + data) << size << " " << static_cast<int>(level);
+    }
+  }
+}
+
+TEST(StringKernelsTestSuite, Base64DecodeRejects) {
+  for (const char *text : {"A", "AAA", "AAAAA", "A===", "====", "A=AA", "AA=A",
+                           "AAA*", "AA\xc1=", "AA==AAAA"}) {
+    std::string out = "x";
+    EXPECT_FALSE(Base64Decode(text, out)) << text;
+    EXPECT_EQ(out, "x");
+  }
+  std::string encoded;
+  Base64Encode(std::string(300, '\x5a'), encoded);
+  for (KernelLevel level : AvailableLevels()) {
+    ScopedKernelLevel scoped(level);
+    // a bad character anywhere, also in the steps of the vector loops
+    for (size_t i = 0; i < encoded.size(); ++i) {
+      for (char bad : {'*', '=', '\0', '\x80', '\xff'}) {
+        std::string text = encoded;
+        text[i] = bad;
+        if (bad == '=' && i + 1 == text.size()) {
+          continue;
+        }
+        std::string out;
+        EXPECT_FALSE(Base64Decode(text, out))
+            << i << " " << static_cast<int>(bad);
+        EXPECT_TRUE(out.empty());
+      }
+    }
+  }
+}
+
+}  // namespace base
+}  // namespace debugrouter
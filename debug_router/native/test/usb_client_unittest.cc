@@ -0,0 +1,360 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/socket/usb_client.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "debug_router/native/core/util.h"
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace socket_server {
+
+namespace {
+
+class TestListener : public UsbClientListener {
+ public:
+  void OnOpen(std::shared_ptr<UsbClient> client, int32_t code,
+              const std::string &reason) override {
+    client->SetConnectStatus(USBConnectStatus::CONNECTED);
+    Record("open");
+  }
+  void OnClose(std::shared_ptr<UsbClient> client, int32_t code,
+               const std::string &reason) override {
+    Record("close");
+  }
+  void OnError(std::shared_ptr<UsbClient> client, int32_t code,
+               const std::string &message) override {
+    Record("error");
+  }
+  void OnMessage(std::shared_ptr<UsbClient> client,
+                 const std::string &message) override {
+    Record("message:" + message);
+  }
+
+  // waits until count events have been recorded
+  std::vector<std::string> WaitForEvents(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [&]() { return events_.size() >= count; });
+    return events_;
+  }
+
+ private:
+  void Record(const std::string &event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back(event);
+    condition_.notify_all();
+  }
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::vector<std::string> events_;
+};
+
+// a frame as sent by the host
+std::string EncodeFrame(const std::string &payload) {
+  char header[20];
+  util::IntToCharArray(kFrameProtocolVersion, header);
+  util::IntToCharArray(kPTFrameTypeTextMessage, header + 4);
+  util::IntToCharArray(kFrameDefaultTag, header + 8);
+  util::IntToCharArray(static_cast<uint32_t>(payload.size() + 4), header + 12);
+  util::IntToCharArray(static_cast<uint32_t>(payload.size()), header + 16);
+  return std::string(header, sizeof(header)) + payload;
+}
+
+// a version 2 frame as sent by the host
+std::string EncodeFrameV2(const std::string &payload, int32_t session_id,
+                          uint32_t sequence, uint8_t flags = 0) {
+  char header[32] = {};
+  util::IntToCharArray(kFrameProtocolVersion2, header);
+  util::IntToCharArray(kPTFrameTypeTextMessage, header + 4);
+  util::IntToCharArray(kFrameDefaultTag, header + 8);
+  util::IntToCharArray(static_cast<uint32_t>(payload.size() + 16), header + 12);
+  util::IntToCharArray(static_cast<uint32_t>(session_id), header + 16);
+  header[20] = kFrameClassCdp;
+  header[21] = static_cast<char>(flags);
+  util::IntToCharArray(sequence, header + 24);
+  util::IntToCharArray(static_cast<uint32_t>(payload.size()), header + 28);
+  return std::string(header, sizeof(header)) + payload;
+}
+
+uint32_t ReadUInt32(const std::string &data, size_t offset) {
+  return util::DecodePayloadSize(const_cast<char *>(&data[offset]), 4);
+}
+
+std::string ReadExactly(int fd, size_t size) {
+  std::string result(size, 0);
+  size_t read_size = 0;
+  while (read_size < size) {
+    ssize_t ret = read(fd, &result[read_size], size - read_size);
+    if (ret <= 0) {
+      break;
+    }
+    read_size += ret;
+  }
+  result.resize(read_size);
+  return result;
+}
+
+}  // namespace
+
+TEST(UsbClientTestSuite, FramesSplitAcrossReads) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  auto listener = std::make_shared<TestListener>();
+  auto client = std::make_shared<UsbClient>(fds[0]);
+  client->Init();
+  client->StartUp(listener);
+
+  std::string data = EncodeFrame("{\"a\":1}") + EncodeFrame("second");
+  // byte by byte, every header and payload is completed across reads
+  for (char c : data) {
+    ASSERT_EQ(write(fds[1], &c, 1), 1);
+  }
+  std::vector<std::string> events = listener->WaitForEvents(3);
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[0], "open");
+  EXPECT_EQ(events[1], "message:{\"a\":1}");
+  EXPECT_EQ(events[2], "message:second");
+
+  close(fds[1]);
+  events = listener->WaitForEvents(5);
+  EXPECT_EQ(events[3], "error");
+  EXPECT_EQ(events[4], "close");
+  client->Stop();
+}
+
+TEST(UsbClientTestSuite, SendAfterOpen) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  auto listener = std::make_shared<TestListener>();
+  auto client = std::make_shared<UsbClient>(fds[0]);
+  client->Init();
+  client->StartUp(listener);
+  std::string frame = EncodeFrame("hello");
+  ASSERT_EQ(write(fds[1], frame.data(), frame.size()),
+            static_cast<ssize_t>(frame.size()));
+  listener->WaitForEvents(2);
+
+  // larger than the socket buffer, the write completes on writable events
+  std::string large(2 * 1024 * 1024, 'x');
+  EXPECT_TRUE(client->Send("reply"));
+  EXPECT_TRUE(client->Send(large));
+  std::string received = ReadExactly(fds[1], 20 + 5);
+  EXPECT_EQ(received.substr(20), "reply");
+  received = ReadExactly(fds[1], 20 + large.size());
+  EXPECT_EQ(received.size(), 20 + large.size());
+  EXPECT_TRUE(received.substr(20) == large);
+
+  // binary messages only differ in the frame type
+  core::OutboundMessage binary(std::string("\0\xff", 2));
+  binary.binary = true;
+  EXPECT_TRUE(client->Send(binary));
+  received = ReadExactly(fds[1], 20 + 2);
+  EXPECT_EQ(util::DecodePayloadSize(&received[4], 4),
+            static_cast<uint32_t>(kPTFrameTypeBinaryMessage));
+  EXPECT_EQ(received.substr(20), std::string("\0\xff", 2));
+
+  client->Stop();
+  // Stop closes the socket
+  char c;
+  EXPECT_EQ(read(fds[1], &c, 1), 0);
+  close(fds[1]);
+}
+
+TEST(UsbClientTestSuite, InteractiveOvertakesScreencast) {
+  // fewer than kMaxQueuedScreencastMessages, none of them is dropped
+  constexpr int kFrames = 60;
+  constexpr size_t kFrameSize = 64 * 1024;
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  auto listener = std::make_shared<TestListener>();
+  auto client = std::make_shared<UsbClient>(fds[0]);
+  client->Init();
+  client->StartUp(listener);
+  std::string frame = EncodeFrame("hello");
+  ASSERT_EQ(write(fds[1], frame.data(), frame.size()),
+            static_cast<ssize_t>(frame.size()));
+  listener->WaitForEvents(2);
+
+  // nothing is read until the socket is full
+  core::OutboundMessage screencast(std::string(kFrameSize, 'f'));
+  screencast.priority = core::MessagePriority::kScreencast;
+  for (int i = 0; i < kFrames; ++i) {
+    EXPECT_TRUE(client->Send(screencast));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_TRUE(client->Send("paused"));
+
+  int position = -1;
+  for (int i = 0; i <= kFrames; ++i) {
+    std::string header = ReadExactly(fds[1], 20);
+    ASSERT_EQ(header.size(), 20u);
+    std::string payload = ReadExactly(fds[1], ReadUInt32(header, 16));
+    if (payload == "paused") {
+      position = i;
+    }
+  }
+  // only the frames already in the socket and in one fill were ahead of it
+  EXPECT_GE(position, 0);
+  EXPECT_LT(position, kFrames / 2);
+  client->Stop();
+  close(fds[1]);
+}
+
+TEST(UsbClientTestSuite, InvalidFirstFrameClosesSilently) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  auto listener = std::make_shared<TestListener>();
+  auto client = std::make_shared<UsbClient>(fds[0]);
+  client->Init();
+  client->StartUp(listener);
+  std::string garbage(32, 'g');
+  ASSERT_EQ(write(fds[1], garbage.data(), garbage.size()),
+            static_cast<ssize_t>(garbage.size()));
+  char c;
+  EXPECT_EQ(read(fds[1], &c, 1), 0);
+  client->Stop();
+  // no event is reported for a client that is not a DebugRouter host
+  EXPECT_TRUE(listener->WaitForEvents(0).empty());
+  close(fds[1]);
+}
+
+TEST(UsbClientTestSuite, MixedVersionPeers) {
+  int v1_fds[2];
+  int v2_fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, v1_fds), 0);
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, v2_fds), 0);
+  auto v1_listener = std::make_shared<TestListener>();
+  auto v2_listener = std::make_shared<TestListener>();
+  auto v1_client = std::make_shared<UsbClient>(v1_fds[0]);
+  auto v2_client = std::make_shared<UsbClient>(v2_fds[0]);
+  v1_client->Init();
+  v1_client->StartUp(v1_listener);
+  v2_client->Init();
+  v2_client->StartUp(v2_listener);
+
+  std::string frame = EncodeFrame("v1");
+  ASSERT_EQ(write(v1_fds[1], frame.data(), frame.size()),
+            static_cast<ssize_t>(frame.size()));
+  // a message in fragments, a compressed frame that is dropped, and a
+  // version 1 frame from the same peer
+  std::string data = EncodeFrameV2("frag", core::kNoSessionId, 0,
+                                   kFrameFlagMoreFragments) +
+                     EncodeFrameV2("ments", core::kNoSessionId, 1) +
+                     EncodeFrameV2("zip", core::kNoSessionId, 2,
+                                   kFrameFlagCompressed) +
+                     EncodeFrame("old") +
+                     EncodeFrameV2("v2", core::kNoSessionId, 3);
+  ASSERT_EQ(write(v2_fds[1], data.data(), data.size()),
+            static_cast<ssize_t>(data.size()));
+  std::vector<std::string> events = v1_listener->WaitForEvents(2);
+  EXPECT_EQ(events[1], "message:v1");
+  events = v2_listener->WaitForEvents(4);
+  ASSERT_EQ(events.size(), 4u);
+  EXPECT_EQ(events[1], "message:fragments");
+  EXPECT_EQ(events[2], "message:old");
+  EXPECT_EQ(events[3], "message:v2");
+
+  // each peer receives the version it sent
+  core::OutboundMessage message(std::string("reply"));
+  message.session_id = core::kNoSessionId;
+  message.type = "CDP";
+  EXPECT_TRUE(v1_client->Send(message));
+  EXPECT_TRUE(v2_client->Send(message));
+  EXPECT_TRUE(v2_client->Send(message));
+  std::string received = ReadExactly(v1_fds[1], 20 + 5);
+  EXPECT_EQ(ReadUInt32(received, 0),
+            static_cast<uint32_t>(kFrameProtocolVersion));
+  EXPECT_EQ(received.substr(20), "reply");
+  for (uint32_t sequence = 0; sequence < 2; ++sequence) {
+    received = ReadExactly(v2_fds[1], 32 + 5);
+    ASSERT_EQ(received.size(), 37u);
+    EXPECT_EQ(ReadUInt32(received, 0),
+              static_cast<uint32_t>(kFrameProtocolVersion2));
+    EXPECT_EQ(ReadUInt32(received, 12), 16u + 5);
+    EXPECT_EQ(static_cast<int32_t>(ReadUInt32(received, 16)),
+              core::kNoSessionId);
+    EXPECT_EQ(received[20], kFrameClassCdp);
+    EXPECT_EQ(received[21], 0);
+    EXPECT_EQ(ReadUInt32(received, 24), sequence);
+    EXPECT_EQ(ReadUInt32(received, 28), 5u);
+    EXPECT_EQ(received.substr(32), "reply");
+  }
+
+  v1_client->Stop();
+  v2_client->Stop();
+  close(v1_fds[1]);
+  close(v2_fds[1]);
+}
+
+TEST(UsbClientTestSuite, BrokenFragmentsCloseTheConnection) {
+  // a lost frame, and a compressed message in fragments
+  const std::string cases[] = {
+      EncodeFrameV2("frag", core::kNoSessionId, 0, kFrameFlagMoreFragments) +
+          EncodeFrameV2("ments", core::kNoSessionId, 2),
+      EncodeFrameV2("zip", core::kNoSessionId, 0,
+                    kFrameFlagCompressed | kFrameFlagMoreFragments) +
+          EncodeFrameV2("ped", core::kNoSessionId, 1)};
+  for (const std::string &data : cases) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    auto listener = std::make_shared<TestListener>();
+    auto client = std::make_shared<UsbClient>(fds[0]);
+    client->Init();
+    client->StartUp(listener);
+    ASSERT_EQ(write(fds[1], data.data(), data.size()),
+              static_cast<ssize_t>(data.size()));
+    // the error is followed by the close, no message is delivered
+    std::vector<std::string> events = listener->WaitForEvents(3);
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0], "open");
+    EXPECT_EQ(events[1], "error");
+    EXPECT_EQ(events[2], "close");
+    client->Stop();
+    close(fds[1]);
+  }
+}
+
+TEST(UsbClientTestSuite, StopIsPrompt) {
+  constexpr int kClients = 8;
+  int fds[kClients][2];
+  std::vector<std::shared_ptr<UsbClient>> clients;
+  auto listener = std::make_shared<TestListener>();
+  for (int i = 0; i < kClients; ++i) {
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds[i]), 0);
+    clients.push_back(std::make_shared<UsbClient>(fds[i][0]));
+    clients.back()->Init();
+    clients.back()->StartUp(listener);
+    std::string frame = EncodeFrame("hello");
+    ASSERT_EQ(write(fds[i][1], frame.data(), frame.size()),
+              static_cast<ssize_t>(frame.size()));
+  }
+  listener->WaitForEvents(2 * kClients);
+  // one client has a write pending that its peer never reads
+  EXPECT_TRUE(clients[0]->Send(std::string(4 * 1024 * 1024, 'x')));
+  // idle connections, the loop sleeps until it is woken
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  for (int i = 0; i < kClients; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    clients[i]->Stop();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    // Stop wakes the loop, which sleeps without a timeout otherwise. The limit
+    // leaves room for loaded machines.
+    EXPECT_LT(elapsed, std::chrono::seconds(1)) << i;
+    close(fds[i][1]);
+  }
+}
+
+}  // namespace socket_server
+}  // namespace debugrouter
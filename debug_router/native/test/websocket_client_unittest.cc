@@ -0,0 +1,334 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/net/websocket_client.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "debug_router/native/thread/debug_router_executor.h"
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace net {
+
+namespace {
+
+class TestDelegate : public core::MessageTransceiverDelegate {
+ public:
+  void OnOpen(
+      const std::shared_ptr<core::MessageTransceiver> &transceiver) override {
+    Record("open");
+  }
+  void OnClosed(
+      const std::shared_ptr<core::MessageTransceiver> &transceiver) override {
+    Record("close");
+  }
+  void OnFailure(const std::shared_ptr<core::MessageTransceiver> &transceiver,
+                 const std::string &error_message, int error_code) override {
+    Record("failure");
+  }
+  void OnMessage(
+      const std::string &message,
+      const std::shared_ptr<core::MessageTransceiver> &transceiver) override {
+    Record("message:" + message);
+  }
+  void OnInit(const std::shared_ptr<core::MessageTransceiver> &transceiver,
+              int32_t code, const std::string &info) override {}
+
+  std::vector<std::string> WaitForEvents(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [&]() { return events_.size() >= count; });
+    return events_;
+  }
+
+ private:
+  void Record(const std::string &event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back(event);
+    condition_.notify_all();
+  }
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::vector<std::string> events_;
+};
+
+std::string ReadExactly(int fd, size_t size) {
+  std::string result(size, 0);
+  size_t read_size = 0;
+  while (read_size < size) {
+    ssize_t ret = read(fd, &result[read_size], size - read_size);
+    if (ret <= 0) {
+      break;
+    }
+    read_size += ret;
+  }
+  result.resize(read_size);
+  return result;
+}
+
+std::string ReadUntil(int fd, const std::string &terminator) {
+  std::string result;
+  char c;
+  while (result.find(terminator) == std::string::npos &&
+         read(fd, &c, 1) == 1) {
+    result.push_back(c);
+  }
+  return result;
+}
+
+// client frames are masked with a zero key, so the payload is readable
+std::string ClientFrame(uint8_t opcode, const std::string &payload) {
+  std::string frame;
+  frame.push_back(static_cast<char>(0x80 | opcode));
+  frame.push_back(static_cast<char>(0x80 | payload.size()));
+  frame.append(4, '\0');
+  return frame + payload;
+}
+
+// the payload of the next client frame, its opcode is stored in opcode
+std::string ReadFramePayload(int fd, uint8_t *opcode = nullptr) {
+  std::string header = ReadExactly(fd, 2);
+  if (header.size() != 2) {
+    return "";
+  }
+  if (opcode) {
+    *opcode = static_cast<uint8_t>(header[0]) & 0x0f;
+  }
+  uint64_t size = static_cast<uint8_t>(header[1]) & 0x7f;
+  size_t size_len = size == 126 ? 2 : (size == 127 ? 8 : 0);
+  if (size_len > 0) {
+    std::string extended = ReadExactly(fd, size_len);
+    size = 0;
+    for (char c : extended) {
+      size = (size << 8) | static_cast<uint8_t>(c);
+    }
+  }
+  ReadExactly(fd, 4);
+  return ReadExactly(fd, size);
+}
+
+}  // namespace
+
+TEST(WebSocketClientTestSuite, HandshakeMessagesPingAndClose) {
+  thread::DebugRouterExecutor::GetInstance().Start();
+  int server = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(server, 0);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(bind(server, (struct sockaddr *)&addr, sizeof(addr)), 0);
+  socklen_t addr_len = sizeof(addr);
+  ASSERT_EQ(getsockname(server, (struct sockaddr *)&addr, &addr_len), 0);
+  ASSERT_EQ(listen(server, 1), 0);
+
+  TestDelegate delegate;
+  auto client = std::make_shared<WebSocketClient>();
+  client->SetDelegate(&delegate);
+  client->Init();
+  client->Connect("ws://127.0.0.1:" + std::to_string(ntohs(addr.sin_port)) +
+                  "/test");
+
+  int connection = accept(server, nullptr, nullptr);
+  ASSERT_GE(connection, 0);
+  std::string request = ReadUntil(connection, "\r\n\r\n");
+  EXPECT_EQ(request.find("GET /test HTTP/1.1\r\n"), 0u);
+  // a text message and a ping arrive together with the upgrade response
+  std::string response =
+      "HTTP/1.1 101 Switching Protocols\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n\r\n";
+  response += std::string("\x81\x05hello", 7);
+  response += std::string("\x89\x02hi", 4);
+  ASSERT_EQ(write(connection, response.data(), response.size()),
+            static_cast<ssize_t>(response.size()));
+
+  std::string pong = ClientFrame(0xa, "hi");
+  EXPECT_EQ(ReadExactly(connection, pong.size()), pong);
+  std::vector<std::string> events = delegate.WaitForEvents(2);
+  EXPECT_EQ(events[0], "open");
+  EXPECT_EQ(events[1], "message:hello");
+
+  client->Send("reply");
+  std::string reply = ClientFrame(0x1, "reply");
+  EXPECT_EQ(ReadExactly(connection, reply.size()), reply);
+
+  // the close status code is echoed and the connection reports closed
+  std::string close_frame("\x88\x02\x03\xe8", 4);
+  ASSERT_EQ(write(connection, close_frame.data(), close_frame.size()),
+            static_cast<ssize_t>(close_frame.size()));
+  std::string close_reply = ClientFrame(0x8, std::string("\x03\xe8", 2));
+  EXPECT_EQ(ReadExactly(connection, close_reply.size()), close_reply);
+  events = delegate.WaitForEvents(3);
+  EXPECT_EQ(events[2], "close");
+  char c;
+  EXPECT_EQ(read(connection, &c, 1), 0);
+
+  client.reset();
+  close(connection);
+  close(server);
+}
+
+TEST(WebSocketClientTestSuite, InteractiveOvertakesBulk) {
+  constexpr int kMessages = 600;
+  constexpr size_t kMessageSize = 60000;
+  thread::DebugRouterExecutor::GetInstance().Start();
+  int server = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(server, 0);
+  // a small window, so that the client has to queue the backlog itself
+  int buffer_size = 64 * 1024;
+  setsockopt(server, SOL_SOCKET, SO_RCVBUF, &buffer_size,
+             sizeof(buffer_size));
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(bind(server, (struct sockaddr *)&addr, sizeof(addr)), 0);
+  socklen_t addr_len = sizeof(addr);
+  ASSERT_EQ(getsockname(server, (struct sockaddr *)&addr, &addr_len), 0);
+  ASSERT_EQ(listen(server, 1), 0);
+
+  TestDelegate delegate;
+  auto client = std::make_shared<WebSocketClient>();
+  client->SetDelegate(&delegate);
+  client->Init();
+  client->Connect("ws://127.0.0.1:" + std::to_string(ntohs(addr.sin_port)) +
+                  "/test");
+  int connection = accept(server, nullptr, nullptr);
+  ASSERT_GE(connection, 0);
+  ReadUntil(connection, "\r\n\r\n");
+  std::string response =
+      "HTTP/1.1 101 Switching Protocols\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n\r\n";
+  ASSERT_EQ(write(connection, response.data(), response.size()),
+            static_cast<ssize_t>(response.size()));
+  EXPECT_EQ(delegate.WaitForEvents(1)[0], "open");
+
+  // nothing is read until the socket is full
+  core::OutboundMessage bulk(std::string(kMessageSize, 'b'));
+  bulk.priority = core::MessagePriority::kBulk;
+  bulk.session_id = 1;
+  for (int i = 0; i < kMessages; ++i) {
+    client->SendMessage(bulk);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  // a session only overtakes the backlog of other sessions
+  core::OutboundMessage paused("paused");
+  paused.session_id = 2;
+  client->SendMessage(paused);
+
+  int position = -1;
+  for (int i = 0; i <= kMessages; ++i) {
+    std::string payload = ReadFramePayload(connection);
+    ASSERT_FALSE(payload.empty());
+    if (payload == "paused") {
+      position = i;
+    }
+  }
+  // only the messages already in the sockets and in one fill were ahead
+  EXPECT_GE(position, 0);
+  EXPECT_LT(position, kMessages / 2);
+
+  client.reset();
+  close(connection);
+  close(server);
+}
+
+TEST(WebSocketClientTestSuite, CloseFrameFollowsBacklog) {
+  constexpr int kMessages = 600;
+  constexpr size_t kMessageSize = 60000;
+  thread::DebugRouterExecutor::GetInstance().Start();
+  int server = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(server, 0);
+  int buffer_size = 64 * 1024;
+  setsockopt(server, SOL_SOCKET, SO_RCVBUF, &buffer_size,
+             sizeof(buffer_size));
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(bind(server, (struct sockaddr *)&addr, sizeof(addr)), 0);
+  socklen_t addr_len = sizeof(addr);
+  ASSERT_EQ(getsockname(server, (struct sockaddr *)&addr, &addr_len), 0);
+  ASSERT_EQ(listen(server, 1), 0);
+
+  TestDelegate delegate;
+  auto client = std::make_shared<WebSocketClient>();
+  client->SetDelegate(&delegate);
+  client->Init();
+  client->Connect("ws://127.0.0.1:" + std::to_string(ntohs(addr.sin_port)) +
+                  "/test");
+  int connection = accept(server, nullptr, nullptr);
+  ASSERT_GE(connection, 0);
+  ReadUntil(connection, "\r\n\r\n");
+  std::string response =
+      "HTTP/1.1 101 Switching Protocols\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n\r\n";
+  ASSERT_EQ(write(connection, response.data(), response.size()),
+            static_cast<ssize_t>(response.size()));
+  EXPECT_EQ(delegate.WaitForEvents(1)[0], "open");
+
+  core::OutboundMessage bulk(std::string(kMessageSize, 'b'));
+  bulk.priority = core::MessagePriority::kBulk;
+  bulk.session_id = 1;
+  for (int i = 0; i < kMessages; ++i) {
+    client->SendMessage(bulk);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // the server closes while the backlog waits for the socket, every pending
+  // message is sent before the echoed close frame
+  std::string close_frame("\x88\x02\x03\xe8", 4);
+  ASSERT_EQ(write(connection, close_frame.data(), close_frame.size()),
+            static_cast<ssize_t>(close_frame.size()));
+  uint8_t opcode = 0;
+  for (int i = 0; i < kMessages; ++i) {
+    ASSERT_EQ(ReadFramePayload(connection, &opcode).size(), kMessageSize);
+    EXPECT_EQ(opcode, 0x1);
+  }
+  EXPECT_EQ(ReadFramePayload(connection, &opcode), std::string("\x03\xe8", 2));
+  EXPECT_EQ(opcode, 0x8);
+  EXPECT_EQ(delegate.WaitForEvents(2)[1], "close");
+  char c;
+  EXPECT_EQ(read(connection, &c, 1), 0);
+
+  client.reset();
+  close(connection);
+  close(server);
+}
+
+TEST(WebSocketClientTestSuite, ConnectRefused) {
+  thread::DebugRouterExecutor::GetInstance().Start();
+  // a port that was just released, nothing listens on it
+  int server = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(server, 0);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(bind(server, (struct sockaddr *)&addr, sizeof(addr)), 0);
+  socklen_t addr_len = sizeof(addr);
+  ASSERT_EQ(getsockname(server, (struct sockaddr *)&addr, &addr_len), 0);
+  close(server);
+
+  TestDelegate delegate;
+  auto client = std::make_shared<WebSocketClient>();
+  client->SetDelegate(&delegate);
+  client->Connect("ws://127.0.0.1:" + std::to_string(ntohs(addr.sin_port)));
+  std::vector<std::string> events = delegate.WaitForEvents(1);
+  EXPECT_EQ(events[0], "failure");
+  client.reset();
+}
+
+}  // namespace net
+}  // namespace debugrouter
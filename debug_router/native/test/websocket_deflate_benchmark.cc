@@ -0,0 +1,134 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+// Compares sending CDP payloads with and without permessage-deflate: CPU
+// time spent compressing on the device, bytes on the wire and the resulting
+// throughput over a link of the given bandwidth.
+//
+// Usage: websocket_deflate_benchmark [payload files...] [--mbps=N]
+// Each file holds one recorded message. Without files, synthetic DOM,
+// heap snapshot and screencast metadata payloads are used.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "debug_router/native/net/websocket_deflate.h"
+
+namespace {
+
+using debugrouter::net::WebSocketDeflateParams;
+using debugrouter::net::WebSocketDeflater;
+using debugrouter::net::WebSocketInflater;
+
+std::string DomTree() {
+  std::string result =
+      "{\"id\":12,\"result\":{\"root\":{\"nodeId\":1,\"nodeType\":9,"
+      "\"nodeName\":\"#document\",\"children\":[";
+  for (int i = 0; i < 2000; ++i) {
+    if (i > 0) {
+      result += ",";
+    }
+    result += "{\"nodeId\":" + std::to_string(i + 2) +
+              ",\"parentId\":" + std::to_string(i / 4 + 1) +
+              ",\"nodeType\":1,\"nodeName\":\"VIEW\",\"localName\":\"view\","
+              "\"attributes\":[\"class\",\"item-" +
+              std::to_string(i % 17) + "\",\"style\",\"width: " +
+              std::to_string(i % 300) + "px;\"],\"childNodeCount\":" +
+              std::to_string(i % 5) + "}";
+  }
+  return result + "]}}}";
+}
+
+std::string HeapSnapshotChunk() {
+  std::string result =
+      "{\"method\":\"HeapProfiler.addHeapSnapshotChunk\",\"params\":{"
+      "\"chunk\":\"";
+  for (int i = 0; i < 40000; ++i) {
+    result += std::to_string(i % 7) + "," + std::to_string(i * 31 % 4096) +
+              "," + std::to_string(i * 17 % 100000) + ",0,";
+  }
+  return result + "\"}}";
+}
+
+std::string ScreencastMetadata() {
+  return "{\"method\":\"Page.screencastFrame\",\"params\":{\"sessionId\":3,"
+         "\"metadata\":{\"offsetTop\":0,\"pageScaleFactor\":1,"
+         "\"deviceWidth\":390,\"deviceHeight\":844,\"scrollOffsetX\":0,"
+         "\"scrollOffsetY\":1024,\"timestamp\":1712345678.123}}}";
+}
+
+double CpuSeconds(std::clock_t start) {
+  return static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+}
+
+void Run(const std::string &name, const std::string &payload, double mbps) {
+  const int kIterations = std::max<int>(1, (64 << 20) / payload.size());
+  WebSocketDeflater deflater{WebSocketDeflateParams()};
+  WebSocketInflater inflater{WebSocketDeflateParams()};
+  std::vector<std::string> compressed(kIterations);
+
+  std::clock_t cpu_start = std::clock();
+  size_t wire_bytes = 0;
+  for (int i = 0; i < kIterations; ++i) {
+    deflater.Compress(payload.data(), payload.size(), &compressed[i]);
+    wire_bytes += compressed[i].size();
+  }
+  double deflate_cpu = CpuSeconds(cpu_start);
+
+  cpu_start = std::clock();
+  std::string out;
+  for (int i = 0; i < kIterations; ++i) {
+    inflater.Decompress(compressed[i], 0, &out);
+  }
+  double inflate_cpu = CpuSeconds(cpu_start);
+
+  double raw_bytes = static_cast<double>(payload.size()) * kIterations;
+  double link = mbps * 1000 * 1000 / 8;
+  // the sender is bound by the slower of the cpu and the link
+  double raw_seconds = raw_bytes / link;
+  double deflate_seconds = std::max(deflate_cpu, wire_bytes / link);
+  printf(
+      "%-20s %8zu B  ratio %5.2fx  deflate %7.1f MB/s cpu  inflate %7.1f "
+      "MB/s cpu  @%gMbps: raw %7.2f msg/s, deflate %7.2f msg/s\n",
+      name.c_str(), payload.size(), raw_bytes / wire_bytes,
+      raw_bytes / deflate_cpu / 1e6, raw_bytes / inflate_cpu / 1e6, mbps,
+      kIterations / raw_seconds, kIterations / deflate_seconds);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (!debugrouter::net::IsWebSocketDeflateSupported()) {
+    printf("built without ENABLE_WEBSOCKET_DEFLATE\n");
+    return 1;
+  }
+  double mbps = 20;
+  std::vector<std::pair<std::string, std::string>> payloads;
+  for (int i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], "--mbps=", 7) == 0) {
+      mbps = atof(argv[i] + 7);
+      continue;
+    }
+    std::ifstream file(argv[i], std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    payloads.emplace_back(argv[i], content.str());
+  }
+  if (payloads.empty()) {
+    payloads.emplace_back("DOM.getDocument", DomTree());
+    payloads.emplace_back("HeapSnapshotChunk", HeapSnapshotChunk());
+    payloads.emplace_back("screencastMetadata", ScreencastMetadata());
+  }
+  for (const auto &payload : payloads) {
+    Run(payload.first, payload.second, mbps);
+  }
+  return 0;
+}
@@ -0,0 +1,112 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/net/websocket_deflate.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace net {
+
+TEST(WebSocketDeflateTestSuite, ParseResponse) {
+  bool negotiated = true;
+  WebSocketDeflateParams params;
+  EXPECT_TRUE(ParseWebSocketDeflateResponse("", &negotiated, &params));
+  EXPECT_FALSE(negotiated);
+
+  EXPECT_TRUE(ParseWebSocketDeflateResponse(
+      " permessage-deflate; server_no_context_takeover; "
+      "server_max_window_bits=\"10\"",
+      &negotiated, &params));
+  EXPECT_TRUE(negotiated);
+  EXPECT_TRUE(params.server_no_context_takeover);
+  EXPECT_FALSE(params.client_no_context_takeover);
+  EXPECT_EQ(params.server_max_window_bits, 10);
+
+  // not offered by the client
+  EXPECT_FALSE(ParseWebSocketDeflateResponse(
+      "permessage-deflate; client_max_window_bits=10", &negotiated, &params));
+  EXPECT_FALSE(
+      ParseWebSocketDeflateResponse("x-webkit-deflate", &negotiated, &params));
+  EXPECT_FALSE(ParseWebSocketDeflateResponse(
+      "permessage-deflate; server_max_window_bits=16", &negotiated, &params));
+}
+
+TEST(WebSocketDeflateTestSuite, InflateRfcExample) {
+  // RFC 7692 section 7.2.3.1, "Hello" compressed
+  const std::string data("\xf2\x48\xcd\xc9\xc9\x07\x00", 7);
+  WebSocketInflater inflater{WebSocketDeflateParams()};
+  std::string out;
+  ASSERT_TRUE(inflater.Decompress(data, 0, &out));
+  EXPECT_EQ(out, "Hello");
+}
+
+TEST(WebSocketDeflateTestSuite, RoundTripWithContextTakeover) {
+  WebSocketDeflateParams params;
+  WebSocketDeflater deflater(params);
+  WebSocketInflater inflater(params);
+  std::string message =
+      "{\"id\":1,\"result\":{\"root\":{\"nodeId\":1,\"nodeName\":\"#document\","
+      "\"children\":[]}}}";
+  std::string first;
+  std::string second;
+  ASSERT_TRUE(deflater.Compress(message.data(), message.size(), &first));
+  ASSERT_TRUE(deflater.Compress(message.data(), message.size(), &second));
+  // the second message refers to the window of the first one
+  EXPECT_LT(second.size(), first.size());
+
+  std::string out;
+  ASSERT_TRUE(inflater.Decompress(first, 0, &out));
+  EXPECT_EQ(out, message);
+  ASSERT_TRUE(inflater.Decompress(second, 0, &out));
+  EXPECT_EQ(out, message);
+}
+
+TEST(WebSocketDeflateTestSuite, NoContextTakeover) {
+  WebSocketDeflateParams params;
+  params.client_no_context_takeover = true;
+  WebSocketDeflater deflater(params);
+  std::string message(300, 'a');
+  std::string first;
+  std::string second;
+  ASSERT_TRUE(deflater.Compress(message.data(), message.size(), &first));
+  ASSERT_TRUE(deflater.Compress(message.data(), message.size(), &second));
+  EXPECT_EQ(first, second);
+
+  // each message can be inflated on its own
+  std::string out;
+  WebSocketInflater inflater{WebSocketDeflateParams()};
+  ASSERT_TRUE(inflater.Decompress(second, 0, &out));
+  EXPECT_EQ(out, message);
+}
+
+TEST(WebSocketDeflateTestSuite, LargeMessageAndMaxSize) {
+  std::string message;
+  for (int i = 0; i < 100000; ++i) {
+    message += std::to_string(i * 7919 % 1000);
+  }
+  WebSocketDeflater deflater{WebSocketDeflateParams()};
+  std::string compressed;
+  ASSERT_TRUE(deflater.Compress(message.data(), message.size(), &compressed));
+
+  std::string out;
+  WebSocketInflater inflater{WebSocketDeflateParams()};
+  ASSERT_TRUE(inflater.Decompress(compressed, 0, &out));
+  EXPECT_EQ(out, message);
+
+  WebSocketInflater limited{WebSocketDeflateParams()};
+  EXPECT_FALSE(limited.Decompress(compressed, message.size() / 2, &out));
+}
+
+TEST(WebSocketDeflateTestSuite, CorruptedData) {
+  WebSocketInflater inflater{WebSocketDeflateParams()};
+  std::string out;
+  const std::string data("\xff\xff\xff\xff", 4);
+  EXPECT_FALSE(inflater.Decompress(data, 0, &out));
+}
+
+}  // namespace net
+}  // namespace debugrouter
@@ -0,0 +1,81 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+// Measures frames per second and recv calls per frame of
+// WebSocketFrameReader on an in-memory stream. Each recv returns at most
+// kRecvChunk bytes to mimic a socket receive buffer.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "debug_router/native/net/websocket_frame_reader.h"
+
+namespace {
+
+constexpr size_t kRecvChunk = 64 * 1024;
+constexpr size_t kStreamSize = 64 * 1024 * 1024;
+
+std::string ServerFrame(size_t len) {
+  std::string frame;
+  frame.push_back(static_cast<char>(0x81));
+  if (len > 65535) {
+    frame.push_back(static_cast<char>(127));
+    for (int i = 7; i >= 0; --i) {
+      frame.push_back(
+          static_cast<char>((static_cast<uint64_t>(len) >> (8 * i)) & 0xff));
+    }
+  } else if (len > 125) {
+    frame.push_back(static_cast<char>(126));
+    frame.push_back(static_cast<char>(len >> 8));
+    frame.push_back(static_cast<char>(len & 0xff));
+  } else {
+    frame.push_back(static_cast<char>(len));
+  }
+  frame.append(len, 'x');
+  return frame;
+}
+
+void Run(size_t payload_size) {
+  std::string frame = ServerFrame(payload_size);
+  size_t frame_count = std::max<size_t>(kStreamSize / frame.size(), 1);
+  std::string stream;
+  stream.reserve(frame.size() * frame_count);
+  for (size_t i = 0; i < frame_count; ++i) {
+    stream.append(frame);
+  }
+
+  size_t offset = 0;
+  debugrouter::net::WebSocketFrameReader reader(
+      [&](char *buffer, size_t size) -> int64_t {
+        size_t count = std::min({size, kRecvChunk, stream.size() - offset});
+        memcpy(buffer, stream.data() + offset, count);
+        offset += count;
+        return static_cast<int64_t>(count);
+      });
+
+  debugrouter::net::WebSocketFrame parsed;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < frame_count; ++i) {
+    reader.ReadFrame(parsed);
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  printf("payload %8zu B: %10.0f frames/s, %7.3f recv/frame\n", payload_size,
+         frame_count / seconds,
+         static_cast<double>(reader.GetRecvCount()) / frame_count);
+}
+
+}  // namespace
+
+int main() {
+  const size_t sizes[] = {64, 1024, 16 * 1024, 256 * 1024, 4 * 1024 * 1024};
+  for (size_t size : sizes) {
+    Run(size);
+  }
+  return 0;
+}
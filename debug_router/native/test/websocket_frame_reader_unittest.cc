@@ -0,0 +1,265 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/net/websocket_frame_reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace debugrouter {
+namespace net {
+
+namespace {
+
+// serves data to the reader, at most chunk_size bytes per recv
+class FakeStream {
+ public:
+  FakeStream(const std::string &data, size_t chunk_size)
+      : data_(data), chunk_size_(chunk_size), offset_(0) {}
+
+  WebSocketFrameReader::RecvFunction AsRecvFunction() {
+    return [this](char *buffer, size_t size) -> int64_t {
+      size_t count = std::min({size, chunk_size_, data_.size() - offset_});
+      memcpy(buffer, data_.data() + offset_, count);
+      offset_ += count;
+      return static_cast<int64_t>(count);
+    };
+  }
+
+ private:
+  std::string data_;
+  size_t chunk_size_;
+  size_t offset_;
+};
+
+std::string ServerFrame(const std::string &payload, uint8_t opcode = 1,
+                        bool fin = true) {
+  std::string frame;
+  frame.push_back(static_cast<char>((fin ? 0x80 : 0) | opcode));
+  size_t len = payload.size();
+  if (len > 65535) {
+    frame.push_back(static_cast<char>(127));
+    for (int i = 7; i >= 0; --i) {
+      frame.push_back(static_cast<char>((static_cast<uint64_t>(len) >>
+                                         (8 * i)) &
+                                        0xff));
+    }
+  } else if (len > 125) {
+    frame.push_back(static_cast<char>(126));
+    frame.push_back(static_cast<char>(len >> 8));
+    frame.push_back(static_cast<char>(len & 0xff));
+  } else {
+    frame.push_back(static_cast<char>(len));
+  }
+  return frame + payload;
+}
+
+}  // namespace
+
+TEST(RingBufferTestSuite, WrapAroundAndGrow) {
+  RingBuffer buffer(8);
+  size_t writable = 0;
+  char *out = buffer.PrepareWrite(1, &writable);
+  EXPECT_EQ(writable, static_cast<size_t>(8));
+  memcpy(out, "abcdef", 6);
+  buffer.CommitWrite(6);
+  buffer.Consume(4);
+
+  // the tail wraps: only two contiguous bytes remain before the end
+  out = buffer.PrepareWrite(1, &writable);
+  EXPECT_EQ(writable, static_cast<size_t>(2));
+  memcpy(out, "gh", 2);
+  buffer.CommitWrite(2);
+  out = buffer.PrepareWrite(1, &writable);
+  EXPECT_EQ(writable, static_cast<size_t>(4));
+  memcpy(out, "ij", 2);
+  buffer.CommitWrite(2);
+
+  char data[6];
+  buffer.Peek(0, data, sizeof(data));
+  EXPECT_EQ(std::string(data, sizeof(data)), "efghij");
+
+  buffer.PrepareWrite(10, &writable);
+  EXPECT_GE(buffer.Capacity(), static_cast<size_t>(16));
+  buffer.Peek(0, data, sizeof(data));
+  EXPECT_EQ(std::string(data, sizeof(data)), "efghij");
+}
+
+TEST(WebSocketFrameReaderTestSuite, ShortReads) {
+  std::string payload(70000, 'x');
+  FakeStream stream(ServerFrame(payload), 1);
+  WebSocketFrameReader reader(stream.AsRecvFunction(), 16);
+  WebSocketFrame frame;
+  ASSERT_EQ(reader.ReadFrame(frame), WebSocketReadStatus::kOk);
+  EXPECT_TRUE(frame.fin);
+  EXPECT_EQ(frame.opcode, 1);
+  EXPECT_EQ(frame.payload, payload);
+}
+
+TEST(WebSocketFrameReaderTestSuite, SeveralFramesFromOneRecv) {
+  std::string medium(300, 'm');
+  std::string data = ServerFrame("first") + ServerFrame(medium) +
+                     ServerFrame("third", 2);
+  FakeStream stream(data, data.size());
+  WebSocketFrameReader reader(stream.AsRecvFunction(), 1024);
+  WebSocketFrame frame;
+  ASSERT_EQ(reader.ReadFrame(frame), WebSocketReadStatus::kOk);
+  EXPECT_EQ(frame.payload, "first");
+  ASSERT_EQ(reader.ReadFrame(frame), WebSocketReadStatus::kOk);
+  EXPECT_EQ(frame.payload, medium);
+  ASSERT_EQ(reader.ReadFrame(frame), WebSocketReadStatus::kOk);
+  EXPECT_EQ(frame.payload, "third");
+  EXPECT_EQ(frame.opcode, 2);
+  EXPECT_EQ(reader.GetRecvCount(), static_cast<uint64_t>(1));
+
+  EXPECT_EQ(reader.ReadFrame(frame), WebSocketReadStatus::kClosed);
+}
+
+TEST(WebSocketFrameReaderTestSuite, MaskedPayload) {
+  std::string data = {static_cast<char>(0x81), static_cast<char>(0x83), 1, 2,
+                      3,                       4};
+  data.push_back('a' ^ 1);
+  data.push_back('b' ^ 2);
+  data.push_back('c' ^ 3);
+  FakeStream stream(data, 3);
+  WebSocketFrameReader reader(stream.AsRecvFunction());
+  WebSocketFrame frame;
+  ASSERT_EQ(reader.ReadFrame(frame), WebSocketReadStatus::kOk);
+  EXPECT_TRUE(frame.masked);
+  EXPECT_EQ(frame.payload, "abc");
+}
+
+TEST(WebSocketFrameReaderTestSuite, UpgradeResponseThenFrame) {
+  std::string data =
+      "HTTP/1.1 101 Switching Protocols\r\n"
+      "Upgrade: websocket\r\n"
+      "\r\n" +
+      ServerFrame("hello");
+  FakeStream stream(data, data.size());
+  WebSocketFrameReader reader(stream.AsRecvFunction());
+  std::string line;
+  ASSERT_EQ(reader.ReadLine(line, 512), WebSocketReadStatus::kOk);
+  EXPECT_EQ(line, "HTTP/1.1 101 Switching Protocols\r\n");
+  ASSERT_EQ(reader.ReadLine(line, 512), WebSocketReadStatus::kOk);
+  EXPECT_EQ(line, "Upgrade: websocket\r\n");
+  ASSERT_EQ(reader.ReadLine(line, 512), WebSocketReadStatus::kOk);
+  EXPECT_EQ(line, "\r\n");
+  WebSocketFrame frame;
+  ASSERT_EQ(reader.ReadFrame(frame), WebSocketReadStatus::kOk);
+  EXPECT_EQ(frame.payload, "hello");
+  EXPECT_EQ(reader.GetRecvCount(), static_cast<uint64_t>(1));
+}
+
+TEST(WebSocketFrameReaderTestSuite, LineTooLong) {
+  FakeStream stream(std::string(64, 'a') + "\n", 8);
+  WebSocketFrameReader reader(stream.AsRecvFunction());
+  std::string line;
+  EXPECT_EQ(reader.ReadLine(line, 16), WebSocketReadStatus::kLineTooLong);
+}
+
+TEST(WebSocketFrameReaderTestSuite, RecvError) {
+  WebSocketFrameReader reader([](char *, size_t) -> int64_t { return -1; });
+  WebSocketFrame frame;
+  EXPECT_EQ(reader.ReadFrame(frame), WebSocketReadStatus::kRecvError);
+}
+
+TEST(WebSocketFrameReaderTestSuite, ReassembleFragmentsAroundPing) {
+  std::string data = ServerFrame("he", kWebSocketOpcodeText, false) +
+                     ServerFrame("ll", kWebSocketOpcodeContinuation, false) +
+                     ServerFrame("ping", kWebSocketOpcodePing) +
+                     ServerFrame("o", kWebSocketOpcodeContinuation) +
+                     ServerFrame("next");
+  FakeStream stream(data, 3);
+  WebSocketFrameReader reader(stream.AsRecvFunction());
+  WebSocketFrame message;
+  ASSERT_EQ(reader.ReadMessage(message), WebSocketReadStatus::kOk);
+  EXPECT_EQ(message.opcode, kWebSocketOpcodePing);
+  EXPECT_EQ(message.payload, "ping");
+  ASSERT_EQ(reader.ReadMessage(message), WebSocketReadStatus::kOk);
+  EXPECT_EQ(message.opcode, kWebSocketOpcodeText);
+  EXPECT_TRUE(message.fin);
+  EXPECT_EQ(message.payload, "hello");
+  ASSERT_EQ(reader.ReadMessage(message), WebSocketReadStatus::kOk);
+  EXPECT_EQ(message.payload, "next");
+}
+
+TEST(WebSocketFrameReaderTestSuite, ProtocolErrors) {
+  // continuation without a started message
+  FakeStream orphan(ServerFrame("x", kWebSocketOpcodeContinuation), 64);
+  WebSocketFrameReader orphan_reader(orphan.AsRecvFunction());
+  WebSocketFrame message;
+  EXPECT_EQ(orphan_reader.ReadMessage(message),
+            WebSocketReadStatus::kProtocolError);
+
+  // new data message before the previous one is finished
+  FakeStream interleaved(ServerFrame("a", kWebSocketOpcodeText, false) +
+                             ServerFrame("b", kWebSocketOpcodeText),
+                         64);
+  WebSocketFrameReader interleaved_reader(interleaved.AsRecvFunction());
+  EXPECT_EQ(interleaved_reader.ReadMessage(message),
+            WebSocketReadStatus::kProtocolError);
+
+  // fragmented control frame
+  FakeStream control(ServerFrame("p", kWebSocketOpcodePing, false), 64);
+  WebSocketFrameReader control_reader(control.AsRecvFunction());
+  EXPECT_EQ(control_reader.ReadMessage(message),
+            WebSocketReadStatus::kProtocolError);
+
+  // reserved opcode
+  FakeStream reserved(ServerFrame("r", 0x3), 64);
+  WebSocketFrameReader reserved_reader(reserved.AsRecvFunction());
+  EXPECT_EQ(reserved_reader.ReadMessage(message),
+            WebSocketReadStatus::kProtocolError);
+}
+
+TEST(WebSocketFrameReaderTestSuite, MaxMessageSize) {
+  FakeStream single(ServerFrame(std::string(100, 'a')), 1024);
+  WebSocketFrameReader single_reader(single.AsRecvFunction());
+  single_reader.SetMaxMessageSize(64);
+  WebSocketFrame message;
+  EXPECT_EQ(single_reader.ReadMessage(message),
+            WebSocketReadStatus::kMessageTooLarge);
+  // the oversized payload is rejected from the header, before buffering it
+  EXPECT_EQ(single_reader.GetRecvCount(), static_cast<uint64_t>(1));
+
+  std::string data =
+      ServerFrame(std::string(40, 'a'), kWebSocketOpcodeText, false) +
+      ServerFrame(std::string(40, 'b'), kWebSocketOpcodeContinuation);
+  FakeStream fragmented(data, 1024);
+  WebSocketFrameReader fragmented_reader(fragmented.AsRecvFunction());
+  fragmented_reader.SetMaxMessageSize(64);
+  EXPECT_EQ(fragmented_reader.ReadMessage(message),
+            WebSocketReadStatus::kMessageTooLarge);
+}
+
+TEST(WebSocketFrameReaderTestSuite, AnnouncedLengthIsNotTrusted) {
+  // the buffer only grows with the payload that arrives
+  // a 256MB frame of which 1000 bytes arrive
+  std::string header = {static_cast<char>(0x82), static_cast<char>(127)};
+  header.append({0, 0, 0, 0x10, 0, 0, 0, 0});
+  FakeStream partial(header + std::string(1000, 'p'), 1 << 30);
+  size_t max_recv_size = 0;
+  auto recv = partial.AsRecvFunction();
+  WebSocketFrameReader reader([&](char *buffer, size_t size) {
+    max_recv_size = std::max(max_recv_size, size);
+    return recv(buffer, size);
+  });
+  WebSocketFrame frame;
+  EXPECT_EQ(reader.ReadFrame(frame), WebSocketReadStatus::kClosed);
+  EXPECT_LT(max_recv_size, static_cast<size_t>(1024 * 1024));
+
+  // a length that does not fit size_t is rejected even when unlimited
+  std::string huge = {static_cast<char>(0x82), static_cast<char>(127)};
+  huge.append(8, static_cast<char>(0xff));
+  FakeStream huge_stream(huge, 64);
+  WebSocketFrameReader huge_reader(huge_stream.AsRecvFunction());
+  EXPECT_EQ(huge_reader.ReadFrame(frame),
+            WebSocketReadStatus::kMessageTooLarge);
+}
+
+}  // namespace net
+}  // namespace debugrouter
@@ -18,13 +18,14 @@ DebugRouterExecutor &DebugRouterExecutor::GetInstance() {
 }
 
 void DebugRouterExecutor::Start() {
+  if (is_running_) {
+    return;
+  }
   if (thread_.joinable()) {
     thread_.join();
   }
-  if (!is_running_) {
-    is_running_ = true;
-    thread_ = std::thread([=]() { looper_->Run(); });
-  }
+  is_running_ = true;
+  thread_ = std::thread([=]() { looper_->Run(); });
 }
 
 void DebugRouterExecutor::Quit() {
@@ -43,10 +44,31 @@ void DebugRouterExecutor::Post(std::function<void()> work, bool run_now) {
   looper_->Post(work);
 }
 
+TaskHandle DebugRouterExecutor::PostDelayed(std::function<void()> work,
+                                            std::chrono::milliseconds delay) {
+  return looper_->PostAt(std::move(work), TaskClock::now() + delay);
+}
+
+TaskHandle DebugRouterExecutor::PostAt(std::function<void()> work,
+                                       TaskClock::time_point time) {
+  return looper_->PostAt(std::move(work), time);
+}
+
+void TaskHandle::Cancel() {
+  if (cancelled_) {
+    cancelled_->store(true, std::memory_order_relaxed);
+  }
+}
+
+bool TaskHandle::IsCancelled() const {
+  return cancelled_ && cancelled_->load(std::memory_order_relaxed);
+}
+
 ThreadLooper::ThreadLooper()
     : keep_running_(true),
       working_queue_(std::make_shared<std::queue<std::function<void()>>>()),
-      incoming_queue_(std::make_shared<std::queue<std::function<void()>>>()) {}
+      incoming_queue_(std::make_shared<std::queue<std::function<void()>>>()),
+      delayed_sequence_(0) {}
 
 void ThreadLooper::Run() {
   while (keep_running_) {
@@ -54,18 +76,46 @@ void ThreadLooper::Run() {
       auto work = working_queue_->front();
       working_queue_->pop();
       work();
-    } else if (!incoming_queue_->empty()) {
-      std::lock_guard<std::mutex> lock(incoming_queue_lock_);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(incoming_queue_lock_);
+    PromoteDelayedTasks(TaskClock::now());
+    if (!incoming_queue_->empty()) {
       working_queue_.swap(incoming_queue_);
-    } else {
-      std::unique_lock<std::mutex> lock(condition_lock_);
+    } else if (!keep_running_) {
+      break;
+    } else if (delayed_queue_.empty()) {
       condition_.wait(lock);
+    } else {
+      // copied, a PostDelayed during the wait may reallocate the heap
+      const auto deadline = delayed_queue_.top().time;
+      condition_.wait_until(lock, deadline);
     }
   }
 }
 
+void ThreadLooper::PromoteDelayedTasks(TaskClock::time_point now) {
+  while (!delayed_queue_.empty() && delayed_queue_.top().time <= now) {
+    DelayedTask task = delayed_queue_.top();
+    delayed_queue_.pop();
+    if (task.cancelled->load(std::memory_order_relaxed)) {
+      continue;
+    }
+    // Cancel() may still race with the task waiting in working_queue_.
+    incoming_queue_->push(
+        [work = std::move(task.work), cancelled = task.cancelled]() {
+          if (!cancelled->load(std::memory_order_relaxed)) {
+            work();
+          }
+        });
+  }
+}
+
 void ThreadLooper::Stop() {
-  keep_running_ = false;
+  {
+    std::lock_guard<std::mutex> lock(incoming_queue_lock_);
+    keep_running_ = false;
+  }
   condition_.notify_one();
 }
 
@@ -77,5 +127,17 @@ void ThreadLooper::Post(std::function<void()> work) {
   condition_.notify_one();
 }
 
+TaskHandle ThreadLooper::PostAt(std::function<void()> work,
+                                TaskClock::time_point time) {
+  auto cancelled = std::make_shared<std::atomic<bool>>(false);
+  {
+    std::lock_guard<std::mutex> lock(incoming_queue_lock_);
+    delayed_queue_.push(
+        DelayedTask{time, delayed_sequence_++, std::move(work), cancelled});
+  }
+  condition_.notify_one();
+  return TaskHandle(cancelled);
+}
+
 }  // namespace thread
 }  // namespace debugrouter
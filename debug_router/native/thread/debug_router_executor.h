@@ -5,10 +5,16 @@
 #ifndef DEBUGROUTER_NATIVE_THREAD_DEBUG_ROUTER_EXECUTOR_H_
 #define DEBUGROUTER_NATIVE_THREAD_DEBUG_ROUTER_EXECUTOR_H_
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
 
 #include "debug_router/native/base/no_destructor.h"
 
@@ -17,9 +23,32 @@ namespace thread {
 
 class ThreadLooper;
 
+using TaskClock = std::chrono::steady_clock;
+
+/*
+ * Handle of a delayed task. Cancel() prevents the task from running if it
+ * has not started yet. A default constructed handle refers to no task.
+ */
+class TaskHandle {
+ public:
+  TaskHandle() = default;
+  void Cancel();
+  bool IsCancelled() const;
+  bool IsValid() const { return cancelled_ != nullptr; }
+
+ private:
+  friend class ThreadLooper;
+  explicit TaskHandle(std::shared_ptr<std::atomic<bool>> cancelled)
+      : cancelled_(std::move(cancelled)) {}
+
+  std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
 /*
  * All the actions inside DebugRouter will be executed on DebugRouterExecutor.
  *
+ * Never block this thread: use PostDelayed/PostAt for anything that has to
+ * wait, so that Send/Plug/Pull and state notifications keep flowing.
  */
 class DebugRouterExecutor {
  public:
@@ -27,6 +56,9 @@ class DebugRouterExecutor {
   void Start();
   void Quit();
   void Post(std::function<void()> work, bool run_now = true);
+  TaskHandle PostDelayed(std::function<void()> work,
+                         std::chrono::milliseconds delay);
+  TaskHandle PostAt(std::function<void()> work, TaskClock::time_point time);
 
  private:
   DebugRouterExecutor();
@@ -42,16 +74,40 @@ class ThreadLooper {
   explicit ThreadLooper();
   ~ThreadLooper() = default;
   void Post(std::function<void()> work);
+  TaskHandle PostAt(std::function<void()> work, TaskClock::time_point time);
   void Run();
   void Stop();
 
  private:
+  struct DelayedTask {
+    TaskClock::time_point time;
+    // keeps FIFO order for tasks with the same deadline
+    uint64_t sequence;
+    std::function<void()> work;
+    std::shared_ptr<std::atomic<bool>> cancelled;
+  };
+  struct DelayedTaskCompare {
+    bool operator()(const DelayedTask &a, const DelayedTask &b) const {
+      if (a.time != b.time) {
+        return a.time > b.time;
+      }
+      return a.sequence > b.sequence;
+    }
+  };
+
+  // move delayed tasks whose deadline has passed into incoming_queue_,
+  // incoming_queue_lock_ must be held.
+  void PromoteDelayedTasks(TaskClock::time_point now);
+
   volatile bool keep_running_;
   std::shared_ptr<std::queue<std::function<void()>>> working_queue_;
   std::shared_ptr<std::queue<std::function<void()>>> incoming_queue_;
+  std::priority_queue<DelayedTask, std::vector<DelayedTask>,
+                      DelayedTaskCompare>
+      delayed_queue_;
+  uint64_t delayed_sequence_;
   std::mutex incoming_queue_lock_;
-  std::condition_variable_any condition_;
-  std::mutex condition_lock_;
+  std::condition_variable condition_;
 };
 
 }  // namespace thread
@@ -0,0 +1,69 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "debug_router/native/thread/strand_pool.h"
+
+namespace debugrouter {
+namespace thread {
+
+StrandPool::StrandPool(size_t thread_count)
+    : thread_count_(thread_count == 0 ? 1 : thread_count), stopping_(false) {}
+
+StrandPool::~StrandPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void StrandPool::Post(int64_t strand, std::function<void()> task) {
+  std::call_once(start_flag_, [this]() {
+    for (size_t i = 0; i < thread_count_; ++i) {
+      threads_.emplace_back([this]() { Run(); });
+    }
+  });
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto result = strands_.try_emplace(strand);
+    result.first->second.push(std::move(task));
+    if (!result.second) {
+      // already ready or running, it is rescheduled after its running task
+      return;
+    }
+    ready_.push_back(strand);
+  }
+  condition_.notify_one();
+}
+
+void StrandPool::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    condition_.wait(lock, [this]() { return stopping_ || !ready_.empty(); });
+    if (stopping_) {
+      return;
+    }
+    int64_t strand = ready_.front();
+    ready_.pop_front();
+    auto &tasks = strands_[strand];
+    std::function<void()> task = std::move(tasks.front());
+    tasks.pop();
+    lock.unlock();
+    task();
+    task = nullptr;
+    lock.lock();
+    // only the worker running a task of the strand removes it
+    if (tasks.empty()) {
+      strands_.erase(strand);
+    } else {
+      ready_.push_back(strand);
+    }
+  }
+}
+
+}  // namespace thread
+}  // namespace debugrouter
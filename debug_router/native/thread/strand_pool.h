@@ -0,0 +1,62 @@
+// Copyright 2025 The Lynx Authors. All rights reserved.
+// Licensed under the Apache License Version 2.0 that can be found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DEBUGROUTER_NATIVE_THREAD_STRAND_POOL_H_
+#define DEBUGROUTER_NATIVE_THREAD_STRAND_POOL_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace debugrouter {
+namespace thread {
+
+/*
+ * Runs tasks on a few worker threads. Tasks posted to the same strand run one
+ * at a time in the order they were posted, tasks of different strands run in
+ * parallel, so a slow strand only delays itself.
+ *
+ * Strands take turns: a worker runs one task of a strand and then moves on to
+ * the next ready strand, the next task of the strand may run on another
+ * worker. The threads are started by the first Post.
+ */
+class StrandPool {
+ public:
+  explicit StrandPool(size_t thread_count);
+  // waits for the running tasks, the pending ones are dropped
+  ~StrandPool();
+
+  StrandPool(const StrandPool &) = delete;
+  StrandPool &operator=(const StrandPool &) = delete;
+
+  void Post(int64_t strand, std::function<void()> task);
+
+  size_t thread_count() const { return thread_count_; }
+
+ private:
+  void Run();
+
+  const size_t thread_count_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  // the pending tasks of strands that have some or run one, a strand is
+  // removed once it is idle
+  std::unordered_map<int64_t, std::queue<std::function<void()>>> strands_;
+  // strands that have a task to run and no task running
+  std::deque<int64_t> ready_;
+  bool stopping_;
+  std::once_flag start_flag_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace thread
+}  // namespace debugrouter
+
+#endif  // DEBUGROUTER_NATIVE_THREAD_STRAND_POOL_H_